@@ -22,11 +22,13 @@
 #include <stdio.h>
 #include "XNet.h"
 #include "../tensor/XUtility.h"
+#include "../tensor/XCorpus.h"
 #include "../tensor/function/FHeader.h"
 #include "../tensor/core/CHeader.h"
 #include "../tensor/test/Test.h"
 #include "../sample/fnnlm/FNNLM.h"
 #include "../sample/transformer/Transformer.h"
+#include "../sample/bench/Bench.h"
 
 //#define CRTDBG_MAP_ALLOC
 //#include <stdlib.h>
@@ -39,6 +41,7 @@ void SumDimTest();
 using namespace nts;
 using namespace fnnlm;
 using namespace transformer;
+using namespace bench;
 
 int main( int argc, const char ** argv )
 {
@@ -50,11 +53,21 @@ int main( int argc, const char ** argv )
         FNNLMMain(argc - 1, argv + 1);
     else if(argc > 1 && !strcmp(argv[1], "-t2t"))
         TransformerMain(argc - 1, argv + 1);
+    else if(argc > 1 && !strcmp(argv[1], "-benchtopk"))
+        BenchmarkTopK(argc > 2 ? atoi(argv[2]) : 4);
+    else if(argc > 1 && !strcmp(argv[1], "-benchnuma"))
+        BenchmarkNuma(argc > 2 ? atoi(argv[2]) : 4);
+    else if(argc > 1 && !strcmp(argv[1], "-bench"))
+        return BenchMain(argc - 1, argv + 1);
+    else if(argc > 3 && !strcmp(argv[1], "-compilecorpus"))
+        XCorpus::Compile(argv[2], argv[3]);
     else{
         fprintf(stderr, "Thanks for using NiuTrans.Network! This is a library for building\n");
         fprintf(stderr, "neural networks in an easy way. \n\n");
         fprintf(stderr, "Run this program with \"-test\" for unit test!\n");
         fprintf(stderr, "Or run this program with \"-fnnlm\" for sample FNNLM!\n");
+        fprintf(stderr, "Or run this program with \"-bench [-baseline <file>]\" for benchmarks!\n");
+        fprintf(stderr, "Or run this program with \"-compilecorpus <text> <binary>\" to compile a corpus of word ids!\n");
     }
 
     //_CrtDumpMemoryLeaks();
@@ -24,49 +24,171 @@
 #include "XNoder.h"
 #include "XBackwardFunc.h"
 #include "../tensor/XName.h"
+#include "../tensor/XOperator.h"
 #include "../tensor/function/FHeader.h"
+#include "../tensor/core/arithmetic/Sum.h"
 
 namespace nts{
 
-/* compute dE/dx of a node */
-void XFuncGrad::MakeGrad(XTensor * node, bool isEfficient)
+/* register the gradient functions of the activation functions (see XOperator.h) */
+void XFuncGrad::Register()
+{
+    GOPs.SetBackward(FUNC_HARDTANH,   GradHardTanH);
+    GOPs.SetBackward(FUNC_IDENTITY,   GradIdentity);
+    GOPs.SetBackward(FUNC_LOGSOFTMAX, GradLogSoftmax);
+    GOPs.SetBackward(FUNC_RECTIFY,    GradRectify);
+    GOPs.SetBackward(FUNC_SIGMOID,    GradSigmoid);
+    GOPs.SetBackward(FUNC_SOFTMAX,    GradSoftmax);
+}
+
+/* 
+dE/dx of the input for the functions that overwrite dE/dx. It is computed
+on a buffer if dE/dx has been written by other nodes, and is accumulated
+by AccumulateInputGrad() then
+>> node - the node (y) for backward computation
+<< return - where we keep dE/dx
+*/
+XTensor * XFuncGrad::MakeInputGrad(XTensor * node)
 {
     XLink &income = node->income;
-    int operID = income.typeID;
 
     CheckNTErrors(node->grad != NULL, "No gradient found!");
     CheckNTErrors(income.tailNum == 1, "Too many input tensors for the function!");
 
     XTensor * input = income.tails[0];
-    XTensor * output = node;
-
-    XNoder::MakeGrad(input);
-
-    if(operID == FUNC_HARDTANH)
-        _HardTanHBackward(NULL, output, input, output->grad, input->grad, NOLOSS);
-    else if(operID == FUNC_IDENTITY)
-        _IdentityBackward(NULL, output, input, output->grad, input->grad, NOLOSS);
-    else if(operID == FUNC_LOGSOFTMAX){
-        int leadDim = income.GetParamInt(0);
-        CheckNTErrors(leadDim >= 0 && leadDim < input->order, "wrong leading dimension in logsoftmax!");
-        _LogSoftmaxBackward(NULL, output, input, output->grad, input->grad, NULL, leadDim, NOLOSS);
-    }
-    else if(operID == FUNC_RECTIFY)
-        _RectifyBackward(NULL, output, input, output->grad, input->grad, NOLOSS);
-    else if(operID == FUNC_SIGMOID)
-        _SigmoidBackward(NULL, output, input, output->grad, input->grad, NOLOSS);
-    else if(operID == FUNC_SOFTMAX){
-        int leadDim = income.GetParamInt(0);
-        CheckNTErrors(leadDim >= 0 && leadDim < input->order, "wrong leading dimension in softmax!");
-        _SoftmaxBackward(NULL, output, input, output->grad, input->grad, NULL, leadDim, NOLOSS);
-    }
-    else{
-        ShowNTErrors("Wrong activation function type!");
+    DTYPE beta = XNoder::MakeGradToWrite(input);
+
+    if(beta != 0)
+        return NewTensorBuf(input->grad, input->devID, input->mem);
+    else
+        return input->grad;
+}
+
+/* 
+accumulate dE/dx of the input if it is computed on a buffer
+>> node - the node (y) for backward computation
+>> dedx - dE/dx given by MakeInputGrad()
+*/
+void XFuncGrad::AccumulateInputGrad(XTensor * node, XTensor * dedx)
+{
+    XTensor * input = node->income.tails[0];
+
+    if(dedx != input->grad){
+        _Sum(input->grad, dedx, input->grad);
+        DelTensorBuf(dedx);
     }
 
     node->visitMark = NODE_FINISHED;
 }
 
+/* 
+gradient for hardtanh: y = hardtanh(x)
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradHardTanH(XTensor * node, bool isEfficient)
+{
+    XTensor * dedx = MakeInputGrad(node);
+    XTensor * input = node->income.tails[0];
+
+    _HardTanHBackward(NULL, node, input, node->grad, dedx, NOLOSS);
+
+    AccumulateInputGrad(node, dedx);
+}
+
+/* 
+gradient for identity: y = x
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradIdentity(XTensor * node, bool isEfficient)
+{
+    XTensor * dedx = MakeInputGrad(node);
+    XTensor * input = node->income.tails[0];
+
+    _IdentityBackward(NULL, node, input, node->grad, dedx, NOLOSS);
+
+    AccumulateInputGrad(node, dedx);
+}
+
+/* 
+gradient for log-softmax: y = log(softmax(x))
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradLogSoftmax(XTensor * node, bool isEfficient)
+{
+    XTensor * dedx = MakeInputGrad(node);
+    XTensor * input = node->income.tails[0];
+
+    int leadDim = node->income.GetParamInt(0);
+    CheckNTErrors(leadDim >= 0 && leadDim < input->order, "wrong leading dimension in logsoftmax!");
+
+    _LogSoftmaxBackward(NULL, node, input, node->grad, dedx, NULL, leadDim, NOLOSS);
+
+    AccumulateInputGrad(node, dedx);
+}
+
+/* 
+gradient for rectify: y = max(0, x)
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradRectify(XTensor * node, bool isEfficient)
+{
+    XTensor * dedx = MakeInputGrad(node);
+    XTensor * input = node->income.tails[0];
+
+    _RectifyBackward(NULL, node, input, node->grad, dedx, NOLOSS);
+
+    AccumulateInputGrad(node, dedx);
+}
+
+/* 
+gradient for sigmoid: y = 1 / (1 + exp(-x))
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradSigmoid(XTensor * node, bool isEfficient)
+{
+    XTensor * dedx = MakeInputGrad(node);
+    XTensor * input = node->income.tails[0];
+
+    _SigmoidBackward(NULL, node, input, node->grad, dedx, NOLOSS);
+
+    AccumulateInputGrad(node, dedx);
+}
+
+/* 
+gradient for softmax: y = softmax(x). Unlike the other functions, it
+accumulates dE/dx in place
+>> node - the node (y) for backward computation
+>> isEfficient - indicates whether the computation is in
+                 an efficient manner
+*/
+void XFuncGrad::GradSoftmax(XTensor * node, bool isEfficient)
+{
+    XLink &income = node->income;
+
+    CheckNTErrors(node->grad != NULL, "No gradient found!");
+    CheckNTErrors(income.tailNum == 1, "Too many input tensors for the function!");
+
+    XTensor * input = income.tails[0];
+    DTYPE beta = XNoder::MakeGradToWrite(input);
+
+    int leadDim = income.GetParamInt(0);
+    CheckNTErrors(leadDim >= 0 && leadDim < input->order, "wrong leading dimension in softmax!");
+
+    _SoftmaxBackward(NULL, node, input, node->grad, input->grad, NULL, leadDim, NOLOSS, beta);
+
+    node->visitMark = NODE_FINISHED;
+}
+
 /* indicates whether the node is for an activation function */
 bool XFuncGrad::IsFunc(XTensor * node)
 {
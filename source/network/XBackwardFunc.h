@@ -33,13 +33,46 @@ namespace nts{
 class XFuncGrad
 {
 public:
-    /* compute dE/dx of a node */
+    /* register the gradient functions of the activation functions */
     static
-    void MakeGrad(XTensor * node, bool isEfficient);
+    void Register();
 
     /* indicates whether the node is for an activation function */
     static
     bool IsFunc(XTensor * node);
+
+private:
+    /* dE/dx of the input for the functions that overwrite dE/dx */
+    static
+    XTensor * MakeInputGrad(XTensor * node);
+
+    /* accumulate dE/dx of the input if it is computed on a buffer */
+    static
+    void AccumulateInputGrad(XTensor * node, XTensor * dedx);
+
+    /* gradient for hardtanh */
+    static
+    void GradHardTanH(XTensor * node, bool isEfficient);
+
+    /* gradient for identity */
+    static
+    void GradIdentity(XTensor * node, bool isEfficient);
+
+    /* gradient for log-softmax */
+    static
+    void GradLogSoftmax(XTensor * node, bool isEfficient);
+
+    /* gradient for rectify */
+    static
+    void GradRectify(XTensor * node, bool isEfficient);
+
+    /* gradient for sigmoid */
+    static
+    void GradSigmoid(XTensor * node, bool isEfficient);
+
+    /* gradient for softmax */
+    static
+    void GradSoftmax(XTensor * node, bool isEfficient);
 };
 
 }
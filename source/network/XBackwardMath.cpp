@@ -23,87 +23,44 @@
 #include "XNoder.h"
 #include "XBackwardMath.h"
 #include "../tensor/XName.h"
+#include "../tensor/XOperator.h"
 #include "../tensor/core/CHeader.h"
 
 namespace nts{
 
-/* compute dE/dx of a node */
-void XMathGrad::MakeGrad(XTensor * node, bool isEfficient)
+/* register the gradient functions of the math operations (see XOperator.h) */
+void XMathGrad::Register()
 {
-    if(!isEfficient){
-        CheckNTErrors(node->grad != NULL, "No gradient found!");
-    }
-    else{
-        CheckNTErrors(!node->isGrad || node->grad != NULL, "No gradient found!");
-    }
-
-    XLink &income = node->income;
-    int operID = income.typeID;
-
-    if(operID == MATH_ABSOLUTE)
-        GradAbsolute(node, isEfficient);
-    else if(operID == MATH_COS)
-        GradCos(node, isEfficient);
-    else if(operID == MATH_EXP)
-        GradExp(node, isEfficient);
-    else if(operID == MATH_LOG)
-        GradLog(node, isEfficient);
-    else if(operID == MATH_ROUND)
-        GradRound(node, isEfficient);
-    else if(operID == MATH_SIGN)
-        GradSign(node, isEfficient);
-    else if(operID == MATH_SIN)
-        GradSin(node, isEfficient);
-    else if(operID == MATH_TAN)
-        GradTan(node, isEfficient);
-
-    else if(operID == MATH_CLIP)
-        GradClip(node, isEfficient);
-    else if(operID == MATH_DIV)
-        GradDiv(node, isEfficient);
-    else if(operID == MATH_DIVDIM)
-        GradDivDim(node, isEfficient);
-    else if(operID == MATH_MATRIXMUL)
-        GradMatrixMul(node, isEfficient);
-    else if(operID == MATH_MATRIXMULBATCHED)
-        GradMatrixMulBatched(node, isEfficient);
-    else if(operID == MATH_MULTIPLY)
-        GradMultiply(node, isEfficient);
-    else if(operID == MATH_MULTIPLYDIM)
-        GradMultiplyDim(node, isEfficient);
-    else if (operID == MATH_MULTIPLYBROADCAST)
-        GradMultiplyBroadcast(node, isEfficient);
-    else if(operID == MATH_NEGATE)
-        GradNegate(node, isEfficient);
-    else if(operID == MATH_NORMALIZE)
-        GradNormalize(node, isEfficient);
-    else if(operID == MATH_POWER)
-        GradPower(node, isEfficient);
-    else if(operID == MATH_SCALEANDSHIFT)
-        GradScaleAndShift(node, isEfficient);
-    else if(operID == MATH_SUB)
-        GradSub(node, isEfficient);
-    else if(operID == MATH_SUBDIM)
-        GradSubDim(node, isEfficient);
-    else if(operID == MATH_SUM)
-        GradSum(node, isEfficient);
-    else if(operID == MATH_SUMDIM)
-        GradSumDim(node, isEfficient);
-    else if(operID == MATH_SUMBROADCAST)
-        GradSumBroadcast(node, isEfficient);
-    else if(operID == REDUCE_REDUCEMEAN)
-        GradReduceMean(node, isEfficient);
-    else if(operID == REDUCE_REDUCESUM)
-        GradReduceSum(node, isEfficient);
-    else if(operID == REDUCE_REDUCESUMSQUARED)
-        GradReduceSumSquared(node, isEfficient);
-    else if(operID == REDUCE_REDUCEVARIANCE)
-        GradReduceVariance(node, isEfficient);
-    else if (operID == MATH_MULANDSHIFT)
-        GradMulAndShift(node, isEfficient);
-    else{
-        ShowNTErrors("TODO!");
-    }
+    GOPs.SetBackward(MATH_ABSOLUTE,           GradAbsolute);
+    GOPs.SetBackward(MATH_COS,                GradCos);
+    GOPs.SetBackward(MATH_EXP,                GradExp);
+    GOPs.SetBackward(MATH_LOG,                GradLog);
+    GOPs.SetBackward(MATH_ROUND,              GradRound);
+    GOPs.SetBackward(MATH_SIGN,               GradSign);
+    GOPs.SetBackward(MATH_SIN,                GradSin);
+    GOPs.SetBackward(MATH_TAN,                GradTan);
+    GOPs.SetBackward(MATH_CLIP,               GradClip);
+    GOPs.SetBackward(MATH_DIV,                GradDiv);
+    GOPs.SetBackward(MATH_DIVDIM,             GradDivDim);
+    GOPs.SetBackward(MATH_MATRIXMUL,          GradMatrixMul);
+    GOPs.SetBackward(MATH_MATRIXMULBATCHED,   GradMatrixMulBatched);
+    GOPs.SetBackward(MATH_MULTIPLY,           GradMultiply);
+    GOPs.SetBackward(MATH_MULTIPLYDIM,        GradMultiplyDim);
+    GOPs.SetBackward(MATH_MULTIPLYBROADCAST,  GradMultiplyBroadcast);
+    GOPs.SetBackward(MATH_NEGATE,             GradNegate);
+    GOPs.SetBackward(MATH_NORMALIZE,          GradNormalize);
+    GOPs.SetBackward(MATH_POWER,              GradPower);
+    GOPs.SetBackward(MATH_SCALEANDSHIFT,      GradScaleAndShift);
+    GOPs.SetBackward(MATH_SUB,                GradSub);
+    GOPs.SetBackward(MATH_SUBDIM,             GradSubDim);
+    GOPs.SetBackward(MATH_SUM,                GradSum);
+    GOPs.SetBackward(MATH_SUMDIM,             GradSumDim);
+    GOPs.SetBackward(MATH_SUMBROADCAST,       GradSumBroadcast);
+    GOPs.SetBackward(REDUCE_REDUCEMEAN,       GradReduceMean);
+    GOPs.SetBackward(REDUCE_REDUCESUM,        GradReduceSum);
+    GOPs.SetBackward(REDUCE_REDUCESUMSQUARED, GradReduceSumSquared);
+    GOPs.SetBackward(REDUCE_REDUCEVARIANCE,   GradReduceVariance);
+    GOPs.SetBackward(MATH_MULANDSHIFT,        GradMulAndShift);
 }
 
 /* indicates whether the node is for a math operation */
@@ -132,10 +89,10 @@ void XMathGrad::GradAbsolute(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Sign(a, b);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -160,11 +117,11 @@ void XMathGrad::GradCos(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Sin(a, b);
     _ScaleAndShiftMe(b, -1.0F);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -189,10 +146,10 @@ void XMathGrad::GradExp(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Exp(a, b);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -216,9 +173,9 @@ void XMathGrad::GradLog(XTensor * node, bool isEfficient)
 
     XTensor * a = income.tails[0];
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
-    _Div(node->grad, a, a->grad, 1.0F);
+    _Div(node->grad, a, a->grad, beta);
 
     node->visitMark = NODE_FINISHED;
 }
@@ -283,10 +240,10 @@ void XMathGrad::GradSin(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Cos(a, b);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -311,11 +268,11 @@ void XMathGrad::GradTan(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Cos(a, b);
     _PowerMe(b, -2.0F);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -515,10 +472,13 @@ void XMathGrad::GradMatrixMul(XTensor * node, bool isEfficient)
     MATRIX_TRANS_TYPE transB = income.GetParamTrans(1);
     DTYPE alpha = income.GetParam(2);
 
+    DTYPE betaA = 1.0F;
+    DTYPE betaB = 1.0F;
+
     if(!isEfficient || a->isGrad)
-        XNoder::MakeGrad(a);
+        betaA = XNoder::MakeGradToWrite(a);
     if(!isEfficient || b->isGrad)
-        XNoder::MakeGrad(b);
+        betaB = XNoder::MakeGradToWrite(b);
 
     XTensor * c = node;
     XTensor * dedc = node->grad;
@@ -526,7 +486,7 @@ void XMathGrad::GradMatrixMul(XTensor * node, bool isEfficient)
     XTensor * dedb = b->grad;
     
     if(a->order == 2 && b->order == 2)
-        GradMatrixMul(a, deda, transA, b, dedb, transB, dedc, alpha, isEfficient);
+        GradMatrixMul(a, deda, transA, b, dedb, transB, dedc, alpha, betaA, betaB, isEfficient);
     else if(transA == X_NOTRANS && a->order > 2 && b->order == 2){
         int orderBackupA = a->order;
         int orderBackupC = c->order;
@@ -541,7 +501,7 @@ void XMathGrad::GradMatrixMul(XTensor * node, bool isEfficient)
             deda->Reshape(deda->unitNum/deda->GetDim(-1), deda->GetDim(-1));
         dedc->Reshape(dedc->unitNum/dedc->GetDim(-1), dedc->GetDim(-1));
 
-        GradMatrixMul(a, deda, transA, b, dedb, transB, dedc, alpha, isEfficient);
+        GradMatrixMul(a, deda, transA, b, dedb, transB, dedc, alpha, betaA, betaB, isEfficient);
 
         a->Reshape(orderBackupA, dimsBackupA);
         c->Reshape(orderBackupC, dimsBackupC);
@@ -564,23 +524,27 @@ gradient for matrix multiply: c = matmul(a, b) * \alpha
 >> dedb - dE/db
 >> dedc - dE/dc
 >> alpha - the scalar
+>> betaA - the coefficient of dE/da, i.e., dE/da = dE/da * betaA + the result
+           (betaA = 0 means that we overwrite dE/da)
+>> betaB - the coefficient of dE/db
 >> isEfficient - indicates whether the computation is in
                  an efficient manner
 */
 void XMathGrad::GradMatrixMul(XTensor * a, XTensor * deda, MATRIX_TRANS_TYPE transA,
                               XTensor * b, XTensor * dedb, MATRIX_TRANS_TYPE transB,
-                              XTensor * dedc, DTYPE alpha, bool isEfficient)
+                              XTensor * dedc, DTYPE alpha, DTYPE betaA, DTYPE betaB, 
+                              bool isEfficient)
 {
     /* c = a * b * \alpha */
     if(transA == X_NOTRANS && transB == X_NOTRANS){
         
         /* dE/da = dE/dc * b^T * \alpha */
         if(!isEfficient || a->isGrad)
-            _MatrixMul(dedc, X_NOTRANS, b, X_TRANS, deda, alpha, 1.0F);
+            _MatrixMul(dedc, X_NOTRANS, b, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = a^T * dE/dc * \alpha */
         if(!isEfficient || b->isGrad)
-            _MatrixMul(a, X_TRANS, dedc, X_NOTRANS, dedb, alpha, 1.0F);
+            _MatrixMul(a, X_TRANS, dedc, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a^T * b * \alpha */
@@ -589,11 +553,11 @@ void XMathGrad::GradMatrixMul(XTensor * a, XTensor * deda, MATRIX_TRANS_TYPE tra
         /* dE/da = (dE/dc * b^T)^T * \alpha 
                  = b * dE/dc^T * \alpha */
         if(!isEfficient || a->isGrad)
-            _MatrixMul(b, X_NOTRANS, dedc, X_TRANS, deda, alpha, 1.0F);
+            _MatrixMul(b, X_NOTRANS, dedc, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = a * dE/dc * \alpha */
         if(!isEfficient || b->isGrad)
-            _MatrixMul(a, X_NOTRANS, dedc, X_NOTRANS, dedb, alpha, 1.0F);
+            _MatrixMul(a, X_NOTRANS, dedc, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a * b^T * \alpha */
@@ -601,12 +565,12 @@ void XMathGrad::GradMatrixMul(XTensor * a, XTensor * deda, MATRIX_TRANS_TYPE tra
         
         /* dE/da = dE/dc * b * \alpha */
         if(!isEfficient || a->isGrad)
-            _MatrixMul(dedc, X_NOTRANS, b, X_NOTRANS, deda, alpha, 1.0F);
+            _MatrixMul(dedc, X_NOTRANS, b, X_NOTRANS, deda, alpha, betaA);
         
         /* dE/db = (a^T * dE/dc)^T * \alpha 
                  = dE/dc^T * a * \alpha */
         if(!isEfficient || b->isGrad)
-            _MatrixMul(dedc, X_TRANS, a, X_NOTRANS, dedb, alpha, 1.0F);
+            _MatrixMul(dedc, X_TRANS, a, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a^T * b^T * \alpha */
@@ -615,12 +579,12 @@ void XMathGrad::GradMatrixMul(XTensor * a, XTensor * deda, MATRIX_TRANS_TYPE tra
         /* dE/da = (dE/dc * b)^T * \alpha 
                  = b^T * dE/dc^T * \alpha */
         if(!isEfficient || a->isGrad)
-            _MatrixMul(b, X_TRANS, dedc, X_TRANS, deda, alpha, 1.0F);
+            _MatrixMul(b, X_TRANS, dedc, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = (a * dE/dc)^T * \alpha 
                  = dE/dc^T * a^T * \alpha */
         if(!isEfficient || b->isGrad)
-            _MatrixMul(dedc, X_TRANS, a, X_TRANS, dedb, alpha, 1.0F);
+            _MatrixMul(dedc, X_TRANS, a, X_TRANS, dedb, alpha, betaB);
     }
 }
 
@@ -647,8 +611,8 @@ void XMathGrad::GradMatrixMulBatched(XTensor * node, bool isEfficient)
     MATRIX_TRANS_TYPE transB = income.GetParamTrans(1);
     DTYPE alpha = income.GetParam(2);
 
-    XNoder::MakeGrad(a);
-    XNoder::MakeGrad(b);
+    DTYPE betaA = XNoder::MakeGradToWrite(a);
+    DTYPE betaB = XNoder::MakeGradToWrite(b);
 
     XTensor * dedc = node->grad;
     XTensor * deda = a->grad;
@@ -658,10 +622,10 @@ void XMathGrad::GradMatrixMulBatched(XTensor * node, bool isEfficient)
     if(transA == X_NOTRANS && transB == X_NOTRANS){
         
         /* dE/da = dE/dc * b^T * \alpha */
-        _MatrixMulBatched(dedc, X_NOTRANS, b, X_TRANS, deda, alpha, 1.0F);
+        _MatrixMulBatched(dedc, X_NOTRANS, b, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = a^T * dE/dc * \alpha */
-        _MatrixMulBatched(a, X_TRANS, dedc, X_NOTRANS, dedb, alpha, 1.0F);
+        _MatrixMulBatched(a, X_TRANS, dedc, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a^T * b * \alpha */
@@ -669,21 +633,21 @@ void XMathGrad::GradMatrixMulBatched(XTensor * node, bool isEfficient)
         
         /* dE/da = (dE/dc * b^T)^T * \alpha 
                  = b * dE/dc^T * \alpha */
-        _MatrixMulBatched(b, X_NOTRANS, dedc, X_TRANS, deda, alpha, 1.0F);
+        _MatrixMulBatched(b, X_NOTRANS, dedc, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = a * dE/dc * \alpha */
-        _MatrixMulBatched(a, X_NOTRANS, dedc, X_NOTRANS, dedb, alpha, 1.0F);
+        _MatrixMulBatched(a, X_NOTRANS, dedc, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a * b^T * \alpha */
     else if(transA == X_NOTRANS && transB == X_TRANS){
         
         /* dE/da = dE/dc * b * \alpha */
-        _MatrixMulBatched(dedc, X_NOTRANS, b, X_NOTRANS, deda, alpha, 1.0F);
+        _MatrixMulBatched(dedc, X_NOTRANS, b, X_NOTRANS, deda, alpha, betaA);
         
         /* dE/db = (a^T * dE/dc)^T * \alpha 
                  = dE/dc^T * a * \alpha */
-        _MatrixMulBatched(dedc, X_TRANS, a, X_NOTRANS, dedb, alpha, 1.0F);
+        _MatrixMulBatched(dedc, X_TRANS, a, X_NOTRANS, dedb, alpha, betaB);
     }
     
     /* c = a^T * b^T * \alpha */
@@ -691,11 +655,11 @@ void XMathGrad::GradMatrixMulBatched(XTensor * node, bool isEfficient)
         
         /* dE/da = (dE/dc * b)^T * \alpha 
                  = b^T * dE/dc^T * \alpha */
-        _MatrixMulBatched(b, X_TRANS, dedc, X_TRANS, deda, alpha, 1.0F);
+        _MatrixMulBatched(b, X_TRANS, dedc, X_TRANS, deda, alpha, betaA);
         
         /* dE/db = (a * dE/dc)^T * \alpha 
                  = dE/dc^T * a^T * \alpha */
-        _MatrixMulBatched(dedc, X_TRANS, a, X_TRANS, dedb, alpha, 1.0F);
+        _MatrixMulBatched(dedc, X_TRANS, a, X_TRANS, dedb, alpha, betaB);
     }
 
     node->visitMark = NODE_FINISHED;
@@ -719,12 +683,14 @@ void XMathGrad::GradMultiply(XTensor * node, bool isEfficient)
 
     XTensor * a = income.tails[0]; 
     XTensor * b = income.tails[1];
-    XNoder::MakeGrad(a);
-    XNoder::MakeGrad(b);
 
     CheckNTErrors(XTensor::IsSameShaped(a, b), "Wrong sized input tensors!");
-    _Multiply(node->grad, b, a->grad, 1.0F);
-    _Multiply(node->grad, a, b->grad, 1.0F);
+
+    DTYPE betaA = XNoder::MakeGradToWrite(a);
+    _Multiply(node->grad, b, a->grad, betaA);
+
+    DTYPE betaB = XNoder::MakeGradToWrite(b);
+    _Multiply(node->grad, a, b->grad, betaB);
 
     node->visitMark = NODE_FINISHED;
 }
@@ -748,11 +714,12 @@ void XMathGrad::GradMultiplyDim(XTensor * node, bool isEfficient)
     XTensor * a = income.tails[0];
     XTensor * b = income.tails[1];
     int n = income.GetParamInt(0);
-    XNoder::MakeGrad(a);
-    XNoder::MakeGrad(b);
 
     /* dE/da */
-    _MultiplyDim(node->grad, b, a->grad, n, 1.0F);
+    DTYPE betaA = XNoder::MakeGradToWrite(a);
+    _MultiplyDim(node->grad, b, a->grad, n, betaA);
+
+    DTYPE betaB = XNoder::MakeGradToWrite(b);
 	
 	/* dE/db */
     int order = a->order;
@@ -771,17 +738,7 @@ void XMathGrad::GradMultiplyDim(XTensor * node, bool isEfficient)
            size of b. Then we can reduce the matrix into a row vector. */
         bGradTMP->Reshape(2, reshapedSize);
 
-        //if(b->outgo.tailNum > 1){
-            XTensor * bGradTMP2 = NewTensorBuf(b->grad, b->devID, b->mem);
-
-            _ReduceSum(bGradTMP, bGradTMP2, 0);
-            _Sum(b->grad, bGradTMP2, b->grad);
-
-            DelTensorBuf(bGradTMP2);
-        /*}
-        else{
-            _ReduceSum(bGradTMP, b->grad, 0);
-        }*/
+        _ReduceSum(bGradTMP, b->grad, 0, NULL, 1.0F, false, betaB);
     }
     else{
         int reshapedSize[MAX_TENSOR_DIM_NUM];
@@ -803,17 +760,7 @@ void XMathGrad::GradMultiplyDim(XTensor * node, bool isEfficient)
         XTensor * interGrad = NewTensorBuf(2, reshapedSize, b->dataType, b->denseRatio, b->devID, b->mem);
         _ReduceSum(bGradTMP, interGrad, 2);
 
-        //if(b->outgo.tailNum > 1){
-            XTensor * bGradTMP2 = NewTensorBuf(b->grad, b->devID, b->mem);
-
-            _ReduceSum(interGrad, bGradTMP2, 0);
-            _Sum(b->grad, bGradTMP2, b->grad);
-
-            DelTensorBuf(bGradTMP2);
-        /*}
-        else{
-            _ReduceSum(interGrad, b->grad, 0);
-        }*/
+        _ReduceSum(interGrad, b->grad, 0, NULL, 1.0F, false, betaB);
 
         DelTensorBuf(interGrad);
     }
@@ -993,11 +940,11 @@ void XMathGrad::GradPower(XTensor * node, bool isEfficient)
 
     DTYPE p = income.GetParam(0);
 
-    XNoder::MakeGrad(a);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
 
     _Power(a, b, p - 1.0F);
     _ScaleAndShiftMe(b, p);
-    _Multiply(node->grad, b, a->grad, 1.0F);
+    _Multiply(node->grad, b, a->grad, beta);
 
     DelTensorBuf(b);
 
@@ -1180,13 +1127,15 @@ void XMathGrad::GradSum(XTensor * node, bool isEfficient)
     DTYPE beta = income.GetParam(0);
 
     if(!isEfficient || a->isGrad){
-        XNoder::MakeGrad(a);
-        _Sum(a->grad, node->grad, a->grad);
+        DTYPE betaA = XNoder::MakeGradToWrite(a);
+        _Sum(node->grad, a->grad, a->grad, betaA);
     }
 
     if(!isEfficient || b->isGrad){
-        XNoder::MakeGrad(b);
-        _Sum(b->grad, node->grad, b->grad, beta);
+        if(XNoder::MakeGradToWrite(b) == 0)
+            _ScaleAndShift(node->grad, b->grad, beta);
+        else
+            _Sum(b->grad, node->grad, b->grad, beta);
     }
 
     node->visitMark = NODE_FINISHED;
@@ -1212,10 +1161,16 @@ void XMathGrad::GradSumDim(XTensor * node, bool isEfficient)
     XTensor * b = income.tails[1];
     int n = income.GetParamInt(0);
     DTYPE beta = income.GetParam(1);
-    XNoder::MakeGrad(a);
-    XNoder::MakeGrad(b);
 
-    _Sum(a->grad, node->grad, a->grad);
+    DTYPE betaA = XNoder::MakeGradToWrite(a);
+    _Sum(node->grad, a->grad, a->grad, betaA);
+
+    /* we reduce dE/dc into dE/db directly if there is no scaling */
+    DTYPE betaB = 1.0F;
+    if(beta == 1.0F)
+        betaB = XNoder::MakeGradToWrite(b);
+    else
+        XNoder::MakeGrad(b);
 
     int order = a->order;
     int dimSize[MAX_TENSOR_DIM_NUM];
@@ -1230,19 +1185,15 @@ void XMathGrad::GradSumDim(XTensor * node, bool isEfficient)
            size of b. Then we can reduce the matrix into a row vector. */
         node->grad->Reshape(2, reshapedSize);
 
-        //if(b->outgo.tailNum > 1){
+        if(beta == 1.0F)
+            _ReduceSum(node->grad, b->grad, 0, NULL, 1.0F, false, betaB);
+        else{
             XTensor * bGradTMP = NewTensorBuf(b->grad, b->devID, b->mem);
             _ReduceSum(node->grad, bGradTMP, 0);
-            if(beta != 1.0F)
-                _ScaleAndShiftMe(bGradTMP, beta);
+            _ScaleAndShiftMe(bGradTMP, beta);
             _Sum(bGradTMP, b->grad, b->grad);
             DelTensorBuf(bGradTMP);
-        /*}
-        else{
-            _ReduceSum(node->grad, b->grad, 0);
-            if(beta != 1.0F)
-                _ScaleAndShiftMe(b->grad, beta);
-        }*/
+        }
 
         node->grad->Reshape(order, dimSize);
     }
@@ -1267,19 +1218,15 @@ void XMathGrad::GradSumDim(XTensor * node, bool isEfficient)
 
         _ReduceSum(node->grad, interGrad, 2);
 
-        //if(b->outgo.tailNum > 1){
+        if(beta == 1.0F)
+            _ReduceSum(interGrad, b->grad, 0, NULL, 1.0F, false, betaB);
+        else{
             XTensor * bGradTMP = NewTensorBuf(b->grad, b->devID, b->mem);
             _ReduceSum(interGrad, bGradTMP, 0);
-            if(beta != 1.0F)
-                _ScaleAndShiftMe(bGradTMP, beta);
+            _ScaleAndShiftMe(bGradTMP, beta);
             _Sum(bGradTMP, b->grad, b->grad);
             DelTensorBuf(bGradTMP);
-        /*}
-        else{
-            _ReduceSum(interGrad, b->grad, 0);
-            if(beta != 1.0F)
-                _ScaleAndShiftMe(b->grad, beta);
-        }*/
+        }
 
         node->grad->Reshape(order, dimSize);
 
@@ -1338,18 +1285,20 @@ void XMathGrad::GradReduceMean(XTensor * node, bool isEfficient)
     CheckNTErrors(income.tailNum == 1, "Wrong input tensor number for Reduce!");
 
     XTensor * a = income.tails[0];
-    XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
     int dim = income.GetParamInt(0);
     int n = a->GetDim(dim);
 
-    XNoder::MakeGrad(a);
-
-    _Unsqueeze(node->grad, b, dim, n);
-    _ScaleAndShiftMe(b, 1.0F/n);
-    _Sum(a->grad, b, a->grad);
-
-    DelTensorBuf(b);
+    if(XNoder::MakeGradToWrite(a) == 0){
+        _Unsqueeze(node->grad, a->grad, dim, n);
+        _ScaleAndShiftMe(a->grad, 1.0F/n);
+    }
+    else{
+        XTensor * b = NewTensorBuf(a, a->devID, a->mem);
+        _Unsqueeze(node->grad, b, dim, n);
+        _Sum(a->grad, b, a->grad, 1.0F/n);
+        DelTensorBuf(b);
+    }
 
     node->visitMark = NODE_FINISHED;
 }
@@ -1371,17 +1320,12 @@ void XMathGrad::GradReduceSum(XTensor * node, bool isEfficient)
     CheckNTErrors(income.tailNum == 1, "Wrong input tensor number for Reduce!");
 
     XTensor * a = income.tails[0];
-    XTensor * b = NewTensorBuf(a, a->devID, a->mem);
 
     int dim = income.GetParamInt(0);
     int n = a->GetDim(dim);
 
-    XNoder::MakeGrad(a);
-
-    _Unsqueeze(node->grad, b, dim, n);
-    _Sum(a->grad, b, a->grad);
-
-    DelTensorBuf(b);
+    DTYPE beta = XNoder::MakeGradToWrite(a);
+    _Unsqueeze(node->grad, a->grad, dim, n, beta);
 
     node->visitMark = NODE_FINISHED;
 }
@@ -1514,12 +1458,16 @@ void XMathGrad::GradMulAndShift(XTensor * node, bool isEfficient)
     MATRIX_TRANS_TYPE transW = income.GetParamTrans(1);
     MATRIX_TRANS_TYPE transX = income.GetParamTrans(2);
 
+    DTYPE betaW = 1.0F;
+    DTYPE betaX = 1.0F;
+    DTYPE betaB = 1.0F;
+
     if (!isEfficient || w->isGrad)
-        XNoder::MakeGrad(w);
+        betaW = XNoder::MakeGradToWrite(w);
     if (!isEfficient || x->isGrad)
-        XNoder::MakeGrad(x);
+        betaX = XNoder::MakeGradToWrite(x);
     if (!isEfficient || b->isGrad)
-        XNoder::MakeGrad(b);
+        betaB = XNoder::MakeGradToWrite(b);
 
     int order = node->order;
     int dimSize[MAX_TENSOR_DIM_NUM];
@@ -1535,10 +1483,7 @@ void XMathGrad::GradMulAndShift(XTensor * node, bool isEfficient)
         size of b. Then we can reduce the matrix into a row vector. */
         node->grad->Reshape(2, reshapedSize);
 
-        XTensor * bGradTMP = NewTensorBuf(b->grad, b->devID, b->mem);
-        _ReduceSum(node->grad, bGradTMP, 0);
-        _Sum(bGradTMP, b->grad, b->grad);
-        DelTensorBuf(bGradTMP);
+        _ReduceSum(node->grad, b->grad, 0, NULL, 1.0F, false, betaB);
 
         node->grad->Reshape(order, dimSize);
     }
@@ -1563,10 +1508,7 @@ void XMathGrad::GradMulAndShift(XTensor * node, bool isEfficient)
 
         _ReduceSum(node->grad, interGrad, 2);
 
-        XTensor * bGradTMP = NewTensorBuf(b->grad, b->devID, b->mem);
-        _ReduceSum(interGrad, bGradTMP, 0);
-        _Sum(bGradTMP, b->grad, b->grad);
-        DelTensorBuf(bGradTMP);
+        _ReduceSum(interGrad, b->grad, 0, NULL, 1.0F, false, betaB);
 
         node->grad->Reshape(order, dimSize);
 
@@ -1582,7 +1524,7 @@ void XMathGrad::GradMulAndShift(XTensor * node, bool isEfficient)
     XTensor * dedx = x->grad;
 
     if (x->order == 2 && w->order == 2)
-        GradMatrixMul(x, dedx, transX, w, dedw, transW, dedc, 1.0F, isEfficient);
+        GradMatrixMul(x, dedx, transX, w, dedw, transW, dedc, 1.0F, betaX, betaW, isEfficient);
     else if (transX == X_NOTRANS && x->order > 2 && w->order == 2){
         int orderBackupX = x->order;
         int orderBackupC = c->order;
@@ -1597,7 +1539,7 @@ void XMathGrad::GradMulAndShift(XTensor * node, bool isEfficient)
             dedx->Reshape(dedx->unitNum / dedx->GetDim(-1), dedx->GetDim(-1));
         dedc->Reshape(dedc->unitNum / dedc->GetDim(-1), dedc->GetDim(-1));
 
-        GradMatrixMul(x, dedx, transX, w, dedw, transW, dedc, 1.0F, isEfficient);
+        GradMatrixMul(x, dedx, transX, w, dedw, transW, dedc, 1.0F, betaX, betaW, isEfficient);
 
         x->Reshape(orderBackupX, dimsBackupX);
         c->Reshape(orderBackupC, dimsBackupC);
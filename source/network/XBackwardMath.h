@@ -31,9 +31,9 @@ namespace nts{
 class XMathGrad
 {
 public:
-    /* compute dE/dx of a node */
+    /* register the gradient functions of the operations */
     static
-    void MakeGrad(XTensor * node, bool isEfficient);
+    void Register();
 
     /* indicates whether the node is for a math operation */
     static
@@ -93,7 +93,8 @@ private:
     static
     void GradMatrixMul(XTensor * a, XTensor * deda, MATRIX_TRANS_TYPE transA,
                        XTensor * b, XTensor * dedb, MATRIX_TRANS_TYPE transB,
-                       XTensor * dedc, DTYPE alpha, bool isEfficient);
+                       XTensor * dedc, DTYPE alpha, DTYPE betaA, DTYPE betaB,
+                       bool isEfficient);
 
     /* gradient for matrix multiply in batch mode.
        for each batch: c_i = matmul(a_i, b_i) * \alpha */
@@ -25,41 +25,25 @@
 #include "XNoder.h"
 #include "XBackwardShape.h"
 #include "../tensor/XName.h"
+#include "../tensor/XOperator.h"
 #include "../tensor/XUtility.h"
 #include "../tensor/core/CHeader.h"
 #include "../tensor/core/getandset/SetData.h"
 
 namespace nts{
 
-/* compute dE/dx of a node */
-void XShapeGrad::MakeGrad(XTensor * node, bool isEfficent)
+/* register the gradient functions of the shaping and movement operations (see XOperator.h) */
+void XShapeGrad::Register()
 {
-    CheckNTErrors(node->grad != NULL, "No gradient found!");
-
-    XLink &income = node->income;
-    int operID = income.typeID;
-
-    if(operID == MOVEMENT_COPYINDEXED)
-        GradCopyIndexed(node, isEfficent);
-    else if(operID == MOVEMENT_GATHER)
-        GradGather(node, isEfficent);
-    else if(operID == SHAPE_MERGE)
-        GradMerge(node, isEfficent);
-    else if(operID == SHAPE_MERGE_LIST)
-        GradMergeList(node, isEfficent);
-    else if(operID == SHAPE_RESHAPE)
-        GradReshape(node, isEfficent);
-    else if(operID == SHAPE_SPLIT)
-        GradSplit(node, isEfficent);
-    else if(operID == SHAPE_SPLIT_LIST)
-        GradSplitList(node, isEfficent);
-    else if (operID == SHAPE_TRANSPOSE)
-        GradTranspose(node, isEfficent);
-    else if(operID == SHAPE_UNSQUEEZE)
-        GradUnsqueeze(node, isEfficent);
-    else{
-        ShowNTErrors("TODO!");
-    }
+    GOPs.SetBackward(MOVEMENT_COPYINDEXED, GradCopyIndexed);
+    GOPs.SetBackward(MOVEMENT_GATHER,      GradGather);
+    GOPs.SetBackward(SHAPE_MERGE,          GradMerge);
+    GOPs.SetBackward(SHAPE_MERGE_LIST,     GradMergeList);
+    GOPs.SetBackward(SHAPE_RESHAPE,        GradReshape);
+    GOPs.SetBackward(SHAPE_SPLIT,          GradSplit);
+    GOPs.SetBackward(SHAPE_SPLIT_LIST,     GradSplitList);
+    GOPs.SetBackward(SHAPE_TRANSPOSE,      GradTranspose);
+    GOPs.SetBackward(SHAPE_UNSQUEEZE,      GradUnsqueeze);
 }
 
 /* indicates whether the node is for a math operation */
@@ -123,6 +107,18 @@ void XShapeGrad::GradGather(XTensor * node, bool isEfficent)
 
     _SpreadForGather(input->grad, node->grad, index);
 
+    /* record the rows that receive the gradient */
+    if(input->gradRows != NULL){
+        if(index->devID < 0)
+            input->gradRows->Add((int*)index->data, index->unitNum);
+        else{
+            int * indexOnHost = new int[index->unitNum];
+            XMemCopy(indexOnHost, -1, index->data, index->devID, sizeof(int) * index->unitNum);
+            input->gradRows->Add(indexOnHost, index->unitNum);
+            delete[] indexOnHost;
+        }
+    }
+
     node->visitMark = NODE_FINISHED;
 }
 
@@ -160,7 +156,7 @@ void XShapeGrad::GradMerge(XTensor * node, bool isEfficent)
     }
     blockSize = input->GetDataSizeInChar() / blockNum;
 
-    XNoder::MakeGrad(input);
+    DTYPE beta = XNoder::MakeGradToWrite(input);
 
     int * dims = new int[input->order];
     memset(dims, 0, sizeof(int) * input->order);
@@ -179,29 +175,14 @@ void XShapeGrad::GradMerge(XTensor * node, bool isEfficent)
                           node->dataType, node->denseRatio, 
                           node->devID, node->mem);
 
-    /* we can simply split the gradient tensor 
-       if the input is used in merging only */
-    if(input->outgo.tailNum == 1){
-        for(int i = 0; i < blockNum; i++){
-            gradNodeSmall.data = (char*)node->grad->data + i * blockSize;
-            gradInputSmall.data = (char*)input->grad->data + i * blockSize;
-            _Split(&gradNodeSmall, &gradInputSmall, whereToMerge - leadDim - 1, input->dimSize[leadDim]);
-        }
-    }
-
-    /* a more complicated case is that the input tensor is used for 
-       other operations somewhere else. So we have to do gradient 
-       accumulation after spliting, i.e., we need an additional 
-       SUM operation */
-    else{
-        XTensor gradInputSmallBuf(&gradInputSmall);
-
-        for(int i = 0; i < blockNum; i++){
-            gradNodeSmall.data = (char*)node->grad->data + i * blockSize;
-            gradInputSmall.data = (char*)input->grad->data + i * blockSize;
-            _Split(&gradNodeSmall, &gradInputSmallBuf, whereToMerge - leadDim - 1, input->dimSize[leadDim]);
-            _Sum(&gradInputSmall, &gradInputSmallBuf, &gradInputSmall);
-        }
+    /* we split the gradient tensor into the gradient of the input. The 
+       result is accumulated (beta = 1) if the input is used for other 
+       operations somewhere else, and we simply overwrite the gradient 
+       (beta = 0) otherwise */
+    for(int i = 0; i < blockNum; i++){
+        gradNodeSmall.data = (char*)node->grad->data + i * blockSize;
+        gradInputSmall.data = (char*)input->grad->data + i * blockSize;
+        _Split(&gradNodeSmall, &gradInputSmall, whereToMerge - leadDim - 1, input->dimSize[leadDim], beta);
     }
 
     gradNodeSmall.data = NULL;
@@ -309,12 +290,15 @@ void XShapeGrad::GradReshape(XTensor * node, bool isEfficent)
 {
     XLink &income = node->income;
     XTensor * input = income.tails[0];
-    XNoder::MakeGrad(input);
+    DTYPE beta = XNoder::MakeGradToWrite(input);
 
     CheckNTErrors(income.tailNum == 1, "Wrong input tensor number for MERGE!");
 
     node->grad->Reshape(input->order, input->dimSize);
-    _CopyValues(node->grad, input->grad);
+    if(beta == 0)
+        _CopyValues(node->grad, input->grad);
+    else
+        _Sum(input->grad, node->grad, input->grad);
     node->grad->Reshape(node->order, node->dimSize);
 
     node->visitMark = NODE_FINISHED;
@@ -342,23 +326,10 @@ void XShapeGrad::GradSplit(XTensor * node, bool isEfficient)
     CheckNTErrors(node->order == input->order + 1, "Wrong tensor orders!");
     CheckNTErrors(splitNum == node->dimSize[0], "Wrong split number!");
 
-    XNoder::MakeGrad(input);
-
-    /* we can simply merge the gradient tensor 
-       if the input is used in spliting only */
-    if(input->outgo.tailNum == 1)
-        _Merge(node->grad, input->grad, whereToSplit + 1, 0);
-
-    /* if the tensor is used somewhere else, we need another SUM
-       for gradient accumulation */
-    else{
-        XTensor * inputGradTMP = NewTensorBuf(input, input->devID, input->mem);
-
-        _Merge(node->grad, inputGradTMP, whereToSplit + 1, 0);
-        _Sum(input->grad, inputGradTMP, input->grad);
-        
-        DelTensorBuf(inputGradTMP);
-    }
+    /* we merge the gradient tensor into the gradient of the input, 
+       and accumulate the result if the input is used somewhere else */
+    DTYPE beta = XNoder::MakeGradToWrite(input);
+    _Merge(node->grad, input->grad, whereToSplit + 1, 0, beta);
 
     node->visitMark = NODE_FINISHED;
 }
@@ -462,8 +433,7 @@ void XShapeGrad::GradTranspose(XTensor * node, bool isEfficient)
 
     XTensor * output = node;
     XTensor * input = income.tails[0];
-    XTensor * b = NewTensorBuf(input, input->devID, input->mem);
-    XNoder::MakeGrad(input);
+    DTYPE beta = XNoder::MakeGradToWrite(input);
 
     int i = income.GetParamInt(0);
     int j = income.GetParamInt(1);
@@ -471,10 +441,14 @@ void XShapeGrad::GradTranspose(XTensor * node, bool isEfficient)
     CheckNTErrors(input->order > i && i >= 0, "index of dimension is out of scope!");
     CheckNTErrors(input->order > j && j >= 0, "index of dimension is out of scope!");
 
-    _Transpose(output->grad, b, i, j);
-    _Sum(input->grad, b, input->grad);
-    
-    DelTensorBuf(b);
+    if(beta == 0)
+        _Transpose(output->grad, input->grad, i, j);
+    else{
+        XTensor * b = NewTensorBuf(input, input->devID, input->mem);
+        _Transpose(output->grad, b, i, j);
+        _Sum(input->grad, b, input->grad);
+        DelTensorBuf(b);
+    }
 
     node->visitMark = NODE_FINISHED;
 }
@@ -496,7 +470,6 @@ void XShapeGrad::GradUnsqueeze(XTensor * node, bool isEfficient)
 
     XTensor * output = node;
     XTensor * input = income.tails[0];
-    XNoder::MakeGrad(input);
 
     int dim = income.GetParamInt(0);
     int dSize = income.GetParamInt(1);
@@ -504,12 +477,8 @@ void XShapeGrad::GradUnsqueeze(XTensor * node, bool isEfficient)
     CheckNTErrors(dSize == output->GetDim(dim), "Wrong dim size for UNSQUEEZE!");
     CheckNTErrors(output->unitNum = input->unitNum * dSize, "Wrong tensor size!");
     
-    XTensor * g = NewTensorBuf(input->grad, input->devID, input->mem);
-    
-    _ReduceSum(output->grad, g, dim);
-    _Sum(input->grad, g, input->grad);
-    
-    DelTensorBuf(g);
+    DTYPE beta = XNoder::MakeGradToWrite(input);
+    _ReduceSum(output->grad, input->grad, dim, NULL, 1.0F, false, beta);
 
     node->visitMark = NODE_FINISHED;
 }
@@ -32,9 +32,9 @@ namespace nts{
 class XShapeGrad
 {
 public:
-    /* compute dE/dx of a node */
+    /* register the gradient functions of the operations */
     static
-    void MakeGrad(XTensor * node, bool isEfficent);
+    void Register();
 
     /* indicates whether the node is for a shaping operation */
     static
@@ -26,6 +26,8 @@
 #include "XBackwardFunc.h"
 #include "XBackwardShape.h"
 #include "../tensor/XName.h"
+#include "../tensor/XOperator.h"
+#include "../tensor/XGraphArena.h"
 
 namespace nts{
 
@@ -51,6 +53,21 @@ void XNetClearAll()
     MUTEX_DELE(netMutex);
 }
 
+/* register the gradient functions of the operators */
+static
+bool RegisterGrads()
+{
+    XMathGrad::Register();
+    XShapeGrad::Register();
+    XFuncGrad::Register();
+
+    return true;
+}
+
+/* the gradient functions are registered before main() runs, i.e., before
+   any thread starts (the registry of operators is not thread-safe) */
+static bool gradRegistered = RegisterGrads();
+
 /* constructor */
 XNet::XNet()
 {
@@ -63,13 +80,15 @@ XNet::~XNet()
 {
 }
 
-/* clear the network */
+/* clear the network. The memory of the edges is freed in one go 
+   if no edge of any network is in use */
 void XNet::Clear()
 {
     nodes.Clear();
     gradNodes.Clear();
     outputs.Clear();
     inputs.Clear();
+    GGraphArena.Rewind();
 }
 
 /* 
@@ -259,16 +278,15 @@ void XNet::BackwardNode(XTensor * node, bool isEfficent)
         /* post processing for parent nodes */
         BackwardNodePost(node, isEfficent);
 
-        /* process the current node */
-        if(XMathGrad::IsMathOP(node))
-            XMathGrad::MakeGrad(node, isEfficent);
-        else if(XFuncGrad::IsFunc(node))
-            XFuncGrad::MakeGrad(node, isEfficent);
-        else if(XShapeGrad::IsShapeOP(node))
-            XShapeGrad::MakeGrad(node, isEfficent);
+        if(!isEfficent){
+            CheckNTErrors(node->grad != NULL, "No gradient found!");
+        }
         else{
-            ShowNTErrors("Wrong node type!");
+            CheckNTErrors(!node->isGrad || node->grad != NULL, "No gradient found!");
         }
+
+        /* process the current node by the gradient function of its operator */
+        GOPs.Backward(node, isEfficent);
     }
     else{
         node->visitMark = NODE_FINISHED;
@@ -314,7 +332,12 @@ depth-first search (Tarjan's algorithm)
 void XNet::Traverse(XList &roots)
 {
     id = MakeNetID();
+
+    /* the lists are made again for the new order (their arrays are reused) */
     nodes.Clear();
+    gradNodes.Clear();
+    outputs.Clear();
+    inputs.Clear();
  
     for (int i = 0; i < roots.count; i++)
         TarjanVisit((XTensor*)roots.Get(i), nodes, id);
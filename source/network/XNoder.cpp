@@ -36,6 +36,34 @@ void XNoder::MakeGrad(XTensor * node)
     }
 }
 
+/* 
+make gradient tensor for a node that is to be written by a backward 
+function. If the gradient is newly created and the node is used by only
+one node (i.e., the gradient is written once), we do not need to
+initialize it and the backward function can write the result on it
+directly. Otherwise, the result is accumulated into the gradient.
+>> node - the node
+<< return - the coefficient of the old gradient, i.e., 
+            grad = result + grad * return
+*/
+DTYPE XNoder::MakeGradToWrite(XTensor * node)
+{
+    if(node == NULL)
+        return 1.0F;
+
+    if(!XTensor::IsSameShaped(node, node->grad) && 
+       node->outgo.tailNum == 1 && node->gradRows == NULL)
+    {
+        delete node->grad;
+        node->grad = NewTensor(node);
+        return 0;
+    }
+
+    MakeGrad(node);
+
+    return 1.0F;
+}
+
 /* the node is a leaf node (intput) or not */
 bool XNoder::IsLeaf(XTensor * node)
 {
@@ -39,6 +39,11 @@ public:
     static
     void MakeGrad(XTensor * node);
 
+    /* make gradient tensor for a node that is to be written by a
+       backward function, and return the coefficient of the old gradient */
+    static
+    DTYPE MakeGradToWrite(XTensor * node);
+
     /* the node is a leaf node (intput) or not */
     static
     bool IsLeaf(XTensor * node);
@@ -0,0 +1,590 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The optimizer that updates model parameters over flat buffers.
+ *
+ */
+
+#include <math.h>
+#include "XOptimizer.h"
+#include "XNoder.h"
+#include "../tensor/XUtility.h"
+#include "../tensor/core/CHeader.h"
+#include "../tensor/core/utilities/XMatrixSegment.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace nts{
+
+/* constructor */
+XOptimizer::XOptimizer()
+{
+    type = OPTIMIZER_SGD;
+    adamBeta1 = 0.9F;
+    adamBeta2 = 0.98F;
+    adamDelta = 1e-9F;
+    adamBeta1T = 1.0F;
+    adamBeta2T = 1.0F;
+    momentum = 0;
+    clipNorm = 0;
+    gradNorm = 0;
+    parallelRunner = NULL;
+    flatSize = 0;
+    flatPara = NULL;
+    flatGrad = NULL;
+    flatMoment = NULL;
+    flatMoment2nd = NULL;
+}
+
+/* 
+de-constructor. Note that the packed parameters keep pointers to the flat 
+buffers, i.e., the optimizer should not be destroyed before the parameters 
+are used up. 
+*/
+XOptimizer::~XOptimizer()
+{
+    Clear();
+}
+
+/* release the buffers */
+void XOptimizer::Clear()
+{
+    delete[] flatPara;
+    delete[] flatGrad;
+    delete[] flatMoment;
+    delete[] flatMoment2nd;
+    flatPara = NULL;
+    flatGrad = NULL;
+    flatMoment = NULL;
+    flatMoment2nd = NULL;
+    flatSize = 0;
+
+    for(int i = 0; i < otherMoments.count; i++)
+        delete (XTensor*)otherMoments.Get(i);
+    for(int i = 0; i < otherMoments2nd.count; i++)
+        delete (XTensor*)otherMoments2nd.Get(i);
+
+    others.Clear();
+    otherMoments.Clear();
+    otherMoments2nd.Clear();
+}
+
+/* 
+use sgd 
+>> myMomentum - momentum (0 means the vanilla sgd)
+*/
+void XOptimizer::SetSGD(float myMomentum)
+{
+    type = OPTIMIZER_SGD;
+    momentum = myMomentum;
+}
+
+/* 
+use adam 
+>> myBeta1 - decay rate of the 1st order moment
+>> myBeta2 - decay rate of the 2nd order moment
+>> myDelta - a small number for numerical stability
+*/
+void XOptimizer::SetAdam(float myBeta1, float myBeta2, float myDelta)
+{
+    type = OPTIMIZER_ADAM;
+    adamBeta1 = myBeta1;
+    adamBeta2 = myBeta2;
+    adamDelta = myDelta;
+}
+
+/* 
+set the maximum global norm of the gradient. The gradient is scaled 
+down if its norm (over all parameters) is larger than this value.
+>> myClipNorm - the maximum norm (<= 0 means no clipping)
+*/
+void XOptimizer::SetClipNorm(float myClipNorm)
+{
+    clipNorm = myClipNorm;
+}
+
+/* check whether a parameter can be kept in the flat buffer */
+bool XOptimizer::IsPackable(XTensor * para)
+{
+    XTensor * grad = para->grad;
+
+    return para->devID < 0 && para->mem == NULL && 
+           para->dataType == DEFAULT_DTYPE && !para->isSparse && !para->isShared &&
+           para->gradRows == NULL && grad != NULL && 
+           grad->devID < 0 && grad->mem == NULL && !grad->isShared;
+}
+
+/* 
+initialize the optimizer. The parameters (and gradients) on the CPU are 
+moved into the flat buffers, so call SetSGD or SetAdam before this.
+>> myParams - the parameters
+>> myParallelRunner - parallel runner
+*/
+void XOptimizer::Init(XList &myParams, XPRunner * myParallelRunner)
+{
+    /* give the parameters of the last initialization their own memory */
+    for(int i = 0; i < params.count && flatPara != NULL; i++){
+        XTensor * para = (XTensor*)params.Get(i);
+        XTensor * grads[2] = {para, para->grad};
+        for(int k = 0; k < 2; k++){
+            XTensor * t = grads[k];
+            if(t == NULL || !t->isShared)
+                continue;
+            void * data = XMemAlloc(t->devID, t->unitNum * t->unitSize);
+            memcpy(data, t->data, t->unitNum * t->unitSize);
+            t->data = data;
+            t->isShared = false;
+        }
+    }
+
+    Clear();
+
+    params.Clear();
+    parallelRunner = myParallelRunner;
+    adamBeta1T = 1.0F;
+    adamBeta2T = 1.0F;
+
+    bool useMoment = type == OPTIMIZER_ADAM || momentum > 0;
+    bool useMoment2nd = type == OPTIMIZER_ADAM;
+
+    for(int i = 0; i < myParams.count; i++){
+        XTensor * para = (XTensor*)myParams.Get(i);
+        CheckNTErrors(para != NULL, "NULL parameter tensor!");
+
+        XNoder::MakeGrad(para);
+        params.Add(para);
+
+        if(IsPackable(para)){
+            flatSize += (para->unitNum + OPTIMIZER_ALIGNMENT - 1) / OPTIMIZER_ALIGNMENT * OPTIMIZER_ALIGNMENT;
+        }
+        else{
+            others.Add(para);
+
+            XTensor * m = NULL;
+            XTensor * m2 = NULL;
+            if(useMoment){
+                m = new XTensor(para);
+                m->SetZeroAll();
+            }
+            if(useMoment2nd){
+                m2 = new XTensor(para);
+                m2->SetZeroAll();
+            }
+            otherMoments.Add(m);
+            otherMoments2nd.Add(m2);
+        }
+    }
+
+    if(flatSize == 0)
+        return;
+
+    flatPara = new DTYPE[flatSize];
+    flatGrad = new DTYPE[flatSize];
+    memset(flatPara, 0, sizeof(DTYPE) * flatSize);
+    memset(flatGrad, 0, sizeof(DTYPE) * flatSize);
+
+    if(useMoment){
+        flatMoment = new DTYPE[flatSize];
+        memset(flatMoment, 0, sizeof(DTYPE) * flatSize);
+    }
+    if(useMoment2nd){
+        flatMoment2nd = new DTYPE[flatSize];
+        memset(flatMoment2nd, 0, sizeof(DTYPE) * flatSize);
+    }
+
+    /* move the parameters and the gradients into the flat buffers */
+    int offset = 0;
+    for(int i = 0; i < params.count; i++){
+        XTensor * para = (XTensor*)params.Get(i);
+
+        if(!IsPackable(para))
+            continue;
+
+        XTensor * grad = para->grad;
+
+        memcpy(flatPara + offset, para->data, sizeof(DTYPE) * para->unitNum);
+        memcpy(flatGrad + offset, grad->data, sizeof(DTYPE) * grad->unitNum);
+
+        XMemFree(para->devID, para->data);
+        XMemFree(grad->devID, grad->data);
+
+        para->data = flatPara + offset;
+        grad->data = flatGrad + offset;
+        para->isShared = true;
+        grad->isShared = true;
+
+        offset += (para->unitNum + OPTIMIZER_ALIGNMENT - 1) / OPTIMIZER_ALIGNMENT * OPTIMIZER_ALIGNMENT;
+    }
+}
+
+/* 
+update a number of chunks of the flat buffers (in a job)
+>> args - the arguments
+   args[0] - the first chunk
+   args[1] - the last chunk + 1
+   args[2] - the optimizer
+   args[3] - the scaling factor of the gradient
+   args[4] - the learning rate (with the correction of adam)
+   args[5] - delta of adam
+*/
+void _OptimizerUpdateChunks(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    XOptimizer * optimizer = (XOptimizer*)args->GetItem(2);
+    DTYPE scale = *(DTYPE*)args->GetItem(3);
+    DTYPE e = *(DTYPE*)args->GetItem(4);
+    DTYPE d = *(DTYPE*)args->GetItem(5);
+
+    optimizer->UpdateFlat(beg * OPTIMIZER_CHUNK_SIZE, 
+                          MIN(end * OPTIMIZER_CHUNK_SIZE, optimizer->flatSize), 
+                          scale, e, d);
+}
+
+/* 
+sum of the squared gradients of a number of chunks (in a job)
+>> args - the arguments
+   args[0] - the first chunk
+   args[1] - the last chunk + 1
+   args[2] - the optimizer
+   args[3] - the array that keeps the sum of each chunk
+*/
+void _OptimizerSumSquaredChunks(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    XOptimizer * optimizer = (XOptimizer*)args->GetItem(2);
+    double * sums = (double*)args->GetItem(3);
+
+    for(int c = beg; c < end; c++){
+        sums[c] = optimizer->SumSquaredFlat(c * OPTIMIZER_CHUNK_SIZE, 
+                                            MIN((c + 1) * OPTIMIZER_CHUNK_SIZE, optimizer->flatSize));
+    }
+}
+
+/* 
+update the items in [beg, end) of the flat buffers, and clear the gradient
+>> beg - the first item
+>> end - the last item + 1
+>> scale - the scaling factor of the gradient (for clipping)
+>> e - the learning rate (with the bias correction for adam)
+>> d - delta (with the bias correction) for adam
+*/
+void XOptimizer::UpdateFlat(int beg, int end, DTYPE scale, DTYPE e, DTYPE d)
+{
+    DTYPE * p = flatPara;
+    DTYPE * g = flatGrad;
+    DTYPE * m = flatMoment;
+    DTYPE * v = flatMoment2nd;
+    int i = beg;
+
+    if(type == OPTIMIZER_ADAM){
+        DTYPE b1 = adamBeta1;
+        DTYPE b2 = adamBeta2;
+        DTYPE c1 = (1.0F - adamBeta1) * scale;
+        DTYPE c2 = (1.0F - adamBeta2) * scale * scale;
+
+#ifdef __AVX__
+        __m256 vb1 = _mm256_set1_ps(b1);
+        __m256 vb2 = _mm256_set1_ps(b2);
+        __m256 vc1 = _mm256_set1_ps(c1);
+        __m256 vc2 = _mm256_set1_ps(c2);
+        __m256 ve = _mm256_set1_ps(e);
+        __m256 vd = _mm256_set1_ps(d);
+        for(; i + 8 <= end; i += 8){
+            __m256 vg = _mm256_loadu_ps(g + i);
+            __m256 vm = _mm256_add_ps(_mm256_mul_ps(vb1, _mm256_loadu_ps(m + i)), _mm256_mul_ps(vc1, vg));
+            __m256 vv = _mm256_add_ps(_mm256_mul_ps(vb2, _mm256_loadu_ps(v + i)), 
+                                      _mm256_mul_ps(vc2, _mm256_mul_ps(vg, vg)));
+            __m256 vdelta = _mm256_div_ps(_mm256_mul_ps(ve, vm), _mm256_add_ps(_mm256_sqrt_ps(vv), vd));
+            _mm256_storeu_ps(m + i, vm);
+            _mm256_storeu_ps(v + i, vv);
+            _mm256_storeu_ps(p + i, _mm256_sub_ps(_mm256_loadu_ps(p + i), vdelta));
+        }
+#endif
+        for(; i < end; i++){
+            /* m = beta_1 * m + (1-beta_1) * grad */
+            m[i] = b1 * m[i] + c1 * g[i];
+
+            /* v = beta_2 * v + (1-beta_2) * grad * grad */
+            v[i] = b2 * v[i] + c2 * g[i] * g[i];
+
+            /* the delta rule */
+            p[i] -= e * m[i] / ((DTYPE)sqrt(v[i]) + d);
+        }
+    }
+    else if(momentum > 0){
+        DTYPE mu = momentum;
+        for(; i < end; i++){
+            /* m = momentum * m + grad */
+            m[i] = mu * m[i] + scale * g[i];
+
+            /* the delta rule */
+            p[i] -= e * m[i];
+        }
+    }
+    else{
+        DTYPE es = e * scale;
+        for(; i < end; i++){
+            /* the delta rule */
+            p[i] -= es * g[i];
+        }
+    }
+
+    /* clear gradient */
+    memset(g + beg, 0, sizeof(DTYPE) * (end - beg));
+}
+
+/* 
+sum of the squared gradients in [beg, end) of the flat buffer 
+>> beg - the first item
+>> end - the last item + 1
+<< return - the sum
+*/
+double XOptimizer::SumSquaredFlat(int beg, int end)
+{
+    DTYPE * g = flatGrad;
+    DTYPE sum = 0;
+    int i = beg;
+
+#ifdef __AVX__
+    __m256 vsum = _mm256_setzero_ps();
+    for(; i + 8 <= end; i += 8){
+        __m256 vg = _mm256_loadu_ps(g + i);
+        vsum = _mm256_add_ps(vsum, _mm256_mul_ps(vg, vg));
+    }
+    DTYPE tmp[8];
+    _mm256_storeu_ps(tmp, vsum);
+    for(int k = 0; k < 8; k++)
+        sum += tmp[k];
+#endif
+    for(; i < end; i++)
+        sum += g[i] * g[i];
+
+    return (double)sum;
+}
+
+/* 
+compute the global norm of the gradient (over all parameters)
+<< return - the norm
+*/
+float XOptimizer::GetGradNorm()
+{
+    double sum = 0;
+
+    if(flatSize > 0){
+        int chunkNum = (flatSize + OPTIMIZER_CHUNK_SIZE - 1) / OPTIMIZER_CHUNK_SIZE;
+        double * sums = new double[chunkNum];
+
+        RunParallel1D(parallelRunner, (void*)_OptimizerSumSquaredChunks, flatSize, chunkNum, 2,
+                      this, sums);
+
+        for(int c = 0; c < chunkNum; c++)
+            sum += sums[c];
+
+        delete[] sums;
+    }
+
+    for(int i = 0; i < others.count; i++){
+        XTensor * para = (XTensor*)others.Get(i);
+        XTensor * grad = para->grad;
+
+        if(grad == NULL)
+            continue;
+
+        if(para->gradRows != NULL && grad->devID < 0){
+            XSparseRows * rows = para->gradRows;
+            int stride = grad->GetDim(-1);
+            for(int k = 0; k < rows->count; k++){
+                DTYPE * g = (DTYPE*)grad->data + rows->rows[k] * stride;
+                for(int j = 0; j < stride; j++)
+                    sum += g[j] * g[j];
+            }
+        }
+        else{
+            XTensor * squared = NewTensorBuf(grad, grad->devID, grad->mem);
+            _Multiply(grad, grad, squared);
+            sum += _ReduceSumAll(squared);
+            DelTensorBuf(squared);
+        }
+    }
+
+    return (float)sqrt(sum);
+}
+
+/* 
+update a parameter that is not in the flat buffer, and clear its gradient
+>> i - index of the parameter (in "others")
+>> scale - the scaling factor of the gradient (for clipping)
+>> lr - the learning rate
+>> e - the learning rate (with the bias correction for adam)
+>> d - delta (with the bias correction) for adam
+*/
+void XOptimizer::UpdateOther(int i, DTYPE scale, DTYPE lr, DTYPE e, DTYPE d)
+{
+    XTensor * para = (XTensor*)others.Get(i);
+    XTensor * paraGrad = para->grad;
+    XTensor * m = (XTensor*)otherMoments.Get(i);
+    XTensor * v = (XTensor*)otherMoments2nd.Get(i);
+
+    if(paraGrad == NULL)
+        return;
+
+    /* row-sparse gradient (e.g., of the embedding matrix). Only the rows
+       in use are updated. For adam and momentum, the moments of the other 
+       rows are not decayed (i.e., the "lazy" update) */
+    if(para->gradRows != NULL && para->devID < 0){
+        XSparseRows * rows = para->gradRows;
+        int stride = para->GetDim(-1);
+
+        for(int k = 0; k < rows->count; k++){
+            int offset = rows->rows[k] * stride;
+            DTYPE * pp = (DTYPE*)para->data + offset;
+            DTYPE * gp = (DTYPE*)paraGrad->data + offset;
+            DTYPE * mp = m != NULL ? (DTYPE*)m->data + offset : NULL;
+            DTYPE * vp = v != NULL ? (DTYPE*)v->data + offset : NULL;
+
+            for(int j = 0; j < stride; j++){
+                DTYPE g = gp[j] * scale;
+                if(type == OPTIMIZER_ADAM){
+                    mp[j] = adamBeta1 * mp[j] + (1.0F - adamBeta1) * g;
+                    vp[j] = adamBeta2 * vp[j] + (1.0F - adamBeta2) * g * g;
+                    pp[j] -= e * mp[j] / ((DTYPE)sqrt(vp[j]) + d);
+                }
+                else if(momentum > 0){
+                    mp[j] = momentum * mp[j] + g;
+                    pp[j] -= lr * mp[j];
+                }
+                else
+                    pp[j] -= lr * g;
+            }
+        }
+
+        /* clear gradient */
+        _SetDataRows(paraGrad, rows, 0);
+        rows->Clear();
+
+        return;
+    }
+
+    if(scale != 1.0F)
+        _ScaleAndShiftMe(paraGrad, scale, 0);
+
+    if(type == OPTIMIZER_ADAM){
+        /* m = beta_1 * m + (1-beta_1) * grad */
+        _ScaleAndShiftMe(m, adamBeta1, 0);
+        _Sum(m, paraGrad, m, (1.0F - adamBeta1));
+            
+        /* v = beta_2 * v + (1-beta_2) * grad * grad*/
+        _Multiply(paraGrad, paraGrad, v, adamBeta2/(1.0F - adamBeta2));
+        _ScaleAndShiftMe(v, (1.0F - adamBeta2), 0);
+
+        /* v2 = m / (sqrt(v) + delta) */
+        XTensor * v2 = NewTensorBuf(v, v->devID, v->mem);
+        _Power(v, v2, 0.5F);
+        _ScaleAndShiftMe(v2, 1.0F, d);
+        _Div(m, v2, v2);
+
+        /* the delta rule */
+        _Sum(para, v2, para, -e);
+
+        DelTensorBuf(v2);
+    }
+    else if(momentum > 0){
+        /* m = momentum * m + grad */
+        _ScaleAndShiftMe(m, momentum, 0);
+        _Sum(m, paraGrad, m);
+
+        /* the delta rule */
+        _Sum(para, m, para, -lr);
+    }
+    else{
+        /* the delta rule */
+        _Sum(para, paraGrad, para, -lr);
+    }
+
+    /* clear gradient */
+    paraGrad->SetZeroAll();
+}
+
+/* 
+update the parameters (one step) and clear the gradients 
+>> lr - the learning rate
+*/
+void XOptimizer::Update(float lr)
+{
+    DTYPE scale = 1.0F;
+
+    /* clip the gradient by its global norm */
+    if(clipNorm > 0){
+        gradNorm = GetGradNorm();
+        if(gradNorm > clipNorm)
+            scale = clipNorm / gradNorm;
+    }
+
+    DTYPE e = lr;
+    DTYPE d = 0;
+
+    if(type == OPTIMIZER_ADAM){
+        adamBeta1T *= adamBeta1;
+        adamBeta2T *= adamBeta2;
+        e = lr * (DTYPE)sqrt(1 - adamBeta2T) / (1 - adamBeta1T);
+        d = adamDelta * (DTYPE)sqrt(1 - adamBeta2T);
+    }
+
+    /* the fused update of the flat buffers */
+    if(flatSize > 0){
+        int chunkNum = (flatSize + OPTIMIZER_CHUNK_SIZE - 1) / OPTIMIZER_CHUNK_SIZE;
+        RunParallel1D(parallelRunner, (void*)_OptimizerUpdateChunks, flatSize * 4, chunkNum, 4,
+                      this, &scale, &e, &d);
+    }
+
+    /* the other parameters */
+    for(int i = 0; i < others.count; i++)
+        UpdateOther(i, scale, lr, e, d);
+}
+
+/* 
+clear the gradients without any update, e.g., when the gradients
+of a step are thrown away
+*/
+void XOptimizer::ClearGrad()
+{
+    if(flatSize > 0)
+        memset(flatGrad, 0, sizeof(DTYPE) * flatSize);
+
+    for(int i = 0; i < others.count; i++){
+        XTensor * para = (XTensor*)others.Get(i);
+        if(para->grad == NULL)
+            continue;
+
+        /* the rows in use are cleared as in UpdateOther(). Leaving them in
+           the list would make the next update revisit the stale rows */
+        if(para->gradRows != NULL && para->devID < 0){
+            _SetDataRows(para->grad, para->gradRows, 0);
+            para->gradRows->Clear();
+        }
+        else
+            para->grad->SetZeroAll();
+    }
+}
+
+}
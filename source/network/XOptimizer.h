@@ -0,0 +1,146 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The optimizer that updates model parameters. Parameters and their
+ * gradients (on the CPU) are packed into contiguous flat buffers, and
+ * the whole update (gradient clipping, the moments, the delta rule and
+ * clearing the gradient) is done in a single fused pass that can run
+ * in parallel. Parameters that cannot be packed (e.g., on GPUs, in memory
+ * pools or with row-sparse gradients) are updated one by one.
+ *
+ */
+
+#ifndef __XOPTIMIZER_H__
+#define __XOPTIMIZER_H__
+
+#include "../tensor/XTensor.h"
+#include "../tensor/XPRunner.h"
+
+namespace nts{
+
+/* the flat buffers are processed in chunks of this many items */
+#define OPTIMIZER_CHUNK_SIZE (1 << 14)
+
+/* each parameter in the flat buffer is aligned to this many items */
+#define OPTIMIZER_ALIGNMENT 16
+
+/* optimization methods */
+enum OPTIMIZER_TYPE {OPTIMIZER_SGD, OPTIMIZER_ADAM};
+
+/* optimizer of model parameters */
+class XOptimizer
+{
+public:
+    /* the optimization method */
+    OPTIMIZER_TYPE type;
+
+    /* hyper parameters of adam */
+    float adamBeta1;
+    float adamBeta2;
+    float adamDelta;
+    float adamBeta1T;
+    float adamBeta2T;
+
+    /* momentum of sgd (0 means the vanilla sgd) */
+    float momentum;
+
+    /* the maximum global norm of the gradient (<= 0 means no clipping) */
+    float clipNorm;
+
+    /* global norm of the gradient in the last update */
+    float gradNorm;
+
+    /* parallel runner */
+    XPRunner * parallelRunner;
+
+    /* the parameters (all of them) */
+    XList params;
+
+    /* size of the flat buffers (number of items) */
+    int flatSize;
+
+    /* the flat buffer of the packed parameters */
+    DTYPE * flatPara;
+
+    /* the flat buffer of the gradients of the packed parameters */
+    DTYPE * flatGrad;
+
+    /* the flat buffer of the 1st order moment (or the velocity of sgd) */
+    DTYPE * flatMoment;
+
+    /* the flat buffer of the 2nd order moment */
+    DTYPE * flatMoment2nd;
+
+    /* the parameters that are not packed */
+    XList others;
+
+    /* the 1st order moment (or the velocity) of each parameter that is not packed */
+    XList otherMoments;
+
+    /* the 2nd order moment of each parameter that is not packed */
+    XList otherMoments2nd;
+
+public:
+    /* constructor */
+    XOptimizer();
+
+    /* de-constructor */
+    ~XOptimizer();
+
+    /* use sgd (with momentum) */
+    void SetSGD(float myMomentum = 0);
+
+    /* use adam */
+    void SetAdam(float myBeta1 = 0.9F, float myBeta2 = 0.98F, float myDelta = 1e-9F);
+
+    /* set the maximum global norm of the gradient */
+    void SetClipNorm(float myClipNorm);
+
+    /* initialize the optimizer with the parameters (and pack them) */
+    void Init(XList &myParams, XPRunner * myParallelRunner = NULL);
+
+    /* update the parameters and clear the gradients */
+    void Update(float lr);
+
+    /* clear the gradients without any update */
+    void ClearGrad();
+
+    /* compute the global norm of the gradient */
+    float GetGradNorm();
+
+    /* update the items of the flat buffers in [beg, end) */
+    void UpdateFlat(int beg, int end, DTYPE scale, DTYPE e, DTYPE d);
+
+    /* sum of the squared gradients in [beg, end) of the flat buffer */
+    double SumSquaredFlat(int beg, int end);
+
+protected:
+    /* check whether a parameter can be kept in the flat buffer */
+    bool IsPackable(XTensor * para);
+
+    /* update a parameter that is not packed */
+    void UpdateOther(int i, DTYPE scale, DTYPE lr, DTYPE e, DTYPE d);
+
+    /* release the buffers */
+    void Clear();
+};
+
+}
+
+#endif // __XOPTIMIZER_H__
@@ -0,0 +1,297 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Bench.h"
+#include "../../tensor/XGlobal.h"
+#include "../../tensor/XUtility.h"
+#include "../../tensor/XPRunner.h"
+#include "../../tensor/XNuma.h"
+#include "../../tensor/test/TBenchmark.h"
+#include "../fnnlm/FNNLM.h"
+#include "../transformer/Transformer.h"
+
+using namespace nts;
+
+namespace bench
+{
+
+/*
+generate a synthetic corpus of word ids
+>> fn - the file
+>> lineNum - number of lines
+>> minLen - minimum length of a line
+>> maxLen - maximum length of a line
+>> vocabSize - size of the vocabulary
+*/
+void MakeSyntheticData(const char * fn, int lineNum, int minLen, int maxLen, int vocabSize)
+{
+    FILE * file = fopen(fn, "wb");
+    CheckNTErrors(file != NULL, "Cannot create the file for the synthetic data!");
+
+    unsigned int seed = 1;
+
+    for (int i = 0; i < lineNum; i++) {
+        seed = seed * 1103515245 + 12345;
+        int len = minLen + (int)((seed >> 16) % (maxLen - minLen + 1));
+        for (int j = 0; j < len; j++) {
+            seed = seed * 1103515245 + 12345;
+            /* ids of 0 and 1 are kept for padding and the start symbol */
+            fprintf(file, "%s%d", j > 0 ? " " : "", 2 + (int)((seed >> 16) % (vocabSize - 2)));
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+}
+
+/*
+time a run of a sample program
+>> mainFunc - the entrance of the program
+>> args - the arguments
+>> argNum - number of the arguments
+>> stepArg - the position of the value of "-nstep"
+>> step - number of the training steps
+<< return - time (in ms)
+*/
+double TimeSample(int (*mainFunc)(int, const char **), const char ** args, int argNum, int stepArg, int step)
+{
+    char stepStr[32];
+    sprintf(stepStr, "%d", step);
+    args[stepArg] = stepStr;
+
+    double startT = GetClock();
+    mainFunc(argNum, args);
+    double elapsed = GetClock() - startT;
+
+    args[stepArg] = NULL;
+
+    return elapsed;
+}
+
+/*
+measure the time of a training step of a sample program. The program runs
+for a few steps and for more steps, and the difference of the two runs
+is the time of the extra steps, i.e., the time of loading the data and
+initializing the model is not counted.
+>> bench - where we keep the results
+>> name - name of the benchmark
+>> mainFunc - the entrance of the program
+>> args - the arguments
+>> argNum - number of the arguments
+>> stepArg - the position of the value of "-nstep"
+>> stepNum - number of the steps that are measured
+>> wordNum - number of (target) words of a step
+*/
+void BenchmarkSteps(XBench &bench, const char * name, int (*mainFunc)(int, const char **),
+                    const char ** args, int argNum, int stepArg, int stepNum, int wordNum)
+{
+    if (!bench.IsSelected(name))
+        return;
+
+    int warmupStep = 2;
+    double t1 = TimeSample(mainFunc, args, argNum, stepArg, warmupStep);
+    double t2 = TimeSample(mainFunc, args, argNum, stepArg, warmupStep + stepNum);
+    double ms = MAX(t2 - t1, 0) / stepNum;
+
+    bench.Add(name, ms, ms > 0 ? wordNum / (ms / 1000) : 0, "words/s", stepNum);
+}
+
+/*
+step benchmarks of the transformer and FNNLM samples
+>> bench - where we keep the results
+>> isQuick - indicates whether we run small models only
+>> prefix - prefix of the temporary files
+*/
+void BenchmarkSamples(XBench &bench, bool isQuick, const char * prefix)
+{
+    char dataFN[1024];
+    char modelFN[1024];
+    char tmpFN[1024];
+    int vocabSize = isQuick ? 1000 : 8000;
+
+    /* a transformer language model. The model (checkpoints) and the temporary
+       file of the program are put next to the data rather than in the cwd */
+    sprintf(dataFN, "%s.t2t.txt", prefix);
+    sprintf(modelFN, "%s.t2t.model", prefix);
+    sprintf(tmpFN, "%s.t2t.tmp", prefix);
+    MakeSyntheticData(dataFN, 2000, 10, 40, vocabSize);
+
+    {
+        char vsize[16];
+        sprintf(vsize, "%d", vocabSize);
+        const char * d = isQuick ? "32" : "256";
+        const char * hsize = isQuick ? "128" : "1024";
+        const char * nlayer = isQuick ? "1" : "3";
+        int wbatch = isQuick ? 256 : 1024;
+        char wbatchStr[16];
+        sprintf(wbatchStr, "%d", wbatch);
+
+        const char * args[] = {"-t2t", "-lm", "-train", dataFN, "-model", modelFN, "-tmpfile", tmpFN,
+                               "-vsize", vsize, "-vsizetgt", vsize,
+                               "-nlayer", nlayer, "-d", d, "-hsize", hsize, "-nhead", "4",
+                               "-sbatch", "64", "-wbatch", wbatchStr, "-nepoch", "1000", "-adam",
+                               "-nstep", NULL};
+        int argNum = sizeof(args) / sizeof(args[0]);
+
+        char name[MAX_BENCH_NAME_LENGTH];
+        sprintf(name, "e2e.t2t.lm.d%s.l%s.v%d", d, nlayer, vocabSize);
+        BenchmarkSteps(bench, name, transformer::TransformerMain, args, argNum, argNum - 1,
+                       isQuick ? 2 : 10, wbatch);
+    }
+
+    remove(dataFN);
+    remove(tmpFN);
+
+    /* a feed-forward neural language model */
+    sprintf(dataFN, "%s.fnnlm.txt", prefix);
+    MakeSyntheticData(dataFN, 2000, 10, 40, vocabSize);
+
+    {
+        char vsize[16];
+        sprintf(vsize, "%d", vocabSize);
+        const char * hsize = isQuick ? "128" : "512";
+        int batch = isQuick ? 256 : 512;
+        char batchStr[16];
+        sprintf(batchStr, "%d", batch);
+
+        const char * args[] = {"-fnnlm", "-train", dataFN, "-n", "3", "-vsize", vsize,
+                               "-esize", "128", "-hdepth", "1", "-hsize", hsize,
+                               "-wbatch", batchStr, "-nepoch", "1000", "-nstep", NULL};
+        int argNum = sizeof(args) / sizeof(args[0]);
+
+        char name[MAX_BENCH_NAME_LENGTH];
+        sprintf(name, "e2e.fnnlm.n3.h%s.v%d", hsize, vocabSize);
+        BenchmarkSteps(bench, name, fnnlm::FNNLMMain, args, argNum, argNum - 1,
+                       isQuick ? 4 : 10, batch);
+    }
+
+    /* hogwild training of the feed-forward neural language model
+       with 1, 2, 4, ... threads (up to all cores) */
+    GNuma.Init();
+    int cpuNum = MIN(MAX(GNuma.cpuNum, 1), MAX_THREAD_NUM);
+
+    for (int t = 1; t > 0; t = t < cpuNum ? MIN(t * 2, cpuNum) : 0) {
+        char vsize[16];
+        sprintf(vsize, "%d", vocabSize);
+        const char * hsize = isQuick ? "128" : "512";
+        int batch = isQuick ? 256 : 512;
+        char batchStr[16];
+        sprintf(batchStr, "%d", batch);
+        char threadStr[16];
+        sprintf(threadStr, "%d", t);
+
+        const char * args[] = {"-fnnlm", "-train", dataFN, "-n", "3", "-vsize", vsize,
+                               "-esize", "128", "-hdepth", "1", "-hsize", hsize,
+                               "-wbatch", batchStr, "-nepoch", "1000", "-hogwild", 
+                               "-nthread", threadStr, "-nstep", NULL};
+        int argNum = sizeof(args) / sizeof(args[0]);
+
+        char name[MAX_BENCH_NAME_LENGTH];
+        sprintf(name, "e2e.fnnlm.hogwild.n3.h%s.v%d.t%d", hsize, vocabSize, t);
+        BenchmarkSteps(bench, name, fnnlm::FNNLMMain, args, argNum, argNum - 1,
+                       (isQuick ? 4 : 10) * t, batch);
+    }
+
+    remove(dataFN);
+}
+
+/*
+entrance of the benchmarks
+>> argc - number of the arguments
+>> argv - the arguments
+<< return - 0 if there is no regression, and 1 otherwise
+*/
+int BenchMain(int argc, const char ** argv)
+{
+    const char * outputFN = "bench.json";
+    const char * baselineFN = NULL;
+    const char * filter = NULL;
+    const char * prefix = "bench.tmp";
+    double threshold = 0.1;
+    double minTime = 200.0;
+    int threadNum = 1;
+    bool isQuick = false;
+    bool runSamples = true;
+
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "-output") && i + 1 < argc)
+            outputFN = argv[i + 1];
+        if (!strcmp(argv[i], "-baseline") && i + 1 < argc)
+            baselineFN = argv[i + 1];
+        if (!strcmp(argv[i], "-filter") && i + 1 < argc)
+            filter = argv[i + 1];
+        if (!strcmp(argv[i], "-tmpprefix") && i + 1 < argc)
+            prefix = argv[i + 1];
+        if (!strcmp(argv[i], "-threshold") && i + 1 < argc)
+            threshold = atof(argv[i + 1]);
+        if (!strcmp(argv[i], "-mintime") && i + 1 < argc)
+            minTime = atof(argv[i + 1]);
+        if (!strcmp(argv[i], "-nthread") && i + 1 < argc)
+            threadNum = atoi(argv[i + 1]);
+        if (!strcmp(argv[i], "-quick"))
+            isQuick = true;
+        if (!strcmp(argv[i], "-nosample"))
+            runSamples = false;
+    }
+
+    XBench bench;
+    bench.minTime = minTime;
+    bench.filter = filter;
+
+    XPRunner * runner = NULL;
+    if (threadNum > 1) {
+        runner = new XPRunner();
+        runner->Init(MIN(threadNum, MAX_THREAD_NUM));
+        bench.runner = runner;
+    }
+
+    /* the operators that use the global runner (e.g., block copy in merge and split) */
+    XPRunner * globalRunnerBackup = globalPRunner;
+    globalPRunner = runner;
+
+    BenchmarkOperators(bench, isQuick);
+
+    if (runSamples)
+        BenchmarkSamples(bench, isQuick, prefix);
+
+    bench.Show(stdout);
+
+    if (outputFN != NULL && *outputFN != 0) {
+        bench.Save(outputFN);
+        XPRINT1(0, stderr, "[BENCH] results are saved to %s\n", outputFN);
+    }
+
+    int regressed = 0;
+
+    if (baselineFN != NULL) {
+        XBench baseline;
+        if (baseline.Load(baselineFN))
+            regressed = bench.Compare(baseline, threshold, stdout);
+        else
+            XPRINT1(0, stderr, "[BENCH] Warning! cannot read the baseline %s\n", baselineFN);
+    }
+
+    globalPRunner = globalRunnerBackup;
+    delete runner;
+
+    return regressed > 0 ? 1 : 0;
+}
+
+}
@@ -0,0 +1,42 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The benchmark suite. It runs the operator benchmarks (see
+ * tensor/test/TBenchmark.h) and step benchmarks of the transformer and
+ * FNNLM samples on synthetic data, saves the results as JSON and compares
+ * them with a baseline, e.g.,
+ *
+ * NiuTrans.Tensor.CPU -bench -output new.json -baseline old.json -threshold 0.1
+ *
+ * It returns a non-zero value if any benchmark is slower than the baseline by
+ * more than the threshold. "make bench" runs it.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+namespace bench
+{
+
+/* entrance of the benchmarks */
+int BenchMain(int argc, const char ** argv);
+
+}
+
+#endif
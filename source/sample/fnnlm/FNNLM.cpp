@@ -27,9 +27,13 @@
 
 #include <math.h>
 #include "FNNLM.h"
+#include "FNNLMScorer.h"
 #include "../../tensor/XGlobal.h"
 #include "../../tensor/XUtility.h"
 #include "../../tensor/XDevice.h"
+#include "../../tensor/XCorpus.h"
+#include "../../tensor/XThread.h"
+#include "../../tensor/XPRunner.h"
 #include "../../tensor/function/FHeader.h"
 #include "../../network/XNet.h"
 
@@ -51,7 +55,12 @@ float minmax = 0.08F;                 // range [-p,p] for parameter initializati
 int sentBatch = 0;                    // batch size at the sentence level
 int wordBatch = 1;                    // batch size at the word level
 bool shuffled = false;                // shuffled the training data file or not
+int shuffleSeed = 1;                  // seed of shuffling (shuffleSeed + epoch for each epoch)
 bool autoDiff = false;                // indicator of automatic differentiation
+bool hogwild = false;                 // indicator of lock-free (hogwild) training
+int threadNum = 1;                    // number of threads in hogwild training
+bool isNuma = false;                  // pin the threads of hogwild training on the NUMA nodes
+int cacheSize = 0;                    // number of the contexts cached in testing (0 = no scorer)
 
 void LoadArgs(int argc, const char ** argv, FNNModel &model);
 void Init(FNNModel &model);
@@ -61,8 +70,11 @@ void Clear(FNNModel &model, bool isNodeGrad);
 void InitModelTensor1D(XTensor &tensor, int num, FNNModel &model);
 void InitModelTensor2D(XTensor &tensor, int rowNum, int colNum, FNNModel &model);
 void Train(const char * train, bool isShuffled, FNNModel &model);
+void TrainHogwild(const char * train, bool isShuffled, FNNModel &model);
 void Update(FNNModel &model, FNNModel &grad, float epsilon, bool isNodeGrad);
-float GetProb(XTensor &output, XTensor &gold, XTensor * wordProbs = NULL);
+void UpdateHogwild(FNNModel &model, FNNModel &grad, NGram * ngrams, int ngramNum, 
+                   XTensor &dedEmbeddings, float epsilon);
+float GetProb(XTensor &output, XTensor &goldIds, XTensor * wordProbs = NULL);
 void Dump(const char * fn, FNNModel &model);
 void Read(const char * fn, FNNModel &model);
 void Test(const char * test, const char * result, FNNModel &model);
@@ -70,9 +82,10 @@ int  LoadNGrams(FILE * file, int n, NGram * ngrams, int sentNum, int wordNum);
 void InitZeroOneTensor2D(XTensor &tensor, int rowNum, int colNum, int * rows, int * cols, 
                          int itemNum, int devID, XMem * mem);
 void MakeWordBatch(XTensor &batch, NGram * ngrams, int ngramNum, int n, int vSize, int devID, XMem * mem);
+void MakeWordIds(XTensor &ids, NGram * ngrams, int ngramNum, int n, int devID, XMem * mem);
 void Forward(XTensor inputs[], XTensor &output, FNNModel &model, FNNNet &net);
 void Backward(XTensor inputs[], XTensor &output, XTensor &gold, LOSS_FUNCTION_NAME loss, 
-              FNNModel &model, FNNModel &grad, FNNNet &net);
+              FNNModel &model, FNNModel &grad, FNNNet &net, XTensor * dedEmbeddings = NULL);
 void ForwardAutoDiff(XTensor inputs[], XTensor &output, FNNModel &model);
 void ForwardAutoDiff(NGram * ngrams, int batch, XTensor &output, FNNModel &model);
 
@@ -98,11 +111,23 @@ arguments:
  -batch D: batch size (how many sentences)
  -wbatch D: batch size at the word level
             (how many words)
- -shuffle: shuffle the training data
+ -shuffle: shuffle the training data (in a binary copy of the data file)
+ -shuffleseed D: seed of shuffling
  -devid D: the id of the device used
            -1: CPU, >=0: GPUs
  -mempool: use memory pools for memory management
  -autodiff: use automatic differentiation for training
+ -hogwild: train the model with a number of threads that update
+           the shared parameters without locks (see -nthread)
+ -nthread D: number of threads in hogwild training
+             (-hogwild is implied if D > 1). Note that the updates
+             of the threads are stale and a smaller learning rate
+             might be needed when D is large
+ -numa: pin the threads of hogwild training to the cpus node by
+        node. The gradients and the batches of a thread are then
+        on its own node (they are first touched by the thread)
+ -cache D: test the model with the batch scorer that caches the
+           states of D contexts (see FNNLMScorer.h)
  
  where S=string, D=integer and F=float.
  All words in the training and test data files
@@ -128,7 +153,9 @@ int FNNLMMain(int argc, const char ** argv)
     Init(model);
 
     /* learn model parameters */
-    if(strcmp(trainFN, ""))
+    if(strcmp(trainFN, "") && hogwild)
+        TrainHogwild(trainFN, shuffled, model);
+    else if(strcmp(trainFN, ""))
         Train(trainFN, shuffled, model);
 
     /* save the final model */
@@ -220,10 +247,32 @@ void LoadArgs(int argc, const char ** argv, FNNModel &model)
             shuffled = true;
             fprintf(stderr, " -shuffle=true\n");
         }
+        if(!strcmp(argv[i], "-shuffleseed") && i + 1 < argc){
+            shuffleSeed = atoi(argv[i + 1]);
+            fprintf(stderr, " -shuffleseed=%d\n", shuffleSeed);
+        }
         if(!strcmp(argv[i], "-autodiff")){
             autoDiff = true;
             fprintf(stderr, " -autodiff=true\n");
         }
+        if(!strcmp(argv[i], "-hogwild")){
+            hogwild = true;
+            fprintf(stderr, " -hogwild=true\n");
+        }
+        if(!strcmp(argv[i], "-nthread") && i + 1 < argc){
+            threadNum = atoi(argv[i + 1]);
+            if(threadNum > 1)
+                hogwild = true;
+            fprintf(stderr, " -nthread=%d\n", threadNum);
+        }
+        if(!strcmp(argv[i], "-numa")){
+            isNuma = true;
+            fprintf(stderr, " -numa=true\n");
+        }
+        if(!strcmp(argv[i], "-cache") && i + 1 < argc){
+            cacheSize = atoi(argv[i + 1]);
+            fprintf(stderr, " -cache=%d\n", cacheSize);
+        }
         if(!strcmp(argv[i], "-dev") && i + 1 < argc){
             model.devID = atoi(argv[i + 1]);
             fprintf(stderr, " -dev=%d\n", model.devID);
@@ -242,6 +291,11 @@ void Check(FNNModel &model)
     CheckErrors(model.n > 0 && model.n <= MAX_N_GRAM, "The LM order is out of range (use -n)!");
     CheckErrors(model.vSize > 0, "no vocabulary size found (use -vsize)!");
     CheckErrors(model.eSize > 0, "no embedding size found (use -esize)!");
+    if(hogwild){
+        CheckErrors(threadNum > 0 && threadNum <= MAX_THREAD_NUM, "Illegal number of threads (use -nthread)!");
+        CheckErrors(model.devID < 0 && model.mem == NULL, "Hogwild training runs on CPUs without memory pools!");
+        CheckErrors(!autoDiff, "Hogwild training does not support automatic differentiation!");
+    }
 }
 
 /* make a hard copy of the fnn model */
@@ -278,7 +332,12 @@ reset model parameters
 void Clear(FNNModel &model, bool isNodeGrad)
 {
     if (isNodeGrad) {
-        if(model.embeddingW.grad != NULL)
+        if(model.embeddingW.grad != NULL && model.embeddingW.gradRows != NULL){
+            /* clear the rows that are used in the last batch only */
+            _SetDataRows(model.embeddingW.grad, model.embeddingW.gradRows, 0);
+            model.embeddingW.gradRows->Clear();
+        }
+        else if(model.embeddingW.grad != NULL)
             model.embeddingW.grad->SetZeroAll();
         for (int i = 0; i < MAX_HIDDEN_NUM; i++) {
             if(model.hiddenW[i].grad != NULL)
@@ -353,6 +412,11 @@ void Init(FNNModel &model)
     /* then, we initialize model parameters using a uniform distribution in range
        of [-minmax, minmax] */
     model.embeddingW.SetDataRand(-minmax, minmax);
+
+    /* in automatic differentiation, the embedding matrix is accessed by gather
+       and its gradient is row-sparse */
+    if(autoDiff && model.devID < 0)
+        model.embeddingW.SetSparseGradFlag();
     model.outputW.SetDataRand(-minmax, minmax);
     for(int i = 0; i < model.hDepth; i++)
         model.hiddenW[i].SetDataRand(-minmax, minmax);
@@ -363,26 +427,44 @@ void Init(FNNModel &model)
         model.hiddenB[i].SetZeroAll();
 }
     
-/*
- shuffle lines of the file
- >> srcFile - the source file to shuffle
- >> tgtFile - the resulting file
- */
-void Shuffle(const char * srcFile, const char * tgtFile)
-{
-    char * line = new char[MAX_LINE_LENGTH_HERE];
-#ifndef WIN32
-    sprintf(line, "shuf %s > %s", srcFile, tgtFile);
-    system(line);
-#else
-    ShowErrors("Cannot shuffle the file on WINDOWS systems!");
-#endif
-    delete[] line;
     
-}
-    
-char lineBuf[MAX_LINE_LENGTH_HERE];
-int wordBuf[MAX_LINE_LENGTH_HERE];
+/* the state of loading ngrams from a data file. The lines are split into 
+   "shardNum" shards (by line id) and a reader keeps one of them, so that 
+   the threads of hogwild training read disjoint data. */
+struct NGramReader
+{
+    /* the binary corpus that is being read (NULL for text files) */
+    XCorpus * corpus;
+
+    /* where we start in the current line (0 for a new line) */
+    int pin;
+
+    /* number of words in the current line */
+    int wordBufCount;
+
+    /* id of the next line of the data file */
+    int lineID;
+
+    /* the shard that is kept */
+    int shard;
+
+    /* number of shards */
+    int shardNum;
+
+    char lineBuf[MAX_LINE_LENGTH_HERE];
+    int wordBuf[MAX_LINE_LENGTH_HERE];
+    int seqLenBuf[MAX_LINE_LENGTH_HERE];
+
+    NGramReader(){ corpus = NULL; pin = 0; wordBufCount = 0; lineID = 0; shard = 0; shardNum = 1; };
+};
+
+/* the reader of the single-thread training and test */
+NGramReader mainReader;
+
+/* the binary corpus that is being read (NULL for text files) */
+XCorpus * corpus = NULL;
+
+int LoadNGrams(FILE * file, NGramReader &reader, int n, NGram * ngrams, int sentNum, int wordNum);
 
 /* 
 train the model with the standard SGD method
@@ -394,13 +476,20 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
 {
     char name[MAX_NAME_LENGTH];
     
-    /* shuffle the data */
-    if(isShuffled){
-        sprintf(name, "%s-tmp", train);
-        Shuffle(train, name);
+    /* the data is shuffled in-process, and a text file is 
+       compiled into a binary corpus for this */
+    if(isShuffled && !XCorpus::IsBinary(train)){
+        sprintf(name, "%s.bin", train);
+        XCorpus::Compile(train, name);
     }
     else
         strcpy(name, train);
+
+    XCorpus binCorpus;
+    if(XCorpus::IsBinary(name)){
+        binCorpus.Open(name);
+        corpus = &binCorpus;
+    }
     
     int epoch = 0;
     int step = 0;
@@ -425,8 +514,17 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
     for(epoch = 0; epoch < nEpoch; epoch++){
 
         /* data file */
-        FILE * file = fopen(name, "rb");
-        CheckErrors(file, "Cannot open the training file");
+        FILE * file = NULL;
+        if(corpus != NULL){
+            if(isShuffled)
+                corpus->Shuffle(shuffleSeed + epoch, 0);
+            else
+                corpus->Rewind();
+        }
+        else{
+            file = fopen(name, "rb");
+            CheckErrors(file, "Cannot open the training file");
+        }
 
         wordCount = 0;
         loss = 0;
@@ -449,12 +547,16 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
             /* the gold standard */
             XTensor gold;
 
+            /* ids of the gold words */
+            XTensor goldIds;
+
             /* make the input tensor for position i */
             for(int i = 0; i < model.n - 1; i++)
                 MakeWordBatch(inputs[i], ngrams, ngramNum, i, model.vSize, model.devID, model.mem);
 
             /* make the gold tensor */
             MakeWordBatch(gold, ngrams, ngramNum, model.n - 1, model.vSize, model.devID, model.mem);
+            MakeWordIds(goldIds, ngrams, ngramNum, model.n - 1, model.devID, model.mem);
 
             if(!autoDiff){
                 /* prepare an empty network for building the fnn */
@@ -492,7 +594,7 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
             }
                 
             /* get probabilities */
-            float prob = GetProb(output, gold);
+            float prob = GetProb(output, goldIds);
                 
             loss += -prob;
             wordCount += ngramNum;
@@ -510,7 +612,8 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
             }
         }
 
-        fclose(file);
+        if(file != NULL)
+            fclose(file);
         
         if(isEnd)
             break;
@@ -525,6 +628,8 @@ void Train(const char * train, bool isShuffled, FNNModel &model)
     XPRINT3(0, stderr, "[INFO] training finished (took %.1fs, step=%d and epoch=%d)\n", 
                elapsed, step, epoch);
     
+    corpus = NULL;
+
     delete[] ngrams;
 }
 
@@ -581,50 +686,291 @@ void Update(FNNModel &model, FNNModel &grad, float epsilon, bool isNodeGrad)
         //paraGrad->Dump(stderr, "grad:", 10);
 
         /* the delta rule */
-        _Sum(para, paraGrad, para, -epsilon);
+        if(isNodeGrad && para->gradRows != NULL)
+            _SumRowsMe(para, paraGrad, para->gradRows, -epsilon);
+        else
+            _Sum(para, paraGrad, para, -epsilon);
     }
 }
   
+/* 
+update the model parameters with the gradients of a thread in hogwild training.
+The update is lock-free, i.e., the threads write the shared parameters at the
+same time. The hidden and output layers are updated by the delta rule, and
+only the embeddings of the words in the batch are updated (row by row).
+>> model - the model to update (shared by the threads)
+>> grad - gradients of the hidden and output layers
+>> ngrams - the ngram batch
+>> ngramNum - batch size
+>> dedEmbeddings - gradient of the concatenated embeddings
+>> epsilon - learning rate
+*/
+void UpdateHogwild(FNNModel &model, FNNModel &grad, NGram * ngrams, int ngramNum, 
+                   XTensor &dedEmbeddings, float epsilon)
+{
+    _Sum(&model.outputW, &grad.outputW, &model.outputW, -epsilon);
+    _Sum(&model.outputB, &grad.outputB, &model.outputB, -epsilon);
+
+    for (int i = 0; i < model.hDepth; i++) {
+        _Sum(&model.hiddenW[i], &grad.hiddenW[i], &model.hiddenW[i], -epsilon);
+        _Sum(&model.hiddenB[i], &grad.hiddenB[i], &model.hiddenB[i], -epsilon);
+    }
+
+    CheckErrors(model.embeddingW.dataType == X_FLOAT && dedEmbeddings.dataType == X_FLOAT,
+                "Only float tensors are supported in hogwild training!");
+    CheckErrors(dedEmbeddings.unitNum == ngramNum * (model.n - 1) * model.eSize, 
+                "Wrong gradient of the embeddings!");
+
+    int eSize = model.eSize;
+    float * w = (float*)model.embeddingW.data;
+    float * g = (float*)dedEmbeddings.data;
+
+    /* w[word] = w[word] - epsilon * dE/dy for each word in the history */
+    for (int k = 0; k < ngramNum; k++) {
+        for (int i = 0; i < model.n - 1; i++) {
+            float * wRow = w + (MTYPE)ngrams[k].words[i] * eSize;
+            float * gRow = g + ((MTYPE)k * (model.n - 1) + i) * eSize;
+            for (int j = 0; j < eSize; j++)
+                wRow[j] -= epsilon * gRow[j];
+        }
+    }
+}
+
+/* the state shared by the threads of hogwild training */
+struct HogwildState
+{
+    /* the data file */
+    const char * fn;
+
+    /* shuffle the data or not */
+    bool isShuffled;
+
+    /* the model (parameters are shared by the threads) */
+    FNNModel * model;
+
+    /* number of model updates (of all threads) */
+    long long step;
+
+    /* number of ngrams (of all threads) */
+    long long wordCount;
+
+    /* the beginning of the training */
+    double startT;
+};
+
+/* 
+a thread of hogwild training. It reads its own shard of the data and
+updates the shared model without locks.
+>> args - the arguments: the shared state, the thread id, number of threads, 
+           the loss and the number of ngrams of this thread
+*/
+void TrainHogwildThread(XList * args)
+{
+    HogwildState * state = (HogwildState*)args->GetItem(0);
+    int id = *(int*)args->GetItem(1);
+    int num = *(int*)args->GetItem(2);
+    double * threadLoss = (double*)args->GetItem(3);
+    long long * threadWordCount = (long long*)args->GetItem(4);
+
+    FNNModel &model = *state->model;
+
+    /* gradients of the hidden and output layers (the embeddings are
+       updated row by row so we do not keep their gradient) */
+    FNNModel grad;
+    for (int i = 0; i < model.hDepth; i++) {
+        InitTensor(&grad.hiddenW[i], &model.hiddenW[i]);
+        InitTensor(&grad.hiddenB[i], &model.hiddenB[i]);
+    }
+    InitTensor(&grad.outputW, &model.outputW);
+    InitTensor(&grad.outputB, &model.outputB);
+    Clear(grad, false);
+
+    NGram * ngrams = new NGram[MAX_LINE_LENGTH_HERE];
+    NGramReader * reader = new NGramReader();
+    reader->shard = id;
+    reader->shardNum = num;
+
+    XCorpus binCorpus;
+    if(XCorpus::IsBinary(state->fn)){
+        binCorpus.Open(state->fn);
+        reader->corpus = &binCorpus;
+    }
+
+    bool isEnd = false;
+    
+    for(int epoch = 0; epoch < nEpoch && !isEnd; epoch++){
+
+        /* the same order of lines in all threads, and each of them 
+           keeps a different shard */
+        FILE * file = NULL;
+        if(reader->corpus != NULL){
+            if(state->isShuffled)
+                binCorpus.Shuffle(shuffleSeed + epoch, 0);
+            else
+                binCorpus.Rewind();
+        }
+        else{
+            file = fopen(state->fn, "rb");
+            CheckErrors(file, "Cannot open the training file");
+        }
+
+        reader->pin = 0;
+        reader->wordBufCount = 0;
+        reader->lineID = 0;
+
+        while(true){
+            int ngramNum = LoadNGrams(file, *reader, model.n, ngrams, sentBatch, wordBatch);
+
+            if(ngramNum <= 0)
+                break;
+
+            XTensor inputs[MAX_N_GRAM];
+            XTensor output;
+            XTensor gold;
+            XTensor goldIds;
+            XTensor dedEmbeddings;
+            FNNNet net;
+
+            for(int i = 0; i < model.n - 1; i++)
+                MakeWordBatch(inputs[i], ngrams, ngramNum, i, model.vSize, model.devID, NULL);
+            MakeWordBatch(gold, ngrams, ngramNum, model.n - 1, model.vSize, model.devID, NULL);
+            MakeWordIds(goldIds, ngrams, ngramNum, model.n - 1, model.devID, NULL);
+
+            /* forward and backward computation on the shared model */
+            Forward(inputs, output, model, net);
+            Backward(inputs, output, gold, CROSSENTROPY, model, grad, net, &dedEmbeddings);
+
+            /* lock-free update */
+            UpdateHogwild(model, grad, ngrams, ngramNum, dedEmbeddings, learningRate);
+
+            *threadLoss += -GetProb(output, goldIds);
+            *threadWordCount += ngramNum;
+
+            ATOMIC_ADD(state->wordCount, (long long)ngramNum);
+            long long step = ATOMIC_ADD(state->step, (long long)1) + 1;
+
+            if(step >= nStep){
+                isEnd = true;
+                break;
+            }
+
+            if (step % 100 == 0) {
+                double elapsed = GetClockSec() - state->startT;
+                long long wordCount = ATOMIC_LOAD(state->wordCount);
+                XPRINT6(0, stderr, "[INFO] elapsed=%.1fs, step=%lld, thread=%d, epoch=%d, ngram=%lld, ppl=%.3f\n",
+                           elapsed, step, id, epoch + 1, wordCount, exp(*threadLoss / *threadWordCount));
+            }
+        }
+
+        if(file != NULL)
+            fclose(file);
+    }
+
+    delete reader;
+    delete[] ngrams;
+}
+
+/* 
+train the model with a number of threads (hogwild). Each thread reads a shard 
+of the data and updates the shared model without any lock.
+See "Hogwild!: A Lock-Free Approach to Parallelizing Stochastic Gradient Descent"
+by Niu et al. (NIPS 2011)
+>> train - training data file
+>> isShuffled - shuffle the data file or not
+>> model - the fnn model
+*/
+void TrainHogwild(const char * train, bool isShuffled, FNNModel &model)
+{
+    char name[MAX_NAME_LENGTH];
+
+    /* the threads shuffle the same binary corpus in the same way */
+    if(isShuffled && !XCorpus::IsBinary(train)){
+        sprintf(name, "%s.bin", train);
+        XCorpus::Compile(train, name);
+    }
+    else
+        strcpy(name, train);
+
+    HogwildState state;
+    state.fn = name;
+    state.isShuffled = isShuffled;
+    state.model = &model;
+    state.step = 0;
+    state.wordCount = 0;
+
+    int * ids = new int[threadNum];
+    double * losses = new double[threadNum];
+    long long * wordCounts = new long long[threadNum];
+    XList * args = new XList[threadNum];
+    XList jobs(threadNum);
+    XList jobArgs(threadNum);
+
+    for(int i = 0; i < threadNum; i++){
+        ids[i] = i;
+        losses[i] = 0;
+        wordCounts[i] = 0;
+        args[i].Add(&state);
+        args[i].Add(ids + i);
+        args[i].Add(&threadNum);
+        args[i].Add(losses + i);
+        args[i].Add(wordCounts + i);
+        jobs.Add((void*)TrainHogwildThread);
+        jobArgs.Add(args + i);
+    }
+
+    XPRunner runner;
+    runner.Init(threadNum);
+
+    /* thread i always runs job i, i.e., the thread of a shard stays on its node */
+    if(isNuma)
+        runner.PinThreads();
+
+    state.startT = GetClockSec();
+
+    /* the threads run for a long time and we check them every 10ms */
+    runner.Run(&jobs, &jobArgs, 10.0F);
+
+    double elapsed = GetClockSec() - state.startT;
+
+    double loss = 0;
+    long long wordCount = 0;
+    for(int i = 0; i < threadNum; i++){
+        loss += losses[i];
+        wordCount += wordCounts[i];
+    }
+
+    XPRINT5(0, stderr, "[INFO] elapsed=%.1fs, step=%lld, thread=%d, ngram=%lld, ppl=%.3f\n",
+               elapsed, state.step, threadNum, wordCount, exp(loss / MAX(wordCount, 1)));
+    XPRINT3(0, stderr, "[INFO] hogwild training finished (took %.1fs, step=%lld, %.1f words/s)\n",
+               elapsed, state.step, elapsed > 0 ? wordCount / elapsed : 0);
+
+    delete[] ids;
+    delete[] losses;
+    delete[] wordCounts;
+    delete[] args;
+}
+
 /*
 get prediction probabilites of the gold words
 >> output - output probabilities
->> gold - gold standard
+>> goldIds - id of the gold word for each row of the output
 >> wordPobs - probability of each word
 << return - probability of the batch
 */
-float GetProb(XTensor &output, XTensor &gold, XTensor * wordProbs)
+float GetProb(XTensor &output, XTensor &goldIds, XTensor * wordProbs)
 {
-    XTensor probs;
-    InitTensor(&probs, &output);
-    
-    /* probs[i,j] = output[i,j] * gold[i,j] */
-    _Multiply(&output, &gold, &probs);
-
-    /* probability of each word */
+    /* probability of each word, i.e., wprobs[i] = output[i, goldIds[i]] */
     XTensor wprobs;
     InitTensor1D(&wprobs, output.GetDim(0), output.dataType, output.devID, output.mem);
-    _ReduceSum(&probs, &wprobs, 1);
+    _GatherByIndex(&output, &wprobs, &goldIds);
+
     if(wordProbs != NULL)
         _CopyValues(&wprobs, wordProbs);
-
-    /* reshape the tensor to fit it into the reduce procedure 
-       TODO: XTensor supports scalars */
-    int dims[2];
-    dims[0] = 1;
-    dims[1] = probs.unitNum;
-    probs.Reshape(2, dims);
  
     /* probability for the batch */
-    XTensor result;
-    InitTensor1D(&result, 1, X_FLOAT, output.devID, output.mem);
-    _ReduceSum(&probs, &result, 1);
-    
-    return result.Get1D(0);
+    return _ReduceSumAll(&wprobs);
 }
 
-int pin = 0;
-int wordBufCount = 0;
-
 /*
 load a minibatch of ngrams
 >> file - data file
@@ -635,10 +981,50 @@ load a minibatch of ngrams
 */
 int LoadNGrams(FILE * file, int n, NGram * ngrams, int sentNum, int wordNum)
 {
+    mainReader.corpus = corpus;
+    return LoadNGrams(file, mainReader, n, ngrams, sentNum, wordNum);
+}
+
+/*
+load a minibatch of ngrams with a reader
+>> file - data file
+>> reader - the reader (that keeps where we are in the file)
+>> n - order of the language model
+>> ngrams - the loaded ngrams
+>> sentNum - maximum sentences kept in the minibatch
+>> wordNum - maximum words kept in the minibatch
+*/
+int LoadNGrams(FILE * file, NGramReader &reader, int n, NGram * ngrams, int sentNum, int wordNum)
+{
+    int &pin = reader.pin;
+    int &wordBufCount = reader.wordBufCount;
+    char * lineBuf = reader.lineBuf;
+    int * wordBuf = reader.wordBuf;
+    int * seqLenBuf = reader.seqLenBuf;
+    XCorpus * corpus = reader.corpus;
+
     int num = 0;
     int lineNum = 0;
-    while(pin > 0 || fgets(lineBuf, MAX_LINE_LENGTH_HERE - 1, file)){
-        if(pin <= 0){
+    while(pin > 0 || corpus != NULL || fgets(lineBuf, MAX_LINE_LENGTH_HERE - 1, file)){
+        /* skip the lines of the other shards */
+        if(pin <= 0 && reader.shardNum > 1 && reader.lineID++ % reader.shardNum != reader.shard){
+            if(corpus != NULL && corpus->NextLine(wordBuf, seqLenBuf, MAX_LINE_LENGTH_HERE, MAX_LINE_LENGTH_HERE) < 0)
+                break;
+            continue;
+        }
+
+        /* a line of the binary corpus (no parsing is needed) */
+        if(pin <= 0 && corpus != NULL){
+            int seqNum = corpus->NextLine(wordBuf, seqLenBuf, MAX_LINE_LENGTH_HERE, MAX_LINE_LENGTH_HERE);
+            if(seqNum < 0)
+                break;
+
+            wordBufCount = 0;
+            for(int s = 0; s < seqNum; s++)
+                wordBufCount += seqLenBuf[s];
+            lineNum++;
+        }
+        else if(pin <= 0){
             int len = (int)strlen(lineBuf);
 
             while(lineBuf[len - 1] == '\r' || lineBuf[len - 1] == '\n'){
@@ -753,6 +1139,28 @@ void MakeWordBatch(XTensor &batch, NGram * ngrams, int ngramNum, int n, int vSiz
     delete[] cols;
 }
 
+/*
+make a tensor that keeps the ids of a batch of words
+>> ids - the tensor of the word ids
+>> ngrams - the ngram batch
+>> ngramNum - batch size
+>> n - indicate which word is kept for each ngram
+>> devID - device id
+>> mem - memory pool
+*/
+void MakeWordIds(XTensor &ids, NGram * ngrams, int ngramNum, int n, int devID, XMem * mem)
+{
+    int * words = new int[ngramNum];
+
+    for(int i = 0; i < ngramNum; i++)
+        words[i] = ngrams[i].words[n];
+
+    InitTensor1D(&ids, ngramNum, X_INT, devID, mem);
+    ids.SetData(words, ngramNum);
+
+    delete[] words;
+}
+
 /*
 forward procedure
 >> inputs - input word representations
@@ -862,9 +1270,11 @@ backward procedure
 >> model - the fnn model
 >> grad - the model that keeps the gradient information
 >> net - the network that keeps the internal tensors generated in the process
+>> dedEmbeddings - gradient of the concatenated embeddings. If it is not NULL, we keep
+                   the gradient here and skip the (dense) gradient of the embedding matrix.
 */
 void Backward(XTensor inputs[], XTensor &output, XTensor &gold, LOSS_FUNCTION_NAME loss, 
-              FNNModel &model,  FNNModel &grad, FNNNet &net)
+              FNNModel &model,  FNNModel &grad, FNNNet &net, XTensor * dedEmbeddings)
 {
     int batchSize = output.GetDim(0);
     int n = model.n;
@@ -943,6 +1353,16 @@ void Backward(XTensor inputs[], XTensor &output, XTensor &gold, LOSS_FUNCTION_NA
             _CopyValues(&dedx, &gradPassed);
     }
 
+    /* gradient of the concatenation of the embedding layers */
+    XTensor &dedyCat = depth > 0 ? dedxBottom : dedx;
+
+    /* the embedding matrix is updated row by row by the caller */
+    if (dedEmbeddings != NULL) {
+        InitTensor(dedEmbeddings, &dedyCat);
+        _CopyValues(&dedyCat, dedEmbeddings);
+        return;
+    }
+
     XList eList(n - 1);
 
     /* back-propagation for the embedding layer */
@@ -951,9 +1371,6 @@ void Backward(XTensor inputs[], XTensor &output, XTensor &gold, LOSS_FUNCTION_NA
         eList.Add(dedy);
     }
 
-    /* gradient of the concatenation of the embedding layers */
-    XTensor &dedyCat = depth > 0 ? dedxBottom : dedx;
-
     /* split the concatenation of gradients of the embeddings */
     _Split(&dedyCat, &eList, 1, n - 1);
 
@@ -1130,11 +1547,26 @@ void Test(const char * test, const char * result, FNNModel &model)
     double startT = GetClockSec();
 
     /* data files */
-    FILE * file = fopen(test, "rb");
-    CheckErrors(file, "Cannot read the test file");
+    XCorpus * trainCorpus = corpus;
+    XCorpus binCorpus;
+    FILE * file = NULL;
+    corpus = NULL;
+    if(XCorpus::IsBinary(test)){
+        binCorpus.Open(test);
+        corpus = &binCorpus;
+    }
+    else{
+        file = fopen(test, "rb");
+        CheckErrors(file, "Cannot read the test file");
+    }
     FILE * ofile = fopen(result, "wb");
     CheckErrors(ofile, "Cannot open the output file");
 
+    /* the batch scorer (with the cache of the contexts) */
+    FNNLMScorer scorer;
+    if (cacheSize > 0)
+        scorer.Init(&model, cacheSize);
+
     int ngramNum = 1;
     while (ngramNum > 0) {
 
@@ -1144,43 +1576,53 @@ void Test(const char * test, const char * result, FNNModel &model)
         if (ngramNum <= 0)
             break;
 
-        /* previous n - 1 words */
-        XTensor inputs[MAX_N_GRAM];
+        /* prediction probabilities */
+        XTensor probs;
+        InitTensor1D(&probs, ngramNum);
+
+        float prob = 0;
+
+        if (cacheSize > 0) {
+            /* the states of the contexts are computed once for all sentences */
+            scorer.Score(ngrams, ngramNum, (float*)probs.data);
+            for (int i = 0; i < ngramNum; i++)
+                prob += probs.Get1D(i);
+        }
+        else {
+            /* previous n - 1 words */
+            XTensor inputs[MAX_N_GRAM];
 
-        /* the predicted word */
-        XTensor output;
+            /* the predicted word */
+            XTensor output;
 
-        /* the gold standard */
-        XTensor gold;
+            /* ids of the gold words (we need no dense gold tensor for scoring) */
+            XTensor goldIds;
         
-        /* make the input tensor for position i */
-        for (int i = 0; i < model.n - 1; i++)
-            MakeWordBatch(inputs[i], ngrams, ngramNum, i, model.vSize, model.devID, model.mem);
+            /* make the input tensor for position i */
+            for (int i = 0; i < model.n - 1; i++)
+                MakeWordBatch(inputs[i], ngrams, ngramNum, i, model.vSize, model.devID, model.mem);
 
-        /* make the gold tensor */
-        MakeWordBatch(gold, ngrams, ngramNum, model.n - 1, model.vSize, model.devID, model.mem);
+            /* make the gold ids */
+            MakeWordIds(goldIds, ngrams, ngramNum, model.n - 1, model.devID, model.mem);
 
-        if (!autoDiff) {
-            /* prepare an empty network for building the fnn */
-            FNNNet net;
+            if (!autoDiff) {
+                /* prepare an empty network for building the fnn */
+                FNNNet net;
 
-            /* forward computation */
-            Forward(inputs, output, model, net);
-        }
-        else {			
-			/* this is implemented by gather function */
-            ForwardAutoDiff(ngrams, ngramNum, output, model);
-				
-			/* this is implemented by multiply function */
-			//ForwardAutoDiff(inputs, output, model);
-        }
+                /* forward computation */
+                Forward(inputs, output, model, net);
+            }
+            else {
+                /* this is implemented by gather function */
+                ForwardAutoDiff(ngrams, ngramNum, output, model);
 
-        /* prediction probabilities */
-        XTensor probs;
-        InitTensor1D(&probs, ngramNum);
+                /* this is implemented by multiply function */
+                //ForwardAutoDiff(inputs, output, model);
+            }
 
-        /* get probabilities */
-        float prob = GetProb(output, gold, &probs);
+            /* get probabilities */
+            prob = GetProb(output, goldIds, &probs);
+        }
 
         /* dump the test result */
         for (int i = 0; i < model.n - 1; i++)
@@ -1199,7 +1641,9 @@ void Test(const char * test, const char * result, FNNModel &model)
         sentCount += 1;
     }
 
-    fclose(file);
+    if(file != NULL)
+        fclose(file);
+    corpus = trainCorpus;
 
     double elapsed = GetClockSec() - startT;
 
@@ -1207,6 +1651,11 @@ void Test(const char * test, const char * result, FNNModel &model)
     XPRINT3(0, stderr, "[INFO] test finished (took %.1fs, sentence=%d and ngram=%d)\n", 
                elapsed, sentCount, wordCount);
 
+    if (cacheSize > 0) {
+        XPRINT3(0, stderr, "[INFO] context cache: lookup=%lld, hit=%lld and computed=%lld\n",
+                scorer.lookupCount, scorer.hitCount, scorer.computeCount);
+    }
+
     delete[] ngrams;
 }
 
@@ -0,0 +1,539 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "FNNLMScorer.h"
+#include "../../tensor/XUtility.h"
+#include "../../tensor/function/FHeader.h"
+
+namespace fnnlm
+{
+
+/* constructor */
+FNNContextCache::FNNContextCache()
+{
+    contextSize = 0;
+    stateSize = 0;
+    capacity = 0;
+    count = 0;
+    words = NULL;
+    states = NULL;
+    logZ = NULL;
+    prev = NULL;
+    next = NULL;
+    head = -1;
+    tail = -1;
+    buckets = NULL;
+    bucketNum = 0;
+    chain = NULL;
+}
+
+/* de-constructor */
+FNNContextCache::~FNNContextCache()
+{
+    delete[] words;
+    delete[] states;
+    delete[] logZ;
+    delete[] prev;
+    delete[] next;
+    delete[] buckets;
+    delete[] chain;
+}
+
+/*
+initialize the cache
+>> myContextSize - number of the words in a context
+>> myStateSize - size of the state of a context
+>> myCapacity - maximum number of the contexts
+*/
+void FNNContextCache::Init(int myContextSize, int myStateSize, int myCapacity)
+{
+    CheckErrors(myContextSize > 0 && myStateSize > 0 && myCapacity > 0, "Illegal cache!");
+
+    contextSize = myContextSize;
+    stateSize = myStateSize;
+    capacity = myCapacity;
+    count = 0;
+    head = -1;
+    tail = -1;
+
+    /* about two buckets for each entry (a power of 2) */
+    bucketNum = 1;
+    while(bucketNum < capacity * 2)
+        bucketNum <<= 1;
+
+    delete[] words;
+    delete[] states;
+    delete[] logZ;
+    delete[] prev;
+    delete[] next;
+    delete[] buckets;
+    delete[] chain;
+
+    words = new int[capacity * contextSize];
+    states = new float[(long long)capacity * stateSize];
+    logZ = new float[capacity];
+    prev = new int[capacity];
+    next = new int[capacity];
+    chain = new int[capacity];
+    buckets = new int[bucketNum];
+
+    for(int i = 0; i < bucketNum; i++)
+        buckets[i] = -1;
+}
+
+/* hash of a context */
+int FNNContextCache::Hash(const int * context)
+{
+    unsigned int h = 2166136261U;
+    for(int i = 0; i < contextSize; i++){
+        h ^= (unsigned int)context[i];
+        h *= 16777619U;
+    }
+    return (int)(h & (bucketNum - 1));
+}
+
+/*
+find a context
+>> context - the words of the context
+<< return - the entry of the context (-1 if it is not in the cache)
+*/
+int FNNContextCache::Find(const int * context)
+{
+    for(int e = buckets[Hash(context)]; e >= 0; e = chain[e]){
+        if(!memcmp(words + e * contextSize, context, sizeof(int) * contextSize))
+            return e;
+    }
+    return -1;
+}
+
+/* mark an entry as the most recently used one */
+void FNNContextCache::Touch(int entry)
+{
+    if(entry == head)
+        return;
+
+    /* take it out of the list */
+    next[prev[entry]] = next[entry];
+    if(entry == tail)
+        tail = prev[entry];
+    else
+        prev[next[entry]] = prev[entry];
+
+    /* and put it at the head */
+    prev[entry] = -1;
+    next[entry] = head;
+    prev[head] = entry;
+    head = entry;
+}
+
+/* remove an entry from its hash bucket */
+void FNNContextCache::Unchain(int entry)
+{
+    int * p = buckets + Hash(words + entry * contextSize);
+    while(*p != entry)
+        p = chain + *p;
+    *p = chain[entry];
+}
+
+/*
+add a context. If the cache is full, we drop the least recently used
+context and reuse its entry. The state of the new entry is to be filled
+by the caller.
+>> context - the words of the context
+<< return - the entry of the context
+*/
+int FNNContextCache::Add(const int * context)
+{
+    int e;
+
+    if(count < capacity){
+        e = count++;
+        prev[e] = -1;
+        next[e] = head;
+        if(head >= 0)
+            prev[head] = e;
+        else
+            tail = e;
+        head = e;
+    }
+    else{
+        e = tail;
+        Unchain(e);
+        Touch(e);
+    }
+
+    memcpy(words + e * contextSize, context, sizeof(int) * contextSize);
+
+    int b = Hash(context);
+    chain[e] = buckets[b];
+    buckets[b] = e;
+
+    return e;
+}
+
+/* constructor */
+FNNLMScorer::FNNLMScorer()
+{
+    model = NULL;
+    outputWT = NULL;
+    outputB = NULL;
+    lookupCount = 0;
+    hitCount = 0;
+    computeCount = 0;
+}
+
+/* de-constructor */
+FNNLMScorer::~FNNLMScorer()
+{
+    delete[] outputWT;
+    delete[] outputB;
+}
+
+/*
+initialize the scorer. The parameters are read once here, i.e., the
+scorer must be initialized again if the model is updated.
+>> myModel - the model
+>> cacheSize - maximum number of the contexts in the cache
+*/
+void FNNLMScorer::Init(FNNModel * myModel, int cacheSize)
+{
+    model = myModel;
+
+    CheckErrors(model->n > 1, "The scorer needs a context!");
+
+    int n = model->n;
+    int vSize = model->vSize;
+    int stateSize = model->hDepth > 0 ? model->hSize : (n - 1) * model->eSize;
+
+    cache.Init(n - 1, stateSize, cacheSize);
+
+    /* a copy of the output layer on the host, where the output matrix is
+       transposed so that the column of a word is contiguous */
+    float * w = new float[stateSize * vSize];
+    XMemCopy(w, -1, model->outputW.data, model->outputW.devID, sizeof(float) * stateSize * vSize);
+
+    delete[] outputWT;
+    delete[] outputB;
+    outputWT = new float[vSize * stateSize];
+    outputB = new float[vSize];
+
+    for(int i = 0; i < stateSize; i++){
+        for(int j = 0; j < vSize; j++)
+            outputWT[j * stateSize + i] = w[i * vSize + j];
+    }
+
+    XMemCopy(outputB, -1, model->outputB.data, model->outputB.devID, sizeof(float) * vSize);
+
+    delete[] w;
+
+    lookupCount = 0;
+    hitCount = 0;
+    computeCount = 0;
+}
+
+/*
+make sure the contexts of a batch of n-grams are in the cache. The
+contexts that are not found are computed in one forward pass (once for
+each distinct context).
+>> ngrams - the n-grams (no more than the capacity of the cache)
+>> num - number of the n-grams
+>> entries - the cache entry of each n-gram
+*/
+void FNNLMScorer::Prepare(NGram * ngrams, int num, int * entries)
+{
+    CheckErrors(num <= cache.capacity, "Too many n-grams for the cache!");
+
+    int * missing = new int[num];
+    int missingNum = 0;
+
+    for(int i = 0; i < num; i++){
+        int e = cache.Find(ngrams[i].words);
+
+        /* a context that is computed for a previous n-gram in the batch
+           is not computed again */
+        if(e >= 0){
+            cache.Touch(e);
+            hitCount++;
+        }
+        else{
+            e = cache.Add(ngrams[i].words);
+            missing[missingNum++] = i;
+        }
+
+        entries[i] = e;
+        lookupCount++;
+    }
+
+    if(missingNum > 0){
+        int stateSize = cache.stateSize;
+        int vSize = model->vSize;
+
+        XTensor states;
+        XTensor rows;
+        ComputeStates(ngrams, missing, missingNum, &states);
+        ComputeRows(&states, &rows);
+
+        float * stateValues = new float[missingNum * stateSize];
+        float * rowValues = new float[missingNum * vSize];
+        XMemCopy(stateValues, -1, states.data, states.devID, sizeof(float) * missingNum * stateSize);
+        XMemCopy(rowValues, -1, rows.data, rows.devID, sizeof(float) * missingNum * vSize);
+
+        for(int j = 0; j < missingNum; j++){
+            int e = entries[missing[j]];
+            float * h = cache.states + (long long)e * stateSize;
+            memcpy(h, stateValues + j * stateSize, sizeof(float) * stateSize);
+
+            /* logZ = s[0] - log P(0 | context) where s[0] is the score of word 0 */
+            float s = outputB[0];
+            for(int k = 0; k < stateSize; k++)
+                s += h[k] * outputWT[k];
+            cache.logZ[e] = s - rowValues[j * vSize];
+        }
+
+        computeCount += missingNum;
+
+        delete[] stateValues;
+        delete[] rowValues;
+    }
+
+    delete[] missing;
+}
+
+/*
+log-probability of the last word of each n-gram, i.e.,
+log P(w_{n-1} | w_0...w_{n-2})
+>> ngrams - the n-grams
+>> num - number of the n-grams
+>> logProbs - the log-probabilities (num items)
+*/
+void FNNLMScorer::Score(NGram * ngrams, int num, float * logProbs)
+{
+    int stateSize = cache.stateSize;
+    int last = model->n - 1;
+    int * entries = new int[MIN(num, cache.capacity)];
+
+    for(int beg = 0; beg < num; beg += cache.capacity){
+        int size = MIN(cache.capacity, num - beg);
+
+        Prepare(ngrams + beg, size, entries);
+
+        for(int i = 0; i < size; i++){
+            int e = entries[i];
+            int w = ngrams[beg + i].words[last];
+            const float * h = cache.states + (long long)e * stateSize;
+            const float * col = outputWT + (long long)w * stateSize;
+
+            float s = outputB[w];
+            for(int k = 0; k < stateSize; k++)
+                s += h[k] * col[k];
+
+            logProbs[beg + i] = s - cache.logZ[e];
+        }
+    }
+
+    delete[] entries;
+}
+
+/*
+log-probabilities of all words for the context of each n-gram (the last
+word of an n-gram is not used). The output layer is computed once for
+each distinct context.
+>> ngrams - the n-grams
+>> num - number of the n-grams
+>> rows - the log-probabilities (num * vSize)
+*/
+void FNNLMScorer::ScoreRows(NGram * ngrams, int num, XTensor * rows)
+{
+    int vSize = model->vSize;
+    int chunkSize = MIN(num, cache.capacity);
+    int * entries = new int[chunkSize];
+    int * uniqEntries = new int[chunkSize];
+    int * positions = new int[chunkSize];
+    int * marks = new int[cache.capacity];
+
+    for(int i = 0; i < cache.capacity; i++)
+        marks[i] = -1;
+
+    InitTensor2D(rows, num, vSize, X_FLOAT, model->devID, model->mem);
+
+    for(int beg = 0; beg < num; beg += cache.capacity){
+        int size = MIN(cache.capacity, num - beg);
+        int uniqNum = 0;
+
+        Prepare(ngrams + beg, size, entries);
+
+        /* the distinct contexts of the chunk */
+        for(int i = 0; i < size; i++){
+            int e = entries[i];
+            if(marks[e] < 0){
+                marks[e] = uniqNum;
+                uniqEntries[uniqNum++] = e;
+            }
+            positions[i] = marks[e];
+        }
+
+        for(int i = 0; i < uniqNum; i++)
+            marks[uniqEntries[i]] = -1;
+
+        XTensor states;
+        XTensor uniqRows;
+        XTensor index;
+        XTensor chunkRows;
+
+        LoadStates(uniqEntries, uniqNum, &states);
+        ComputeRows(&states, &uniqRows);
+
+        InitTensor1D(&index, size, X_INT, model->devID, model->mem);
+        index.SetData(positions, size);
+        InitTensor2D(&chunkRows, size, vSize, X_FLOAT, model->devID, model->mem);
+        _Gather(&uniqRows, &chunkRows, &index);
+
+        XMemCopy((float*)rows->data + (long long)beg * vSize, rows->devID,
+                 chunkRows.data, chunkRows.devID, sizeof(float) * size * vSize);
+    }
+
+    delete[] entries;
+    delete[] uniqEntries;
+    delete[] positions;
+    delete[] marks;
+}
+
+/*
+the k most probable continuations of the context of each n-gram
+>> ngrams - the n-grams
+>> num - number of the n-grams
+>> k - number of the continuations
+>> words - the continuations (num * k, the most probable first)
+>> logProbs - their log-probabilities (num * k)
+*/
+void FNNLMScorer::TopK(NGram * ngrams, int num, int k, int * words, float * logProbs)
+{
+    CheckErrors(k > 0 && k <= model->vSize, "Illegal k!");
+
+    XTensor rows;
+    XTensor values;
+    XTensor index;
+
+    ScoreRows(ngrams, num, &rows);
+
+    InitTensor2D(&values, num, k, X_FLOAT, model->devID, model->mem);
+    InitTensor2D(&index, num, k, X_INT, model->devID, model->mem);
+    _TopK(&rows, &values, &index, 1, k);
+
+    XMemCopy(words, -1, index.data, index.devID, sizeof(int) * num * k);
+    XMemCopy(logProbs, -1, values.data, values.devID, sizeof(float) * num * k);
+}
+
+/*
+compute the states of the contexts, i.e., the output of the last hidden
+layer (see Forward in FNNLM.cpp)
+>> ngrams - the n-grams
+>> ids - the n-grams whose contexts we compute
+>> num - number of the contexts
+>> states - the states (num * stateSize)
+*/
+void FNNLMScorer::ComputeStates(NGram * ngrams, int * ids, int num, XTensor * states)
+{
+    int n = model->n;
+    int eSize = model->eSize;
+    int devID = model->devID;
+    XMem * mem = model->mem;
+
+    int * wordIds = new int[num * (n - 1)];
+    for(int i = 0; i < num; i++){
+        for(int j = 0; j < n - 1; j++)
+            wordIds[i * (n - 1) + j] = ngrams[ids[i]].words[j];
+    }
+
+    XTensor words;
+    XTensor embeddings;
+    InitTensor1D(&words, num * (n - 1), X_INT, devID, mem);
+    words.SetData(wordIds, num * (n - 1));
+    InitTensor2D(&embeddings, num * (n - 1), eSize, X_FLOAT, devID, mem);
+
+    /* the embeddings of the n - 1 words of a context are next to each other,
+       i.e., they are already concatenated */
+    _Gather(&model->embeddingW, &embeddings, &words);
+    embeddings.Reshape(num, (n - 1) * eSize);
+
+    delete[] wordIds;
+
+    if(model->hDepth == 0){
+        InitTensor(states, &embeddings);
+        _CopyValues(&embeddings, states);
+        return;
+    }
+
+    XTensor hidden;
+    for(int i = 0; i < model->hDepth; i++){
+        XTensor &h = i == model->hDepth - 1 ? *states : hidden;
+        XTensor &input = i == 0 ? embeddings : hidden;
+        XTensor s;
+
+        InitTensor2D(&s, num, model->hSize, X_FLOAT, devID, mem);
+
+        /* h = hardtanh(input * w + b) */
+        _MatrixMul(&input, X_NOTRANS, &model->hiddenW[i], X_NOTRANS, &s);
+        _SumDim(&s, &model->hiddenB[i], 1);
+
+        InitTensor(&h, &s);
+        _HardTanH(&s, &h);
+    }
+}
+
+/*
+compute the log-probabilities of all words from the states
+>> states - the states (num * stateSize)
+>> rows - the log-probabilities (num * vSize)
+*/
+void FNNLMScorer::ComputeRows(XTensor * states, XTensor * rows)
+{
+    int num = states->GetDim(0);
+
+    XTensor s;
+    InitTensor2D(&s, num, model->vSize, X_FLOAT, model->devID, model->mem);
+
+    /* rows = logsoftmax(states * w + b) */
+    _MatrixMul(states, X_NOTRANS, &model->outputW, X_NOTRANS, &s);
+    _SumDim(&s, &model->outputB, 1);
+
+    InitTensor(rows, &s);
+    _LogSoftmax(&s, rows, 1);
+}
+
+/*
+load the states of the cache entries into a tensor
+>> entries - the entries
+>> num - number of the entries
+>> states - the states (num * stateSize)
+*/
+void FNNLMScorer::LoadStates(int * entries, int num, XTensor * states)
+{
+    int stateSize = cache.stateSize;
+    float * values = new float[num * stateSize];
+
+    for(int i = 0; i < num; i++)
+        memcpy(values + i * stateSize, cache.states + (long long)entries[i] * stateSize, sizeof(float) * stateSize);
+
+    InitTensor2D(states, num, stateSize, X_FLOAT, model->devID, model->mem);
+    states->SetData(values, num * stateSize);
+
+    delete[] values;
+}
+
+}
@@ -0,0 +1,166 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * Batch scoring of n-grams with a trained FNNLM (e.g., for the queries of
+ * a decoder). The output of the last hidden layer depends on the n - 1
+ * context words only, so we keep it for each context in an LRU cache,
+ * together with the normalizer of the output softmax (logZ). For a batch
+ * of n-grams:
+ *   1) the contexts are looked up in the cache, and the contexts that
+ *      are missing are computed once each (in a single forward pass),
+ *      even if they appear many times in the batch;
+ *   2) log P(w | context) = h * outputW[:, w] + outputB[w] - logZ, i.e.,
+ *      a dot-product for each n-gram rather than a row of the output
+ *      layer.
+ * Full rows of log-probabilities and top-k continuations are available
+ * on request (they need the output layer for the requested contexts).
+ *
+ */
+
+#ifndef __FNNLMSCORER_H__
+#define __FNNLMSCORER_H__
+
+#include "FNNLM.h"
+
+namespace fnnlm
+{
+
+/* the LRU cache of the context states */
+struct FNNContextCache
+{
+    /* number of the words in a context (n - 1) */
+    int contextSize;
+
+    /* size of the state of a context (the last hidden layer) */
+    int stateSize;
+
+    /* maximum number of the contexts */
+    int capacity;
+
+    /* number of the contexts in the cache */
+    int count;
+
+    /* words of the contexts (capacity * contextSize) */
+    int * words;
+
+    /* states of the contexts (capacity * stateSize) */
+    float * states;
+
+    /* normalizer of the output softmax of each context */
+    float * logZ;
+
+    /* the LRU list (head = the most recently used entry) */
+    int * prev;
+    int * next;
+    int head;
+    int tail;
+
+    /* hash buckets (the first entry of each bucket) */
+    int * buckets;
+
+    /* number of the buckets */
+    int bucketNum;
+
+    /* the next entry in the same bucket */
+    int * chain;
+
+    /* constructor */
+    FNNContextCache();
+
+    /* de-constructor */
+    ~FNNContextCache();
+
+    /* initialize the cache */
+    void Init(int myContextSize, int myStateSize, int myCapacity);
+
+    /* find a context (-1 if it is not in the cache) */
+    int Find(const int * context);
+
+    /* add a context (the least recently used one is dropped if the cache is full) */
+    int Add(const int * context);
+
+    /* mark an entry as the most recently used one */
+    void Touch(int entry);
+
+    /* hash of a context */
+    int Hash(const int * context);
+
+    /* remove an entry from its hash bucket */
+    void Unchain(int entry);
+};
+
+/* batch scoring of n-grams with the context states cached */
+class FNNLMScorer
+{
+public:
+    /* the model */
+    FNNModel * model;
+
+    /* the cache */
+    FNNContextCache cache;
+
+    /* the output matrix (transposed, vSize * stateSize) and the bias on the host */
+    float * outputWT;
+    float * outputB;
+
+    /* number of the lookups of the contexts */
+    long long lookupCount;
+
+    /* number of the contexts that were found in the cache */
+    long long hitCount;
+
+    /* number of the contexts that were computed */
+    long long computeCount;
+
+public:
+    /* constructor */
+    FNNLMScorer();
+
+    /* de-constructor */
+    ~FNNLMScorer();
+
+    /* initialize the scorer */
+    void Init(FNNModel * myModel, int cacheSize);
+
+    /* log-probability of the last word of each n-gram */
+    void Score(NGram * ngrams, int num, float * logProbs);
+
+    /* log-probabilities of all words for the context of each n-gram */
+    void ScoreRows(NGram * ngrams, int num, XTensor * rows);
+
+    /* the k most probable continuations of the context of each n-gram */
+    void TopK(NGram * ngrams, int num, int k, int * words, float * logProbs);
+
+    /* make sure the contexts are in the cache */
+    void Prepare(NGram * ngrams, int num, int * entries);
+
+protected:
+    /* compute the states of the contexts */
+    void ComputeStates(NGram * ngrams, int * ids, int num, XTensor * states);
+
+    /* compute the log-probabilities of all words from the states */
+    void ComputeRows(XTensor * states, XTensor * rows);
+
+    /* load the states of the cache entries into a tensor */
+    void LoadStates(int * entries, int num, XTensor * states);
+};
+
+}
+
+#endif
@@ -99,9 +99,15 @@ make the network
 >> v - values
 >> mask - as it is
 >> isTraining - indicates whether the model is used for training
+>> selfatt - indicates whether it is self-attention (k, q and v are the same)
+>> packedQ - the packed batch of the queries (NULL means that they are padded).
+             The linear transformations run on the real tokens and the results
+             are unpacked for the dot-product attention of each sequence
+>> packedKV - the packed batch of the keys and values (for selfatt = false)
 << return - multi-attention result
 */
-XTensor T2TAttention::Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bool isTraining, bool selfatt)
+XTensor T2TAttention::Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bool isTraining, bool selfatt,
+                           T2TPackedBatch * packedQ, T2TPackedBatch * packedKV)
 {
     XTensor k2;
     XTensor q2;
@@ -114,6 +120,9 @@ XTensor T2TAttention::Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bo
 
         con = MMul(k, wbig);
 
+        if(packedQ != NULL)
+            con = packedQ->Unpack(con);
+
         int d1 = con.GetDim(0);
         int d2 = con.GetDim(1);
         int d3 = con.GetDim(2) / 3;
@@ -134,8 +143,53 @@ XTensor T2TAttention::Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bo
         k2 = MMul(k, wk);
         q2 = MMul(q, wq);
         v2 = MMul(v, wv);
+
+        if(packedQ != NULL)
+            q2 = packedQ->Unpack(q2);
+        if(packedKV != NULL){
+            k2 = packedKV->Unpack(k2);
+            v2 = packedKV->Unpack(v2);
+        }
     }
 
+    return MakeAttention(k2, q2, v2, mask, isTraining, packedQ);
+}
+
+/* 
+make the network with the keys and values that have already been transformed. 
+This is used when many queries share the same keys and values, e.g., the 
+encoder-decoder attention of many target candidates of the same source sentence.
+>> k2 - transformed keys (i.e., k * wk)
+>> q - queries (not transformed)
+>> v2 - transformed values (i.e., v * wv)
+>> mask - as it is
+>> isTraining - indicates whether the model is used for training
+<< return - multi-attention result
+*/
+XTensor T2TAttention::MakeWithKV(XTensor &k2, XTensor &q, XTensor &v2, XTensor &mask, bool isTraining)
+{
+    XTensor q2;
+
+    /* linear transofmration of the queries */
+    q2 = MMul(q, wq);
+
+    return MakeAttention(k2, q2, v2, mask, isTraining);
+}
+
+/* 
+make the attention network given the transformed keys, queries and values 
+>> k2 - transformed keys
+>> q2 - transformed queries
+>> v2 - transformed values
+>> mask - as it is
+>> isTraining - indicates whether the model is used for training
+>> packedQ - the packed batch of the queries. The result is packed
+             before the output transformation if it is not NULL
+<< return - multi-attention result
+*/
+XTensor T2TAttention::MakeAttention(XTensor &k2, XTensor &q2, XTensor &v2, XTensor &mask, bool isTraining,
+                                    T2TPackedBatch * packedQ)
+{
     XTensor kheads;
     XTensor qheads;
     XTensor vheads;
@@ -165,7 +219,13 @@ XTensor T2TAttention::Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bo
     att = BMMul(scalar, vheads);
 
     /* concatenate the heads */
-    return MMul(Merge(att, att.order - 1), wa);
+    XTensor heads;
+    heads = Merge(att, att.order - 1);
+
+    if(packedQ != NULL)
+        heads = packedQ->Pack(heads);
+
+    return MMul(heads, wa);
 }
 
 }
@@ -22,6 +22,7 @@
 #ifndef __T2TATTENTION_H__
 #define __T2TATTENTION_H__
 
+#include "T2TPackedBatch.h"
 #include "../../network/XNet.h"
 
 using namespace nts;
@@ -97,7 +98,15 @@ public:
                    int myDevID = -1, XMem * myMem = NULL);
 
     /* make the network */
-    XTensor Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bool isTraining, bool selfatt);
+    XTensor Make(XTensor &k, XTensor &q, XTensor &v, XTensor &mask, bool isTraining, bool selfatt,
+                 T2TPackedBatch * packedQ = NULL, T2TPackedBatch * packedKV = NULL);
+
+    /* make the network with the keys and values that have already been transformed */
+    XTensor MakeWithKV(XTensor &k2, XTensor &q, XTensor &v2, XTensor &mask, bool isTraining);
+
+    /* make the attention network given the transformed keys, queries and values */
+    XTensor MakeAttention(XTensor &k2, XTensor &q2, XTensor &v2, XTensor &mask, bool isTraining,
+                          T2TPackedBatch * packedQ = NULL);
 };
 
 }
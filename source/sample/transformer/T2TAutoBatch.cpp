@@ -0,0 +1,233 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+#include "T2TAutoBatch.h"
+#include "T2TUtility.h"
+#include "../../tensor/XUtility.h"
+
+namespace transformer
+{
+
+/* constructor */
+T2TAutoBatch::T2TAutoBatch()
+{
+    isEnabled = false;
+    memLimit = 0;
+    maxLen = 128;
+    shrinkFactor = 0.75F;
+    baseSize = 0;
+    coef[0] = 0;
+    coef[1] = 0;
+    coef[2] = 0;
+    probeNum = 0;
+    budget = 0;
+    peakSize = 0;
+    retryNum = 0;
+}
+
+/* de-constructor */
+T2TAutoBatch::~T2TAutoBatch()
+{
+}
+
+/* 
+initialize the parameters
+>> argc - number of arguments
+>> argv - list of pointers to the arguments
+>> memSize - the default memory limit (in MB)
+*/
+void T2TAutoBatch::Init(int argc, char ** argv, int memSize)
+{
+    int limit = 0;
+
+    LoadParamBool(argc, argv, "autobatch", &isEnabled, false);
+    LoadParamInt(argc, argv, "automem", &limit, memSize);
+    LoadParamInt(argc, argv, "autobatchlen", &maxLen, 128);
+    LoadParamFloat(argc, argv, "autoshrink", &shrinkFactor, 0.75F);
+
+    CheckNTErrors(limit > 0, "Illegal memory limit!");
+    CheckNTErrors(maxLen > 0, "Illegal length for the batch sizing!");
+    CheckNTErrors(shrinkFactor > 0 && shrinkFactor < 1.0F, "Illegal shrinking factor!");
+
+    memLimit = (MTYPE)limit * MILLION;
+}
+
+/* 
+add a probe
+>> tokens - number of tokens (with padding) of the batch
+>> len - length of the batch
+>> size - memory used by the step
+*/
+void T2TAutoBatch::AddProbe(int tokens, int len, MTYPE size)
+{
+    CheckNTErrors(probeNum < MAX_AUTO_BATCH_PROBE_NUM, "Too many probes!");
+
+    probeTokens[probeNum] = tokens;
+    probeLens[probeNum] = len;
+    probeSizes[probeNum] = size;
+    probeNum++;
+}
+
+/* 
+fit the memory model by least squares, i.e., we solve the normal
+equations (X^T X) coef = X^T y with the features x = (1, tokens, tokens * length)
+*/
+void T2TAutoBatch::Fit()
+{
+    CheckNTErrors(probeNum >= 3, "We need at least 3 probes!");
+
+    double m[3][4];
+    memset(m, 0, sizeof(m));
+
+    for(int p = 0; p < probeNum; p++){
+        double x[3] = {1.0, (double)probeTokens[p], (double)probeTokens[p] * probeLens[p]};
+        for(int i = 0; i < 3; i++){
+            for(int j = 0; j < 3; j++)
+                m[i][j] += x[i] * x[j];
+            m[i][3] += x[i] * (double)probeSizes[p];
+        }
+    }
+
+    /* Gaussian elimination with partial pivoting */
+    for(int i = 0; i < 3; i++){
+        int pivot = i;
+        for(int k = i + 1; k < 3; k++){
+            if(fabs(m[k][i]) > fabs(m[pivot][i]))
+                pivot = k;
+        }
+        for(int j = 0; j < 4; j++){
+            double t = m[i][j];
+            m[i][j] = m[pivot][j];
+            m[pivot][j] = t;
+        }
+
+        CheckNTErrors(fabs(m[i][i]) > 1e-12, "The probes are not enough to fit the memory model!");
+
+        for(int k = 0; k < 3; k++){
+            if(k == i)
+                continue;
+            double r = m[k][i] / m[i][i];
+            for(int j = i; j < 4; j++)
+                m[k][j] -= r * m[i][j];
+        }
+    }
+
+    for(int i = 0; i < 3; i++)
+        coef[i] = m[i][3] / m[i][i];
+
+    /* memory never goes down with the batch size */
+    coef[1] = MAX(coef[1], 0);
+    coef[2] = MAX(coef[2], 0);
+}
+
+/* 
+predict the memory of a step (not including the model)
+>> tokens - number of tokens (with padding) of the batch
+>> len - length of the batch
+*/
+double T2TAutoBatch::Predict(int tokens, int len)
+{
+    return coef[0] + coef[1] * tokens + coef[2] * (double)tokens * len;
+}
+
+/* 
+choose the token budget, i.e., the largest number of tokens whose
+batches of length "maxLen" fit the memory limit
+<< return - the budget
+*/
+int T2TAutoBatch::ChooseBudget()
+{
+    double room = (double)memLimit - (double)baseSize - coef[0];
+    double perToken = coef[1] + coef[2] * maxLen;
+
+    if(perToken <= 0){
+        /* the memory does not grow with the batch (in the probes), so we
+           keep the largest batch that we have seen */
+        budget = 0;
+        for(int p = 0; p < probeNum; p++)
+            budget = MAX(budget, probeTokens[p]);
+    }
+    else
+        budget = (int)MIN(room / perToken, (double)INT_MAX / 2);
+
+    if(budget < maxLen){
+        XPRINT3(0, stderr, "[WARNING] the memory limit (%.1fMB) is too small for batches of length %d (budget=%d)\n",
+                (double)memLimit / MILLION, maxLen, budget);
+        budget = maxLen;
+    }
+
+    return budget;
+}
+
+/* 
+check whether a batch fits the memory limit
+>> tokens - number of tokens (with padding) of the batch
+>> len - length of the batch
+*/
+bool T2TAutoBatch::Fits(int tokens, int len)
+{
+    return baseSize + Predict(tokens, len) <= (double)memLimit;
+}
+
+/* 
+make the budget smaller after a step goes over the limit
+>> tokens - number of tokens (with padding) of the step
+<< return - the new budget
+*/
+int T2TAutoBatch::Shrink(int tokens)
+{
+    budget = MAX((int)(MIN(budget, tokens) * shrinkFactor), 1);
+    return budget;
+}
+
+/* 
+show the model and the budget
+>> file - where to show
+*/
+void T2TAutoBatch::Show(FILE * file)
+{
+    for(int p = 0; p < probeNum; p++){
+        fprintf(file, "[INFO] auto batch probe: tokens=%d, len=%d, mem=%.1fMB (predicted=%.1fMB)\n",
+                probeTokens[p], probeLens[p], (double)probeSizes[p] / MILLION, 
+                Predict(probeTokens[p], probeLens[p]) / MILLION);
+    }
+
+    double predicted = baseSize + Predict(budget, maxLen);
+
+    fprintf(file, "[INFO] auto batch: mem = %.1fMB + %.1fKB * tokens + %.3fKB * tokens * len (model=%.1fMB)\n",
+            coef[0] / MILLION, coef[1] / 1000, coef[2] / 1000, (double)baseSize / MILLION);
+    fprintf(file, "[INFO] auto batch: budget=%d tokens (len=%d), limit=%.1fMB, predicted headroom=%.1fMB\n",
+            budget, maxLen, (double)memLimit / MILLION, ((double)memLimit - predicted) / MILLION);
+}
+
+/* 
+show the budget and the measured headroom
+>> file - where to show
+*/
+void T2TAutoBatch::ShowReport(FILE * file)
+{
+    double headroom = (double)memLimit - (double)peakSize;
+
+    fprintf(file, "[INFO] auto batch: budget=%d tokens, limit=%.1fMB, peak=%.1fMB, headroom=%.1fMB (%.1f%%), retried=%d\n",
+            budget, (double)memLimit / MILLION, (double)peakSize / MILLION, headroom / MILLION, 
+            100.0 * headroom / memLimit, retryNum);
+}
+
+}
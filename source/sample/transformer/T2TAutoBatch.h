@@ -0,0 +1,128 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Memory-aware batch sizing. The memory used by a training step (on top
+ * of the model and the optimizer) is measured for a few synthetic batches
+ * and fitted by
+ *     size = a + b * tokens + c * tokens * length
+ * where tokens = sentences * length (with padding). The last term covers
+ * the attention weights (sentences * length * length). The token budget
+ * is the largest one whose batches of the maximum length fit the memory
+ * limit. During training, batches that are not predicted to fit are split,
+ * and a step that goes over the limit of the memory pool is thrown away
+ * and retried with a smaller budget.
+ */
+
+#ifndef __T2TAUTOBATCH_H__
+#define __T2TAUTOBATCH_H__
+
+#include <stdio.h>
+#include "../../tensor/XMem.h"
+
+using namespace nts;
+
+namespace transformer
+{
+
+/* maximum number of the probes */
+#define MAX_AUTO_BATCH_PROBE_NUM 16
+
+/* token number of the smaller probes */
+#define AUTO_BATCH_PROBE_TOKENS 512
+
+/* memory-aware batch sizing */
+class T2TAutoBatch
+{
+public:
+    /* indicates whether the batch size is chosen automatically */
+    bool isEnabled;
+
+    /* the target memory limit (in bytes) */
+    MTYPE memLimit;
+
+    /* the length for which the budget is chosen */
+    int maxLen;
+
+    /* the budget is scaled by this factor when a step goes over the limit */
+    float shrinkFactor;
+
+    /* memory used before a step, i.e., the model and the optimizer */
+    MTYPE baseSize;
+
+    /* coefficients of the memory model: a, b and c */
+    double coef[3];
+
+    /* number of the probes */
+    int probeNum;
+
+    /* token numbers of the probes */
+    int probeTokens[MAX_AUTO_BATCH_PROBE_NUM];
+
+    /* lengths of the probes */
+    int probeLens[MAX_AUTO_BATCH_PROBE_NUM];
+
+    /* memory used by the probes */
+    MTYPE probeSizes[MAX_AUTO_BATCH_PROBE_NUM];
+
+    /* the token budget */
+    int budget;
+
+    /* the peak memory of the steps in training */
+    MTYPE peakSize;
+
+    /* number of the steps that are retried (or split) */
+    int retryNum;
+
+public:
+    /* constructor */
+    T2TAutoBatch();
+
+    /* de-constructor */
+    ~T2TAutoBatch();
+
+    /* initialize the parameters */
+    void Init(int argc, char ** argv, int memSize);
+
+    /* add a probe */
+    void AddProbe(int tokens, int len, MTYPE size);
+
+    /* fit the memory model */
+    void Fit();
+
+    /* predict the memory of a step */
+    double Predict(int tokens, int len);
+
+    /* choose the token budget */
+    int ChooseBudget();
+
+    /* check whether a batch fits the memory limit */
+    bool Fits(int tokens, int len);
+
+    /* make the budget smaller after a step of a given size goes over the limit */
+    int Shrink(int tokens);
+
+    /* show the model and the budget */
+    void Show(FILE * file);
+
+    /* show the budget and the measured headroom */
+    void ShowReport(FILE * file);
+};
+
+}
+
+#endif
@@ -0,0 +1,284 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "T2TCheckpoint.h"
+#include "T2TTrainer.h"
+#include "T2TUtility.h"
+#include "../../tensor/XUtility.h"
+#include "../../tensor/core/CHeader.h"
+
+namespace transformer
+{
+
+/* constructor */
+T2TCheckpointer::T2TCheckpointer()
+{
+    model = NULL;
+    snapshot = NULL;
+    paramNum = 0;
+    isAsync = true;
+    validModel = NULL;
+    validator = NULL;
+    validFN = NULL;
+    modelFN = new char[MAX_LINE_LENGTH];
+    outputFN = new char[MAX_LINE_LENGTH];
+    modelFN[0] = 0;
+    outputFN[0] = 0;
+    hasJob = false;
+    toStop = false;
+    isRunning = false;
+    checkpointNum = 0;
+    snapshotTime = 0;
+    stallTime = 0;
+
+    MUTEX_INIT(mutex);
+    COND_INIT(jobCond);
+    COND_INIT(doneCond);
+}
+
+/* de-constructor */
+T2TCheckpointer::~T2TCheckpointer()
+{
+    Stop();
+
+    for(int i = 0; i < paramNum; i++)
+        delete snapshot[i];
+    delete[] snapshot;
+
+    delete validModel;
+    delete validator;
+    delete[] validFN;
+    delete[] modelFN;
+    delete[] outputFN;
+
+    MUTEX_DELE(mutex);
+    COND_DELE(jobCond);
+    COND_DELE(doneCond);
+}
+
+/*
+initialize the writer. The staging buffer is of the same size as the model,
+and the writer thread starts here if the checkpoints are written in the
+background
+>> argc - number of arguments
+>> argv - list of pointers to the arguments
+>> myModel - the model that is trained
+>> myValidFN - the validation data file (NULL or "" if there is none)
+*/
+void T2TCheckpointer::Init(int argc, char ** argv, T2TModel * myModel, const char * myValidFN)
+{
+    bool isSync = false;
+    bool toValidate = false;
+
+    LoadParamBool(argc, argv, "synccheckpoint", &isSync, false);
+    LoadParamBool(argc, argv, "validate", &toValidate, false);
+
+    isAsync = !isSync;
+
+#ifdef WIN32
+    /* the condition variables of XThread.h are events on windows and
+       do not release the mutex when waiting. We write synchronously. */
+    isAsync = false;
+#endif
+
+    model = myModel;
+
+    XList params(100);
+    model->GetParams(params);
+
+    paramNum = params.count;
+    snapshot = new XTensor*[paramNum];
+    for(int i = 0; i < paramNum; i++){
+        XTensor * p = (XTensor*)params.Get(i);
+        snapshot[i] = NewTensor(p->order, p->dimSize, p->dataType, p->denseRatio, -1, NULL);
+    }
+
+    /* the validation model is of the same configuration but on the CPU,
+       i.e., it runs on the spare cores rather than the device of training */
+    if(toValidate && myValidFN != NULL && strcmp(myValidFN, "")){
+        char ** args = new char*[argc + 2];
+        for(int i = 0; i < argc; i++)
+            args[i] = argv[i];
+        args[argc] = (char*)"-dev";
+        args[argc + 1] = (char*)"-1";
+
+        validModel = new T2TModel();
+        validModel->InitModel(argc + 2, args);
+
+        validator = new T2TTrainer();
+        validator->Init(argc + 2, args);
+
+        validFN = new char[strlen(myValidFN) + 1];
+        strcpy(validFN, myValidFN);
+
+        delete[] args;
+    }
+
+    if(isAsync && !isRunning){
+        toStop = false;
+        writerArgs.Clear();
+        writerArgs.Add(this);
+        writer.function = (TFunction)RunThread;
+        writer.argv = &writerArgs;
+        isRunning = writer.Start();
+        CheckNTErrors(isRunning, "Cannot create the checkpoint thread!");
+        writer.LetItGo();
+    }
+}
+
+/*
+make a checkpoint. It returns once the parameters are copied, and the
+checkpoint is written (and validated) in the background
+>> fn - where we write the checkpoint
+>> ofn - where we write the result of validation
+*/
+void T2TCheckpointer::Make(const char * fn, const char * ofn)
+{
+    CheckNTErrors(model != NULL, "The checkpoint writer is not initialized!");
+
+    /* the staging buffer is in use until the last checkpoint is done */
+    Wait();
+
+    double startT = GetClockSec();
+    Snapshot();
+    snapshotTime += GetClockSec() - startT;
+
+    strcpy(modelFN, fn);
+    strcpy(outputFN, ofn);
+    checkpointNum++;
+
+    if(!isRunning){
+        Write();
+        return;
+    }
+
+    MUTEX_LOCK(mutex);
+    hasJob = true;
+    COND_SIGNAL(jobCond);
+    MUTEX_UNLOCK(mutex);
+}
+
+/* wait until the last checkpoint is done */
+void T2TCheckpointer::Wait()
+{
+    if(!isRunning)
+        return;
+
+    double startT = GetClockSec();
+
+    MUTEX_LOCK(mutex);
+    while(hasJob)
+        COND_WAIT(doneCond, mutex);
+    MUTEX_UNLOCK(mutex);
+
+    stallTime += GetClockSec() - startT;
+}
+
+/* finish the last checkpoint and stop the writer */
+void T2TCheckpointer::Stop()
+{
+    if(!isRunning)
+        return;
+
+    MUTEX_LOCK(mutex);
+    toStop = true;
+    COND_SIGNAL(jobCond);
+    MUTEX_UNLOCK(mutex);
+
+    writer.End();
+    isRunning = false;
+
+    XPRINT3(0, stderr, "[INFO] checkpoints: %d (copying took %.2fs, and training waited %.2fs for the writer)\n",
+            checkpointNum, snapshotTime, stallTime);
+}
+
+/* copy the parameters to the staging buffer */
+void T2TCheckpointer::Snapshot()
+{
+    XList params(100);
+    model->GetParams(params);
+
+    CheckNTErrors(params.count == paramNum, "The model is changed!");
+
+    for(int i = 0; i < paramNum; i++)
+        _CopyValues((XTensor*)params.Get(i), snapshot[i]);
+}
+
+/* write the copy (in the format of T2TModel::Dump) and validate it */
+void T2TCheckpointer::Write()
+{
+    double startT = GetClockSec();
+
+    FILE * file = fopen(modelFN, "wb");
+    CheckNTErrors(file, "Cannot open the model file");
+
+    for(int i = 0; i < paramNum; i++)
+        snapshot[i]->Dump(file, "param:");
+
+    fclose(file);
+
+    XPRINT2(0, stderr, "[INFO] checkpoint saved to %s (took %.1fs)\n", modelFN, GetClockSec() - startT);
+
+    if(validModel == NULL)
+        return;
+
+    XList params(100);
+    validModel->GetParams(params);
+
+    for(int i = 0; i < paramNum; i++)
+        _CopyValues(snapshot[i], (XTensor*)params.Get(i));
+
+    float ppl = validator->Test(validFN, outputFN, validModel);
+
+    XPRINT2(0, stderr, "[INFO] checkpoint %s: validation ppl=%.3f\n", modelFN, ppl);
+}
+
+/* the loop of the writer thread */
+void T2TCheckpointer::Run()
+{
+    MUTEX_LOCK(mutex);
+
+    while(true){
+        while(!hasJob && !toStop)
+            COND_WAIT(jobCond, mutex);
+
+        if(!hasJob)
+            break;
+
+        MUTEX_UNLOCK(mutex);
+        Write();
+        MUTEX_LOCK(mutex);
+
+        hasJob = false;
+        COND_SIGNAL(doneCond);
+    }
+
+    MUTEX_UNLOCK(mutex);
+}
+
+/* 
+the entrance of the writer thread 
+>> args - the arguments (the checkpointer)
+*/
+void T2TCheckpointer::RunThread(XList * args)
+{
+    CheckNTErrors(args->count == 1, "Illegal arguments!");
+
+    ((T2TCheckpointer*)args->GetItem(0))->Run();
+}
+
+}
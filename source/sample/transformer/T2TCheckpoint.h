@@ -0,0 +1,142 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checkpointing in the background. The parameters are copied to a staging
+ * buffer (on the CPU) on the training thread, which is the only time that
+ * training waits for, and a writer thread dumps the copy to the model file
+ * while training goes on. That is, the parameters are double-buffered: the
+ * training thread updates the model and the writer reads the copy. The next
+ * checkpoint waits for the writer only if the previous one is not done yet.
+ * Optionally the writer scores the validation data with the copy (on a
+ * model of its own on the CPU) and reports the perplexity when it is done.
+ */
+
+#ifndef __T2TCHECKPOINT_H__
+#define __T2TCHECKPOINT_H__
+
+#include "T2TModel.h"
+#include "../../tensor/XThread.h"
+
+using namespace nts;
+
+namespace transformer
+{
+
+class T2TTrainer;
+
+/* the background checkpoint writer */
+class T2TCheckpointer
+{
+public:
+    /* the model that is trained */
+    T2TModel * model;
+
+    /* the staging copy of the parameters (on the CPU) */
+    XTensor ** snapshot;
+
+    /* number of the parameters */
+    int paramNum;
+
+    /* indicates whether the checkpoints are written in the background */
+    bool isAsync;
+
+    /* the model that scores the validation data with the copy (NULL if we do not validate) */
+    T2TModel * validModel;
+
+    /* the trainer that runs the validation */
+    T2TTrainer * validator;
+
+    /* the validation data file */
+    char * validFN;
+
+    /* where we write the checkpoint */
+    char * modelFN;
+
+    /* where we write the result of validation */
+    char * outputFN;
+
+    /* indicates whether a checkpoint is being written */
+    bool hasJob;
+
+    /* indicates whether the writer is asked to quit */
+    bool toStop;
+
+    /* indicates whether the writer thread is running */
+    bool isRunning;
+
+    /* the writer thread */
+    XThread writer;
+
+    /* arguments of the writer thread */
+    XList writerArgs;
+
+    /* mutex for the job state */
+    MUTEX_HANDLE mutex;
+
+    /* the writer waits for this until there is a job */
+    COND_HANDLE jobCond;
+
+    /* the training thread waits for this until the job is done */
+    COND_HANDLE doneCond;
+
+    /* number of the checkpoints */
+    int checkpointNum;
+
+    /* time of copying the parameters (on the training thread) */
+    double snapshotTime;
+
+    /* time that the training thread waits for the writer */
+    double stallTime;
+
+public:
+    /* constructor */
+    T2TCheckpointer();
+
+    /* de-constructor */
+    ~T2TCheckpointer();
+
+    /* initialize the writer */
+    void Init(int argc, char ** argv, T2TModel * myModel, const char * myValidFN);
+
+    /* make a checkpoint */
+    void Make(const char * fn, const char * ofn);
+
+    /* wait until the last checkpoint is done */
+    void Wait();
+
+    /* finish the last checkpoint and stop the writer */
+    void Stop();
+
+protected:
+    /* copy the parameters to the staging buffer */
+    void Snapshot();
+
+    /* write the copy and validate it */
+    void Write();
+
+    /* the loop of the writer thread */
+    void Run();
+
+    /* the entrance of the writer thread */
+    static
+    void RunThread(XList * args);
+};
+
+}
+
+#endif
@@ -102,9 +102,36 @@ make the decoding network
 */
 XTensor AttDecoder::Make(XTensor &inputDec, XTensor &outputEnc, XTensor &mask, XTensor &maskEncDec, bool isTraining)
 {
+    return MakeShared(inputDec, outputEnc, NULL, mask, maskEncDec, isTraining);
+}
+
+/* 
+make the decoding network where a number of target sequences share the 
+encoder output of the same source sequence (e.g., n-best rescoring). The 
+keys and values of the encoder-decoder attention are generated only once 
+for each source sequence and then copied to the target sequences.
+>> inputDec - the input tensor of the decoder (n sequences)
+>> outputEnc - the output tensor of the encoder (u source sequences)
+>> srcIndex - srcIndex[i] is the source sequence (in outputEnc) of the i-th 
+                target sequence. NULL means that outputEnc and inputDec are 
+                aligned one by one.
+>> mask - mask that indicates which position is valid
+>> maskEncDec - mask for the encoder-decoder attention (of the n sequences)
+>> isTraining - indicates whether the model is used for training
+>> packedDec - the packed batch of the target sequences (NULL means that inputDec is padded)
+>> packedEnc - the packed batch of the source sequences (NULL means that outputEnc is padded)
+<< return - the output tensor of the encoder
+*/
+XTensor AttDecoder::MakeShared(XTensor &inputDec, XTensor &outputEnc, int * srcIndex, 
+                               XTensor &mask, XTensor &maskEncDec, bool isTraining,
+                               T2TPackedBatch * packedDec, T2TPackedBatch * packedEnc)
+{
+    CheckNTErrors(srcIndex == NULL || (packedDec == NULL && packedEnc == NULL),
+                  "The shared source sequences cannot be packed!");
+
     XTensor x;
 
-    x = embedder.Make(inputDec);
+    x = embedder.Make(inputDec, packedDec);
 
     /* dropout */
     if(isTraining && dropoutP > 0)
@@ -119,7 +146,7 @@ XTensor AttDecoder::Make(XTensor &inputDec, XTensor &outputEnc, XTensor &mask, X
 
         /******************/
         /* self attention */
-        att = attentions[i].Make(x, x, x, mask, isTraining, true);
+        att = attentions[i].Make(x, x, x, mask, isTraining, true, packedDec);
 
         /* dropout */
         if(isTraining && dropoutP > 0)
@@ -133,7 +160,26 @@ XTensor AttDecoder::Make(XTensor &inputDec, XTensor &outputEnc, XTensor &mask, X
 
         /*****************************/
         /* encoder-decoder attention */
-        ende = attentionsEnde[i].Make(outputEnc, x, outputEnc, maskEncDec, isTraining, false);
+        if(srcIndex == NULL)
+            ende = attentionsEnde[i].Make(outputEnc, x, outputEnc, maskEncDec, isTraining, false, packedDec, packedEnc);
+        else{
+            XTensor kSrc;
+            XTensor vSrc;
+            XTensor k2;
+            XTensor v2;
+
+            /* transform the encoder output once for each source sequence */
+            kSrc = MMul(outputEnc, attentionsEnde[i].wk);
+            vSrc = MMul(outputEnc, attentionsEnde[i].wv);
+
+            /* copy the keys and values to the target sequences */
+            InitTensor3D(&k2, x.GetDim(0), kSrc.GetDim(1), kSrc.GetDim(2), X_FLOAT, devID, mem);
+            InitTensor3D(&v2, x.GetDim(0), vSrc.GetDim(1), vSrc.GetDim(2), X_FLOAT, devID, mem);
+            _Gather(&kSrc, &k2, 0, srcIndex, x.GetDim(0));
+            _Gather(&vSrc, &v2, 0, srcIndex, x.GetDim(0));
+
+            ende = attentionsEnde[i].MakeWithKV(k2, x, v2, maskEncDec, isTraining);
+        }
 
         /* dropout */
         if(isTraining && dropoutP > 0)
@@ -96,6 +96,11 @@ public:
 
     /* make the decoding network */
     XTensor Make(XTensor &inputDec, XTensor &outputEnc, XTensor &mask, XTensor &maskEncDec, bool isTraining);
+
+    /* make the decoding network where target sequences share the encoder output of their source */
+    XTensor MakeShared(XTensor &inputDec, XTensor &outputEnc, int * srcIndex, 
+                       XTensor &mask, XTensor &maskEncDec, bool isTraining,
+                       T2TPackedBatch * packedDec = NULL, T2TPackedBatch * packedEnc = NULL);
 };
 
 }
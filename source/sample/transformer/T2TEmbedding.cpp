@@ -69,6 +69,13 @@ void T2TEmbedder::InitModel(int argc, char ** argv, int myDevID, XMem * myMem, b
     DTYPE v = 1.0F/(float)sqrt((float)eSize);
     w.SetDataRandn(0, v);
 
+    /* the embedding matrix is accessed by gather only, and its gradient 
+       has non-zero values for the words in the batch */
+    bool isSparseGrad = true;
+    LoadParamBool(argc, argv, "sparsegrad", &isSparseGrad, devID < 0);
+    if(isSparseGrad)
+        w.SetSparseGradFlag();
+
     /* create the positional embedding matrix */
     MakePosEmbedding(eSize, d, maxLength);
 }
@@ -118,12 +125,16 @@ void T2TEmbedder::MakePosEmbedding(int eSize, int d, int length)
 
 /* 
 make the network 
+>> input - word ids of the sequences
+>> packed - the packed batch if the input is packed (1 * tokenNum), 
+            NULL means that the input is padded (batch * length)
 */
-XTensor T2TEmbedder::Make(XTensor &input)
+XTensor T2TEmbedder::Make(XTensor &input, T2TPackedBatch * packed)
 {
     //CheckNTErrors(input.GetDim(-1) == vSize, "Wrong vocabulary size!");
     CheckNTErrors(input.order > 1, "Wrong input tensor size!");
-    CheckNTErrors(input.dimSize[input.order - 1] < maxLength, "The sequence is too long!");
+    CheckNTErrors((packed != NULL ? packed->maxLen : input.dimSize[input.order - 1]) < maxLength, 
+                  "The sequence is too long!");
     CheckNTErrors(vSize > 0, "set vocabulary size by \"-vsize\"");
     CheckNTErrors(eSize > 0, "set embedding size by \"-esize\"");
 
@@ -143,8 +154,13 @@ XTensor T2TEmbedder::Make(XTensor &input)
     }
 
     /* we make positional embeddings first */
-    //if(!match){
-    if(true){
+    if(packed != NULL){
+        /* the position of each token is given by the packed batch */
+        InitTensor(&posEmbedding, input.order + 1, dims, X_FLOAT, 1.0F, devID, mem);
+        _Gather(&posEmbeddingBase, &posEmbedding, &packed->positions);
+    }
+    //else if(!match){
+    else{
         InitTensor(&posEmbedding, input.order + 1, dims, X_FLOAT, 1.0F, devID, mem);
 
         XTensor * posTMP = NewTensorBuf(2, dims + 1, X_FLOAT, 1.0F, devID, mem);
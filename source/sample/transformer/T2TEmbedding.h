@@ -22,6 +22,7 @@
 #ifndef __T2TEMBEDDING_H__
 #define __T2TEMBEDDING_H__
 
+#include "T2TPackedBatch.h"
 #include "../../network/XNet.h"
 
 using namespace nts;
@@ -76,8 +77,8 @@ public:
     /* make positional embeddings */
     void MakePosEmbedding(int eSize, int d, int length);
 
-    /* make the network */
-    XTensor Make(XTensor &input);
+    /* make the network (the input might be packed) */
+    XTensor Make(XTensor &input, T2TPackedBatch * packed = NULL);
 };
 
 }
@@ -98,10 +98,26 @@ make the encoding network
 << return - the output tensor of the encoder
 */
 XTensor AttEncoder::Make(XTensor &input, XTensor &mask, XTensor &maskEncDec, bool isTraining)
+{
+    return Make(input, mask, maskEncDec, isTraining, NULL);
+}
+
+/* 
+make the encoding network for a packed batch. The embedding, fnn and layer 
+normalization run on the real tokens only, and the self-attention is made 
+for each sequence (see T2TPackedBatch).
+>> input - the input tensor of the encoder (1 * tokenNum if it is packed)
+>> mask - the mask that indicate each position is valid (of the unpacked sequences)
+>> maskEncDec - no use
+>> isTraining - indicates whether the model is used for training
+>> packed - the packed batch (NULL means that the input is padded)
+<< return - the output tensor of the encoder
+*/
+XTensor AttEncoder::Make(XTensor &input, XTensor &mask, XTensor &maskEncDec, bool isTraining, T2TPackedBatch * packed)
 {
     XTensor x;
 
-    x = embedder.Make(input);
+    x = embedder.Make(input, packed);
 
     /* dropout */
     if(isTraining && dropoutP > 0)
@@ -114,7 +130,7 @@ XTensor AttEncoder::Make(XTensor &input, XTensor &mask, XTensor &maskEncDec, boo
         XTensor res;
 
         /* self attention */
-        att = attentions[i].Make(x, x, x, mask, isTraining, true);
+        att = attentions[i].Make(x, x, x, mask, isTraining, true, packed);
         
         /* dropout */
         if(isTraining && dropoutP > 0)
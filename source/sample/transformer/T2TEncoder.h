@@ -120,6 +120,9 @@ public:
     /* make the encoding network */
     XTensor Make(XTensor &input, XTensor &mask, XTensor &maskEncDec, bool isTraining);
 
+    /* make the encoding network for a packed batch */
+    XTensor Make(XTensor &input, XTensor &mask, XTensor &maskEncDec, bool isTraining, T2TPackedBatch * packed);
+
     /* make the encoding network (wrapper) */
     XTensor Make(XTensor &input, XTensor &mask, bool isTraining);
 };
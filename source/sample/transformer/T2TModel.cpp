@@ -23,6 +23,7 @@
 #include "T2TModel.h"
 #include "T2TUtility.h"
 #include "../../tensor/core/CHeader.h"
+#include "../../tensor/XNuma.h"
 
 namespace transformer
 {
@@ -35,6 +36,9 @@ T2TModel::T2TModel()
     isLM = false;
     isMT = false;
     nhead = 1;
+    isBlockSparse = false;
+    sparseBlockRow = 1;
+    sparseBlockCol = 16;
 
     encoder = new AttEncoder();
     decoder = new AttDecoder();
@@ -58,8 +62,10 @@ initialize the model
 void T2TModel::InitModel(int argc, char ** argv)
 {
     bool useMem = false;
+    bool useAutoBatch = false;
     int memSize = 0;
     bool isMemFreeOTF = false;
+    bool isNuma = false;
 
     LoadParamInt(argc, argv, "dev", &devID, -1);
     LoadParamBool(argc, argv, "mem", &useMem, useMem);
@@ -68,10 +74,24 @@ void T2TModel::InitModel(int argc, char ** argv)
     LoadParamBool(argc, argv, "lm", &isLM, !isMT);
     LoadParamInt(argc, argv, "nhead", &nhead, 8);
     LoadParamBool(argc, argv, "freeotf", &isMemFreeOTF, false);
-
-    if(useMem){
+    LoadParamBool(argc, argv, "autobatch", &useAutoBatch, false);
+    LoadParamBool(argc, argv, "blocksparse", &isBlockSparse, false);
+    LoadParamInt(argc, argv, "sparserow", &sparseBlockRow, 1);
+    LoadParamInt(argc, argv, "sparsecol", &sparseBlockCol, 16);
+    LoadParamBool(argc, argv, "numa", &isNuma, false);
+
+    /* on NUMA hosts the model is kept in a pool on the CPU whose blocks are 
+       spread over the (pinned) threads of the global runner, i.e., each thread 
+       works on the segments on its own node */
+    isNuma = isNuma && devID < 0;
+
+    /* automatic batch sizing measures the memory in the pool */
+    if(useMem || useAutoBatch || isNuma){
         delete mem;
-        mem = new XMem(devID, FREE_ON_THE_FLY, (MTYPE)MILLION * 256, 1024, MILLION * 128);
+        mem = new XMem();
+        if(isNuma)
+            mem->SetNumaNode(NUMA_NODE_SPREAD);
+        mem->Initialize(devID, FREE_ON_THE_FLY, (MTYPE)MILLION * 256, 1024, MILLION * 128);
         mem->SetDesiredSize(devID, 0, (MTYPE)memSize * MILLION);
     }
 
@@ -95,13 +115,14 @@ make the encoding network
 >> input - input tensor
 >> mask - the mask for positions that are/not involved in computation
 >> isTraining - indicates whether we are training the model
+>> packed - the packed batch (NULL means that the input is padded)
 << return - encoding result
 */
-XTensor T2TModel::MakeEncoder(XTensor &input, XTensor &mask, bool isTraining)
+XTensor T2TModel::MakeEncoder(XTensor &input, XTensor &mask, bool isTraining, T2TPackedBatch * packed)
 {
     XTensor nothing;
 
-    return encoder->Make(input, mask, nothing, isTraining);
+    return encoder->Make(input, mask, nothing, isTraining, packed);
 }
 
 /* 
@@ -125,8 +146,12 @@ make the network for language modeling (with the output softmax layer)
 >> output - output tensor (distribution)
 >> padding - padding of the sequences
 >> isTraining - indicates whether the model is for training
+>> packed - the packed batch. If it is not NULL, the input (and the output) 
+            is of size 1 * tokenNum, and the mask is made for the unpacked 
+            sequences
 */
-void T2TModel::MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool isTraining)
+void T2TModel::MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool isTraining, 
+                      T2TPackedBatch * packed)
 {
     XTensor encoding;
     
@@ -145,6 +170,14 @@ void T2TModel::MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool is
         dims[i + 1] = input.GetDim(i);
     dims[0] = nhead;
     dims[input.order + 1] = len;
+
+    /* the mask is of size nhead * seqNum * maxLen * maxLen for a packed batch */
+    if(packed != NULL){
+        dims[1] = packed->seqNum;
+        dims[2] = packed->maxLen;
+        dims[3] = packed->maxLen;
+    }
+
     XTensor mask(input.order + 2, dims, X_FLOAT, 1.0F, padding.devID, padding.mem);
 
     /* a upper triangular matrix where the cells of the upper triangular are set to -1e-9.
@@ -152,39 +185,14 @@ void T2TModel::MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool is
         a given sequence. */
     _SetDataLowTri(&mask, 1e9F, 0);
     _ScaleAndShiftMe(&mask, 1.0F, -1e9F);
-        
-    int * dimsPadding = new int[padding.order + 2];
-    for(int i = 0; i < padding.order - 1; i++)
-        dimsPadding[i] = padding.GetDim(i);
-    dimsPadding[padding.order - 1] = padding.GetDim(-1);
-    dimsPadding[padding.order] = padding.GetDim(-1);
-
-    XTensor * padding2 = NewTensorBuf(padding.order + 1, dimsPadding, padding.dataType,
-                                      padding.denseRatio, padding.devID, padding.mem);
 
-    for(int i = 0; i < padding2->order; i++)
-        dimsPadding[i + 1] = padding2->GetDim(i);
-    dimsPadding[0] = nhead;
+    /* the padding needs no mask here: a word sees the previous words only, 
+       and they are not dummy words */
 
-    //XTensor * padding3 = NewTensorBuf(padding.order + 2, dimsPadding, padding.dataType,
-    //                                  padding.denseRatio, padding.devID, padding.mem);
-    //    
-    ///* mask of the padding */
-    //_Unsqueeze(&padding, padding2, padding.order - 1, padding.GetDim(-1));
-    //_Unsqueeze(padding2, padding3, 0, nhead);
-    //    
-    //_ScaleAndShiftMe(padding3, 1e9F, -1e9F);
-    //    
-    ////_Sum(&mask, padding3, &mask);
-
-    encoding = MakeEncoder(input, mask, isTraining);
+    encoding = MakeEncoder(input, mask, isTraining, packed);
     outputLayer->Make(encoding, output);
 
     delete[] dims;
-    delete[] dimsPadding;
-        
-    //DelTensorBuf(padding3);
-    DelTensorBuf(padding2);
 }
 
 /* 
@@ -195,14 +203,58 @@ make the network for machine translation (with the output softmax layer)
 >> paddingEnc - padding of the sequences (on the encoder side)
 >> paddingDec - padding of the sequences (on the decoder side)
 >> isTraining - indicates whether the model is for training
+>> packedEnc - the packed batch of the source sequences (NULL means that they are padded)
+>> packedDec - the packed batch of the target sequences (NULL means that they are padded)
 */
-void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTensor &paddingEnc, XTensor &paddingDec, bool isTraining)
+void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTensor &paddingEnc, XTensor &paddingDec, bool isTraining,
+                      T2TPackedBatch * packedEnc, T2TPackedBatch * packedDec)
 {
+    MakeMTShared(inputEnc, inputDec, output, paddingEnc, paddingDec, NULL, isTraining, packedEnc, packedDec);
+}
+
+/* 
+make the network for machine translation where a number of target sequences 
+share the same source sequence (e.g., rescoring of an n-best list). The encoder
+runs only once for each distinct source sequence.
+>> inputEnc - input tensor of the encoder (u distinct source sequences)
+>> inputDec - input tensor of the decoder (n target sequences)
+>> output - output tensor (distribution)
+>> paddingEnc - padding of the sequences (on the encoder side)
+>> paddingDec - padding of the sequences (on the decoder side)
+>> srcIndex - srcIndex[i] is the source sequence of the i-th target sequence.
+              NULL means that inputEnc and inputDec are aligned one by one.
+>> isTraining - indicates whether the model is for training
+>> packedEnc - the packed batch of the source sequences. If it is not NULL, inputEnc
+               is of size 1 * tokenNum and the masks are made for the unpacked 
+               sequences (by the padding of the packed batch)
+>> packedDec - the packed batch of the target sequences
+*/
+void T2TModel::MakeMTShared(XTensor &inputEnc, XTensor &inputDec, XTensor &output, 
+                            XTensor &paddingEnc, XTensor &paddingDec, 
+                            int * srcIndex, bool isTraining,
+                            T2TPackedBatch * packedEnc, T2TPackedBatch * packedDec)
+{
+    CheckNTErrors((packedEnc == NULL) == (packedDec == NULL), "Both sides must be packed!");
+
     XTensor encoding;
     XTensor decoding;
     XTensor maskEnc;
     XTensor maskDec;
     XTensor maskEncDec;
+    XTensor paddingEncExp;
+
+    /* paddings of the unpacked sequences */
+    XTensor &paddingSrc = packedEnc != NULL ? packedEnc->padding : paddingEnc;
+    XTensor &paddingTgt = packedDec != NULL ? packedDec->padding : paddingDec;
+    XTensor * paddingEncDec = &paddingSrc;
+
+    if(srcIndex != NULL){
+        /* padding of the source sequence for each target sequence */
+        InitTensor2D(&paddingEncExp, inputDec.GetDim(0), paddingEnc.GetDim(-1), 
+                     paddingEnc.dataType, paddingEnc.devID, paddingEnc.mem);
+        _Gather(&paddingEnc, &paddingEncExp, 0, srcIndex, inputDec.GetDim(0));
+        paddingEncDec = &paddingEncExp;
+    }
     
     /* generate mask to see "previous" words on the decoder side */
     //int len = inputDec.GetDim(inputDec.order - 2);
@@ -213,13 +265,13 @@ void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTe
     //dims[inputDec.order] = len;
     //InitTensor(&maskDec, inputDec.order + 1, dims, X_FLOAT, 1.0F, inputDec.devID, inputDec.mem);
 
-    int len = inputDec.GetDim(inputDec.order - 1);
-    int * dims = new int[inputDec.order + 2];
-    for(int i = 0; i < inputDec.order; i++)
-        dims[i + 1] = inputDec.GetDim(i);
+    int len = paddingTgt.GetDim(paddingTgt.order - 1);
+    int * dims = new int[paddingTgt.order + 2];
+    for(int i = 0; i < paddingTgt.order; i++)
+        dims[i + 1] = paddingTgt.GetDim(i);
     dims[0] = nhead;
-    dims[inputDec.order + 1] = len;
-    InitTensor(&maskDec, inputDec.order + 2, dims, X_FLOAT, 1.0F, paddingDec.devID, paddingDec.mem);
+    dims[paddingTgt.order + 1] = len;
+    InitTensor(&maskDec, paddingTgt.order + 2, dims, X_FLOAT, 1.0F, paddingTgt.devID, paddingTgt.mem);
         
     /* a upper triangular matrix where the cells of the upper triangular are set to -1e-9.
        this matrix can be used to prevent the attention to current or following words in
@@ -228,14 +280,14 @@ void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTe
     _ScaleAndShiftMe(&maskDec, 1.0F, -1e9F);
 
     /* encoder-decoder mask that prevent the attention to padding dummy words */
-    dims[inputDec.order + 1] = inputEnc.GetDim(inputEnc.order - 1);
-    InitTensor(&maskEncDec, inputDec.order + 2, dims, X_FLOAT, 1.0F, paddingEnc.devID, paddingEnc.mem);
+    dims[paddingTgt.order + 1] = paddingSrc.GetDim(paddingSrc.order - 1);
+    InitTensor(&maskEncDec, paddingTgt.order + 2, dims, X_FLOAT, 1.0F, paddingEncDec->devID, paddingEncDec->mem);
 
-    XTensor * maskEncDecTMPEnc = NewTensorBuf(paddingEnc.order + 1, dims + 1, paddingEnc.dataType,
-                                              paddingEnc.denseRatio, paddingEnc.devID, paddingEnc.mem);
-    XTensor * maskEncDecTMPDec = NewTensorBuf(maskEncDecTMPEnc, paddingEnc.devID, paddingEnc.mem);
+    XTensor * maskEncDecTMPEnc = NewTensorBuf(paddingEncDec->order + 1, dims + 1, paddingEncDec->dataType,
+                                              paddingEncDec->denseRatio, paddingEncDec->devID, paddingEncDec->mem);
+    XTensor * maskEncDecTMPDec = NewTensorBuf(maskEncDecTMPEnc, paddingEncDec->devID, paddingEncDec->mem);
 
-    _Unsqueeze(&paddingEnc, maskEncDecTMPEnc, paddingEnc.order - 1, paddingDec.GetDim(-1));
+    _Unsqueeze(paddingEncDec, maskEncDecTMPEnc, paddingEncDec->order - 1, paddingTgt.GetDim(-1));
     //_Unsqueeze(&paddingDec, maskEncDecTMPDec, paddingEnc.order, paddingEnc.GetDim(-1));
     //_Multiply(maskEncDecTMPDec, maskEncDecTMPEnc, maskEncDecTMPDec);
     _ScaleAndShiftMe(maskEncDecTMPEnc, 1e9F, -1e9F);
@@ -245,24 +297,24 @@ void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTe
     DelTensorBuf(maskEncDecTMPEnc);
 
     /* padding on the source side */
-    int * dimsPadding = new int[paddingEnc.order + 2];
-    for (int i = 0; i < paddingEnc.order - 1; i++)
-        dimsPadding[i] = paddingEnc.GetDim(i);
-    dimsPadding[paddingEnc.order - 1] = paddingEnc.GetDim(-1);
-    dimsPadding[paddingEnc.order] = paddingEnc.GetDim(-1);
+    int * dimsPadding = new int[paddingSrc.order + 2];
+    for (int i = 0; i < paddingSrc.order - 1; i++)
+        dimsPadding[i] = paddingSrc.GetDim(i);
+    dimsPadding[paddingSrc.order - 1] = paddingSrc.GetDim(-1);
+    dimsPadding[paddingSrc.order] = paddingSrc.GetDim(-1);
 
-    XTensor * padding2 = NewTensorBuf(paddingEnc.order + 1, dimsPadding, paddingEnc.dataType,
-                                      paddingEnc.denseRatio, paddingEnc.devID, paddingEnc.mem);
+    XTensor * padding2 = NewTensorBuf(paddingSrc.order + 1, dimsPadding, paddingSrc.dataType,
+                                      paddingSrc.denseRatio, paddingSrc.devID, paddingSrc.mem);
 
     for (int i = 0; i < padding2->order; i++)
         dimsPadding[i + 1] = padding2->GetDim(i);
     dimsPadding[0] = nhead;
 
-    XTensor * padding3 = NewTensorBuf(paddingEnc.order + 2, dimsPadding, paddingEnc.dataType,
-                                      paddingEnc.denseRatio, paddingEnc.devID, paddingEnc.mem);
+    XTensor * padding3 = NewTensorBuf(paddingSrc.order + 2, dimsPadding, paddingSrc.dataType,
+                                      paddingSrc.denseRatio, paddingSrc.devID, paddingSrc.mem);
 
     /* mask of the padding */
-    _Unsqueeze(&paddingEnc, padding2, paddingEnc.order - 1, paddingEnc.GetDim(-1));
+    _Unsqueeze(&paddingSrc, padding2, paddingSrc.order - 1, paddingSrc.GetDim(-1));
     _Unsqueeze(padding2, padding3, 0, nhead);
 
     _ScaleAndShiftMe(padding3, 1e9F, -1e9F);
@@ -273,9 +325,9 @@ void T2TModel::MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTe
     /* generate the mask on the source language side (for padding) */
     _Sum(&maskEnc, padding3, &maskEnc);
 
-    encoding = MakeEncoder(inputEnc, maskEnc, isTraining);
+    encoding = MakeEncoder(inputEnc, maskEnc, isTraining, packedEnc);
 
-    decoding = MakeDecoder(inputDec, encoding, maskDec, maskEncDec, isTraining);
+    decoding = decoder->MakeShared(inputDec, encoding, srcIndex, maskDec, maskEncDec, isTraining, packedDec, packedEnc);
 
     outputLayer->Make(decoding, output);
 
@@ -340,6 +392,73 @@ void T2TModel::GetParams(XList &list)
     }
 }
 
+/* 
+get the weight matrices of the fnns
+>> list - the list that keeps the weights
+*/
+void T2TModel::GetFNNWeights(XList &list)
+{
+    list.Clear();
+
+    for(int i = 0; i < encoder->nlayer; i++){
+        list.Add(&encoder->fnns[i].w1);
+        list.Add(&encoder->fnns[i].w2);
+    }
+
+    if(isMT){
+        for(int i = 0; i < decoder->nlayer; i++){
+            list.Add(&decoder->fnns[i].w1);
+            list.Add(&decoder->fnns[i].w2);
+        }
+    }
+}
+
+/* 
+magnitude pruning of the fnn weights. The blocks of the smallest l2-norm 
+are set to zero (the model is still saved as dense matrices) and the rest 
+are indexed, so that the fnns run with block-sparse multiplication. 
+>> sparsity - the fraction of the blocks that we set to zero
+>> blockRow - number of rows of a block
+>> blockCol - number of columns of a block
+*/
+void T2TModel::Prune(float sparsity, int blockRow, int blockCol)
+{
+    XList weights(100);
+    GetFNNWeights(weights);
+
+    int zeroNum = 0;
+    int blockNum = 0;
+
+    for(int i = 0; i < weights.count; i++){
+        XTensor * w = (XTensor*)weights.Get(i);
+        _PruneBlocks(w, blockRow, blockCol, sparsity);
+
+        XBlockSparse * index = w->blockSparse;
+        blockNum += index->blockRowNum * index->blockColNum;
+        zeroNum += index->blockRowNum * index->blockColNum - index->blockNum;
+    }
+
+    XPRINT4(0, stderr, "[INFO] pruned %d fnn weights with %dx%d blocks (sparsity=%.3f)\n",
+            weights.count, blockRow, blockCol, blockNum > 0 ? (float)zeroNum / blockNum : 0);
+}
+
+/* 
+index the non-zero blocks of the fnn weights, e.g., the weights of a 
+pruned model (see Prune)
+>> blockRow - number of rows of a block
+>> blockCol - number of columns of a block
+*/
+void T2TModel::SetBlockSparse(int blockRow, int blockCol)
+{
+    XList weights(100);
+    GetFNNWeights(weights);
+
+    for(int i = 0; i < weights.count; i++){
+        XTensor * w = (XTensor*)weights.Get(i);
+        w->SetBlockSparse(blockRow, blockCol);
+    }
+}
+
 /*
 dump the parameters 
 >> fn - where to keep the model
@@ -381,6 +500,10 @@ void T2TModel::Read(const char * fn)
 
     fclose(file);
 
+    /* the fnns of a pruned model run with block-sparse multiplication */
+    if(isBlockSparse)
+        SetBlockSparse(sparseBlockRow, sparseBlockCol);
+
     XPRINT(0, stderr, "[INFO] model loaded\n");
 }
 
@@ -58,6 +58,14 @@ public:
     /* number of heads in the attention model */
     int nhead;
 
+    /* indicates whether the fnn weights are multiplied as block-sparse 
+       matrices once the model is loaded (see Prune) */
+    bool isBlockSparse;
+
+    /* size of the blocks of the block-sparse weights */
+    int sparseBlockRow;
+    int sparseBlockCol;
+
 public:
     /* constructor */
     T2TModel();
@@ -69,20 +77,37 @@ public:
     void InitModel(int argc, char ** argv);
 
     /* make the encoding network */
-    XTensor MakeEncoder(XTensor &input, XTensor &mask, bool isTraining);
+    XTensor MakeEncoder(XTensor &input, XTensor &mask, bool isTraining, T2TPackedBatch * packed = NULL);
 
     /* make the encoding network */
     XTensor MakeDecoder(XTensor &inputEnc, XTensor &inputDec, XTensor &mask, XTensor &MaskEncDec, bool isTraining);
 
     /* make the network for langauge modeling (with the output softmax layer) */
-    void MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool isTraining);
+    void MakeLM(XTensor &input, XTensor &output, XTensor &padding, bool isTraining, 
+                T2TPackedBatch * packed = NULL);
 
     /* make the network for machine translation (with the output softmax layer) */
-    void MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTensor &paddingEnc, XTensor &paddingDec, bool isTraining);
+    void MakeMT(XTensor &inputEnc, XTensor &inputDec, XTensor &output, XTensor &paddingEnc, XTensor &paddingDec, bool isTraining,
+                T2TPackedBatch * packedEnc = NULL, T2TPackedBatch * packedDec = NULL);
+
+    /* make the network for machine translation where target sequences share the encoding of their source */
+    void MakeMTShared(XTensor &inputEnc, XTensor &inputDec, XTensor &output, 
+                      XTensor &paddingEnc, XTensor &paddingDec, 
+                      int * srcIndex, bool isTraining,
+                      T2TPackedBatch * packedEnc = NULL, T2TPackedBatch * packedDec = NULL);
 
     /* get parameter matrics */
     void GetParams(XList &list);
 
+    /* get the weight matrices of the fnns */
+    void GetFNNWeights(XList &list);
+
+    /* prune the blocks of the fnn weights */
+    void Prune(float sparsity, int blockRow, int blockCol);
+
+    /* index the non-zero blocks of the fnn weights */
+    void SetBlockSparse(int blockRow, int blockCol);
+
     /* dump the parameters */
     void Dump(const char * fn);
 
@@ -0,0 +1,170 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "T2TPackedBatch.h"
+#include "../../tensor/XUtility.h"
+#include "../../tensor/core/CHeader.h"
+
+namespace transformer
+{
+
+/* constructor */
+T2TPackedBatch::T2TPackedBatch()
+{
+    seqNum = 0;
+    maxLen = 0;
+    tokenNum = 0;
+    offsets = NULL;
+    offsetSize = 0;
+}
+
+/* de-constructor */
+T2TPackedBatch::~T2TPackedBatch()
+{
+    delete[] offsets;
+}
+
+/*
+initialize the batch with the lengths of the sequences
+>> lens - lengths of the sequences
+>> num - number of the sequences
+>> devID - device id
+>> mem - memory pool
+*/
+void T2TPackedBatch::Init(int * lens, int num, int devID, XMem * mem)
+{
+    CheckNTErrors(num > 0, "Empty batch!");
+
+    if(offsetSize < num + 1){
+        delete[] offsets;
+        offsetSize = num + 1;
+        offsets = new int[offsetSize];
+    }
+
+    seqNum = num;
+    maxLen = 0;
+    offsets[0] = 0;
+    for(int i = 0; i < num; i++){
+        CheckNTErrors(lens[i] > 0, "Empty sequence!");
+        offsets[i + 1] = offsets[i] + lens[i];
+        maxLen = MAX(maxLen, lens[i]);
+    }
+    tokenNum = offsets[num];
+
+    int * packIndexValues = new int[tokenNum];
+    int * positionValues = new int[tokenNum];
+    int * unpackIndexValues = new int[seqNum * maxLen];
+    DTYPE * paddingValues = new DTYPE[seqNum * maxLen];
+
+    memset(unpackIndexValues, 0, sizeof(int) * seqNum * maxLen);
+
+    for(int i = 0; i < seqNum; i++){
+        for(int w = 0; w < maxLen; w++)
+            paddingValues[i * maxLen + w] = 0;
+        for(int t = offsets[i]; t < offsets[i + 1]; t++){
+            int w = t - offsets[i];
+            packIndexValues[t] = i * maxLen + w;
+            positionValues[t] = w;
+            unpackIndexValues[i * maxLen + w] = t;
+            paddingValues[i * maxLen + w] = 1.0F;
+        }
+    }
+
+    InitTensor2D(&packIndex, 1, tokenNum, X_INT, devID, mem);
+    InitTensor2D(&positions, 1, tokenNum, X_INT, devID, mem);
+    InitTensor2D(&unpackIndex, seqNum, maxLen, X_INT, devID, mem);
+    InitTensor2D(&padding, seqNum, maxLen, X_FLOAT, devID, mem);
+
+    packIndex.SetData(packIndexValues, tokenNum);
+    positions.SetData(positionValues, tokenNum);
+    unpackIndex.SetData(unpackIndexValues, seqNum * maxLen);
+    padding.SetData(paddingValues, seqNum * maxLen);
+
+    delete[] packIndexValues;
+    delete[] positionValues;
+    delete[] unpackIndexValues;
+    delete[] paddingValues;
+}
+
+/*
+pack a padded block, i.e., we keep the rows of the real tokens
+>> x - the padded block (seqNum * maxLen * H)
+<< return - the packed tensor (1 * tokenNum * H)
+*/
+XTensor T2TPackedBatch::Pack(XTensor &x)
+{
+    CheckNTErrors(x.order == 3, "Wrong tensor order!");
+    CheckNTErrors(x.GetDim(0) == seqNum && x.GetDim(1) == maxLen, "Unmatched batch!");
+
+    int dims[2] = {seqNum * maxLen, x.GetDim(2)};
+
+    XTensor rows;
+    rows = Reshape(x, 2, dims);
+
+    return Gather(rows, packIndex);
+}
+
+/*
+unpack the tokens into a padded block
+>> x - the packed tensor (1 * tokenNum * H)
+<< return - the padded block (seqNum * maxLen * H)
+*/
+XTensor T2TPackedBatch::Unpack(XTensor &x)
+{
+    CheckNTErrors(x.order == 3, "Wrong tensor order!");
+    CheckNTErrors(x.GetDim(0) == 1 && x.GetDim(1) == tokenNum, "Unmatched batch!");
+
+    int dims[2] = {tokenNum, x.GetDim(2)};
+
+    XTensor rows;
+    rows = Reshape(x, 2, dims);
+
+    return Gather(rows, unpackIndex);
+}
+
+/*
+pack the values of a padded block in place, e.g., the word ids and the
+labels. x is of size seqNum * maxLen * ... and it becomes 1 * tokenNum * ...
+>> x - the block
+*/
+void T2TPackedBatch::PackData(XTensor * x)
+{
+    CheckNTErrors(x->order >= 2, "Wrong tensor order!");
+    CheckNTErrors(x->GetDim(0) == seqNum && x->GetDim(1) == maxLen, "Unmatched batch!");
+
+    int rowSize = x->unitSize * (x->unitNum / (seqNum * maxLen));
+    int dims[MAX_TENSOR_DIM_NUM];
+    memcpy(dims, x->dimSize, sizeof(int) * x->order);
+    dims[0] = 1;
+    dims[1] = tokenNum;
+
+    XTensor * block = NewTensorBuf(x, x->devID, x->mem);
+    _CopyValues(x, block);
+
+    InitTensor(x, x->order, dims, x->dataType, 1.0F, block->devID, block->mem);
+
+    for(int i = 0; i < seqNum; i++){
+        XMemCopy((char*)x->data + (MTYPE)offsets[i] * rowSize, x->devID,
+                 (char*)block->data + (MTYPE)i * maxLen * rowSize, block->devID,
+                 (MTYPE)(offsets[i + 1] - offsets[i]) * rowSize);
+    }
+
+    DelTensorBuf(block);
+}
+
+}
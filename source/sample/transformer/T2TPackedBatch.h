@@ -0,0 +1,95 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Packed (padding-free) batches. The tokens of the sequences are
+ * concatenated into a tensor of size 1 * T (T = number of real tokens)
+ * and the sequences are given by their offsets. The position-wise layers
+ * (embedding, MMul, FNN, LayerNorm and the output layer) run on the T
+ * tokens directly. Attention unpacks the keys, queries and values to the
+ * usual B * L * H blocks (one segment per row), so that a token sees
+ * the tokens of its own sequence only (with the usual masks), and packs
+ * the result back before the output transformation.
+ */
+
+#ifndef __T2TPACKEDBATCH_H__
+#define __T2TPACKEDBATCH_H__
+
+#include "../../tensor/XTensor.h"
+
+using namespace nts;
+
+namespace transformer
+{
+
+/* a batch of sequences that are packed without padding */
+class T2TPackedBatch
+{
+public:
+    /* number of the sequences */
+    int seqNum;
+
+    /* length of the longest sequence */
+    int maxLen;
+
+    /* number of the tokens */
+    int tokenNum;
+
+    /* offsets of the sequences (seqNum + 1 items). The tokens of
+       sequence i are [offsets[i], offsets[i + 1]) */
+    int * offsets;
+
+    /* size of the offset array */
+    int offsetSize;
+
+    /* for each token, the row of the padded block (seqNum * maxLen) */
+    XTensor packIndex;
+
+    /* for each row of the padded block, the token. A padding row points to
+       token 0. Its value is not used as it is masked in attention and
+       dropped by packing, and so it receives no gradient */
+    XTensor unpackIndex;
+
+    /* for each token, its position in the sequence */
+    XTensor positions;
+
+    /* padding of the unpacked sequences (seqNum * maxLen) */
+    XTensor padding;
+
+public:
+    /* constructor */
+    T2TPackedBatch();
+
+    /* de-constructor */
+    ~T2TPackedBatch();
+
+    /* initialize the batch with the lengths of the sequences */
+    void Init(int * lens, int num, int devID = -1, XMem * mem = NULL);
+
+    /* pack a padded block (seqNum * maxLen * ...) into 1 * tokenNum * ... */
+    XTensor Pack(XTensor &x);
+
+    /* unpack 1 * tokenNum * H into a padded block (seqNum * maxLen * H) */
+    XTensor Unpack(XTensor &x);
+
+    /* pack the values of a padded block (of any data type). No edge is created */
+    void PackData(XTensor * x);
+};
+
+}
+
+#endif
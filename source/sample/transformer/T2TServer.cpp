@@ -0,0 +1,1012 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "T2TServer.h"
+#include "T2TUtility.h"
+#include "../../tensor/XUtility.h"
+#include "../../tensor/core/CHeader.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+namespace transformer
+{
+
+/* constructor */
+T2TServer::T2TServer()
+{
+    model = NULL;
+    socketFN = new char[MAX_LINE_LENGTH];
+    socketFN[0] = 0;
+    port = 0;
+    listenFD = -1;
+    srcVSize = 0;
+    tgtVSize = 0;
+    srcMaxLen = 0;
+    tgtMaxLen = 0;
+    queueSize = 1024;
+    queue = new ServerRequest*[queueSize];
+    queueNum = 0;
+    queueWords = 0;
+    toStop = false;
+    allowShutdown = false;
+    reqCount = 0;
+    batchCount = 0;
+    fillSum = 0;
+    wordFillSum = 0;
+    queueTime = 0;
+    latency = new float[SERVER_LATENCY_WINDOW];
+    latencyNum = 0;
+
+    MUTEX_INIT(mutex);
+    COND_INIT(cond);
+}
+
+/* de-constructor */
+T2TServer::~T2TServer()
+{
+    delete[] socketFN;
+    delete[] queue;
+    delete[] latency;
+
+    MUTEX_DELE(mutex);
+    COND_DELE(cond);
+}
+
+/*
+initialize the server
+>> argc - number of arguments
+>> argv - list of pointers to the arguments
+*/
+void T2TServer::Init(int argc, char ** argv)
+{
+    LoadParamString(argc, argv, "socket", socketFN, "");
+    LoadParamInt(argc, argv, "port", &port, 0);
+    LoadParamInt(argc, argv, "sbatch", &sBatchSize, 32);
+    LoadParamInt(argc, argv, "wbatch", &wBatchSize, 2048);
+    LoadParamFloat(argc, argv, "maxwait", &maxWait, 10.0F);
+    LoadParamInt(argc, argv, "statfreq", &statFreq, 100);
+    LoadParamBool(argc, argv, "allowshutdown", &allowShutdown, false);
+
+    CheckNTErrors(strcmp(socketFN, "") || port > 0, "Either \"-socket\" or \"-port\" is required!");
+    CheckNTErrors(sBatchSize > 0 && wBatchSize > 0, "Illegal batch size!");
+}
+
+#ifndef WIN32
+
+/* a thread that accepts connections */
+void * ServerAcceptThread(void * arg)
+{
+    ((T2TServer*)arg)->Accept();
+    return NULL;
+}
+
+/* argument of a reading thread */
+struct ServerReadArg
+{
+    T2TServer * server;
+    ServerConn * conn;
+};
+
+/* a thread that reads requests from a connection */
+void * ServerReadThread(void * arg)
+{
+    ServerReadArg * readArg = (ServerReadArg*)arg;
+    readArg->server->Read(readArg->conn);
+    delete readArg;
+    return NULL;
+}
+
+/*
+serve requests until a "#shutdown" request comes (the server must run
+with "-allowshutdown", otherwise the request is answered with an error)
+>> myModel - the model (it has been loaded)
+*/
+void T2TServer::Run(T2TModel * myModel)
+{
+    model = myModel;
+
+    CheckNTErrors(model->isLM || model->isMT, "Illegal model type!");
+
+    /* the requests are checked against the vocabularies and the maximum lengths,
+       so that a bad request is answered with an error instead of stopping the server */
+    srcVSize = model->encoder->embedder.vSize;
+    srcMaxLen = model->encoder->embedder.maxLength;
+    if(model->isMT){
+        tgtVSize = MIN(model->decoder->embedder.vSize, model->outputLayer->vSize);
+        tgtMaxLen = model->decoder->embedder.maxLength;
+    }
+    else{
+        tgtVSize = MIN(srcVSize, model->outputLayer->vSize);
+        tgtMaxLen = srcMaxLen;
+    }
+
+    /* create the listening socket */
+    if(strcmp(socketFN, "")){
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        CheckNTErrors(strlen(socketFN) < sizeof(addr.sun_path), "The socket path is too long!");
+        strcpy(addr.sun_path, socketFN);
+        unlink(socketFN);
+        listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+        CheckNTErrors(listenFD >= 0, "Cannot create the socket!");
+        CheckNTErrors(bind(listenFD, (sockaddr*)&addr, sizeof(addr)) == 0, "Cannot bind the socket!");
+    }
+    else{
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((unsigned short)port);
+        listenFD = socket(AF_INET, SOCK_STREAM, 0);
+        CheckNTErrors(listenFD >= 0, "Cannot create the socket!");
+        int reuse = 1;
+        setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        CheckNTErrors(bind(listenFD, (sockaddr*)&addr, sizeof(addr)) == 0, "Cannot bind the socket!");
+    }
+
+    CheckNTErrors(listen(listenFD, 64) == 0, "Cannot listen on the socket!");
+
+    XPRINT3(0, stderr, "[INFO] server started (%s%s, sbatch=%d)\n",
+            strcmp(socketFN, "") ? "unix:" : "tcp port ",
+            strcmp(socketFN, "") ? socketFN : "", sBatchSize);
+    if(!strcmp(socketFN, ""))
+        XPRINT1(0, stderr, "[INFO] listening on 127.0.0.1:%d\n", port);
+
+    pthread_create(&acceptThread, NULL, ServerAcceptThread, this);
+
+    ServerRequest ** reqs = new ServerRequest*[sBatchSize];
+
+    /* the main loop */
+    int num = 0;
+    while((num = NextBatch(reqs)) > 0){
+        Score(reqs, num);
+
+        if(statFreq > 0 && batchCount % statFreq == 0)
+            ShowStat();
+    }
+
+    /* stop accepting */
+    shutdown(listenFD, SHUT_RDWR);
+    close(listenFD);
+    pthread_join(acceptThread, NULL);
+
+    /* stop reading, i.e., the readers see the end of their connections */
+    MUTEX_LOCK(mutex);
+    for(int i = 0; i < conns.count; i++){
+        ServerConn * conn = (ServerConn*)conns.GetItem(i);
+        if(!conn->isReadDone)
+            shutdown(conn->fd, SHUT_RD);
+    }
+    MUTEX_UNLOCK(mutex);
+
+    for(int i = 0; i < conns.count; i++)
+        pthread_join(((ServerConn*)conns.GetItem(i))->reader, NULL);
+
+    /* answer the requests that came after "#shutdown" */
+    while((num = NextBatch(reqs)) > 0)
+        Score(reqs, num);
+
+    for(int i = 0; i < conns.count; i++){
+        ServerConn * conn = (ServerConn*)conns.GetItem(i);
+        if(!conn->isClosed)
+            close(conn->fd);
+        delete conn;
+    }
+    conns.Clear();
+
+    if(strcmp(socketFN, ""))
+        unlink(socketFN);
+
+    ShowStat();
+
+    XPRINT(0, stderr, "[INFO] server stopped\n");
+
+    delete[] reqs;
+}
+
+/* accept the connections */
+void T2TServer::Accept()
+{
+    while(!toStop){
+        int fd = accept(listenFD, NULL, NULL);
+        if(fd < 0){
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+
+        /* the closed connections are removed and their readers are joined */
+        XList closed;
+        MUTEX_LOCK(mutex);
+        for(int i = conns.count - 1; i >= 0; i--){
+            ServerConn * conn = (ServerConn*)conns.GetItem(i);
+            if(conn->isClosed){
+                closed.Add(conn);
+                conns.Remove(i);
+            }
+        }
+        MUTEX_UNLOCK(mutex);
+
+        for(int i = 0; i < closed.count; i++){
+            ServerConn * conn = (ServerConn*)closed.GetItem(i);
+            pthread_join(conn->reader, NULL);
+            delete conn;
+        }
+
+        ServerConn * conn = new ServerConn;
+        conn->fd = fd;
+        conn->pending = 0;
+        conn->isReadDone = false;
+        conn->isClosed = false;
+
+        ServerReadArg * arg = new ServerReadArg;
+        arg->server = this;
+        arg->conn = conn;
+
+        MUTEX_LOCK(mutex);
+        conns.Add(conn);
+        pthread_create(&conn->reader, NULL, ServerReadThread, arg);
+        MUTEX_UNLOCK(mutex);
+    }
+}
+
+/*
+parse a request line
+>> line - the line
+>> req - the request
+>> isMT - indicates whether a source sequence is given
+>> srcVSize - vocabulary size of the source side
+>> tgtVSize - vocabulary size of the target side
+>> srcMaxLen - maximum length of the source sequence
+>> tgtMaxLen - maximum length of the target sequence (without the start symbol)
+*/
+void ParseRequest(char * line, ServerRequest * req, bool isMT,
+                  int srcVSize, int tgtVSize, int srcMaxLen, int tgtMaxLen)
+{
+    int len = (int)strlen(line);
+    int * words = new int[len / 2 + 2];
+    int wNum = 0;
+    int srcLen = -1;
+    char * p = line;
+
+    req->isBad = false;
+
+    while(*p){
+        if(*p == ' ' || *p == '\t' || *p == '\r'){
+            p++;
+            continue;
+        }
+        if(!strncmp(p, "|||", 3)){
+            if(srcLen >= 0)
+                req->isBad = true;
+            srcLen = wNum;
+            p += 3;
+            continue;
+        }
+
+        char * end = NULL;
+        long w = strtol(p, &end, 10);
+
+        /* ids out of the range of int would wrap around in the cast */
+        if(end == p || w < 0 || w > INT_MAX){
+            req->isBad = true;
+            break;
+        }
+        words[wNum++] = (int)w;
+        p = end;
+    }
+
+    if(isMT){
+        req->srcLen = srcLen;
+        req->tgtLen = wNum - srcLen;
+        if(srcLen < 1)
+            req->isBad = true;
+    }
+    else{
+        req->srcLen = 0;
+        req->tgtLen = wNum;
+        if(srcLen >= 0)
+            req->isBad = true;
+    }
+
+    /* at least a start symbol and a word to score */
+    if(req->tgtLen < 2)
+        req->isBad = true;
+
+    /* the words must be in the vocabularies and the sequences must fit in the embedders */
+    if(!req->isBad){
+        for(int i = 0; i < wNum; i++){
+            if(words[i] < 0 || words[i] >= (i < req->srcLen ? srcVSize : tgtVSize))
+                req->isBad = true;
+        }
+        if(req->srcLen >= srcMaxLen || req->tgtLen - 1 >= tgtMaxLen)
+            req->isBad = true;
+    }
+
+    req->words = words;
+}
+
+/*
+read requests from a connection
+>> conn - the connection
+*/
+void T2TServer::Read(ServerConn * conn)
+{
+    int bufSize = 4096;
+    int bufNum = 0;
+    char * buf = new char[bufSize];
+    int id = 0;
+
+    while(1){
+        if(bufNum == bufSize){
+            char * newBuf = new char[bufSize * 2];
+            memcpy(newBuf, buf, bufNum);
+            delete[] buf;
+            buf = newBuf;
+            bufSize *= 2;
+        }
+
+        int n = (int)recv(conn->fd, buf + bufNum, bufSize - bufNum, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+
+        int beg = 0;
+        bufNum += n;
+
+        /* handle the complete lines */
+        for(int i = bufNum - n; i < bufNum; i++){
+            if(buf[i] != '\n')
+                continue;
+
+            buf[i] = 0;
+            char * line = buf + beg;
+            beg = i + 1;
+
+            if(allowShutdown && !strncmp(line, "#shutdown", 9)){
+                MUTEX_LOCK(mutex);
+                toStop = true;
+                COND_SIGNAL(cond);
+                MUTEX_UNLOCK(mutex);
+                continue;
+            }
+
+            ServerRequest * req = new ServerRequest;
+            req->conn = conn;
+            req->id = id++;
+            ParseRequest(line, req, model->isMT, srcVSize, tgtVSize, srcMaxLen, tgtMaxLen);
+            Push(req);
+        }
+
+        memmove(buf, buf + beg, bufNum - beg);
+        bufNum -= beg;
+    }
+
+    delete[] buf;
+
+    /* the connection is closed if all the requests have been answered
+       (it is freed by the accepting thread or when the server stops) */
+    MUTEX_LOCK(mutex);
+    conn->isReadDone = true;
+    if(conn->pending == 0){
+        close(conn->fd);
+        conn->isClosed = true;
+    }
+    MUTEX_UNLOCK(mutex);
+}
+
+/*
+add a request into the queue
+>> req - the request
+*/
+void T2TServer::Push(ServerRequest * req)
+{
+    MUTEX_LOCK(mutex);
+
+    req->arrivalT = GetClockSec();
+    req->conn->pending++;
+
+    if(queueNum == queueSize){
+        ServerRequest ** newQueue = new ServerRequest*[queueSize * 2];
+        memcpy(newQueue, queue, sizeof(ServerRequest*) * queueNum);
+        delete[] queue;
+        queue = newQueue;
+        queueSize *= 2;
+    }
+
+    queue[queueNum++] = req;
+    queueWords += req->tgtLen;
+
+    COND_SIGNAL(cond);
+
+    MUTEX_UNLOCK(mutex);
+}
+
+/* a candidate of a batch */
+struct BatchCand
+{
+    /* position in the queue */
+    int pos;
+
+    /* distance to the length of the oldest request */
+    int dist;
+};
+
+/* compare two candidates (the closer and the older first) */
+int CompareBatchCand(const void * a, const void * b)
+{
+    const BatchCand * ca = (const BatchCand*)a;
+    const BatchCand * cb = (const BatchCand*)b;
+    if(ca->dist != cb->dist)
+        return ca->dist - cb->dist;
+    return ca->pos - cb->pos;
+}
+
+/*
+wait for a batch and take it from the queue. A batch is formed when the
+queue can fill it or the oldest request has waited for "maxWait" milliseconds.
+The batch always contains the oldest request, and the other requests are
+those with the most similar lengths, so that little is wasted on padding.
+>> reqs - the requests of the batch
+<< return - number of the requests (0 means the server stops)
+*/
+int T2TServer::NextBatch(ServerRequest ** reqs)
+{
+    MUTEX_LOCK(mutex);
+
+    while(1){
+        if(queueNum == 0){
+            if(toStop)
+                break;
+            COND_WAIT(cond, mutex);
+            continue;
+        }
+
+        double deadline = queue[0]->arrivalT + maxWait / 1000.0;
+        double now = GetClockSec();
+
+        if(toStop || queueNum >= sBatchSize || queueWords >= wBatchSize || now >= deadline)
+            break;
+
+        /* wait until more requests come or the deadline */
+        timespec ts;
+        ts.tv_sec = (time_t)deadline;
+        ts.tv_nsec = (long)((deadline - (double)ts.tv_sec) * 1e9);
+        pthread_cond_timedwait(&cond, &mutex, &ts);
+    }
+
+    if(queueNum == 0){
+        MUTEX_UNLOCK(mutex);
+        return 0;
+    }
+
+    /* rank the waiting requests by their lengths */
+    BatchCand * cands = new BatchCand[queueNum];
+    for(int i = 0; i < queueNum; i++){
+        cands[i].pos = i;
+        cands[i].dist = abs(queue[i]->srcLen + queue[i]->tgtLen - queue[0]->srcLen - queue[0]->tgtLen);
+    }
+    qsort(cands, queueNum, sizeof(BatchCand), CompareBatchCand);
+
+    int num = 0;
+    int maxLen = 0;
+    for(int i = 0; i < queueNum && num < sBatchSize; i++){
+        ServerRequest * req = queue[cands[i].pos];
+        int len = MAX(maxLen, MAX(req->srcLen, req->tgtLen));
+        if(num > 0 && len * (num + 1) > wBatchSize)
+            break;
+        maxLen = len;
+        reqs[num++] = req;
+        queue[cands[i].pos] = NULL;
+    }
+
+    delete[] cands;
+
+    /* remove the batched requests and keep the order of the others */
+    int k = 0;
+    for(int i = 0; i < queueNum; i++){
+        if(queue[i] != NULL)
+            queue[k++] = queue[i];
+    }
+    queueNum = k;
+
+    for(int i = 0; i < num; i++){
+        queueWords -= reqs[i]->tgtLen;
+        queueTime += GetClockSec() - reqs[i]->arrivalT;
+    }
+
+    MUTEX_UNLOCK(mutex);
+
+    return num;
+}
+
+/*
+score a batch of requests and send the responses
+>> reqs - the requests
+>> num - number of the requests
+*/
+void T2TServer::Score(ServerRequest ** reqs, int num)
+{
+    int devID = model->devID;
+    XMem * mem = model->mem;
+
+    /* the ill-formed requests are answered at once */
+    int k = 0;
+    for(int i = 0; i < num; i++){
+        if(reqs[i]->isBad)
+            Respond(reqs[i], NULL, 0);
+        else
+            reqs[k++] = reqs[i];
+    }
+    num = k;
+
+    if(num == 0)
+        return;
+
+    int maxEnc = 0;
+    int maxDec = 0;
+    int wordNum = 0;
+    for(int i = 0; i < num; i++){
+        maxEnc = MAX(maxEnc, model->isMT ? reqs[i]->srcLen : reqs[i]->tgtLen - 1);
+        maxDec = MAX(maxDec, reqs[i]->tgtLen - 1);
+        wordNum += reqs[i]->tgtLen - 1;
+    }
+
+    XTensor batchEnc;
+    XTensor paddingEnc;
+    XTensor batchDec;
+    XTensor paddingDec;
+
+    int * encValues = new int[num * MAX(maxEnc, maxDec)];
+    float * encPadding = new float[num * MAX(maxEnc, maxDec)];
+    float * probs = new float[maxDec];
+
+    /* the source side (or the history for language modeling) */
+    memset(encValues, 0, sizeof(int) * num * maxEnc);
+    memset(encPadding, 0, sizeof(float) * num * maxEnc);
+    for(int i = 0; i < num; i++){
+        ServerRequest * req = reqs[i];
+        int len = model->isMT ? req->srcLen : req->tgtLen - 1;
+        for(int w = 0; w < len; w++){
+            encValues[i * maxEnc + w] = req->words[w];
+            encPadding[i * maxEnc + w] = 1.0F;
+        }
+    }
+
+    InitTensor2D(&batchEnc, num, maxEnc, X_INT, devID, mem);
+    InitTensor2D(&paddingEnc, num, maxEnc, X_FLOAT, devID, mem);
+    batchEnc.SetData(encValues, batchEnc.unitNum);
+    paddingEnc.SetData(encPadding, paddingEnc.unitNum);
+
+    /* output probabilities */
+    XTensor output;
+
+    if(model->isLM)
+        model->MakeLM(batchEnc, output, paddingEnc, false);
+    else{
+        /* the target side */
+        memset(encValues, 0, sizeof(int) * num * maxDec);
+        memset(encPadding, 0, sizeof(float) * num * maxDec);
+        for(int i = 0; i < num; i++){
+            ServerRequest * req = reqs[i];
+            for(int w = 0; w < req->tgtLen - 1; w++){
+                encValues[i * maxDec + w] = req->words[req->srcLen + w];
+                encPadding[i * maxDec + w] = 1.0F;
+            }
+        }
+
+        InitTensor2D(&batchDec, num, maxDec, X_INT, devID, mem);
+        InitTensor2D(&paddingDec, num, maxDec, X_FLOAT, devID, mem);
+        batchDec.SetData(encValues, batchDec.unitNum);
+        paddingDec.SetData(encPadding, paddingDec.unitNum);
+
+        model->MakeMT(batchEnc, batchDec, output, paddingEnc, paddingDec, false);
+    }
+
+    /* pick up the probabilities of the words and respond */
+    for(int i = 0; i < num; i++){
+        ServerRequest * req = reqs[i];
+        int * tgt = req->words + req->srcLen;
+        for(int w = 0; w < req->tgtLen - 1; w++)
+            probs[w] = output.Get3D(i, w, tgt[w + 1]);
+        Respond(req, probs, req->tgtLen - 1);
+    }
+
+    MUTEX_LOCK(mutex);
+    batchCount++;
+    fillSum += (double)num / sBatchSize;
+    wordFillSum += (double)wordNum / (num * maxDec);
+    MUTEX_UNLOCK(mutex);
+
+    delete[] encValues;
+    delete[] encPadding;
+    delete[] probs;
+}
+
+/*
+send the response of a request
+>> req - the request
+>> probs - log-probabilities of the words (NULL for an ill-formed request)
+>> num - number of the words
+*/
+void T2TServer::Respond(ServerRequest * req, float * probs, int num)
+{
+    char * line = new char[32 * (num + 2)];
+    int len = sprintf(line, "%d ||| ", req->id);
+
+    if(probs == NULL)
+        len += sprintf(line + len, "ERROR\n");
+    else{
+        float sum = 0;
+        for(int i = 0; i < num; i++){
+            len += sprintf(line + len, "%.3e ", probs[i]);
+            sum += probs[i];
+        }
+        len += sprintf(line + len, "||| %e\n", sum);
+    }
+
+    /* send it (a closed connection is simply ignored) */
+    for(int sent = 0; sent < len;){
+        int n = (int)send(req->conn->fd, line + sent, len - sent, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+        sent += n;
+    }
+
+    delete[] line;
+
+    Release(req);
+}
+
+/*
+release a request (and close its connection if it is finished)
+>> req - the request
+*/
+void T2TServer::Release(ServerRequest * req)
+{
+    ServerConn * conn = req->conn;
+    double elapsed = GetClockSec() - req->arrivalT;
+
+    MUTEX_LOCK(mutex);
+    latency[reqCount % SERVER_LATENCY_WINDOW] = (float)elapsed;
+    latencyNum = MIN(latencyNum + 1, SERVER_LATENCY_WINDOW);
+    reqCount++;
+    conn->pending--;
+    if(conn->isReadDone && conn->pending == 0){
+        close(conn->fd);
+        conn->isClosed = true;
+    }
+    MUTEX_UNLOCK(mutex);
+
+    delete[] req->words;
+    delete req;
+}
+
+#else
+
+void T2TServer::Run(T2TModel * myModel)
+{
+    ShowNTErrors("The server is not supported on Windows!");
+}
+
+void T2TServer::Accept() {}
+void T2TServer::Read(ServerConn * conn) {}
+void T2TServer::Push(ServerRequest * req) {}
+int T2TServer::NextBatch(ServerRequest ** reqs) { return 0; }
+void T2TServer::Score(ServerRequest ** reqs, int num) {}
+void T2TServer::Respond(ServerRequest * req, float * probs, int num) {}
+void T2TServer::Release(ServerRequest * req) {}
+
+#endif
+
+/* compare two floats (for sorting) */
+int CompareLatency(const void * a, const void * b)
+{
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+/* show the statistics */
+void T2TServer::ShowStat()
+{
+    MUTEX_LOCK(mutex);
+
+    int num = latencyNum;
+    float * sorted = new float[MAX(num, 1)];
+    memcpy(sorted, latency, sizeof(float) * num);
+
+    int bc = MAX(batchCount, 1);
+    int rc = MAX(reqCount, 1);
+    double fill = fillSum / bc;
+    double wordFill = wordFillSum / bc;
+    double queueMS = queueTime / rc * 1000;
+    int reqs = reqCount;
+    int batches = batchCount;
+
+    MUTEX_UNLOCK(mutex);
+
+    qsort(sorted, num, sizeof(float), CompareLatency);
+
+    float p50 = num > 0 ? sorted[(int)(0.50 * (num - 1))] * 1000 : 0;
+    float p99 = num > 0 ? sorted[(int)(0.99 * (num - 1))] * 1000 : 0;
+
+    XPRINT7(0, stderr, "[INFO] request=%d, batch=%d, fill=%.1f%%, word-fill=%.1f%%, queue=%.2fms, p50=%.2fms, p99=%.2fms\n",
+            reqs, batches, fill * 100, wordFill * 100, queueMS, p50, p99);
+
+    delete[] sorted;
+}
+
+#ifndef WIN32
+
+/* argument of a client thread */
+struct ClientArg
+{
+    /* the server address */
+    sockaddr * addr;
+
+    /* size of the address */
+    socklen_t addrLen;
+
+    /* all the lines */
+    char ** lines;
+
+    /* responses of the lines */
+    char ** results;
+
+    /* number of the lines */
+    int lineNum;
+
+    /* id of the connection */
+    int connID;
+
+    /* number of the connections */
+    int connNum;
+};
+
+/* send lines connID, connID + connNum, ... through a connection and collect the responses */
+void * ClientThread(void * arg)
+{
+    ClientArg * ca = (ClientArg*)arg;
+
+    int fd = socket(ca->addr->sa_family, SOCK_STREAM, 0);
+    CheckNTErrors(fd >= 0, "Cannot create the socket!");
+    CheckNTErrors(connect(fd, ca->addr, ca->addrLen) == 0, "Cannot connect to the server!");
+
+    for(int i = ca->connID; i < ca->lineNum; i += ca->connNum){
+        const char * line = ca->lines[i];
+        int len = (int)strlen(line);
+        for(int sent = 0; sent < len;){
+            int n = (int)send(fd, line + sent, len - sent, MSG_NOSIGNAL);
+            CheckNTErrors(n > 0, "Cannot send the request!");
+            sent += n;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+
+    /* read the responses. They come in the order the batches finish. */
+    int bufSize = 4096;
+    int bufNum = 0;
+    char * buf = new char[bufSize];
+    while(1){
+        if(bufNum == bufSize){
+            char * newBuf = new char[bufSize * 2];
+            memcpy(newBuf, buf, bufNum);
+            delete[] buf;
+            buf = newBuf;
+            bufSize *= 2;
+        }
+
+        int n = (int)recv(fd, buf + bufNum, bufSize - bufNum, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+
+        int beg = 0;
+        bufNum += n;
+        for(int i = bufNum - n; i < bufNum; i++){
+            if(buf[i] != '\n')
+                continue;
+            buf[i] = 0;
+            char * line = buf + beg;
+            beg = i + 1;
+
+            int id = atoi(line);
+            int lineID = ca->connID + id * ca->connNum;
+            char * result = strstr(line, "||| ");
+            if(lineID < 0 || lineID >= ca->lineNum || result == NULL)
+                continue;
+            result += 4;
+            ca->results[lineID] = new char[strlen(result) + 1];
+            strcpy(ca->results[lineID], result);
+        }
+        memmove(buf, buf + beg, bufNum - beg);
+        bufNum -= beg;
+    }
+
+    delete[] buf;
+    close(fd);
+
+    return NULL;
+}
+
+/*
+run the client that sends the requests of a file to the server
+and dumps the responses in order
+>> argc - number of arguments
+>> argv - list of pointers to the arguments
+*/
+void ClientMain(int argc, char ** argv)
+{
+    char * socketFN = new char[MAX_LINE_LENGTH];
+    char * inputFN = new char[MAX_LINE_LENGTH];
+    char * outputFN = new char[MAX_LINE_LENGTH];
+    int port = 0;
+    int connNum = 1;
+    bool toShutdown = false;
+
+    LoadParamString(argc, argv, "socket", socketFN, "");
+    LoadParamString(argc, argv, "input", inputFN, "");
+    LoadParamString(argc, argv, "output", outputFN, "");
+    LoadParamInt(argc, argv, "port", &port, 0);
+    LoadParamInt(argc, argv, "nconn", &connNum, 1);
+    LoadParamBool(argc, argv, "shutdown", &toShutdown, false);
+
+    CheckNTErrors(strcmp(socketFN, "") || port > 0, "Either \"-socket\" or \"-port\" is required!");
+    CheckNTErrors(connNum > 0, "Illegal connection number!");
+
+    sockaddr_un addrUnix;
+    sockaddr_in addrInet;
+    sockaddr * addr = NULL;
+    socklen_t addrLen = 0;
+
+    if(strcmp(socketFN, "")){
+        memset(&addrUnix, 0, sizeof(addrUnix));
+        addrUnix.sun_family = AF_UNIX;
+        strncpy(addrUnix.sun_path, socketFN, sizeof(addrUnix.sun_path) - 1);
+        addr = (sockaddr*)&addrUnix;
+        addrLen = sizeof(addrUnix);
+    }
+    else{
+        memset(&addrInet, 0, sizeof(addrInet));
+        addrInet.sin_family = AF_INET;
+        addrInet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addrInet.sin_port = htons((unsigned short)port);
+        addr = (sockaddr*)&addrInet;
+        addrLen = sizeof(addrInet);
+    }
+
+    /* load the requests */
+    int lineNum = 0;
+    int lineSize = 1024;
+    char ** lines = new char*[lineSize];
+
+    if(strcmp(inputFN, "")){
+        FILE * file = fopen(inputFN, "rb");
+        CheckNTErrors(file, "Cannot read the input file");
+        char * line = new char[MAX_LINE_LENGTH];
+        while(fgets(line, MAX_LINE_LENGTH - 1, file)){
+            int len = (int)strlen(line);
+            while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+                line[--len] = 0;
+            if(len == 0)
+                continue;
+            if(lineNum == lineSize){
+                char ** newLines = new char*[lineSize * 2];
+                memcpy(newLines, lines, sizeof(char*) * lineNum);
+                delete[] lines;
+                lines = newLines;
+                lineSize *= 2;
+            }
+            lines[lineNum] = new char[len + 2];
+            sprintf(lines[lineNum++], "%s\n", line);
+        }
+        delete[] line;
+        fclose(file);
+    }
+
+    char ** results = new char*[MAX(lineNum, 1)];
+    memset(results, 0, sizeof(char*) * MAX(lineNum, 1));
+
+    double startT = GetClockSec();
+
+    ClientArg * args = new ClientArg[connNum];
+    pthread_t * hnds = new pthread_t[connNum];
+    for(int i = 0; i < connNum; i++){
+        args[i].addr = addr;
+        args[i].addrLen = addrLen;
+        args[i].lines = lines;
+        args[i].results = results;
+        args[i].lineNum = lineNum;
+        args[i].connID = i;
+        args[i].connNum = connNum;
+        pthread_create(hnds + i, NULL, ClientThread, args + i);
+    }
+    for(int i = 0; i < connNum; i++)
+        pthread_join(hnds[i], NULL);
+
+    double elapsed = GetClockSec() - startT;
+
+    /* dump the responses in the order of the input */
+    int failed = 0;
+    FILE * ofile = strcmp(outputFN, "") ? fopen(outputFN, "wb") : stdout;
+    CheckNTErrors(ofile, "Cannot open the output file");
+    for(int i = 0; i < lineNum; i++){
+        if(results[i] == NULL || !strncmp(results[i], "ERROR", 5))
+            failed++;
+        fprintf(ofile, "%s\n", results[i] != NULL ? results[i] : "ERROR");
+    }
+    if(ofile != stdout)
+        fclose(ofile);
+
+    XPRINT4(0, stderr, "[INFO] client finished (took %.3fs, request=%d, failed=%d, connection=%d)\n",
+            elapsed, lineNum, failed, connNum);
+
+    /* stop the server (it must run with "-allowshutdown") */
+    if(toShutdown){
+        ClientArg arg = args[0];
+        char * cmd = new char[16];
+        strcpy(cmd, "#shutdown\n");
+        arg.lines = &cmd;
+        arg.lineNum = 1;
+        arg.connID = 0;
+        arg.connNum = 1;
+        arg.results = results;
+        ClientThread(&arg);
+        delete[] cmd;
+    }
+
+    for(int i = 0; i < lineNum; i++){
+        delete[] lines[i];
+        delete[] results[i];
+    }
+    delete[] lines;
+    delete[] results;
+    delete[] args;
+    delete[] hnds;
+    delete[] socketFN;
+    delete[] inputFN;
+    delete[] outputFN;
+}
+
+#else
+
+void ClientMain(int argc, char ** argv)
+{
+    ShowNTErrors("The client is not supported on Windows!");
+}
+
+#endif
+
+}
@@ -0,0 +1,225 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A long-running scoring server for the transformer. The model is loaded
+ * once and the server listens on a local (unix or tcp) socket. Each line
+ * of a connection is a request, i.e., "w1 w2 ... wn" for language modeling
+ * or "source words ||| target words" for machine translation, where the first
+ * target word is the start symbol and every following word is scored.
+ * Requests of all connections are merged into dynamic batches of similar
+ * lengths. A batch is run as soon as it is full or its oldest request has
+ * waited for "maxwait" milliseconds, and the response "id ||| word
+ * log-probs ||| sum" (id is the line number in the connection) is sent
+ * back once the batch is finished.
+ */
+
+#ifndef __T2TSERVER_H__
+#define __T2TSERVER_H__
+
+#include "T2TModel.h"
+#include "../../tensor/XThread.h"
+
+using namespace nts;
+
+namespace transformer
+{
+
+/* number of latencies kept for the percentile statistics */
+#define SERVER_LATENCY_WINDOW 65536
+
+/* a client connection of the server */
+struct ServerConn
+{
+    /* socket of the connection */
+    int fd;
+
+    /* number of requests that are not answered */
+    int pending;
+
+    /* indicates whether all the requests have been read */
+    bool isReadDone;
+
+    /* indicates whether the socket is closed (all the requests are answered) */
+    bool isClosed;
+
+    /* the thread that reads the requests */
+    THREAD_HANDLE reader;
+};
+
+/* a request of scoring a sequence (or a sequence pair) */
+struct ServerRequest
+{
+    /* the connection where the request comes from */
+    ServerConn * conn;
+
+    /* id of the request in the connection */
+    int id;
+
+    /* words of the source sequence followed by words of the target sequence */
+    int * words;
+
+    /* number of source words (0 for language modeling) */
+    int srcLen;
+
+    /* number of target words */
+    int tgtLen;
+
+    /* indicates whether the request is ill-formed */
+    bool isBad;
+
+    /* time when the request arrives */
+    double arrivalT;
+};
+
+/* the scoring server */
+class T2TServer
+{
+public:
+    /* the model */
+    T2TModel * model;
+
+    /* path of the unix socket */
+    char * socketFN;
+
+    /* port of the tcp socket (used when no unix socket is given) */
+    int port;
+
+    /* the listening socket */
+    int listenFD;
+
+    /* maximum number of requests in a batch */
+    int sBatchSize;
+
+    /* maximum number of (padded) words in a batch */
+    int wBatchSize;
+
+    /* maximum waiting time (in milliseconds) of a request before it is batched */
+    float maxWait;
+
+    /* report the statistics every "statFreq" batches */
+    int statFreq;
+
+    /* indicates whether a "#shutdown" request stops the server. Anyone who can
+       reach the socket could send it, so it is an ill-formed request by default */
+    bool allowShutdown;
+
+    /* vocabulary size of the source side (the input side for language modeling) */
+    int srcVSize;
+
+    /* vocabulary size of the target side */
+    int tgtVSize;
+
+    /* maximum length of a source sequence (that the embedder accepts) */
+    int srcMaxLen;
+
+    /* maximum length of a target sequence */
+    int tgtMaxLen;
+
+    /* requests that are waiting to be batched (in arrival order) */
+    ServerRequest ** queue;
+
+    /* number of the waiting requests */
+    int queueNum;
+
+    /* size of the queue buffer */
+    int queueSize;
+
+    /* number of target words of the waiting requests */
+    int queueWords;
+
+    /* mutex that protects the queue and the connections */
+    MUTEX_HANDLE mutex;
+
+    /* condition that is signaled when new requests come */
+    COND_HANDLE cond;
+
+    /* thread that accepts the connections */
+    THREAD_HANDLE acceptThread;
+
+    /* the connections (their reading threads are joined when they are closed or the server stops) */
+    XList conns;
+
+    /* indicates whether the server is shutting down */
+    volatile bool toStop;
+
+    /* number of answered requests */
+    int reqCount;
+
+    /* number of batches */
+    int batchCount;
+
+    /* sum of batch sizes divided by the maximum batch size */
+    double fillSum;
+
+    /* sum of real words divided by padded words */
+    double wordFillSum;
+
+    /* total queuing time (in seconds) */
+    double queueTime;
+
+    /* latencies (in seconds) of the most recent requests */
+    float * latency;
+
+    /* number of the kept latencies */
+    int latencyNum;
+
+public:
+    /* constructor */
+    T2TServer();
+
+    /* de-constructor */
+    ~T2TServer();
+
+    /* initialize the server */
+    void Init(int argc, char ** argv);
+
+    /* serve requests until a "#shutdown" request comes (if it is allowed) */
+    void Run(T2TModel * myModel);
+
+    /* add a request into the queue */
+    void Push(ServerRequest * req);
+
+    /* read requests from a connection */
+    void Read(ServerConn * conn);
+
+    /* accept the connections */
+    void Accept();
+
+protected:
+    /* wait for a batch and take it from the queue */
+    int NextBatch(ServerRequest ** reqs);
+
+    /* score a batch of requests and send the responses */
+    void Score(ServerRequest ** reqs, int num);
+
+    /* send the response of a request */
+    void Respond(ServerRequest * req, float * probs, int num);
+
+    /* release a request (and close its connection if it is finished) */
+    void Release(ServerRequest * req);
+
+    /* show the statistics */
+    void ShowStat();
+};
+
+/* run the client that sends the requests of a file to the server */
+void ClientMain(int argc, char ** argv);
+
+}
+
+#endif
@@ -51,6 +51,13 @@ T2TTrainer::T2TTrainer()
     bufSize = 0;
     bufBatchSize = 0;
     seqOffset = NULL;
+    isRescoring = false;
+    isPacked = false;
+    corpus = NULL;
+    lastBatchSeq = 0;
+    lastBatchSeqNum = 0;
+    batchSeqLimit = 0;
+    lineBuf = new char[MAX_SEQUENCE_LENGTH];
 }
 
 /* de-constructor */
@@ -62,16 +69,7 @@ T2TTrainer::~T2TTrainer()
     delete[] seqLen;
     delete[] seqLen2;
     delete[] seqOffset;
-
-    for(int i = 0; i < moments.count; i++){
-        XTensor * m = (XTensor*)moments.Get(i);
-        delete m;
-    }
-
-    for(int i = 0; i < moments2nd.count; i++){
-        XTensor * m = (XTensor*)moments2nd.Get(i);
-        delete m;
-    }
+    delete[] lineBuf;
 
     for(int i = 0; i < argNum; i++)
         delete[] argArray[i];
@@ -112,7 +110,11 @@ void T2TTrainer::Init(int argc, char ** argv)
     LoadParamFloat(argc, argv, "adambeta1", &adamBeta1, 0.9F);
     LoadParamFloat(argc, argv, "adambeta2", &adamBeta2, 0.98F);
     LoadParamFloat(argc, argv, "adamdelta", &adamDelta, 1e-9F);
+    LoadParamFloat(argc, argv, "momentum", &momentum, 0);
+    LoadParamFloat(argc, argv, "clipnorm", &clipNorm, 0);
     LoadParamBool(argc, argv, "shuffled", &isShuffled, false);
+    LoadParamInt(argc, argv, "shuffleseed", &shuffleSeed, 1);
+    LoadParamInt(argc, argv, "shuffleblock", &shuffleBlock, 0);
     LoadParamFloat(argc, argv, "labelsmoothing", &labelSmoothingP, 0);
     LoadParamInt(argc, argv, "nstepcheckpoint", &nStepCheckpoint, -1);
     LoadParamBool(argc, argv, "epochcheckpoint", &useEpochCheckpoint, false);
@@ -122,7 +124,13 @@ void T2TTrainer::Init(int argc, char ** argv)
     LoadParamBool(argc, argv, "bigbatch", &isBigBatch, false);
     LoadParamBool(argc, argv, "debug", &isDebugged, false);
     LoadParamBool(argc, argv, "randbatch", &isRandomBatch, false);
+    LoadParamBool(argc, argv, "packed", &isPacked, false);
     LoadParamInt(argc, argv, "bucketsize", &bucketSize, 0);
+    LoadParamBool(argc, argv, "rescore", &isRescoring, false);
+
+    int memSize = 0;
+    LoadParamInt(argc, argv, "memsize", &memSize, 1024);
+    autoBatch.Init(argc, argv, memSize);
 
     buf  = new int[bufSize];
     buf2 = new int[bufSize];
@@ -131,8 +139,6 @@ void T2TTrainer::Init(int argc, char ** argv)
     seqLen2 = new int[bufSize];
     seqOffset = new int[bufSize];
 
-    adamBeta1T = 1.0F;
-    adamBeta2T = 1.0F;
 }
 
 int tc = 0;
@@ -166,10 +172,17 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
     char * trainFN = new char[(int)strlen(fn) + 10];
     strcpy(trainFN, fn);
 
-#ifndef WIN32
-    if(isShuffled)
-        sprintf(trainFN, "%s.random", fn);
-#endif
+    /* the training data is read from a binary corpus if it is given or if
+       it is shuffled. A text file is compiled into "fn.bin" in the latter case. */
+    XCorpus binCorpus;
+    if(isShuffled && !XCorpus::IsBinary(fn)){
+        sprintf(trainFN, "%s.bin", fn);
+        XCorpus::Compile(fn, trainFN);
+    }
+    if(XCorpus::IsBinary(trainFN)){
+        binCorpus.Open(trainFN);
+        corpus = &binCorpus;
+    }
 
     int devID = model->devID;
     XMem * mem = model->mem;
@@ -180,16 +193,24 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
     
     PrepareModel(model);
 
+    if(autoBatch.isEnabled)
+        SetAutoBatch(model, &net);
+
     double startT = GetClockSec();
     
     for(epoch = 1; epoch <= nepoch; epoch++){
-#ifndef WIN32
-        if(isShuffled)
-            Shuffle(fn, trainFN);
-#endif
-        
-        FILE * file = fopen(trainFN, "rb");
-        CheckNTErrors(file, "cannot open training file!");
+        FILE * file = NULL;
+
+        if(corpus != NULL){
+            if(isShuffled)
+                corpus->Shuffle(shuffleSeed + epoch, shuffleBlock);
+            else
+                corpus->Rewind();
+        }
+        else{
+            file = fopen(trainFN, "rb");
+            CheckNTErrors(file, "cannot open training file!");
+        }
         
         wordCount = 0;
         loss = 0;
@@ -218,14 +239,33 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
 
             CheckNTErrors(batchEnc.order == 2, "wrong tensor order of the sequence batch");
 
+            /* packed batches of the sequences (NULL means that they are padded) */
+            T2TPackedBatch * packedSrc = isPacked ? &packedEnc : NULL;
+            T2TPackedBatch * packedTgt = isPacked ? &packedDec : NULL;
+
+            /* tokens (with padding) and length of the batch. The attention weights of
+               a packed batch are still of this size */
+            int batchLen = isPacked ? MAX(packedEnc.maxLen, model->isLM ? 0 : packedDec.maxLen) :
+                                      MAX(batchEnc.GetDim(1), model->isLM ? 0 : batchDec.GetDim(1));
+            int batchTokens = (isPacked ? packedEnc.seqNum : batchEnc.GetDim(0)) * batchLen;
+
+            if(autoBatch.isEnabled){
+                /* a batch that is not predicted to fit is split */
+                if(!autoBatch.Fits(batchTokens, batchLen) && RetryBatch(model)){
+                    autoBatch.retryNum++;
+                    continue;
+                }
+                mem->ResetPeak();
+            }
+
             /* output probabilities */
             XTensor output;
 
             /* make the network */
             if(model->isLM)
-                model->MakeLM(batchEnc, output, paddingEnc, true);
+                model->MakeLM(batchEnc, output, paddingEnc, true, packedSrc);
             else if(model->isMT)
-                model->MakeMT(batchEnc, batchDec, output, paddingEnc, paddingDec, true);
+                model->MakeMT(batchEnc, batchDec, output, paddingEnc, paddingDec, true, packedSrc, packedTgt);
             else{
                 ShowNTErrors("Illegal model type!");
             }
@@ -243,7 +283,7 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
                 PadOutput(&output, &labelOnehot, &paddingDec);
 
             /* get probabilities */
-            float prob = GetProb(&output, &labelOnehot, NULL);
+            float prob = GetProb(&output, &label, &paddingDec, NULL);
 
             DTYPE lossLocal = -prob / wc;
             bool doUpdate = (!IsNAN(lossLocal) && !IsINF(lossLocal) && lossLocal < 1e3F);
@@ -258,6 +298,22 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
                 /* back-propagation */
                 net.Backward(output, labelOnehot, paddingDec, CROSSENTROPY);
                 //net.Backward(output, label, labelSmoothingP, CROSSENTROPY);
+
+                if(autoBatch.isEnabled){
+                    /* the step went over the memory limit: we use a smaller budget, and throw
+                       the step away and retry if no gradient is accumulated from other steps */
+                    if(mem->isOverLimit){
+                        wBatchSize = autoBatch.Shrink(batchTokens);
+                        XPRINT3(0, stderr, "[INFO] auto batch: the step (tokens=%d) took %.1fMB, budget -> %d\n",
+                                batchTokens, (double)mem->peakUsed / MILLION, wBatchSize);
+                        if(gradStep == 0 && RetryBatch(model)){
+                            optimizer.ClearGrad();
+                            autoBatch.retryNum++;
+                            continue;
+                        }
+                    }
+                    autoBatch.peakSize = MAX(autoBatch.peakSize, mem->peakUsed);
+                }
                 
                 gradStep += 1;
                 loss += -prob;
@@ -303,7 +359,8 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
             }
         }
         
-        fclose(file);
+        if(file != NULL)
+            fclose(file);
         
         if (isEnd)
             break;
@@ -321,6 +378,14 @@ void T2TTrainer::Train(const char * fn, const char * validFN, const char * model
     XPRINT4(0, stderr, "[INFO] training finished (took %.1fs, step=%d, skipped=%d and epoch=%d)\n",
             elapsed, step, nSkipped, epoch);
 
+    if(autoBatch.isEnabled)
+        autoBatch.ShowReport(stderr);
+
+    /* the last checkpoint is finished before we return */
+    checkpointer.Stop();
+
+    corpus = NULL;
+
     delete[] trainFN;
 }
 
@@ -329,8 +394,9 @@ test the model
 >> fn - test data file
 >> ofn - output data file
 >> model - model that is trained
+<< return - perplexity of the test data
 */
-void T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
+float T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
 {
     int wc = 0;
     int ws = 0;
@@ -340,8 +406,16 @@ void T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
     float loss = 0;
 
     /* data files */
-    FILE * file = fopen(fn, "rb");
-    CheckNTErrors(file, "Cannot read the test file");
+    XCorpus binCorpus;
+    FILE * file = NULL;
+    if(XCorpus::IsBinary(fn)){
+        binCorpus.Open(fn);
+        corpus = &binCorpus;
+    }
+    else{
+        file = fopen(fn, "rb");
+        CheckNTErrors(file, "Cannot read the test file");
+    }
     FILE * ofile = fopen(ofn, "wb");
     CheckNTErrors(ofile, "Cannot open the output file");
 
@@ -399,7 +473,7 @@ void T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
         InitTensor1D(&probs, bSize * length);
 
         /* get probabilities */
-        float prob = GetProb(&output, &gold, &probs);
+        float prob = GetProb(&output, &label, &paddingDec, &probs);
 
         /* dump the test result */
         for(int s = 0; s < bSize; s++){
@@ -431,8 +505,10 @@ void T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
         sentCount += 1;
     }
         
-    fclose(file);
+    if(file != NULL)
+        fclose(file);
     fclose(ofile);
+    corpus = NULL;
 
     delete[] seqs;
     
@@ -440,10 +516,138 @@ void T2TTrainer::Test(const char * fn, const char * ofn, T2TModel * model)
 
     XPRINT3(0, stderr, "[INFO] test finished (took %.1fs, word=%d, and ppl=%.3f)\n",
             elapsed,wordCountTotal, exp(loss / wordCount));
+
+    return (float)exp(loss / wordCount);
+}
+
+/* 
+rescore an n-best list. Each line of the input file is a "source ||| candidate"
+pair and candidates of the same source are in consecutive lines. The encoder 
+runs only once for each source sentence in a batch, and its output is shared
+by all candidates of that sentence.
+>> fn - n-best list file
+>> ofn - output file
+>> model - model that is trained
+*/
+void T2TTrainer::Rescore(const char * fn, const char * ofn, T2TModel * model)
+{
+    int wc = 0;
+    int ws = 0;
+    int wordCountTotal = 0;
+    int candCount = 0;
+    int srcCount = 0;
+    float loss = 0;
+
+    CheckNTErrors(model->isMT, "Rescoring is available for machine translation only!");
+
+    /* data files */
+    XCorpus binCorpus;
+    FILE * file = NULL;
+    if(XCorpus::IsBinary(fn)){
+        binCorpus.Open(fn);
+        corpus = &binCorpus;
+    }
+    else{
+        file = fopen(fn, "rb");
+        CheckNTErrors(file, "Cannot read the n-best file");
+    }
+    FILE * ofile = fopen(ofn, "wb");
+    CheckNTErrors(ofile, "Cannot open the output file");
+
+    int devID = model->devID;
+    XMem * mem = model->mem;
+
+    double startT = GetClockSec();
+
+    /* batch of input sequences */
+    XTensor batchEnc;
+    XTensor batchDec;
+
+    /* label */
+    XTensor label;
+
+    /* padding */
+    XTensor paddingEnc;
+    XTensor paddingDec;
+
+    /* an array that keeps the sequences */
+    int * seqs = new int[MILLION];
+
+    /* source sentence of each candidate */
+    int * srcIndex = new int[bufSize];
+
+    ClearBuf();
+
+    while(LoadBuf(file, false, 2) > 0){
+        int nc = 0;
+        while((nc = LoadBatchNBest(&batchEnc, &paddingEnc, &batchDec, &paddingDec, &label,
+                                   srcIndex, seqs, sBatchSize, wBatchSize, 
+                                   ws, wc, devID, mem)) > 0)
+        {
+            /* output probabilities */
+            XTensor output;
+
+            /* make the network */
+            model->MakeMTShared(batchEnc, batchDec, output, paddingEnc, paddingDec, srcIndex, false);
+
+            int bSize = output.GetDim(0);
+            int length = output.GetDim(1);
+
+            /* prediction probabilities */
+            XTensor probs;
+            InitTensor1D(&probs, bSize * length);
+
+            /* get probabilities */
+            GetProb(&output, &label, NULL, &probs);
+
+            /* dump the result */
+            for(int s = 0; s < bSize; s++){
+                DTYPE sum = 0;
+                int * seq = seqs + s * length;
+                for(int i = 0; i < length; i++){
+                    if(seq[i] >= 0){
+                        fprintf(ofile, "%d ", seq[i]);
+                    }
+                    else
+                        break;
+                }
+                fprintf(ofile, "||| ");
+                for(int i = 0; i < length; i++){
+                    if(seq[i] >= 0){
+                        DTYPE p = probs.Get1D(s * length + i);
+                        fprintf(ofile, "%.3e ", p);
+                        sum += p;
+                        wordCountTotal++;
+                    }
+                    else
+                        break;
+                }
+                fprintf(ofile, "||| %e\n", sum);
+                loss += -sum;
+            }
+
+            candCount += nc;
+            srcCount += batchEnc.GetDim(0);
+        }
+    }
+
+    if(file != NULL)
+        fclose(file);
+    fclose(ofile);
+    corpus = NULL;
+
+    delete[] seqs;
+    delete[] srcIndex;
+
+    double elapsed = GetClockSec() - startT;
+
+    XPRINT5(0, stderr, "[INFO] rescoring finished (took %.1fs, candidate=%d, source=%d, word=%d, and ppl=%.3f)\n",
+            elapsed, candCount, srcCount, wordCountTotal, exp(loss / MAX(wordCountTotal, 1)));
 }
 
 /* 
-make a checkpoint 
+make a checkpoint. The parameters are copied and the checkpoint is written
+(and validated if "-validate" is set) in the background, see T2TCheckpointer
 >> model - the model
 >> validFN - validation data file
 >> modelFN - model data file
@@ -457,19 +661,15 @@ void T2TTrainer::MakeCheckpoint(T2TModel * model, const char * validFN, const ch
     sprintf(fn, "%s.%s.%03d", modelFN, label, id);
     sprintf(fn2, "%s.%s.%03d.output", modelFN, label, id);
 
-    model->Dump(fn);
-    //if(validFN != NULL){
-        //T2TTrainer trainer;
-        //trainer.Init(argNum, argArray);
-        //trainer.Test(validFN, fn2, model);
-    //}
+    if(checkpointer.model == NULL)
+        checkpointer.Init(argNum, argArray, model, validFN);
+
+    checkpointer.Make(fn, fn2);
 
     delete[] fn;
     delete[] fn2;
 }
 
-char line[MAX_SEQUENCE_LENGTH];
-
 struct SampleNode
 {
     int id;
@@ -501,15 +701,31 @@ int T2TTrainer::LoadBuf(FILE * file, bool isSorted, int step)
     int lineCount = 0;
     int seqCount = 0;
     int wordCount = 0;
-    while(fgets(line, MAX_SEQUENCE_LENGTH - 1, file)){
-        int len = (int)strlen(line);
 
-        while(line[len - 1] == '\r' || line[len - 1] == '\n'){
-            line[len - 1] = 0;
+    /* lines of a binary corpus are copied without any parsing */
+    while(corpus != NULL && wordCount < bufSize - MAX_SEQUENCE_LENGTH){
+        int num = corpus->NextLine(buf + wordCount, seqLen + seqCount, 
+                                   bufSize - seqCount, bufSize - wordCount);
+        if(num < 0)
+            break;
+
+        for(int i = 0; i < num; i++){
+            seqOffset[seqCount] = wordCount;
+            wordCount += seqLen[seqCount++];
+        }
+
+        lineCount++;
+    }
+
+    while(corpus == NULL && fgets(lineBuf, MAX_SEQUENCE_LENGTH - 1, file)){
+        int len = (int)strlen(lineBuf);
+
+        while(lineBuf[len - 1] == '\r' || lineBuf[len - 1] == '\n'){
+            lineBuf[len - 1] = 0;
             len--;
         }
 
-        len = (int)strlen(line);
+        len = (int)strlen(lineBuf);
         if(len == 0)
             continue;
         
@@ -523,17 +739,17 @@ int T2TTrainer::LoadBuf(FILE * file, bool isSorted, int step)
 
         for(i = 0; i < len; i++){
             /* load word (id) seperated by space or tab */
-            if((line[i] == ' ' || line[i] == '\t') && wSize > 0){
-                line[i] = 0;
+            if((lineBuf[i] == ' ' || lineBuf[i] == '\t') && wSize > 0){
+                lineBuf[i] = 0;
 
-                if(wSize == 3 && line[i - 1] == '|' && line[i - 2] == '|' && line[i - 3] == '|'){
+                if(wSize == 3 && lineBuf[i - 1] == '|' && lineBuf[i - 2] == '|' && lineBuf[i - 3] == '|'){
                     seqLen[seqCount] = wNumLocal;
                     seqOffset[seqCount] = wordCount + wNum - wNumLocal;
                     seqCount++;
                     wNumLocal = 0;
                 }
                 else{
-                    buf[wordCount + wNum++] = atoi(line + i - wSize);
+                    buf[wordCount + wNum++] = atoi(lineBuf + i - wSize);
                     wNumLocal++;
                 }
 
@@ -544,7 +760,7 @@ int T2TTrainer::LoadBuf(FILE * file, bool isSorted, int step)
         }
 
         if(wSize > 0){
-            buf[wordCount + wNum++] = atoi(line + i - wSize);
+            buf[wordCount + wNum++] = atoi(lineBuf + i - wSize);
             wNumLocal++;
         }
 
@@ -675,7 +891,7 @@ int T2TTrainer::LoadBatch(FILE * file, bool isLM,
 						  bool isTraining)
 {
     if(isLM){
-        return LoadBatchLM(file, batchEnc, paddingEnc, batchDec, paddingDec, gold, label,
+        return LoadBatchLM(file, batchEnc, paddingEnc, batchDec, paddingDec, label,
                            seqs, vsEnc, sBatch, wBatch, 
                            isSorted, wCount, devID, mem, isTraining);
     }
@@ -694,7 +910,7 @@ load a batch of sequences (for LM)
 >> paddingEnc - padding of the input sequences
 >> batchDec - the batch of the output sequences
 >> paddingDec - padding of the output sequences
->> gold - gold standard
+>> label - id of the gold word for each position
 >> seqs - keep the sequences in an array
 >> vs - vocabulary size
 >> sBatch - batch size of sequences
@@ -708,7 +924,7 @@ load a batch of sequences (for LM)
 int T2TTrainer::LoadBatchLM(FILE * file, 
                             XTensor * batchEnc, XTensor * paddingEnc,
                             XTensor * batchDec, XTensor * paddingDec,
-                            XTensor * gold, XTensor * label,
+                            XTensor * label,
                             int * seqs,
                             int vs, int sBatch, int wBatch, 
                             bool isSorted, int &wCount,
@@ -736,28 +952,30 @@ int T2TTrainer::LoadBatchLM(FILE * file,
         int tc = isBigBatch ? wc : max * sc;
         if(sc >= sBatch && tc >= wBatch)
             break;
+
+        /* the batch is retried in smaller pieces */
+        if(batchSeqLimit > 0 && sc >= batchSeqLimit)
+            break;
     }
 
     wCount = 0;
     nextSeq = seq + sc;
+    lastBatchSeq = seq;
+    lastBatchSeqNum = sc;
+    batchSeqLimit = 0;
 
     if(sc <= 0)
         return 0;
 
-    int dims[MAX_TENSOR_DIM_NUM];
-    dims[0] = sc;
-    dims[1] = max;
-    dims[2] = vs;
-
+    /* the gold standard is kept as word ids (label) rather than a dense 
+       one-hot tensor of size sc * max * vs */
     InitTensor2D(batchEnc, sc, max, X_INT, devID, mem);
     InitTensor2D(label, sc, max, X_INT, devID, mem);
-    InitTensor(gold, 3, dims, X_FLOAT, 1.0F, devID, mem);
     InitTensor2D(paddingEnc, sc, max, X_FLOAT, devID, mem);
     InitTensor2D(paddingDec, sc, max, X_FLOAT, devID, mem);
 
     batchEnc->SetZeroAll();
     label->SetZeroAll();
-    gold->SetZeroAll();
     paddingEnc->SetZeroAll();
     paddingDec->SetZeroAll();
 
@@ -765,11 +983,10 @@ int T2TTrainer::LoadBatchLM(FILE * file,
     
     int * batchEncValues = new int[batchEnc->unitNum];
     int * labelValues = new int[label->unitNum];
-    MTYPE * goldOffsets = new MTYPE[gold->unitNum];
     MTYPE * paddingEncOffsets = new MTYPE[paddingEnc->unitNum];
     MTYPE * paddingDecOffsets = new MTYPE[paddingDec->unitNum];
 
-    int wGold = 0;
+    int * lens = new int[sc];
 
     memset(batchEncValues, 0, sizeof(int) * batchEnc->unitNum);
     memset(labelValues, 0, sizeof(int) * label->unitNum);
@@ -777,23 +994,21 @@ int T2TTrainer::LoadBatchLM(FILE * file,
     for(int s = seq; s < seq + sc; s++){
         int len = isDoubledEnd ? seqLen[s] : seqLen[s] - 1;
         CheckNTErrors(len <= max, "Something is wrong!");
+        lens[s - seq] = len;
         for(int w = 0; w < len; w++){
             int num = buf[seqOffset[s] + w];
             batchEncValues[(int)batchEnc->GetOffset2D(s - seq, w)] = num;
             paddingEncOffsets[wCount] = paddingEnc->GetOffset2D(s - seq, w);
             paddingDecOffsets[wCount] = paddingDec->GetOffset2D(s - seq, w);
             if (w > 0) {
-                goldOffsets[wGold++] = gold->GetOffset3D(s - seq, w - 1, num);
                 labelValues[(int)label->GetOffset2D(s - seq, w - 1)] = buf[seqOffset[s] + w];
             }
             
             if (w == len - 1) {
                 if (isDoubledEnd) {
-                    goldOffsets[wGold++] = gold->GetOffset3D(s - seq, w, num);
                     labelValues[(int)label->GetOffset2D(s - seq, w)] = buf[seqOffset[s] + w];
                 }   
                 else {
-                    goldOffsets[wGold++] = gold->GetOffset3D(s - seq, w, buf[seqOffset[s] + w + 1]);
                     labelValues[(int)label->GetOffset2D(s - seq, w)] = buf[seqOffset[s] + w + 1];
                 }
                     
@@ -813,10 +1028,19 @@ int T2TTrainer::LoadBatchLM(FILE * file,
 
     batchEnc->SetData(batchEncValues, batchEnc->unitNum);
     label->SetData(labelValues, label->unitNum);
-    gold->SetDataBatched(goldOffsets, 1.0F, wGold);
     paddingEnc->SetDataBatched(paddingEncOffsets, 1.0F, wCount);
     paddingDec->SetDataBatched(paddingDecOffsets, 1.0F, wCount);
 
+    /* the sequences are packed into 1 * wCount tokens for training. A test 
+       batch has one sequence only, and there is nothing to pack */
+    if(isPacked && isTraining){
+        packedEnc.Init(lens, sc, devID, mem);
+        packedEnc.PackData(batchEnc);
+        packedEnc.PackData(label);
+        packedEnc.PackData(paddingEnc);
+        packedEnc.PackData(paddingDec);
+    }
+
     /*XTensor * tmp = NewTensorBuf(paddingEnc, devID, mem);
     _ConvertDataType(batchEnc, tmp);
     _NotEqual(tmp, paddingEnc, 0);
@@ -829,9 +1053,9 @@ int T2TTrainer::LoadBatchLM(FILE * file,
 
     delete[] batchEncValues;
     delete[] labelValues;
-    delete[] goldOffsets;
     delete[] paddingEncOffsets;
     delete[] paddingDecOffsets;
+    delete[] lens;
 
     fflush(tf);
 
@@ -976,6 +1200,9 @@ int T2TTrainer::LoadBatchMT(FILE * file,
     MTYPE * paddingDecOffsets = new MTYPE[sc * maxDec / 2];
     //MTYPE * goldOffsets = new MTYPE[sc * maxDec / 2];
 
+    int * lensEnc = new int[sCount];
+    int * lensDec = new int[sCount];
+
     memset(batchEncValues, 0, sizeof(int) * batchEnc->unitNum);
     memset(batchDecValues, 0, sizeof(int) * batchDec->unitNum);
     memset(labelValues, 0, sizeof(int) * batchDec->unitNum);
@@ -984,6 +1211,7 @@ int T2TTrainer::LoadBatchMT(FILE * file,
     for(int s = seq; s < seq + sc; s += 2){
         int len = seqLen[s];
         int sent = (s - seq)/2;
+        lensEnc[sent] = len;
         for(int w = 0; w < len; w++){
             int num = buf[seqOffset[s] + w];
             batchEncValues[batchEnc->GetOffset2D(sent, w)] = num;
@@ -1004,6 +1232,7 @@ int T2TTrainer::LoadBatchMT(FILE * file,
         int len = isDoubledEnd ? seqLen[s] : seqLen[s] - 1;
         CheckNTErrors(len <= maxDec, "Something is wrong!");
         int sent = (s - seq - 1)/2;
+        lensDec[sent] = len;
         for(int w = 0; w < len; w++){
             int num = buf[seqOffset[s] + w];
             batchDecValues[batchDec->GetOffset2D(sent, w)] = num;
@@ -1042,6 +1271,18 @@ int T2TTrainer::LoadBatchMT(FILE * file,
     label->SetData(labelValues, label->unitNum);
     paddingDec->SetDataBatched(paddingDecOffsets, 1.0F, wCountPad);
 
+    /* the source and target sequences are packed for training */
+    if(isPacked && isTraining){
+        packedEnc.Init(lensEnc, sCount, devID, mem);
+        packedEnc.PackData(batchEnc);
+        packedEnc.PackData(paddingEnc);
+
+        packedDec.Init(lensDec, sCount, devID, mem);
+        packedDec.PackData(batchDec);
+        packedDec.PackData(label);
+        packedDec.PackData(paddingDec);
+    }
+
     //XTensor * tmp2 = NewTensorBuf(paddingDec, devID, mem);
     //_ConvertDataType(batchDec, tmp2);
     //_NotEqual(tmp2, paddingDec, 0);
@@ -1055,63 +1296,186 @@ int T2TTrainer::LoadBatchMT(FILE * file,
     //delete[] paddingEncOffsets;
     delete[] paddingDecOffsets;
     //delete[] goldOffsets;
+    delete[] lensEnc;
+    delete[] lensDec;
 
     return sc;
 }
 
 /* 
-shuffle lines of the file 
->> srcFile - the source file to shuffle
->> tgtFile - the resulting file
+load a batch of n-best candidates from the buffer. The candidates of the same 
+source sentence (i.e., consecutive "source ||| candidate" pairs that have the 
+same source sequence) are kept in the same batch and the source sentence 
+appears only once on the encoder side.
+>> batchEnc - the batch of the distinct source sequences
+>> paddingEnc - padding of the source sequences
+>> batchDec - the batch of the candidates (input of the decoder)
+>> paddingDec - padding of the candidates
+>> label - the label (next word) of each decoder position
+>> srcIndex - srcIndex[i] is the source sequence (in batchEnc) of the i-th candidate
+>> seqs - keep the candidates in an array
+>> sBatch - candidate number in a batch
+>> wBatch - word number (on either side) in a batch
+>> ws - number of words on the encoder side
+>> wCount - number of words on the decoder side
+>> devID - device id
+>> mem - memory pool
+<< return - number of candidates in the batch (0 if the buffer is used up)
 */
-void T2TTrainer::Shuffle(const char * srcFile, const char * tgtFile)
+int T2TTrainer::LoadBatchNBest(XTensor * batchEnc, XTensor * paddingEnc, 
+                               XTensor * batchDec, XTensor * paddingDec,
+                               XTensor * label, int * srcIndex, int * seqs,
+                               int sBatch, int wBatch, int &ws, int &wCount,
+                               int devID, XMem * mem)
 {
-    char * line = new char[MAX_LINE_LENGTH];
-#ifndef WIN32
-    sprintf(line, "shuf %s > %s", srcFile, tgtFile);
-    system(line);
-#else
-    ShowNTErrors("Cannot shuffle the file on WINDOWS systems!");
-#endif
-    delete[] line;
+    int seq = nextSeq;
+    int sc = 0;
+    int nc = 0;
+    int uc = 0;
+    int maxEnc = 0;
+    int maxDec = 0;
+    int wcEnc = 0;
+    int wcDec = 0;
+
+    /* collect the candidates group by group */
+    while(seq + sc < nseqBuf){
+        int s = seq + sc;
+        int gc = 1;
+        int gMaxDec = isDoubledEnd ? seqLen[s + 1] : seqLen[s + 1] - 1;
+        int gwDec = gMaxDec;
+
+        /* candidates of the same source sequence */
+        while(s + gc * 2 < nseqBuf){
+            int t = s + gc * 2;
+            if(seqLen[t] != seqLen[s] || 
+               memcmp(buf + seqOffset[t], buf + seqOffset[s], sizeof(int) * seqLen[s]))
+                break;
+            int wnDec = isDoubledEnd ? seqLen[t + 1] : seqLen[t + 1] - 1;
+            gMaxDec = MAX(gMaxDec, wnDec);
+            gwDec += wnDec;
+            gc++;
+        }
+
+        /* the same condition as in LoadBatchMT, i.e., a long source sequence
+           counts even though it appears only once in the batch */
+        int tcEnc = isBigBatch ? (wcEnc + seqLen[s]) : MAX(maxEnc, seqLen[s]) * (uc + 1);
+        int tcDec = isBigBatch ? (wcDec + gwDec) : MAX(maxDec, gMaxDec) * (nc + gc);
+
+        if(nc != 0 && nc + gc > sBatch && (tcEnc > wBatch || tcDec > wBatch))
+            break;
+
+        for(int i = 0; i < gc; i++)
+            srcIndex[nc + i] = uc;
+
+        maxEnc = MAX(maxEnc, seqLen[s]);
+        maxDec = MAX(maxDec, gMaxDec);
+        wcEnc += seqLen[s];
+        wcDec += gwDec;
+        nc += gc;
+        uc += 1;
+        sc += gc * 2;
+    }
+
+    nextSeq = seq + sc;
+
+    if(nc == 0)
+        return 0;
+
+    InitTensor2D(batchEnc, uc, maxEnc, X_INT, devID, mem);
+    InitTensor2D(paddingEnc, uc, maxEnc, X_FLOAT, devID, mem);
+    InitTensor2D(batchDec, nc, maxDec, X_INT, devID, mem);
+    InitTensor2D(paddingDec, nc, maxDec, X_FLOAT, devID, mem);
+    InitTensor2D(label, nc, maxDec, X_INT, devID, mem);
+
+    paddingDec->SetZeroAll();
+
+    int wCountPad = 0;
+    int seqSize = 0;
+    ws = 0;
+    wCount = 0;
+
+    int * batchEncValues = new int[batchEnc->unitNum];
+    int * batchDecValues = new int[batchDec->unitNum];
+    int * labelValues = new int[label->unitNum];
+    MTYPE * paddingDecOffsets = new MTYPE[nc * maxDec];
+
+    memset(batchEncValues, 0, sizeof(int) * batchEnc->unitNum);
+    memset(batchDecValues, 0, sizeof(int) * batchDec->unitNum);
+    memset(labelValues, 0, sizeof(int) * label->unitNum);
+
+    for(int s = seq, cand = 0; s < seq + sc; s += 2, cand++){
+
+        /* the source sequence (the first candidate of each group) */
+        if(cand == 0 || srcIndex[cand] != srcIndex[cand - 1]){
+            int sent = srcIndex[cand];
+            for(int w = 0; w < seqLen[s]; w++){
+                batchEncValues[batchEnc->GetOffset2D(sent, w)] = buf[seqOffset[s] + w];
+                ws++;
+            }
+        }
+
+        /* the candidate. It is the same as what we do in LoadBatchMT */
+        int t = s + 1;
+        int len = isDoubledEnd ? seqLen[t] : seqLen[t] - 1;
+        CheckNTErrors(len <= maxDec, "Something is wrong!");
+        for(int w = 0; w < len; w++){
+            batchDecValues[batchDec->GetOffset2D(cand, w)] = buf[seqOffset[t] + w];
+            if(w < len - 1){
+                paddingDecOffsets[wCountPad++] = paddingDec->GetOffset2D(cand, w);
+                wCount++;
+            }
+            if(w > 0)
+                labelValues[label->GetOffset2D(cand, w - 1)] = buf[seqOffset[t] + w];
+            if(w == len - 1)
+                labelValues[label->GetOffset2D(cand, w)] = buf[seqOffset[t] + (isDoubledEnd ? w : w + 1)];
+            seqs[seqSize++] = buf[seqOffset[t] + w];
+        }
+
+        for(int w = len; w < maxDec; w++)
+            seqs[seqSize++] = -1;
+    }
+
+    batchEnc->SetData(batchEncValues, batchEnc->unitNum);
+    XTensor * tmp = NewTensorBuf(paddingEnc, devID, mem);
+    _ConvertDataType(batchEnc, tmp);
+    _NotEqual(tmp, paddingEnc, 0);
+    DelTensorBuf(tmp);
+
+    batchDec->SetData(batchDecValues, batchDec->unitNum);
+    label->SetData(labelValues, label->unitNum);
+    paddingDec->SetDataBatched(paddingDecOffsets, 1.0F, wCountPad);
+
+    delete[] batchEncValues;
+    delete[] batchDecValues;
+    delete[] labelValues;
+    delete[] paddingDecOffsets;
+
+    return nc;
 }
+
     
 /*
-get word probabilities for a batch of sequences
+get word probabilities for a batch of sequences. We pick up the probability
+of the gold word at each position by its id, rather than multiplying the
+output by a one-hot gold tensor and summing over the vocabulary.
 >> output - word distribution for each position
->> gold - gold standard
+>> label - id of the gold word for each position
+>> padding - padding of the positions (NULL means no padding)
 >> wordProbs - word probability for gold prediction
 */
-float T2TTrainer::GetProb(XTensor * output, XTensor * gold, XTensor * wordProbs)
+float T2TTrainer::GetProb(XTensor * output, XTensor * label, XTensor * padding, XTensor * wordProbs)
 {
-    XTensor probs;
-    InitTensor(&probs, output);
-    
-    _Multiply(output, gold, &probs);
-    
     /* probability of each word */
     XTensor wprobs;
-    InitTensor1D(&wprobs, output->unitNum/output->GetDim(-1), X_FLOAT, output->devID, output->mem);
-    
-    int dims[2] = {output->unitNum/output->GetDim(-1), output->GetDim(-1)};
-    probs.Reshape(2, dims);
-    _ReduceSum(&probs, &wprobs, 1);
+    InitTensor1D(&wprobs, label->unitNum, X_FLOAT, output->devID, output->mem);
+
+    _GatherByIndex(output, &wprobs, label, padding);
     
     if(wordProbs != NULL)
         _CopyValues(&wprobs, wordProbs);
     
-    /* reshape the tensor to fit it into the reduce procedure
-       TODO: XTensor supports scalars */
-    dims[0] = 1;
-    dims[1] = probs.unitNum;
-    probs.Reshape(2, dims);
-    
     /* probability for the batch */
-    XTensor result;
-    InitTensor1D(&result, 1, X_FLOAT, output->devID, output->mem);
-    _ReduceSum(&probs, &result, 1);
-    
-    return result.Get1D(0);
+    return _ReduceSumAll(&wprobs);
 }
 
 /* 
@@ -1123,88 +1487,187 @@ where
 >> lr - learning rate
 */
 void T2TTrainer::Update(T2TModel * model, const float lr)
+{
+    optimizer.Update(lr);
+}
+
+/* 
+prepare model for training 
+>> model - the model for training
+*/
+void T2TTrainer::PrepareModel(T2TModel * model)
 {
     XList ws(100);
 
     model->GetParams(ws);
 
-    for(int i = 0; i < ws.count; i++){
-        XTensor * para = (XTensor*)ws.Get(i);
-        XTensor * paraGrad = para->grad;
+    if(useAdam)
+        optimizer.SetAdam(adamBeta1, adamBeta2, adamDelta);
+    else
+        optimizer.SetSGD(momentum);
 
-        if (paraGrad == NULL)
-            continue;
-
-        CheckNTErrors(para != NULL, "NULL parameter tensor!");
-        CheckNTErrors(paraGrad != NULL, "NULL gradient tensor!");
+    optimizer.SetClipNorm(clipNorm);
 
-        if(useAdam){
-            adamBeta1T *= adamBeta1;
-            adamBeta2T *= adamBeta2;
-            DTYPE e = lr * (DTYPE)sqrt(1 - adamBeta2T) / (1 - adamBeta1T);
-            DTYPE d = adamDelta * (DTYPE)sqrt(1 - adamBeta2T);
+    /* parameters and gradients are packed into flat buffers */
+    optimizer.Init(ws, globalPRunner);
+}
 
-            /* m = beta_1 * m + (1-beta_1) * grad */
-            XTensor * m = (XTensor*)moments.Get(i);
-            _ScaleAndShiftMe(m, adamBeta1, 0);
-            _Sum(m, paraGrad, m, (1.0F - adamBeta1));
-            
-            /* v = beta_2 * v + (1-beta_2) * grad * grad*/
-            XTensor * v = (XTensor*)moments2nd.Get(i);
-            _Multiply(paraGrad, paraGrad, v, adamBeta2/(1.0F - adamBeta2));
-            _ScaleAndShiftMe(v, (1.0F - adamBeta2), 0);
+/* 
+choose the batch size by the memory used in a few probes. We run steps on
+synthetic batches of two lengths and two sizes, fit the memory model and
+take the largest token budget that fits the memory limit.
+>> model - the model for training
+>> net - the network for back-propagation
+*/
+void T2TTrainer::SetAutoBatch(T2TModel * model, XNet * net)
+{
+    XMem * mem = model->mem;
 
-            /* v2 = m / (sqrt(v) + delta) */
-            XTensor * v2 = NewTensorBuf(v, v->devID, v->mem);
-            _Power(v, v2, 0.5F);
-            _ScaleAndShiftMe(v2, 1.0F, d);
-            _Div(m, v2, v2);
+    CheckNTErrors(mem != NULL, "Automatic batch sizing needs a memory pool!");
 
-            /* the delta rule */
-            _Sum(para, v2, para, -e);
+    autoBatch.probeNum = 0;
+    autoBatch.baseSize = mem->GetUsedSize();
 
-            DelTensorBuf(v2);
+    int lens[2] = {MAX(autoBatch.maxLen / 4, 1), autoBatch.maxLen};
+    int tokens[2] = {AUTO_BATCH_PROBE_TOKENS, AUTO_BATCH_PROBE_TOKENS * 2};
 
+    for(int i = 0; i < 2; i++){
+        for(int j = 0; j < 2; j++){
+            int sc = MAX(tokens[j] / lens[i], 1);
+            MTYPE size = ProbeStep(model, net, sc, lens[i]);
+            autoBatch.AddProbe(sc * lens[i], lens[i], size);
         }
-        else{
-            /* the delta rule */
-            _Sum(para, paraGrad, para, -lr);
-        }
+    }
+
+    autoBatch.Fit();
+
+    wBatchSize = autoBatch.ChooseBudget();
+    sBatchSize = 1;
+
+    mem->SetSizeLimit(autoBatch.memLimit);
+
+    autoBatch.Show(stderr);
+}
+
+/* 
+run a training step on a synthetic batch (without update) and measure the
+memory that it uses on top of the model and the optimizer
+>> model - the model for training
+>> net - the network for back-propagation
+>> sc - number of sequences
+>> len - length of the sequences
+<< return - the peak memory of the step
+*/
+MTYPE T2TTrainer::ProbeStep(T2TModel * model, XNet * net, int sc, int len)
+{
+    int devID = model->devID;
+    XMem * mem = model->mem;
 
-        /* clear gradient */
-        paraGrad->SetZeroAll();
+    mem->ResetPeak();
+
+    int * ids = new int[sc * len];
+
+    XTensor batchEnc;
+    XTensor batchDec;
+    XTensor paddingEnc;
+    XTensor paddingDec;
+    XTensor label;
+    XTensor output;
+
+    for(int i = 0; i < sc * len; i++)
+        ids[i] = 2 + rand() % MAX(vSize - 2, 1);
+    InitTensor2D(&batchEnc, sc, len, X_INT, devID, mem);
+    batchEnc.SetData(ids, sc * len);
+
+    for(int i = 0; i < sc * len; i++)
+        ids[i] = 2 + rand() % MAX(vSizeTgt - 2, 1);
+    InitTensor2D(&label, sc, len, X_INT, devID, mem);
+    label.SetData(ids, sc * len);
+
+    InitTensor2D(&paddingEnc, sc, len, X_FLOAT, devID, mem);
+    InitTensor2D(&paddingDec, sc, len, X_FLOAT, devID, mem);
+    _SetDataFixedFloat(&paddingEnc, 1.0F);
+    _SetDataFixedFloat(&paddingDec, 1.0F);
+
+    if(model->isLM)
+        model->MakeLM(batchEnc, output, paddingEnc, true);
+    else{
+        InitTensor2D(&batchDec, sc, len, X_INT, devID, mem);
+        batchDec.SetData(ids, sc * len);
+        model->MakeMT(batchEnc, batchDec, output, paddingEnc, paddingDec, true);
     }
+
+    XTensor labelOnehot;
+    labelOnehot = IndexToOnehot(label, vSizeTgt, labelSmoothingP);
+
+    PadOutput(&output, &labelOnehot, &paddingDec);
+    GetProb(&output, &label, &paddingDec, NULL);
+    RescaleOutput(&output, &labelOnehot, &paddingDec);
+
+    net->Backward(output, labelOnehot, paddingDec, CROSSENTROPY);
+
+    /* the gradients of a probe are not used */
+    optimizer.ClearGrad();
+
+    delete[] ids;
+
+    return mem->peakUsed > autoBatch.baseSize ? mem->peakUsed - autoBatch.baseSize : 0;
 }
 
 /* 
-prepare model for training 
+load the last batch again in smaller pieces, i.e., the next batch has
+the first half of its sequences
 >> model - the model for training
+<< return - false if the batch cannot be split
 */
-void T2TTrainer::PrepareModel(T2TModel * model)
+bool T2TTrainer::RetryBatch(T2TModel * model)
 {
-    moments.Clear();
-    moments2nd.Clear();
+    if(model->isLM){
+        if(lastBatchSeqNum <= 1)
+            return false;
 
-    XList ws(100);
+        nextSeq = lastBatchSeq;
+        batchSeqLimit = lastBatchSeqNum / 2;
 
-    model->GetParams(ws);
+        return true;
+    }
+
+    if(nextBatch <= 0)
+        return false;
 
-    for(int i = 0; i < ws.count; i++){
-        XTensor * para = (XTensor*)ws.Get(i);
-        XNoder::MakeGrad(para);
-
-        if(useAdam){
-            XTensor * m = new XTensor(para);
-            XTensor * m2 = new XTensor(para);
-            m->SetZeroAll();
-            m2->SetZeroAll();
-            moments.Add(m);
-            moments2nd.Add(m2);
+    BatchNode batch = bufBatch[nextBatch - 1];
+    int pairNum = (batch.end - batch.beg) / 2;
+
+    if(pairNum <= 1)
+        return false;
+
+    CheckNTErrors(bufBatchSize < bufSize, "No room for more batches!");
+
+    /* the batch is replaced by its two halves */
+    memmove(bufBatch + nextBatch + 1, bufBatch + nextBatch, sizeof(BatchNode) * (bufBatchSize - nextBatch));
+    bufBatchSize++;
+
+    int mid = batch.beg + pairNum / 2 * 2;
+    int begs[2] = {batch.beg, mid};
+    int ends[2] = {mid, batch.end};
+
+    for(int k = 0; k < 2; k++){
+        BatchNode &node = bufBatch[nextBatch - 1 + k];
+        node.beg = begs[k];
+        node.end = ends[k];
+        node.maxEnc = 0;
+        node.maxDec = 0;
+        node.key = batch.key;
+
+        for(int s = node.beg; s < node.end; s += 2){
+            node.maxEnc = MAX(node.maxEnc, seqLen[s]);
+            node.maxDec = MAX(node.maxDec, isDoubledEnd ? seqLen[s + 1] : seqLen[s + 1] - 1);
         }
     }
 
-    adamBeta1T = 1.0F;
-    adamBeta2T = 1.0F;
+    nextBatch--;
+
+    return true;
 }
 
 /* 
@@ -23,8 +23,13 @@
 #define __T2TTRAINER_H__
 
 #include "T2TModel.h"
+#include "T2TAutoBatch.h"
+#include "T2TCheckpoint.h"
 
 #include "../../tensor/function/FHeader.h"
+#include "../../network/XOptimizer.h"
+#include "../../network/XNet.h"
+#include "../../tensor/XCorpus.h"
 
 #define MAX_SEQUENCE_LENGTH 1024 * 4
 
@@ -135,17 +140,27 @@ public:
     float adamBeta1;
     float adamBeta2;
     float adamDelta;
-    float adamBeta1T;
-    float adamBeta2T;
 
-    /* list of the moment of the parameter matrics */
-    XList moments;
+    /* momentum of sgd */
+    float momentum;
 
-    /* list of the 2nd order moment of the parameter matrics */
-    XList moments2nd;
+    /* the maximum global norm of the gradient (for clipping) */
+    float clipNorm;
+
+    /* the optimizer that updates the parameters over flat buffers */
+    XOptimizer optimizer;
 
     /* indicates whether the data file is shuffled for training */
     bool isShuffled;
+
+    /* seed of shuffling (the seed of an epoch is shuffleSeed + epoch) */
+    int shuffleSeed;
+
+    /* number of lines in a shuffling block (0 means shuffling line by line) */
+    int shuffleBlock;
+
+    /* the binary corpus that is being read (NULL for text files) */
+    XCorpus * corpus;
     
     /* the factor of label smoothing */
     DTYPE labelSmoothingP;
@@ -173,12 +188,42 @@ public:
     /* randomize batches */
     bool isRandomBatch;
 
+    /* indicates whether the batches are packed without padding (see T2TPackedBatch) */
+    bool isPacked;
+
     /* indicates whether we intend to debug the net */
     bool isDebugged;
 
     /* bucket size */
     int bucketSize;
 
+    /* indicates whether we rescore an n-best list (rather than test on sentence pairs) */
+    bool isRescoring;
+
+    /* memory-aware batch sizing */
+    T2TAutoBatch autoBatch;
+
+    /* the first sequence of the last batch (for language modeling) */
+    int lastBatchSeq;
+
+    /* number of sequences in the last batch (for language modeling) */
+    int lastBatchSeqNum;
+
+    /* maximum number of sequences in the next batch (0 means no limit) */
+    int batchSeqLimit;
+
+    /* buffer of a line of the data file */
+    char * lineBuf;
+
+    /* the background checkpoint writer */
+    T2TCheckpointer checkpointer;
+
+    /* the packed batch of the input sequences (the source sequences in mt) */
+    T2TPackedBatch packedEnc;
+
+    /* the packed batch of the target sequences (in mt) */
+    T2TPackedBatch packedDec;
+
 public:
     /* constructor */
     T2TTrainer();
@@ -193,7 +238,10 @@ public:
     void Train(const char * fn, const char * validFN, const char * modelFN, T2TModel * model);
 
     /* test the model */
-    void Test(const char * fn, const char * ofn, T2TModel * model);
+    float Test(const char * fn, const char * ofn, T2TModel * model);
+
+    /* rescore an n-best list (the encoder output is shared by the candidates of a source sentence) */
+    void Rescore(const char * fn, const char * ofn, T2TModel * model);
 
     /* make a checkpoint */
     void MakeCheckpoint(T2TModel * model, const char * validFN, const char * modelFN, const char * label, int id);
@@ -219,7 +267,7 @@ public:
     int LoadBatchLM(FILE * file, 
                     XTensor * batchEnc, XTensor * paddingEnc,
                     XTensor * batchDec, XTensor * paddingDec,
-                    XTensor * gold, XTensor * label,
+                    XTensor * label,
                     int * seqs, int vs, int sBatch, int wBatch, 
                     bool isSorted, int &wCount,
                     int devID, XMem * mem, 
@@ -235,11 +283,15 @@ public:
                     int devID, XMem * mem, 
 					bool isTraining);
 
-    /* shuffle the data file */
-    void Shuffle(const char * srcFile, const char * tgtFile);
-    
+    /* load a batch of n-best candidates (grouped by their source sentences) */
+    int LoadBatchNBest(XTensor * batchEnc, XTensor * paddingEnc, 
+                       XTensor * batchDec, XTensor * paddingDec,
+                       XTensor * label, int * srcIndex, int * seqs,
+                       int sBatch, int wBatch, int &ws, int &wCount,
+                       int devID, XMem * mem);
+
     /* get word probabilities for a batch of sequences */
-    float GetProb(XTensor * output, XTensor * gold, XTensor * wordProbs);
+    float GetProb(XTensor * output, XTensor * label, XTensor * padding, XTensor * wordProbs);
 
     /* update the model by delta rule */
     void Update(T2TModel * model, const float lr);
@@ -247,6 +299,15 @@ public:
     /* prepare model for training */
     void PrepareModel(T2TModel * model);
 
+    /* choose the batch size by the memory used in a few probes */
+    void SetAutoBatch(T2TModel * model, XNet * net);
+
+    /* run a training step on a synthetic batch (without update) and measure the memory */
+    MTYPE ProbeStep(T2TModel * model, XNet * net, int sc, int len);
+
+    /* load the last batch again in smaller pieces */
+    bool RetryBatch(T2TModel * model);
+
     /* do padding on the output */
     void PadOutput(XTensor * output, XTensor * gold, XTensor * padding);
     
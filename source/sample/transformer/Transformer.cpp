@@ -25,9 +25,12 @@
 #include "T2TModel.h"
 #include "T2TUtility.h"
 #include "T2TTrainer.h"
+#include "T2TServer.h"
 #include "../../tensor/XDevice.h"
 #include "../../tensor/XUtility.h"
 #include "../../tensor/XGlobal.h"
+#include "../../tensor/XAutoTune.h"
+#include "../../tensor/XPRunner.h"
 
 namespace transformer
 {
@@ -43,32 +46,73 @@ int TransformerMain(int argc, const char ** argv)
         strcpy(args[i], argv[i]);
     }
 
-    tmpFILE = fopen("tmp.txt", "wb");
-
     ShowParams(argc, args);
 
     char * trainFN = new char[MAX_LINE_LENGTH];
     char * modelFN = new char[MAX_LINE_LENGTH];
     char * testFN = new char[MAX_LINE_LENGTH];
     char * outputFN = new char[MAX_LINE_LENGTH];
+    char * tuneFN = new char[MAX_LINE_LENGTH];
+    char * pruneFN = new char[MAX_LINE_LENGTH];
+    char * tmpFN = new char[MAX_LINE_LENGTH];
 
     LoadParamString(argc, args, "train", trainFN, "");
     LoadParamString(argc, args, "model", modelFN, "");
     LoadParamString(argc, args, "test", testFN, "");
     LoadParamString(argc, args, "output", outputFN, "");
+    LoadParamString(argc, args, "autotune", tuneFN, "");
+    LoadParamString(argc, args, "prune", pruneFN, "");
+    LoadParamString(argc, args, "tmpfile", tmpFN, "tmp.txt");
+
+    tmpFILE = fopen(tmpFN, "wb");
+
+    /* the threads of the operators, e.g., -nthread 16 -numa pins them
+       on the NUMA nodes and spreads the model over them (see T2TModel) */
+    int threadNum = 0;
+    bool isNuma = false;
+    LoadParamInt(argc, args, "nthread", &threadNum, 0);
+    LoadParamBool(argc, args, "numa", &isNuma, false);
+    bool hasRunner = InitGlobalPRunner(threadNum, isNuma);
+
+    /* tune the kernels for the shapes of the model (the settings are kept in the file) */
+    if(strcmp(tuneFN, ""))
+        GTuner.Enable(tuneFN);
 
     srand((unsigned int)time(NULL));
 
+    bool isServer = false;
+    bool isClient = false;
+    LoadParamBool(argc, args, "server", &isServer, false);
+    LoadParamBool(argc, args, "client", &isClient, false);
+
+    float sparsity = 0;
+    LoadParamFloat(argc, args, "sparsity", &sparsity, 0.8F);
+
+    /* send requests to a running server */
+    if(isClient)
+        ClientMain(argc, args);
+
     T2TTrainer trainer;
     trainer.Init(argc, args);
 
     T2TModel model;
-    model.InitModel(argc, args);
+    if(!isClient)
+        model.InitModel(argc, args);
     
     /* learn model parameters */
-    if(strcmp(trainFN, ""))
+    if(strcmp(trainFN, "") && !isClient)
         trainer.Train(trainFN, testFN, strcmp(modelFN, "") ? modelFN : "checkpoint.model", &model);
     
+    /* prune the fnn weights of a trained model into block-sparse matrices, e.g.,
+       -model in.model -prune out.model -sparsity 0.8 -sparserow 1 -sparsecol 16.
+       The pruned model is used in the test (if any) */
+    if(strcmp(pruneFN, "") && !isClient){
+        CheckNTErrors(strcmp(modelFN, ""), "No model to prune!");
+        model.Read(modelFN);
+        model.Prune(sparsity, model.sparseBlockRow, model.sparseBlockCol);
+        model.Dump(pruneFN);
+    }
+
     /* save the final model */
     //if(strcmp(modelFN, "") && strcmp(trainFN, ""))
         //model.Dump(modelFN);
@@ -77,17 +121,37 @@ int TransformerMain(int argc, const char ** argv)
     //if(strcmp(modelFN, ""))
         //model.Read(modelFN);
 
+    /* serve the requests with the model loaded once */
+    if(isServer){
+        if(strcmp(modelFN, "") && !strcmp(trainFN, ""))
+            model.Read(modelFN);
+
+        T2TServer server;
+        server.Init(argc, args);
+        server.Run(&model);
+    }
+
     T2TTrainer tester;
     tester.Init(argc, args);
 
     /* test the model on the new data */
-    if(strcmp(testFN, "") && strcmp(outputFN, ""))
-        tester.Test(testFN, outputFN, &model);
+    if(strcmp(testFN, "") && strcmp(outputFN, "") && !isClient){
+        if(tester.isRescoring)
+            tester.Rescore(testFN, outputFN, &model);
+        else
+            tester.Test(testFN, outputFN, &model);
+    }
 
     delete[] trainFN;
     delete[] modelFN;
     delete[] testFN;
     delete[] outputFN;
+    delete[] tuneFN;
+    delete[] pruneFN;
+    delete[] tmpFN;
+
+    if(hasRunner)
+        FreeGlobalPRunner();
 
     for(int i = 0; i < argc; i++)
         delete[] args[i];
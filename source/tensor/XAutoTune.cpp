@@ -0,0 +1,309 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "XAutoTune.h"
+#include "XCPU.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+#define XTUNE_MIN_SLOT_NUM 256
+
+XAutoTuner GTuner;
+
+/* constructor */
+XAutoTuner::XAutoTuner()
+{
+    isEnabled = false;
+    fileName = NULL;
+    keys = NULL;
+    choices = NULL;
+    used = NULL;
+    slotNum = 0;
+    entryNum = 0;
+    MUTEX_INIT(mutex);
+}
+
+/* de-constructor */
+XAutoTuner::~XAutoTuner()
+{
+    Clear();
+    delete[] fileName;
+    MUTEX_DELE(mutex);
+}
+
+/*
+enable tuning. The settings in the file are loaded, and the new
+settings are appended to it.
+>> fn - the cache file (NULL means that the cache is kept in memory only)
+*/
+void XAutoTuner::Enable(const char * fn)
+{
+    delete[] fileName;
+    fileName = NULL;
+
+    if(fn != NULL && *fn != 0){
+        fileName = new char[strlen(fn) + 1];
+        strcpy(fileName, fn);
+        Load(fn);
+    }
+
+    isEnabled = true;
+}
+
+/* disable tuning */
+void XAutoTuner::Disable()
+{
+    isEnabled = false;
+}
+
+/* clear the cache */
+void XAutoTuner::Clear()
+{
+    delete[] keys;
+    delete[] choices;
+    delete[] used;
+    keys = NULL;
+    choices = NULL;
+    used = NULL;
+    slotNum = 0;
+    entryNum = 0;
+}
+
+/*
+make a key
+>> key - the key
+>> op - name of the operation
+>> dimNum - number of the dimensions (no more than XTUNE_DIM_NUM)
+>> dims - the dimensions
+*/
+void XAutoTuner::MakeKey(XTuneKey &key, const char * op, int dimNum, const int * dims)
+{
+    CheckNTErrors(dimNum <= XTUNE_DIM_NUM, "Too many dimensions for a tuning key!");
+
+    memset(&key, 0, sizeof(key));
+    strncpy(key.op, op, XTUNE_OP_LENGTH - 1);
+    for(int i = 0; i < dimNum; i++)
+        key.dims[i] = dims[i];
+}
+
+/*
+find the slot of a key
+<< return - the slot that keeps the key or the empty slot where it goes
+*/
+int XAutoTuner::FindSlot(const XTuneKey &key)
+{
+    unsigned int h = 2166136261U;
+    const unsigned char * p = (const unsigned char*)&key;
+    for(int i = 0; i < (int)sizeof(XTuneKey); i++)
+        h = (h ^ p[i]) * 16777619U;
+
+    int slot = (int)(h & (unsigned int)(slotNum - 1));
+    while(used[slot] && memcmp(keys + slot, &key, sizeof(XTuneKey)) != 0)
+        slot = (slot + 1) & (slotNum - 1);
+
+    return slot;
+}
+
+/*
+look up the setting of an operation
+>> key - the operation
+>> choice - the setting
+<< return - whether the setting is found
+*/
+bool XAutoTuner::Find(const XTuneKey &key, XTuneChoice &choice)
+{
+    bool found = false;
+
+    MUTEX_LOCK(mutex);
+
+    if(entryNum > 0){
+        int slot = FindSlot(key);
+        if(used[slot]){
+            choice = choices[slot];
+            found = true;
+        }
+    }
+
+    MUTEX_UNLOCK(mutex);
+
+    return found;
+}
+
+/* add a setting (without updating the file) */
+void XAutoTuner::AddEntry(const XTuneKey &key, const XTuneChoice &choice)
+{
+    /* keep the table at most half full */
+    if((entryNum + 1) * 2 > slotNum){
+        XTuneKey * oldKeys = keys;
+        XTuneChoice * oldChoices = choices;
+        bool * oldUsed = used;
+        int oldSlotNum = slotNum;
+
+        slotNum = MAX(slotNum * 2, XTUNE_MIN_SLOT_NUM);
+        keys = new XTuneKey[slotNum];
+        choices = new XTuneChoice[slotNum];
+        used = new bool[slotNum];
+        memset(used, 0, sizeof(bool) * slotNum);
+
+        for(int i = 0; i < oldSlotNum; i++){
+            if(!oldUsed[i])
+                continue;
+            int slot = FindSlot(oldKeys[i]);
+            keys[slot] = oldKeys[i];
+            choices[slot] = oldChoices[i];
+            used[slot] = true;
+        }
+
+        delete[] oldKeys;
+        delete[] oldChoices;
+        delete[] oldUsed;
+    }
+
+    int slot = FindSlot(key);
+    if(!used[slot])
+        entryNum++;
+
+    keys[slot] = key;
+    choices[slot] = choice;
+    used[slot] = true;
+}
+
+/*
+add the setting of an operation. It is appended to the cache file.
+>> key - the operation
+>> choice - the setting
+*/
+void XAutoTuner::Add(const XTuneKey &key, const XTuneChoice &choice)
+{
+    MUTEX_LOCK(mutex);
+
+    AddEntry(key, choice);
+
+    if(fileName != NULL){
+        FILE * file = fopen(fileName, "ab");
+        if(file != NULL){
+            fseek(file, 0, SEEK_END);
+
+            /* a new file starts with the instruction set of the CPU */
+            if(ftell(file) == 0)
+                fprintf(file, "#isa %s\n", GetISAName(GetCPUISA()));
+            Write(file, key, choice);
+            fclose(file);
+        }
+        else{
+            XPRINT1(0, stderr, "[XAutoTuner] Warning! cannot write to \"%s\"\n", fileName);
+        }
+    }
+
+    MUTEX_UNLOCK(mutex);
+}
+
+/* write a setting */
+void XAutoTuner::Write(FILE * file, const XTuneKey &key, const XTuneChoice &choice)
+{
+    fprintf(file, "%s", key.op);
+    for(int i = 0; i < XTUNE_DIM_NUM; i++)
+        fprintf(file, " %d", key.dims[i]);
+    fprintf(file, " ||| %d %d %d %d %.6f\n",
+            choice.kernel, choice.threadNum, choice.tileRow, choice.tileCol, choice.time);
+}
+
+/*
+load the settings from a file
+>> fn - the file
+<< return - number of the settings
+*/
+int XAutoTuner::Load(const char * fn)
+{
+    FILE * file = fopen(fn, "rb");
+    if(file == NULL)
+        return 0;
+
+    char line[1024];
+    char isa[64];
+    int num = 0;
+
+    while(fgets(line, sizeof(line), file)){
+        if(line[0] == '#'){
+            /* settings that are tuned on another CPU do not apply */
+            if(sscanf(line, "#isa %63s", isa) == 1 && strcmp(isa, GetISAName(GetCPUISA())) != 0){
+                XPRINT2(0, stderr, "[XAutoTuner] \"%s\" is tuned for %s. It is ignored.\n", fn, isa);
+                break;
+            }
+            continue;
+        }
+
+        XTuneKey key;
+        XTuneChoice choice;
+        memset(&key, 0, sizeof(key));
+
+        char * sep = strstr(line, "|||");
+        if(sep == NULL)
+            continue;
+        *sep = 0;
+
+        int offset = 0;
+        if(sscanf(line, "%15s%n", key.op, &offset) != 1)
+            continue;
+
+        const char * p = line + offset;
+        bool ok = true;
+        for(int i = 0; i < XTUNE_DIM_NUM && ok; i++){
+            int len = 0;
+            ok = sscanf(p, "%d%n", key.dims + i, &len) == 1;
+            p += len;
+        }
+
+        if(!ok || sscanf(sep + 3, "%d %d %d %d %lf", &choice.kernel, &choice.threadNum,
+                         &choice.tileRow, &choice.tileCol, &choice.time) != 5)
+            continue;
+
+        MUTEX_LOCK(mutex);
+        AddEntry(key, choice);
+        MUTEX_UNLOCK(mutex);
+        num++;
+    }
+
+    fclose(file);
+
+    return num;
+}
+
+/*
+save the settings to a file
+>> fn - the file
+*/
+void XAutoTuner::Save(const char * fn)
+{
+    FILE * file = fopen(fn, "wb");
+    CheckNTErrors(file != NULL, "Cannot open the file for the tuned settings!");
+
+    fprintf(file, "#isa %s\n", GetISAName(GetCPUISA()));
+
+    MUTEX_LOCK(mutex);
+    for(int i = 0; i < slotNum; i++){
+        if(used[i])
+            Write(file, keys[i], choices[i]);
+    }
+    MUTEX_UNLOCK(mutex);
+
+    fclose(file);
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
@@ -0,0 +1,147 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A cache of tuned kernel settings. For an operation on a given shape
+ * (and data type), several kernels, numbers of threads and tile sizes are
+ * tried once, and the fastest setting is kept in the cache. The cache can be
+ * bound to a file: it is loaded when it is enabled, and every new setting is
+ * appended to the file, so tuning is done only once for a shape across runs.
+ * A file that is written on a CPU with a different instruction set is
+ * ignored.
+ */
+
+#ifndef __XAUTOTUNE_H__
+#define __XAUTOTUNE_H__
+
+#include <stdio.h>
+#include "XGlobal.h"
+#include "XThread.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+#define XTUNE_OP_LENGTH 16
+#define XTUNE_DIM_NUM 8
+
+/* the kernel of a setting is a BLAS library (other values are instruction sets in XCPU_ISA) */
+#define XTUNE_KERNEL_BLAS -1
+
+/* an operation on a shape */
+struct XTuneKey
+{
+    /* name of the operation */
+    char op[XTUNE_OP_LENGTH];
+
+    /* shape, data type and other things the setting depends on */
+    int dims[XTUNE_DIM_NUM];
+};
+
+/* a tuned setting */
+struct XTuneChoice
+{
+    /* the kernel (XTUNE_KERNEL_BLAS or an instruction set) */
+    int kernel;
+
+    /* number of threads (jobs) */
+    int threadNum;
+
+    /* tile sizes */
+    int tileRow;
+    int tileCol;
+
+    /* time of a run (in ms) */
+    double time;
+};
+
+/* the cache of tuned settings */
+class XAutoTuner
+{
+public:
+    /* indicates whether the kernels are tuned */
+    bool isEnabled;
+
+    /* the file of the cache (NULL if it is not kept on disk) */
+    char * fileName;
+
+    /* the keys (hash table of open addressing) */
+    XTuneKey * keys;
+
+    /* the settings */
+    XTuneChoice * choices;
+
+    /* indicates whether a slot is used */
+    bool * used;
+
+    /* number of the slots */
+    int slotNum;
+
+    /* number of the settings */
+    int entryNum;
+
+    /* mutex for updating the cache */
+    MUTEX_HANDLE mutex;
+
+public:
+    /* constructor */
+    XAutoTuner();
+
+    /* de-constructor */
+    ~XAutoTuner();
+
+    /* enable tuning with a cache file (or NULL) */
+    void Enable(const char * fn);
+
+    /* disable tuning */
+    void Disable();
+
+    /* clear the cache */
+    void Clear();
+
+    /* look up the setting of an operation */
+    bool Find(const XTuneKey &key, XTuneChoice &choice);
+
+    /* add the setting of an operation */
+    void Add(const XTuneKey &key, const XTuneChoice &choice);
+
+    /* load the settings from a file */
+    int Load(const char * fn);
+
+    /* save the settings to a file */
+    void Save(const char * fn);
+
+    /* make a key */
+    static void MakeKey(XTuneKey &key, const char * op, int dimNum, const int * dims);
+
+protected:
+    /* find the slot of a key */
+    int FindSlot(const XTuneKey &key);
+
+    /* add a setting (without updating the file) */
+    void AddEntry(const XTuneKey &key, const XTuneChoice &choice);
+
+    /* write a setting */
+    static void Write(FILE * file, const XTuneKey &key, const XTuneChoice &choice);
+};
+
+/* the global cache of tuned settings */
+extern XAutoTuner GTuner;
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
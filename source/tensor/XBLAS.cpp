@@ -71,7 +71,7 @@ void (*XBLAS_DGER)(OPENBLAS_CONST enum CBLAS_ORDER, OPENBLAS_CONST BLASINT M, OP
 void (*XBLAS_SET_THREAD_NUM)(int);
 
 /* get the number of threads */
-//int (*XBLAS_GET_THREAD_NUM)();
+int (*XBLAS_GET_THREAD_NUM)();
 
 
 /* get the number of physical processors (cores).*/
@@ -118,7 +118,7 @@ void LoadBLAS(const char * dllFileName)
     /* multi-threading */
     (FARPROC&)XBLAS_SET_THREAD_NUM = GetProcAddress(hBLASDll, "openblas_set_num_threads");
     //(FARPROC&)XBLAS_SET_THREAD_NUM = GetProcAddress(hBLASDll, "goto_set_num_threads");
-    //(FARPROC&)XBLAS_GET_THREAD_NUM = GetProcAddress(hBLASDll, "openblas_get_num_threads");
+    (FARPROC&)XBLAS_GET_THREAD_NUM = GetProcAddress(hBLASDll, "openblas_get_num_threads");
     (FARPROC&)XBLAS_GET_CORE_NUM = GetProcAddress(hBLASDll, "openblas_get_num_procs");
     //(FARPROC&)XBLAS_GET_CORE_NAME = GetProcAddress(hBLASDll, "openblas_get_corename");
     //(FARPROC&)XBLAS_GET_PARALLEL_TYPE = GetProcAddress(hBLASDll, "openblas_get_parallel");
@@ -150,6 +150,7 @@ void LoadBLAS(const char * dllFileName)
 
     /* multi-threading */
     (FARPROC&)XBLAS_SET_THREAD_NUM = GetProcAddress(hBLASDll, "MKL_Set_Num_Threads");
+    (FARPROC&)XBLAS_GET_THREAD_NUM = GetProcAddress(hBLASDll, "MKL_Get_Max_Threads");
     (FARPROC&)XBLAS_GET_CORE_NUM   = GetProcAddress(hBLASDll, "MKL_Get_Max_Threads");
 #endif // defined(MKL)
 
@@ -161,10 +162,12 @@ void LoadBLAS(const char * dllFileName)
     XBLAS_DGER  = &cblas_dger;
 #if defined(OPENBLAS)
     XBLAS_SET_THREAD_NUM    = &openblas_set_num_threads;
+    XBLAS_GET_THREAD_NUM    = &openblas_get_num_threads;
     XBLAS_GET_CORE_NUM      = &openblas_get_num_procs;
 #endif // defined(OPENBLAS)
 #if defined(MKL)
     XBLAS_SET_THREAD_NUM    = &mkl_set_num_threads;
+    XBLAS_GET_THREAD_NUM    = &mkl_get_max_num_threads;
     XBLAS_GET_CORE_NUM      = &mkl_get_max_num_threads;
 #endif // defined(MKL)
 
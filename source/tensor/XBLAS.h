@@ -101,7 +101,7 @@ extern "C" void (*XBLAS_DGER)(OPENBLAS_CONST enum CBLAS_ORDER, OPENBLAS_CONST BL
 extern "C" void (*XBLAS_SET_THREAD_NUM)(int);
 
 /* get the number of threads */
-//extern "C" int (*XBLAS_GET_THREAD_NUM)();
+extern "C" int (*XBLAS_GET_THREAD_NUM)();
 
 
 /* get the number of physical processors (cores).*/
@@ -138,7 +138,7 @@ extern "C" void cblas_dger (OPENBLAS_CONST enum CBLAS_ORDER order, OPENBLAS_CONS
 /* better control of multi-threading */
 extern "C" void  openblas_set_num_threads(int num_threads);
 extern "C" void  goto_set_num_threads(int num_threads);
-//extern "C" int   openblas_get_num_threads(void);
+extern "C" int   openblas_get_num_threads(void);
 extern "C" int   openblas_get_num_procs(void);
 //extern "C" char* openblas_get_config(void);
 //extern "C" char* openblas_get_corename(void);
@@ -0,0 +1,165 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The block index of a block-sparse matrix.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "XBlockSparse.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/*
+constructor
+>> myRowNum - number of rows of the matrix
+>> myColNum - number of columns of the matrix
+>> myBlockRow - number of rows of a block
+>> myBlockCol - number of columns of a block
+*/
+XBlockSparse::XBlockSparse(int myRowNum, int myColNum, int myBlockRow, int myBlockCol)
+{
+    CheckNTErrors(myRowNum > 0 && myColNum > 0, "Illegal matrix size!");
+    CheckNTErrors(myBlockRow > 0 && myBlockCol > 0 && myBlockCol <= MAX_SPARSE_BLOCK_COL,
+                  "Illegal block size!");
+    CheckNTErrors(myRowNum % myBlockRow == 0 && myColNum % myBlockCol == 0,
+                  "The matrix must be cut into blocks evenly!");
+
+    rowNum = myRowNum;
+    colNum = myColNum;
+    blockRow = myBlockRow;
+    blockCol = myBlockCol;
+    blockRowNum = rowNum / blockRow;
+    blockColNum = colNum / blockCol;
+    blockNum = 0;
+    colOffsets = new int[blockColNum + 1];
+    blockRows = new int[blockRowNum * blockColNum];
+    memset(colOffsets, 0, sizeof(int) * (blockColNum + 1));
+}
+
+/* de-constructor */
+XBlockSparse::~XBlockSparse()
+{
+    delete[] colOffsets;
+    delete[] blockRows;
+}
+
+/*
+build the index from the non-zero blocks of a dense matrix
+>> data - the data array of the matrix (row-major and on the host)
+*/
+void XBlockSparse::Build(const DTYPE * data)
+{
+    blockNum = 0;
+
+    for(int j = 0; j < blockColNum; j++){
+        colOffsets[j] = blockNum;
+        for(int i = 0; i < blockRowNum; i++){
+            bool isZero = true;
+            for(int r = 0; r < blockRow && isZero; r++){
+                const DTYPE * p = data + (i * blockRow + r) * colNum + j * blockCol;
+                for(int c = 0; c < blockCol; c++){
+                    if(p[c] != 0){
+                        isZero = false;
+                        break;
+                    }
+                }
+            }
+            if(!isZero)
+                blockRows[blockNum++] = i;
+        }
+    }
+
+    colOffsets[blockColNum] = blockNum;
+}
+
+/* the fraction of the blocks that are zero */
+float XBlockSparse::GetSparsity()
+{
+    return 1.0F - (float)blockNum / (blockRowNum * blockColNum);
+}
+
+/* a block and its magnitude (for pruning) */
+struct XBlockNorm
+{
+    DTYPE norm;
+    int id;
+};
+
+int CompareBlockNorm(const void * a, const void * b)
+{
+    DTYPE na = ((XBlockNorm*)a)->norm;
+    DTYPE nb = ((XBlockNorm*)b)->norm;
+    if(na != nb)
+        return na < nb ? -1 : 1;
+    return ((XBlockNorm*)a)->id - ((XBlockNorm*)b)->id;
+}
+
+/*
+magnitude pruning of a dense matrix: the blocks are ranked by the l2-norm,
+and the first sparsity * (number of blocks) blocks are set to zero
+>> data - the data array of the matrix (row-major and on the host)
+>> rowNum - number of rows of the matrix
+>> colNum - number of columns of the matrix
+>> blockRow - number of rows of a block
+>> blockCol - number of columns of a block
+>> sparsity - the fraction of the blocks that we set to zero
+*/
+void XBlockSparse::Prune(DTYPE * data, int rowNum, int colNum, int blockRow, int blockCol, float sparsity)
+{
+    CheckNTErrors(blockRow > 0 && blockCol > 0, "Illegal block size!");
+    CheckNTErrors(rowNum % blockRow == 0 && colNum % blockCol == 0,
+                  "The matrix must be cut into blocks evenly!");
+    CheckNTErrors(sparsity >= 0 && sparsity <= 1.0F, "The sparsity must be in [0, 1]!");
+
+    int blockRowNum = rowNum / blockRow;
+    int blockColNum = colNum / blockCol;
+    int num = blockRowNum * blockColNum;
+    int pruneNum = (int)(sparsity * num + 0.5F);
+
+    XBlockNorm * norms = new XBlockNorm[num];
+
+    for(int i = 0; i < blockRowNum; i++){
+        for(int j = 0; j < blockColNum; j++){
+            DTYPE sum = 0;
+            for(int r = 0; r < blockRow; r++){
+                const DTYPE * p = data + (i * blockRow + r) * colNum + j * blockCol;
+                for(int c = 0; c < blockCol; c++)
+                    sum += p[c] * p[c];
+            }
+            norms[i * blockColNum + j].norm = sum;
+            norms[i * blockColNum + j].id = i * blockColNum + j;
+        }
+    }
+
+    qsort(norms, num, sizeof(XBlockNorm), CompareBlockNorm);
+
+    for(int k = 0; k < pruneNum; k++){
+        int i = norms[k].id / blockColNum;
+        int j = norms[k].id % blockColNum;
+        for(int r = 0; r < blockRow; r++)
+            memset(data + (i * blockRow + r) * colNum + j * blockCol, 0, sizeof(DTYPE) * blockCol);
+    }
+
+    delete[] norms;
+}
+
+} // namespace nts(NiuTrans.Tensor)
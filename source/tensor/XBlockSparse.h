@@ -0,0 +1,93 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The block index of a block-sparse matrix. The matrix is cut into blocks of
+ * blockRow * blockCol (e.g., 1 * 16 or 4 * 4), and the index keeps the
+ * non-zero blocks by block columns, i.e., the blocks of block column j are
+ * blockRows[colOffsets[j]], ..., blockRows[colOffsets[j + 1] - 1]. The values
+ * are still kept in the dense data array of the matrix, so that the index can
+ * be attached to a matrix (see XTensor::SetBlockSparse) without changing how
+ * the matrix is read, written or saved. Matrix multiplication goes over the
+ * blocks in the index only (see MatrixMulBlockSparse.h).
+ *
+ */
+
+#ifndef __XBLOCKSPARSE_H__
+#define __XBLOCKSPARSE_H__
+
+#include "XGlobal.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* the maximum number of columns of a block */
+#define MAX_SPARSE_BLOCK_COL 64
+
+/* the block index of a block-sparse matrix */
+struct XBlockSparse
+{
+public:
+    /* number of rows of the matrix */
+    int rowNum;
+
+    /* number of columns of the matrix */
+    int colNum;
+
+    /* number of rows of a block */
+    int blockRow;
+
+    /* number of columns of a block */
+    int blockCol;
+
+    /* number of the block rows (rowNum / blockRow) */
+    int blockRowNum;
+
+    /* number of the block columns (colNum / blockCol) */
+    int blockColNum;
+
+    /* number of the non-zero blocks */
+    int blockNum;
+
+    /* offsets of the block columns (blockColNum + 1 items) */
+    int * colOffsets;
+
+    /* block row of each non-zero block */
+    int * blockRows;
+
+public:
+    /* constructor */
+    XBlockSparse(int myRowNum, int myColNum, int myBlockRow, int myBlockCol);
+
+    /* de-constructor */
+    ~XBlockSparse();
+
+    /* build the index from the non-zero blocks of a dense matrix */
+    void Build(const DTYPE * data);
+
+    /* the fraction of the blocks that are zero */
+    float GetSparsity();
+
+    /* set the blocks of the smallest magnitude of a dense matrix to zero */
+    static
+    void Prune(DTYPE * data, int rowNum, int colNum, int blockRow, int blockCol, float sparsity);
+};
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XBLOCKSPARSE_H__
@@ -0,0 +1,133 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "XCPU.h"
+
+#ifdef USE_ISA_DISPATCH
+#include <cpuid.h>
+#endif
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+XCPUFeatures cpuFeatures;
+
+#ifdef USE_ISA_DISPATCH
+/* get the state components that are enabled by the OS (XCR0) */
+static unsigned long long _GetXCR0()
+{
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+#endif
+
+/* get the features of the CPU (detected once) */
+const XCPUFeatures & GetCPUFeatures()
+{
+    if(cpuFeatures.isDetected)
+        return cpuFeatures;
+
+    XCPUFeatures f;
+    memset(&f, 0, sizeof(f));
+
+#ifdef USE_ISA_DISPATCH
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    unsigned int maxLeaf = __get_cpuid_max(0, NULL);
+
+    if(maxLeaf >= 1){
+        __cpuid(1, eax, ebx, ecx, edx);
+
+        bool hasOSXSAVE = (ecx & (1 << 27)) != 0;
+        unsigned long long xcr0 = hasOSXSAVE ? _GetXCR0() : 0;
+
+        /* the OS saves the ymm (and zmm) registers */
+        bool hasYMM = (xcr0 & 0x6) == 0x6;
+        bool hasZMM = (xcr0 & 0xE6) == 0xE6;
+
+        f.hasSSE42 = (ecx & (1 << 20)) != 0;
+        f.hasAVX = hasYMM && (ecx & (1 << 28)) != 0;
+        f.hasFMA = f.hasAVX && (ecx & (1 << 12)) != 0;
+
+        if(maxLeaf >= 7){
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            f.hasAVX2 = f.hasAVX && (ebx & (1 << 5)) != 0;
+            f.hasAVX512F = hasZMM && (ebx & (1 << 16)) != 0;
+            f.hasAVX512BW = f.hasAVX512F && (ebx & (1 << 30)) != 0;
+            f.hasAVX512VNNI = f.hasAVX512F && (ecx & (1 << 11)) != 0;
+        }
+    }
+#endif
+
+    f.isDetected = true;
+    cpuFeatures = f;
+
+    return cpuFeatures;
+}
+
+/* get the highest instruction set level supported by the CPU */
+XCPU_ISA GetCPUISA()
+{
+    const XCPUFeatures & f = GetCPUFeatures();
+
+    if(f.hasAVX512VNNI && f.hasAVX512BW)
+        return ISA_AVX512VNNI;
+    if(f.hasAVX512F)
+        return ISA_AVX512;
+    if(f.hasAVX2 && f.hasFMA)
+        return ISA_AVX2;
+    if(f.hasSSE42)
+        return ISA_SSE42;
+    return ISA_GENERIC;
+}
+
+/* name of an instruction set level */
+const char * GetISAName(XCPU_ISA isa)
+{
+    switch(isa){
+    case ISA_SSE42:
+        return "sse4.2";
+    case ISA_AVX2:
+        return "avx2";
+    case ISA_AVX512:
+        return "avx512";
+    case ISA_AVX512VNNI:
+        return "avx512-vnni";
+    default:
+        return "generic";
+    }
+}
+
+/* show the features of the CPU */
+void ShowCPUFeatures(FILE * file)
+{
+    const XCPUFeatures & f = GetCPUFeatures();
+
+    fprintf(file, "CPU features:%s%s%s%s%s%s%s (isa: %s)\n",
+            f.hasSSE42 ? " sse4.2" : "",
+            f.hasAVX ? " avx" : "",
+            f.hasFMA ? " fma" : "",
+            f.hasAVX2 ? " avx2" : "",
+            f.hasAVX512F ? " avx512f" : "",
+            f.hasAVX512BW ? " avx512bw" : "",
+            f.hasAVX512VNNI ? " avx512vnni" : "",
+            GetISAName(GetCPUISA()));
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
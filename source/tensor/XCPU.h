@@ -0,0 +1,70 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * Run-time detection of the instruction sets of the CPU (by CPUID). The
+ * kernels that are compiled for several instruction sets (see
+ * MatrixMulBatchedStrided.cpp) pick their version with it, so that the
+ * same binary runs the SSE, AVX2 or AVX-512 code on the machine where it is
+ * executed rather than the one where it is compiled.
+ */
+
+#ifndef __XCPU_H__
+#define __XCPU_H__
+
+#include <stdio.h>
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* kernels can be compiled for specific instruction sets with GCC or Clang on x86 */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define USE_ISA_DISPATCH
+#endif
+
+/* instruction set levels (from the lowest to the highest) */
+enum XCPU_ISA {ISA_GENERIC, ISA_SSE42, ISA_AVX2, ISA_AVX512, ISA_AVX512VNNI};
+
+/* features of the CPU */
+struct XCPUFeatures
+{
+    bool isDetected;
+    bool hasSSE42;
+    bool hasAVX;
+    bool hasFMA;
+    bool hasAVX2;
+    bool hasAVX512F;
+    bool hasAVX512BW;
+    bool hasAVX512VNNI;
+};
+
+/* get the features of the CPU (detected once) */
+const XCPUFeatures & GetCPUFeatures();
+
+/* get the highest instruction set level supported by the CPU */
+XCPU_ISA GetCPUISA();
+
+/* name of an instruction set level */
+const char * GetISAName(XCPU_ISA isa);
+
+/* show the features of the CPU */
+void ShowCPUFeatures(FILE * file);
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
@@ -0,0 +1,403 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "XCorpus.h"
+#include "XUtility.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* constructor */
+XCorpus::XCorpus()
+{
+    data = NULL;
+    dataSize = 0;
+    isMapped = false;
+    lineNum = 0;
+    seqNum = 0;
+    wordNum = 0;
+    ids = NULL;
+    seqOffset = NULL;
+    lineSeq = NULL;
+    seqLen = NULL;
+    order = NULL;
+    cursor = 0;
+}
+
+/* de-constructor */
+XCorpus::~XCorpus()
+{
+    Close();
+}
+
+/*
+check whether a file is a binary corpus
+>> fn - the file
+*/
+bool XCorpus::IsBinary(const char * fn)
+{
+    FILE * file = fopen(fn, "rb");
+    if(file == NULL)
+        return false;
+
+    char magic[8];
+    bool isBinary = fread(magic, 1, 8, file) == 8 && !memcmp(magic, XCORPUS_MAGIC, 8);
+
+    fclose(file);
+
+    return isBinary;
+}
+
+/* a growable array */
+template<class T>
+void XCorpusGrow(T * &p, MTYPE &size, MTYPE num)
+{
+    if(num < size)
+        return;
+    MTYPE newSize = MAX(size * 2, 1024);
+    T * newP = new T[newSize];
+    if(p != NULL)
+        memcpy(newP, p, sizeof(T) * num);
+    delete[] p;
+    p = newP;
+    size = newSize;
+}
+
+/*
+compile a text corpus into a binary corpus. Each line of the text is a sample
+of word ids separated by spaces or tabs, and "|||" starts a new sequence of
+the sample. Empty lines are skipped.
+>> textFN - the text corpus
+>> binFN - the binary corpus
+*/
+void XCorpus::Compile(const char * textFN, const char * binFN)
+{
+    FILE * file = fopen(textFN, "rb");
+    CheckNTErrors(file, "Cannot read the text corpus!");
+    FILE * ofile = fopen(binFN, "wb");
+    CheckNTErrors(ofile, "Cannot open the binary corpus!");
+
+    XCorpusHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, XCORPUS_MAGIC, 8);
+    header.version = XCORPUS_VERSION;
+
+    /* the header is written again when everything is known */
+    fwrite(&header, sizeof(header), 1, ofile);
+
+    MTYPE seqSize = 0;
+    MTYPE lineSize = 0;
+    MTYPE * offsets = NULL;
+    MTYPE * lines = NULL;
+    int * lens = NULL;
+    MTYPE lensSize = 0;
+
+    int lineBufSize = MAX_LINE_LENGTH;
+    char * line = new char[lineBufSize];
+    int * words = new int[lineBufSize / 2 + 1];
+
+    double startT = GetClockSec();
+
+    while(fgets(line, lineBufSize, file)){
+        int len = (int)strlen(line);
+
+        /* read the rest of a long line */
+        while(len == lineBufSize - 1 && line[len - 1] != '\n'){
+            char * newLine = new char[lineBufSize * 2];
+            memcpy(newLine, line, len + 1);
+            delete[] line;
+            delete[] words;
+            line = newLine;
+            lineBufSize *= 2;
+            words = new int[lineBufSize / 2 + 1];
+            if(fgets(line + len, lineBufSize - len, file) == NULL)
+                break;
+            len += (int)strlen(line + len);
+        }
+
+        int wNum = 0;
+        int wNumLocal = 0;
+        int seqBeg = (int)header.seqNum;
+        char * p = line;
+
+        while(*p){
+            if(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'){
+                p++;
+                continue;
+            }
+
+            char * end = p;
+            while(*end && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n')
+                end++;
+
+            if(end - p == 3 && !strncmp(p, "|||", 3)){
+                XCorpusGrow(offsets, seqSize, header.seqNum);
+                XCorpusGrow(lens, lensSize, header.seqNum);
+                offsets[header.seqNum] = header.wordNum + wNum - wNumLocal;
+                lens[header.seqNum] = wNumLocal;
+                header.seqNum++;
+                wNumLocal = 0;
+            }
+            else{
+                words[wNum++] = atoi(p);
+                wNumLocal++;
+            }
+
+            p = end;
+        }
+
+        /* skip empty lines */
+        if(wNum == 0 && (int)header.seqNum == seqBeg)
+            continue;
+
+        XCorpusGrow(offsets, seqSize, header.seqNum);
+        XCorpusGrow(lens, lensSize, header.seqNum);
+        offsets[header.seqNum] = header.wordNum + wNum - wNumLocal;
+        lens[header.seqNum] = wNumLocal;
+        header.seqNum++;
+
+        XCorpusGrow(lines, lineSize, header.lineNum);
+        lines[header.lineNum++] = seqBeg;
+
+        fwrite(words, sizeof(int), wNum, ofile);
+        header.wordNum += wNum;
+    }
+
+    /* the index */
+    int pad = 0;
+    if(header.wordNum % 2 != 0)
+        fwrite(&pad, sizeof(int), 1, ofile);
+
+    XCorpusGrow(lines, lineSize, header.lineNum);
+    lines[header.lineNum] = header.seqNum;
+
+    fwrite(offsets, sizeof(MTYPE), header.seqNum, ofile);
+    fwrite(lines, sizeof(MTYPE), header.lineNum + 1, ofile);
+    fwrite(lens, sizeof(int), header.seqNum, ofile);
+
+    fseek(ofile, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, ofile);
+
+    fclose(file);
+    fclose(ofile);
+
+    XPRINT4(0, stderr, "[INFO] corpus compiled (took %.1fs, line=%lld, sequence=%lld, word=%lld)\n",
+            GetClockSec() - startT, (long long)header.lineNum, (long long)header.seqNum, (long long)header.wordNum);
+
+    delete[] line;
+    delete[] words;
+    delete[] offsets;
+    delete[] lines;
+    delete[] lens;
+}
+
+/*
+open a binary corpus. The file is memory-mapped where it is possible.
+>> fn - the file
+*/
+void XCorpus::Open(const char * fn)
+{
+    Close();
+
+    FILE * file = fopen(fn, "rb");
+    CheckNTErrors(file, "Cannot read the corpus!");
+
+    XCorpusHeader header;
+    CheckNTErrors(fread(&header, sizeof(header), 1, file) == 1 &&
+                  !memcmp(header.magic, XCORPUS_MAGIC, 8), "Not a binary corpus!");
+    CheckNTErrors(header.version == XCORPUS_VERSION, "Unsupported version of the binary corpus!");
+
+    fseek(file, 0, SEEK_END);
+    dataSize = (MTYPE)ftell(file);
+
+    MTYPE idSize = (header.wordNum + header.wordNum % 2) * sizeof(int);
+    MTYPE expectedSize = sizeof(header) + idSize + header.seqNum * sizeof(MTYPE) +
+                         (header.lineNum + 1) * sizeof(MTYPE) + header.seqNum * sizeof(int);
+    CheckNTErrors(dataSize == expectedSize, "The binary corpus is broken!");
+
+#ifndef WIN32
+    fclose(file);
+
+    int fd = open(fn, O_RDONLY);
+    CheckNTErrors(fd >= 0, "Cannot read the corpus!");
+    data = (char*)mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    CheckNTErrors(data != MAP_FAILED, "Cannot map the corpus!");
+    isMapped = true;
+#else
+    data = new char[dataSize];
+    fseek(file, 0, SEEK_SET);
+    CheckNTErrors(fread(data, 1, dataSize, file) == dataSize, "Cannot read the corpus!");
+    fclose(file);
+    isMapped = false;
+#endif
+
+    lineNum = header.lineNum;
+    seqNum = header.seqNum;
+    wordNum = header.wordNum;
+
+    char * p = data + sizeof(header);
+    ids = (int*)p;
+    p += idSize;
+    seqOffset = (MTYPE*)p;
+    p += seqNum * sizeof(MTYPE);
+    lineSeq = (MTYPE*)p;
+    p += (lineNum + 1) * sizeof(MTYPE);
+    seqLen = (int*)p;
+
+    cursor = 0;
+}
+
+/* close the corpus */
+void XCorpus::Close()
+{
+    if(data != NULL){
+#ifndef WIN32
+        if(isMapped)
+            munmap(data, dataSize);
+        else
+            delete[] data;
+#else
+        delete[] data;
+#endif
+    }
+
+    delete[] order;
+
+    data = NULL;
+    dataSize = 0;
+    ids = NULL;
+    seqOffset = NULL;
+    lineSeq = NULL;
+    seqLen = NULL;
+    order = NULL;
+    lineNum = 0;
+    seqNum = 0;
+    wordNum = 0;
+    cursor = 0;
+}
+
+/* a linear congruential generator (so that shuffling depends on the seed only) */
+inline MTYPE XCorpusRand(MTYPE &state)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+/* shuffle items in [beg, end) */
+inline void XCorpusShuffle(MTYPE * items, MTYPE beg, MTYPE end, MTYPE &state)
+{
+    for(MTYPE i = end; i > beg + 1; i--){
+        MTYPE j = beg + XCorpusRand(state) % (i - beg);
+        MTYPE tmp = items[i - 1];
+        items[i - 1] = items[j];
+        items[j] = tmp;
+    }
+}
+
+/*
+shuffle the lines with a seed and visit them from the beginning. When a
+block size is given, blocks of continuous lines are shuffled and then the
+lines are shuffled inside each block, so that the reads of an epoch stay
+local in the (mapped) file.
+>> seed - the seed
+>> blockSize - number of lines in a block (0 means shuffling the whole index)
+*/
+void XCorpus::Shuffle(unsigned int seed, int blockSize)
+{
+    MTYPE state = (MTYPE)seed * 2654435761ULL + 1;
+
+    if(order == NULL)
+        order = new MTYPE[MAX(lineNum, 1)];
+
+    if(blockSize <= 1){
+        for(MTYPE i = 0; i < lineNum; i++)
+            order[i] = i;
+        XCorpusShuffle(order, 0, lineNum, state);
+    }
+    else{
+        MTYPE blockNum = (lineNum + blockSize - 1) / blockSize;
+        MTYPE * blocks = new MTYPE[MAX(blockNum, 1)];
+        for(MTYPE i = 0; i < blockNum; i++)
+            blocks[i] = i;
+        XCorpusShuffle(blocks, 0, blockNum, state);
+
+        MTYPE k = 0;
+        for(MTYPE i = 0; i < blockNum; i++){
+            MTYPE beg = blocks[i] * blockSize;
+            MTYPE end = MIN(beg + blockSize, lineNum);
+            MTYPE first = k;
+            for(MTYPE j = beg; j < end; j++)
+                order[k++] = j;
+            XCorpusShuffle(order, first, k, state);
+        }
+
+        delete[] blocks;
+    }
+
+    cursor = 0;
+}
+
+/* visit the lines from the beginning again (in the current order) */
+void XCorpus::Rewind()
+{
+    cursor = 0;
+}
+
+/*
+get the next line
+>> words - the words of all the sequences of the line (continuously)
+>> lens - the length of each sequence
+>> maxSeqNum - size of "lens"
+>> maxWordNum - size of "words"
+<< return - number of the sequences (-1 at the end of the corpus)
+*/
+int XCorpus::NextLine(int * words, int * lens, int maxSeqNum, int maxWordNum)
+{
+    if(cursor >= lineNum)
+        return -1;
+
+    MTYPE line = order != NULL ? order[cursor] : cursor;
+    cursor++;
+
+    int num = (int)(lineSeq[line + 1] - lineSeq[line]);
+    int wNum = 0;
+
+    CheckNTErrors(num <= maxSeqNum, "Too many sequences in a line!");
+
+    for(int i = 0; i < num; i++){
+        MTYPE s = lineSeq[line] + i;
+        int len = seqLen[s];
+        CheckNTErrors(wNum + len <= maxWordNum, "The line is too long!");
+        memcpy(words + wNum, ids + seqOffset[s], sizeof(int) * len);
+        lens[i] = len;
+        wNum += len;
+    }
+
+    return num;
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
@@ -0,0 +1,140 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A pre-tokenized binary corpus. A text corpus of word ids (one sample per
+ * line, and sequences of a sample are separated by "|||") is compiled into
+ * a binary file that keeps the ids as int32 together with an index of the
+ * sequences and the lines. The file is memory-mapped when it is opened so
+ * that nothing is parsed at the beginning of an epoch, and the lines are
+ * shuffled in-process by permuting the index (line by line or block by block)
+ * with a given seed.
+ *
+ * The layout of the file is
+ * header | ids (int32, padded to 8 bytes) | offsets of the sequences (MTYPE)
+ *        | first sequence of each line (MTYPE, lineNum + 1 items)
+ *        | lengths of the sequences (int32)
+ */
+
+#ifndef __XCORPUS_H__
+#define __XCORPUS_H__
+
+#include <stdio.h>
+#include "XGlobal.h"
+#include "XMem.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+#define XCORPUS_MAGIC "NTCORPUS"
+#define XCORPUS_VERSION 1
+
+/* header of a binary corpus file */
+struct XCorpusHeader
+{
+    /* XCORPUS_MAGIC */
+    char magic[8];
+
+    /* version of the format */
+    int version;
+
+    /* reserved for future use */
+    int reserved;
+
+    /* number of lines (samples) */
+    MTYPE lineNum;
+
+    /* number of sequences */
+    MTYPE seqNum;
+
+    /* number of words */
+    MTYPE wordNum;
+};
+
+/* a binary corpus that is read line by line */
+class XCorpus
+{
+public:
+    /* the content of the file */
+    char * data;
+
+    /* size of the content */
+    MTYPE dataSize;
+
+    /* indicates whether the content is memory-mapped */
+    bool isMapped;
+
+    /* number of lines */
+    MTYPE lineNum;
+
+    /* number of sequences */
+    MTYPE seqNum;
+
+    /* number of words */
+    MTYPE wordNum;
+
+    /* word ids */
+    int * ids;
+
+    /* offset of each sequence in the ids */
+    MTYPE * seqOffset;
+
+    /* first sequence of each line */
+    MTYPE * lineSeq;
+
+    /* length of each sequence */
+    int * seqLen;
+
+    /* order in which the lines are visited (NULL means the original order) */
+    MTYPE * order;
+
+    /* the next line to visit */
+    MTYPE cursor;
+
+public:
+    /* constructor */
+    XCorpus();
+
+    /* de-constructor */
+    ~XCorpus();
+
+    /* check whether a file is a binary corpus */
+    static bool IsBinary(const char * fn);
+
+    /* compile a text corpus into a binary corpus */
+    static void Compile(const char * textFN, const char * binFN);
+
+    /* open a binary corpus */
+    void Open(const char * fn);
+
+    /* close the corpus */
+    void Close();
+
+    /* shuffle the lines with a seed */
+    void Shuffle(unsigned int seed, int blockSize = 0);
+
+    /* visit the lines from the beginning again */
+    void Rewind();
+
+    /* get the next line */
+    int NextLine(int * words, int * lens, int maxSeqNum, int maxWordNum);
+};
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
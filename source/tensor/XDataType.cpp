@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "XDataType.h"
+#include "core/utilities/XTypedKernel.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
 namespace nts{
@@ -69,16 +70,13 @@ guys are crazy about this. So I decided to have a try.
 /* float -> float16 */
 _XINLINE_ unsigned short FloatToFloat16(float f)
 {
-    unsigned int x = *((unsigned int*)&f);
-    unsigned short h = ((x>>16)&0x8000)|((((x&0x7f800000)-0x38000000)>>13)&0x7c00)|((x>>13)&0x03ff);
-    return h;
+    return XFloatToHalf(f);
 }
 
 /* float16 -> float */
 _XINLINE_ float Float16ToFloat(unsigned short h)
 {
-    float f = float(((h&0x8000)<<16) | (((h&0x7c00)+0x1C000)<<13) | ((h&0x03FF)<<13));
-    return f;
+    return XHalfToFloat(h);
 }
 
 /* 
@@ -97,19 +95,7 @@ void ConvertDataType(int devID, void * s, TENSOR_DATA_TYPE typeS, void * t, TENS
     if(typeS == typeT)
         return;
 
-    if(typeS == X_FLOAT && typeT == X_FLOAT16){
-        for(int i = 0; i < size; i++){
-            ((unsigned short*)t)[i] = FloatToFloat16(((float*)s)[i]);
-        }
-    }
-    else if(typeS == X_FLOAT16 && typeT == X_FLOAT){
-        for(int i = 0; i < size; i++){
-            ((float*)t)[i] = Float16ToFloat(((unsigned short*)s)[i]);
-        }
-    }
-    else{
-        ShowNTErrors("Unsupported data types for conversion!");
-    }
+    _KernelConvert(s, typeS, t, typeT, size);
 }
 
 } /* end of the nts (NiuTrans.Tensor) namespace */
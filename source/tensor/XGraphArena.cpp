@@ -0,0 +1,196 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "XGraphArena.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+XGraphArena GGraphArena;
+
+/* constructor */
+XGraphArena::XGraphArena()
+{
+    chunkMaxNum = 16;
+    chunks = new char*[chunkMaxNum];
+    chunkNum = 0;
+    top = NULL;
+    topSize = 0;
+    memset(freeLists, 0, sizeof(void*) * GRAPH_ARENA_CLASS_NUM);
+    blockNum = 0;
+    cutNum = 0;
+    isDead = false;
+    MUTEX_INIT(mutex);
+}
+
+/* de-constructor */
+XGraphArena::~XGraphArena()
+{
+    /* the chunks are kept if some blocks are still in use, as the tensors 
+       that die after the arena (e.g., global tensors) might read them. 
+       These tensors release their blocks to nowhere */
+    if(blockNum == 0){
+        Free();
+        delete[] chunks;
+        chunks = NULL;
+    }
+
+    MUTEX_DELE(mutex);
+    isDead = true;
+}
+
+/*
+id of the block size, i.e., the smallest i such that
+GRAPH_ARENA_MIN_BLOCK_SIZE * 2^i >= size
+>> size - size of the request (in bytes)
+*/
+int XGraphArena::GetClassID(MTYPE size)
+{
+    int id = 0;
+    MTYPE blockSize = GRAPH_ARENA_MIN_BLOCK_SIZE;
+    while(blockSize < size){
+        blockSize <<= 1;
+        id++;
+    }
+
+    CheckNTErrors(id < GRAPH_ARENA_CLASS_NUM, "The block is too large!");
+
+    return id;
+}
+
+/*
+the size of the block for a request (i.e., the request is rounded
+up to a power of 2)
+>> size - size of the request (in bytes)
+*/
+MTYPE XGraphArena::GetBlockSize(MTYPE size)
+{
+    return (MTYPE)GRAPH_ARENA_MIN_BLOCK_SIZE << GetClassID(size);
+}
+
+/*
+allocate a block. We first try the free list of the block size, and then
+cut the block from the last chunk (or a new chunk if it is full)
+>> size - size of the request (in bytes)
+<< return - the block of GetBlockSize(size) bytes
+*/
+void * XGraphArena::Alloc(MTYPE size)
+{
+    int id = GetClassID(size);
+    MTYPE blockSize = (MTYPE)GRAPH_ARENA_MIN_BLOCK_SIZE << id;
+    void * block = NULL;
+
+    MUTEX_LOCK(mutex);
+
+    if(freeLists[id] != NULL){
+        block = freeLists[id];
+        freeLists[id] = *(void**)block;
+    }
+    else{
+        if(topSize < blockSize){
+            /* the rest of the last chunk is wasted. It is fine as the
+               chunk is much larger than a block in most cases */
+            MTYPE chunkSize = MAX(blockSize, GRAPH_ARENA_CHUNK_SIZE);
+
+            if(chunkNum == chunkMaxNum){
+                char ** newChunks = new char*[chunkMaxNum * 2];
+                memcpy(newChunks, chunks, sizeof(char*) * chunkNum);
+                delete[] chunks;
+                chunks = newChunks;
+                chunkMaxNum *= 2;
+            }
+
+            top = (char*)malloc(chunkSize);
+            CheckNTErrors(top != NULL, "Cannot allocate the chunk of the graph arena!");
+            chunks[chunkNum++] = top;
+            topSize = chunkSize;
+        }
+
+        block = top;
+        top += blockSize;
+        topSize -= blockSize;
+        cutNum++;
+    }
+
+    blockNum++;
+
+    MUTEX_UNLOCK(mutex);
+
+    return block;
+}
+
+/*
+release a block (it goes to the free list of its size)
+>> block - the block
+>> size - size of the request when the block was allocated
+*/
+void XGraphArena::Release(void * block, MTYPE size)
+{
+    if(block == NULL || isDead)
+        return;
+
+    int id = GetClassID(size);
+
+    MUTEX_LOCK(mutex);
+
+    CheckNTErrors(blockNum > 0, "No block is in use!");
+
+    *(void**)block = freeLists[id];
+    freeLists[id] = block;
+    blockNum--;
+
+    MUTEX_UNLOCK(mutex);
+}
+
+/*
+free all the chunks in one go if no block is in use
+<< return - whether the chunks are freed
+*/
+bool XGraphArena::Rewind()
+{
+    if(isDead)
+        return false;
+
+    MUTEX_LOCK(mutex);
+
+    bool rewound = blockNum == 0;
+    if(rewound)
+        Free();
+
+    MUTEX_UNLOCK(mutex);
+
+    return rewound;
+}
+
+/* free all the chunks (the blocks in use become invalid) */
+void XGraphArena::Free()
+{
+    if(isDead)
+        return;
+
+    for(int i = 0; i < chunkNum; i++)
+        free(chunks[i]);
+
+    chunkNum = 0;
+    top = NULL;
+    topSize = 0;
+    blockNum = 0;
+    memset(freeLists, 0, sizeof(void*) * GRAPH_ARENA_CLASS_NUM);
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,116 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The arena of the network (graph) that we build in a training step. It
+ * keeps the arrays of the edges (i.e., tails and parameters of XLink) that
+ * are too large to be kept in the edges themselves. Memory is cut from big
+ * chunks, and a released array goes to a free list (of its size) for
+ * reuse. So building the network in a step does not call new/delete again
+ * and again. All the chunks are freed in one go (by Rewind()) once no array
+ * is in use, e.g., when a network is cleared after a step.
+ *
+ */
+
+#ifndef __XGRAPHARENA_H__
+#define __XGRAPHARENA_H__
+
+#include "XGlobal.h"
+#include "XThread.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* size of a chunk (in bytes) */
+#define GRAPH_ARENA_CHUNK_SIZE (64 * 1024)
+
+/* the smallest block (in bytes) */
+#define GRAPH_ARENA_MIN_BLOCK_SIZE 16
+
+/* number of the block sizes, i.e., 16B, 32B, ..., 16B * 2^(n-1) */
+#define GRAPH_ARENA_CLASS_NUM 32
+
+/* the arena of the network */
+class XGraphArena
+{
+public:
+    /* the chunks */
+    char ** chunks;
+
+    /* number of the chunks */
+    int chunkNum;
+
+    /* size of the chunk array */
+    int chunkMaxNum;
+
+    /* the unused memory of the last chunk */
+    char * top;
+
+    /* size of the unused memory of the last chunk */
+    MTYPE topSize;
+
+    /* the free lists (one for each block size). A free block keeps
+       the pointer to the next free block in its first bytes */
+    void * freeLists[GRAPH_ARENA_CLASS_NUM];
+
+    /* number of the blocks in use */
+    int blockNum;
+
+    /* number of the blocks that are cut from the chunks */
+    long long cutNum;
+
+    /* the mutex for allocation and release */
+    MUTEX_HANDLE mutex;
+
+    /* indicates whether the arena is destroyed (e.g., at exit) */
+    bool isDead;
+
+public:
+    /* constructor */
+    XGraphArena();
+
+    /* de-constructor */
+    ~XGraphArena();
+
+    /* allocate a block */
+    void * Alloc(MTYPE size);
+
+    /* release a block */
+    void Release(void * block, MTYPE size);
+
+    /* free all the chunks if no block is in use */
+    bool Rewind();
+
+    /* free all the chunks */
+    void Free();
+
+    /* the size of the block for a request */
+    static
+    MTYPE GetBlockSize(MTYPE size);
+
+protected:
+    /* id of the block size */
+    static
+    int GetClassID(MTYPE size);
+};
+
+/* the arena of the edges of the networks */
+extern XGraphArena GGraphArena;
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XGRAPHARENA_H__
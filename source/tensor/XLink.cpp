@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include "XLink.h"
 #include "XName.h"
+#include "XGraphArena.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
 
@@ -31,10 +32,12 @@ int XLink::paramSize = PARAM_UNTI_SIZE;
 XLink::XLink()
 {
     head   = NULL;
-    tails  = NULL;
-    params = NULL;
+    tails  = tailBuf;
+    params = paramBuf;
     tailNum  = 0;
     paramNum = 0;
+    tailCapacity  = XLINK_INLINE_TAIL_NUM;
+    paramCapacity = sizeof(paramBuf);
     type[0] = 0;
     typeID = 0;
     caculator = NULL;
@@ -43,22 +46,16 @@ XLink::XLink()
 /* deconstructor */
 XLink::~XLink()
 {
-    if(tails != NULL)
-        delete[] tails;
-    if(params != NULL)
-        delete[] (char*)params;
+    ClearTail();
+    ClearParam();
 }
 
 /* reset it */
 void XLink::Reset()
 {
-    delete[] tails;
-    delete[] (char*)params;
+    ClearTail();
+    ClearParam();
     head   = NULL;
-    tails  = NULL;
-    params = NULL;
-    tailNum  = 0;
-    paramNum = 0;
     type[0]  = 0;
     typeID   = 0;
     caculator = NULL;
@@ -75,10 +72,69 @@ void XLink::Clear()
     caculator = NULL;
 }
 
-/* reset tails */
+/* reset tails (the array goes back to the edge itself) */
 void XLink::ClearTail()
 {
     tailNum = 0;
+
+    if(tails != tailBuf){
+        GGraphArena.Release(tails, tailCapacity * sizeof(XTensor*));
+        tails = tailBuf;
+        tailCapacity = XLINK_INLINE_TAIL_NUM;
+    }
+}
+
+/* reset parameters (the array goes back to the edge itself) */
+void XLink::ClearParam()
+{
+    paramNum = 0;
+
+    if(params != paramBuf){
+        GGraphArena.Release(params, paramCapacity);
+        params = paramBuf;
+        paramCapacity = sizeof(paramBuf);
+    }
+}
+
+/* 
+make sure that the tail array has room for a number of tails. The array 
+is moved to the graph arena if it is larger than what the edge keeps.
+>> num - number of the tails
+*/
+void XLink::ReserveTail(int num)
+{
+    if(num <= tailCapacity)
+        return;
+
+    MTYPE size = XGraphArena::GetBlockSize(sizeof(XTensor*) * MAX(num, tailCapacity * 2));
+    XTensor ** ts = (XTensor**)GGraphArena.Alloc(size);
+    memcpy(ts, tails, sizeof(XTensor*) * tailNum);
+
+    if(tails != tailBuf)
+        GGraphArena.Release(tails, tailCapacity * sizeof(XTensor*));
+
+    tails = ts;
+    tailCapacity = (int)(size / sizeof(XTensor*));
+}
+
+/* 
+make sure that the parameter array has room for a number of parameters
+>> num - number of the parameters
+*/
+void XLink::ReserveParam(int num)
+{
+    if(num * paramSize <= paramCapacity)
+        return;
+
+    MTYPE size = XGraphArena::GetBlockSize(MAX(num * paramSize, paramCapacity * 2));
+    void * ps = GGraphArena.Alloc(size);
+    memcpy(ps, params, paramNum * paramSize);
+
+    if(params != paramBuf)
+        GGraphArena.Release(params, paramCapacity);
+
+    params = ps;
+    paramCapacity = (int)size;
 }
 
 /*
@@ -106,16 +162,17 @@ void XLink::ClearOutgoing(XTensor * node)
                 memcpy(parentIncome.tails + j, parentIncome.tails + j + 1,
                        sizeof(XTensor*) * (parentIncome.tailNum - 1 - j));
                 parentIncome.tailNum--;
+                if(parentIncome.tailNum == 0)
+                    parentIncome.ClearTail();
                 break;
             }
         }
     }
     
     outgo.ClearTail();
+    outgo.ClearParam();
     outgo.typeID = 0;
     outgo.type[0] = 0;
-    delete[] (char*)outgo.params;
-    outgo.params = NULL;
 }
 
 /*
@@ -143,6 +200,8 @@ void XLink::ClearIncoming(XTensor * node)
                 memcpy(childOutgo.tails + j, childOutgo.tails + j + 1,
                        sizeof(XTensor*) * (childOutgo.tailNum - 1 - j));
                 childOutgo.tailNum--;
+                if(childOutgo.tailNum == 0)
+                    childOutgo.ClearTail();
                 break;
             }
         }
@@ -152,10 +211,9 @@ void XLink::ClearIncoming(XTensor * node)
     }
 
     income.ClearTail();
+    income.ClearParam();
     income.typeID = 0;
     income.type[0] = 0;
-    delete[] (char*)income.params;
-    income.params = NULL;
 }
 
 /* 
@@ -187,11 +245,8 @@ add a tail
 */
 void XLink::AddTail(XTensor * t)
 {
-    XTensor ** ts = tails;
-    tails = new XTensor*[tailNum + 1];
-    memcpy(tails, ts, sizeof(XTensor*) * tailNum);
+    ReserveTail(tailNum + 1);
     tails[tailNum++] = t;
-    delete[] ts;
 }
 
 /* 
@@ -201,12 +256,9 @@ add two tails in one time
 */
 void XLink::AddTwoTails(XTensor * t1, XTensor * t2)
 {
-    XTensor ** ts = tails;
-    tails = new XTensor*[tailNum + 2];
-    memcpy(tails, ts, sizeof(XTensor*) * tailNum);
+    ReserveTail(tailNum + 2);
     tails[tailNum++] = t1;
     tails[tailNum++] = t2;
-    delete[] ts;
 }
 
 /* 
@@ -215,13 +267,10 @@ add a parameter
 */
 void XLink::AddParam(DTYPE param)
 {
-    void * ps = params;
-    params = new char[(paramNum + 1) * paramSize];
-    memcpy(params, ps, paramNum * paramSize);
+    ReserveParam(paramNum + 1);
     DTYPE * p = (DTYPE*)((char*)params + paramNum * paramSize);
     *p = param;
     paramNum++;
-    delete[] (char*)ps;
 }
 
 /* 
@@ -231,13 +280,11 @@ add a parameter
 */
 void XLink::AddParam(void * param, int size)
 {
-    void * ps = params;
-    params = new char[(paramNum + 1) * paramSize];
-    memcpy(params, ps, paramNum * paramSize);
+    CheckNTErrors(size <= paramSize, "The parameter is too large!");
+    ReserveParam(paramNum + 1);
     char * p = (char*)params + paramNum * paramSize;
     memcpy(p, param, size);
     paramNum++;
-    delete[] (char*)ps;
 }
 
 /* 
@@ -247,7 +294,7 @@ get a paramter in default type
 */
 DTYPE XLink::GetParam(int i)
 {
-    CheckNTErrors(params != NULL, "parameter array cannot be empty!");
+    CheckNTErrors(i >= 0 && i < paramNum, "Illegal parameter index!");
     char * p = (char*)params + i * paramSize;
     return *(DTYPE*)p;
 }
@@ -259,7 +306,7 @@ get a paramter in integer
 */
 int XLink::GetParamInt(int i)
 {
-    CheckNTErrors(params != NULL, "parameter array cannot be empty!");
+    CheckNTErrors(i >= 0 && i < paramNum, "Illegal parameter index!");
     char * p = (char*)params + i * paramSize;
     return *(int*)p;
 }
@@ -271,7 +318,7 @@ get a paramter in integer
 */
 void * XLink::GetParamPointer(int i)
 {
-    CheckNTErrors(params != NULL, "parameter array cannot be empty!");
+    CheckNTErrors(i >= 0 && i < paramNum, "Illegal parameter index!");
     char * p = (char*)params + i * paramSize;
     return *(int **)p;
 }
@@ -283,7 +330,7 @@ get a parameter in MATRIX_TRANS_TYPE
 */
 MATRIX_TRANS_TYPE XLink::GetParamTrans(int i)
 {
-    CheckNTErrors(params != NULL, "parameter array cannot be empty!");
+    CheckNTErrors(i >= 0 && i < paramNum, "Illegal parameter index!");
     char * p = (char*)params + i * paramSize;
     return *(MATRIX_TRANS_TYPE*)p;
 }
@@ -300,11 +347,9 @@ void XLink::MakeLink(const XTensor * t1, const XTensor * t2, XTensor * h, int id
     if(h == NULL)
         return;
     
-    XList list(2);
-    list.Add(t1);
-    list.Add(t2);
+    const XTensor * list[2] = {t1, t2};
 
-    MakeLink(&list, h, id);
+    MakeLink(list, 2, h, id);
 }
 
 /*
@@ -320,12 +365,9 @@ void XLink::MakeLink(const XTensor * t1, const XTensor * t2, const XTensor * t3,
     if (h == NULL)
         return;
 
-    XList list(3);
-    list.Add(t1);
-    list.Add(t2);
-    list.Add(t3);
+    const XTensor * list[3] = {t1, t2, t3};
 
-    MakeLink(&list, h, id);
+    MakeLink(list, 3, h, id);
 }
 
 /* 
@@ -335,23 +377,36 @@ create a hyper edge with a list of tensors and a output tensor
 >> id - id of the edge type
 */
 void XLink::MakeLink(const XList * list, XTensor * h, int id)
+{
+    MakeLink((const XTensor**)list->items, list->count, h, id);
+}
+
+/* 
+create a hyper edge with an array of tensors and a output tensor 
+>> list - an array of input tensors
+>> num - number of the input tensors
+>> h - head tensor
+>> id - id of the edge type
+*/
+void XLink::MakeLink(const XTensor ** list, int num, XTensor * h, int id)
 {
     /* forward */
     XLink &income = h->income;
     income.Reset();
     income.SetHead(h);
     income.SetType(id);
+    income.ReserveTail(num);
 
-    for(int i = 0; i < list->count; i++){
-        XTensor * t = (XTensor*)list->GetItem(i);
+    for(int i = 0; i < num; i++){
+        XTensor * t = (XTensor*)list[i];
         if(t == NULL)
             continue;
         income.AddTail(t);
     }
 
     /* backward */
-    for(int i = 0; i < list->count; i++){
-        XTensor * t = (XTensor*)list->GetItem(i);
+    for(int i = 0; i < num; i++){
+        XTensor * t = (XTensor*)list[i];
         if(t == NULL)
             continue;
         XLink &outgo = t->outgo;
@@ -450,6 +505,28 @@ void XLink::AddParamToHeadPointer(XTensor * h, void * param)
 }
 
 
+/* 
+redirect the pointers to a node in a list of nodes 
+>> nodes - the list
+>> num - number of the nodes
+>> oldOne - the node to be replaced
+>> newOne - the new node
+<< return - whether the new node is in the list, i.e., we redirect the old
+             node here or in a previous call (a node can be the tail of the 
+             same edge more than once, e.g., c = a + a)
+*/
+bool RedirectNode(XTensor ** nodes, int num, const XTensor * oldOne, XTensor * newOne)
+{
+    bool hit = false;
+    for(int i = 0; i < num; i++){
+        if(nodes[i] == oldOne)
+            nodes[i] = newOne;
+        if(nodes[i] == newOne)
+            hit = true;
+    }
+    return hit;
+}
+
 /* 
 replace a node with another, i.e., we redirect the links to the new node 
 >> oldOne - the node to be replaced
@@ -468,10 +545,7 @@ void XLink::Replace(const XTensor * oldOne, XTensor * newOne)
 
     /* incoming nodes */
     if(oldOne->income.typeID != 0){
-        if(newIncome.tailNum < oldOne->income.tailNum){
-            delete[] newIncome.tails;
-            newIncome.tails = new XTensor*[oldOne->income.tailNum];
-        }
+        newIncome.ReserveTail(oldOne->income.tailNum);
         
         newIncome.SetType(oldOne->income.typeID);
         newIncome.head = newOne;
@@ -479,7 +553,7 @@ void XLink::Replace(const XTensor * oldOne, XTensor * newOne)
         memcpy(newIncome.tails, oldOne->income.tails, sizeof(XTensor*) * newIncome.tailNum);
 
         int paraArraySize = oldOne->income.paramNum * oldOne->income.paramSize;
-        newIncome.params = new char[paraArraySize];
+        newIncome.ReserveParam(oldOne->income.paramNum);
         memcpy(newIncome.params, oldOne->income.params, paraArraySize);
         newIncome.paramNum = oldOne->income.paramNum;
 
@@ -502,10 +576,7 @@ void XLink::Replace(const XTensor * oldOne, XTensor * newOne)
         }
     }
     
-    if(newOutgo.tailNum < oldOne->outgo.tailNum){
-        delete[] newOutgo.tails;
-        newOutgo.tails = new XTensor*[oldOne->outgo.tailNum];
-    }
+    newOutgo.ReserveTail(oldOne->outgo.tailNum);
 
     /* outgoing nodes */
     newOutgo.head = newOne;
@@ -516,13 +587,7 @@ void XLink::Replace(const XTensor * oldOne, XTensor * newOne)
     for(int i = 0; i < newOutgo.tailNum; i++){
         XTensor * parent = newOutgo.tails[i];
         XLink &parentIncome = parent->income;
-        bool hit = false;
-        for(int j = 0; j < parentIncome.tailNum; j++){
-            if(parentIncome.tails[j] == oldOne){
-                parentIncome.tails[j] = newOne;
-                hit = true;
-            }
-        }
+        bool hit = RedirectNode(parentIncome.tails, parentIncome.tailNum, oldOne, newOne);
 
         if(parentIncome.tailNum > 0){
             CheckNTErrors(hit, "No proper node found in parent.income edge!");
@@ -530,6 +595,108 @@ void XLink::Replace(const XTensor * oldOne, XTensor * newOne)
     }
 }
 
+/* 
+swap the content of two links (the arrays are swapped rather than copied)
+>> a - a link
+>> b - another link
+*/
+void XLink::Swap(XLink &a, XLink &b)
+{
+    /* the arrays kept in the edges are swapped by copying, and the arrays
+       in the graph arena are swapped by pointers */
+    bool aTailInside = a.tails == a.tailBuf;
+    bool bTailInside = b.tails == b.tailBuf;
+    bool aParamInside = a.params == a.paramBuf;
+    bool bParamInside = b.params == b.paramBuf;
+
+    XTensor * tailBufBackup[XLINK_INLINE_TAIL_NUM];
+    memcpy(tailBufBackup, a.tailBuf, sizeof(a.tailBuf));
+    memcpy(a.tailBuf, b.tailBuf, sizeof(a.tailBuf));
+    memcpy(b.tailBuf, tailBufBackup, sizeof(a.tailBuf));
+
+    if(!aParamInside || !bParamInside || a.paramNum > 0 || b.paramNum > 0){
+        char paramBufBackup[sizeof(a.paramBuf)];
+        memcpy(paramBufBackup, a.paramBuf, sizeof(a.paramBuf));
+        memcpy(a.paramBuf, b.paramBuf, sizeof(a.paramBuf));
+        memcpy(b.paramBuf, paramBufBackup, sizeof(a.paramBuf));
+    }
+
+    XTensor ** tailsBackup = aTailInside ? b.tailBuf : a.tails;
+    int tailNumBackup = a.tailNum;
+    int tailCapacityBackup = a.tailCapacity;
+    void * paramsBackup = aParamInside ? b.paramBuf : a.params;
+    int paramNumBackup = a.paramNum;
+    int paramCapacityBackup = a.paramCapacity;
+    int typeIDBackup = a.typeID;
+    void * caculatorBackup = a.caculator;
+    char typeBackup[MAX_OP_NAME_LENGTH];
+    memcpy(typeBackup, a.type, MAX_OP_NAME_LENGTH);
+
+    a.tails = bTailInside ? a.tailBuf : b.tails;
+    a.tailNum = b.tailNum;
+    a.tailCapacity = b.tailCapacity;
+    a.params = bParamInside ? (void*)a.paramBuf : b.params;
+    a.paramNum = b.paramNum;
+    a.paramCapacity = b.paramCapacity;
+    a.typeID = b.typeID;
+    a.caculator = b.caculator;
+    memcpy(a.type, b.type, MAX_OP_NAME_LENGTH);
+
+    b.tails = tailsBackup;
+    b.tailNum = tailNumBackup;
+    b.tailCapacity = tailCapacityBackup;
+    b.params = paramsBackup;
+    b.paramNum = paramNumBackup;
+    b.paramCapacity = paramCapacityBackup;
+    b.typeID = typeIDBackup;
+    b.caculator = caculatorBackup;
+    memcpy(b.type, typeBackup, MAX_OP_NAME_LENGTH);
+}
+
+/* 
+move a node to another, i.e., the new node takes the place of the old node 
+in the network and the old node is left with no links. Unlike Replace(), 
+the edges (and their tails and parameters) are handed over to the new node 
+rather than copied, so it does not allocate memory and takes time linear 
+in the number of the edges around the node. This is used when we move 
+a tensor that is going to die (see the move constructor of XTensor).
+>> oldOne - the node to be moved
+>> newOne - the new node
+*/
+void XLink::Move(XTensor * oldOne, XTensor * newOne)
+{
+    if(oldOne == NULL || newOne == NULL || oldOne == newOne)
+        return;
+
+    XLink::ClearOutgoing(newOne);
+    XLink::ClearIncoming(newOne);
+
+    Swap(oldOne->income, newOne->income);
+    Swap(oldOne->outgo, newOne->outgo);
+
+    XLink &newIncome = newOne->income;
+    XLink &newOutgo = newOne->outgo;
+
+    newIncome.head = newOne;
+    newOutgo.head = newOne;
+    oldOne->income.head = NULL;
+    oldOne->outgo.head = NULL;
+
+    /* update the link to each child node */
+    for(int i = 0; i < newIncome.tailNum; i++){
+        XLink &childOutgo = newIncome.tails[i]->outgo;
+        bool hit = RedirectNode(childOutgo.tails, childOutgo.tailNum, oldOne, newOne);
+        CheckNTErrors(hit || childOutgo.tailNum == 0, "No proper node found in child.outgo edge!");
+    }
+
+    /* update the link to each parent node */
+    for(int i = 0; i < newOutgo.tailNum; i++){
+        XLink &parentIncome = newOutgo.tails[i]->income;
+        bool hit = RedirectNode(parentIncome.tails, parentIncome.tailNum, oldOne, newOne);
+        CheckNTErrors(hit || parentIncome.tailNum == 0, "No proper node found in parent.income edge!");
+    }
+}
+
 /* 
 copy incoming edges of a given node
 >> reference - the node we copy from
@@ -541,22 +708,14 @@ void XLink::CopyIncoming(const XTensor * reference, XTensor * target)
 
     ClearIncoming(target);
 
-    int tailNum = reference->income.tailNum;
-    XList tails(tailNum);
-    for(int i = 0; i < tailNum; i++){
-        XTensor * tail = (XTensor*)reference->income.tails[i];
-        tails.Add(tail);
-    }
-
-    MakeLink(&tails, target, reference->income.typeID);
+    MakeLink((const XTensor**)reference->income.tails, reference->income.tailNum, 
+             target, reference->income.typeID);
 
     int paraNum = reference->income.paramNum;
-    target->income.paramNum = paraNum;
-
-    delete[] (char*)target->income.params;
     int size = paraNum * reference->income.paramSize;
-    target->income.params = new char[size];
+    target->income.ReserveParam(paraNum);
     memcpy(target->income.params, reference->income.params, size);
+    target->income.paramNum = paraNum;
 }
 
 /* 
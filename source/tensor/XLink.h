@@ -27,15 +27,20 @@
 #define __XLINK_H__
 
 #include "XGlobal.h"
+#include "XName.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
 
 /* cross reference */
 struct XTensor;
 
-#define MAX_OP_NAME_LENGTH 16
 #define PARAM_UNTI_SIZE    64
 
+/* number of the tails (and parameters) kept in the edge itself. More tails 
+   (or parameters) are kept in an array of the graph arena (see XGraphArena) */
+#define XLINK_INLINE_TAIL_NUM  4
+#define XLINK_INLINE_PARAM_NUM 4
+
 /*
 This defines the link among tensors in networks. XLink can be
 cast as a hyperedge in a graph. when we compute on tensors, we actually create a
@@ -80,6 +85,18 @@ struct XLink
 
     /* caculator (pointer to the class for computation) */
     void * caculator;
+
+    /* size of the tail array */
+    int tailCapacity;
+
+    /* size of the parameter array (in bytes) */
+    int paramCapacity;
+
+    /* the tail array kept in the edge itself */
+    XTensor * tailBuf[XLINK_INLINE_TAIL_NUM];
+
+    /* the parameter array kept in the edge itself */
+    char paramBuf[XLINK_INLINE_PARAM_NUM * PARAM_UNTI_SIZE];
     
     /* constuctor */
     XLink();
@@ -96,6 +113,15 @@ struct XLink
     /* clear tails */
     void ClearTail();
 
+    /* clear parameters */
+    void ClearParam();
+
+    /* make sure that the tail array has room for a number of tails */
+    void ReserveTail(int num);
+
+    /* make sure that the parameter array has room for a number of parameters */
+    void ReserveParam(int num);
+
     /* clear the incoming node list of tensor node */
     static
     void ClearIncoming(XTensor * node);
@@ -146,6 +172,10 @@ struct XLink
     static
     void MakeLink(const XList * list, XTensor * h, int id);
 
+    /* create a hyper edge with an array of input tensors and a output tensor */
+    static
+    void MakeLink(const XTensor ** list, int num, XTensor * h, int id);
+
     /* create a hyper edge with a input tensors and a list of output tensors */
     static
     void MakeLink(XTensor * h, XList * list, int id);
@@ -174,6 +204,15 @@ struct XLink
     static 
     void Replace(const XTensor * oldOne, XTensor * newOne);
 
+    /* move a node to another, i.e., the links of the old node are handed over
+       to the new node (with no memory allocation) */
+    static
+    void Move(XTensor * oldOne, XTensor * newOne);
+
+    /* swap the content of two links */
+    static
+    void Swap(XLink &a, XLink &b);
+
     /* copy links of a given node */
     static
     void CopyIncoming(const XTensor * reference, XTensor * target);
@@ -28,6 +28,7 @@
 #include <string.h>
 #include "XList.h"
 #include "XGlobal.h"
+#include "XThread.h"
 
 #include "wchar.h"
 #include "locale.h"
@@ -44,13 +45,22 @@ namespace nts{
 
 XList NULLList;
 
+/* number of the arrays that are allocated by the lists */
+long long listAllocCount = 0;
+
+/* count an array allocated by a list */
+void CountListAlloc()
+{
+    ATOMIC_ADD(listAllocCount, 1);
+}
+
 /* constructor */
 XList::XList()
 {
     mem    = NULL;
-    maxNum = 0;
+    maxNum = XLIST_INLINE_NUM;
     count  = 0;
-    items  = NULL;
+    items  = inlineItems;
     isIntList = false;
 }
 
@@ -62,10 +72,11 @@ constructor
 XList::XList(int myMaxNum, bool isIntListOrNot)
 {
     mem    = NULL;
-    maxNum = myMaxNum;
+    maxNum = XLIST_INLINE_NUM;
     count  = 0;
-    items  = new void*[myMaxNum];
+    items  = inlineItems;
     isIntList = isIntListOrNot;
+    Reserve(myMaxNum);
 }
 
 /* 
@@ -77,10 +88,11 @@ constructor
 XList::XList(int myMaxNum, XMem * myMem, bool isIntListOrNot)
 {
     mem    = myMem;
-    maxNum = myMaxNum;
+    maxNum = XLIST_INLINE_NUM;
     count  = 0;
-    items  = (void**)mem->Alloc(mem->devID, sizeof(void*) * maxNum);
+    items  = inlineItems;
     isIntList = isIntListOrNot;
+    Reserve(myMaxNum);
 }
 
 /* de-constructor */
@@ -92,7 +104,7 @@ XList::~XList()
             delete[] p;
         }
     }
-    if(mem == NULL)
+    if(mem == NULL && items != inlineItems)
         delete[] items;
 }
 
@@ -104,9 +116,35 @@ allocate the data array for the list
 void XList::Create(int myMaxNum, XMem * myMem)
 {
     mem    = myMem;
-    maxNum = myMaxNum;
+    maxNum = XLIST_INLINE_NUM;
     count  = 0;
-    items  = (void**)mem->Alloc(mem->devID, sizeof(void*) * maxNum);
+    items  = inlineItems;
+    Reserve(myMaxNum);
+}
+
+/*
+make sure that a number of items can be kept without reallocation. The
+items are kept in the list itself until there are more than
+XLIST_INLINE_NUM items.
+>> num - number of the items
+*/
+void XList::Reserve(int num)
+{
+    if(num <= maxNum)
+        return;
+
+    void ** newItems;
+    if( mem == NULL )
+        newItems = new void*[num];
+    else
+        newItems = (void**)mem->Alloc(mem->devID, sizeof(void*) * num);
+    memcpy(newItems, items, sizeof(void*) * count);
+    if( mem == NULL && items != inlineItems )
+        delete[] items;
+    items = newItems;
+    maxNum = num;
+
+    CountListAlloc();
 }
 
 /*
@@ -115,18 +153,8 @@ add an item into the list
 */
 void XList::Add(const void * item)
 {
-    if( count == maxNum ){
-        void ** newItems;
-        if( mem == NULL )
-            newItems = new void*[maxNum * 2 + 1];
-        else
-            newItems = (void**)mem->Alloc(mem->devID, sizeof(void*) * (maxNum * 2 + 1));
-        memcpy(newItems, items, sizeof(void*) * maxNum);
-        if( mem == NULL )
-            delete[] items;
-        items = newItems;
-        maxNum = maxNum * 2 + 1;
-    }
+    if( count == maxNum )
+        Reserve(maxNum * 2 + 1);
     
     MTYPE p = (MTYPE)item;
     items[count++] = (MTYPE*)p;
@@ -140,19 +168,8 @@ add a number of items into the list
 */
 void XList::Add(void ** inputItems, int inputItemCount)
 {
-    if( count + inputItemCount >= maxNum ){
-        int newMaxNum = (count + inputItemCount) * 2 + 1;
-        void ** newItems;
-        if( mem == NULL )
-            newItems = new void*[newMaxNum];
-        else
-            newItems = (void**)mem->Alloc(mem->devID, sizeof(void*) * newMaxNum);
-        memcpy(newItems, items, sizeof(void*) * maxNum);
-        if( mem == NULL )
-            delete[] items;
-        items = newItems;
-        maxNum = newMaxNum;
-    }
+    if( count + inputItemCount > maxNum )
+        Reserve((count + inputItemCount) * 2 + 1);
     memcpy(items + count, inputItems, sizeof(void*) * inputItemCount);
     count += inputItemCount;
 }
@@ -186,18 +203,8 @@ insert an item to the given position of the list
 */
 void XList::Insert(int pos, void * item)
 {
-    if( count == maxNum ){
-        void ** newItems;
-        if( mem == NULL )
-            newItems = new void*[maxNum * 2 + 1];
-        else
-            newItems = (void**)mem->Alloc(mem->devID, sizeof(void*) * (maxNum * 2 + 1));
-        memcpy(newItems, items, sizeof(void*) * maxNum);
-        if( mem == NULL )
-            delete[] items;
-        items = newItems;
-        maxNum = maxNum * 2 + 1;
-    }
+    if( count == maxNum )
+        Reserve(maxNum * 2 + 1);
 
     for(int i = count - 1; i >= pos; i--)
         items[i + 1] = items[i];
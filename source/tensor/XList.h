@@ -29,12 +29,16 @@
 
 #include "XMem.h"
 #include "XGlobal.h"
+#include "XSmallList.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
 namespace nts{
 
 typedef int (* ListCompare)(const void * item1, const void * item2);
 
+/* number of the items that a list keeps in itself (see XSmallList.h) */
+#define XLIST_INLINE_NUM 8
+
 /* the XList class */
 class XList
 {
@@ -54,6 +58,10 @@ public:
     /* indicates whether data items are integers */
     bool isIntList;
 
+    /* the inline storage. A short list (e.g., the arguments of a job) keeps
+       its items here and needs no allocation */
+    void * inlineItems[XLIST_INLINE_NUM];
+
 public:
     /* constructor */
     XList();
@@ -69,6 +77,7 @@ public:
 
     /* utilities */
     void Create(int myMaxNum, XMem * myMem);
+    void Reserve(int num);
     void Add(const void * item);
     void Add(void ** inputItems, int inputItemCount);
     void AddList(XList * l);
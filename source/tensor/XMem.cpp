@@ -27,6 +27,8 @@
 #include "XGlobal.h"
 #include "XUtility.h"
 #include "XMem.h"
+#include "XNuma.h"
+#include "XPRunner.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
 namespace nts{
@@ -48,6 +50,7 @@ XMem::XMem()
     strcpy(name, "xmem");
     signature = 0;
     mergeFreeOTF = true;
+    numaNode = NUMA_NODE_NONE;
 }
 
 /* 
@@ -71,6 +74,7 @@ XMem::XMem(int myDevID, MEMPOOL_MODE myMode, MTYPE myBlockSize, int myBlockNum,
     strcpy(name, "xmem");
     signature = 0;
     mergeFreeOTF = true;
+    numaNode = NUMA_NODE_NONE;
     Initialize(myDevID, myMode, myBlockSize, myBlockNum, myBufSize);
 }
 
@@ -132,6 +136,8 @@ void XMem::Initialize(int myDevID, MEMPOOL_MODE myMode, MTYPE myBlockSize, int m
 
     if(myDevID < 0){
         buf = new char[(unsigned int)myBufSize];
+        if(numaNode != NUMA_NODE_NONE)
+            TouchBlock(buf, myBufSize);
     }
     else{
 #ifdef USE_CUDA
@@ -283,6 +289,33 @@ void XMem::SetStaticMode(bool myIsStatic)
     isStatic = myIsStatic;
 }
 
+/*
+specify the NUMA node where the memory blocks are placed. It should be
+called before the blocks are allocated.
+>> myNode - id of the node (NUMA_NODE_NONE or NUMA_NODE_SPREAD otherwise)
+*/
+void XMem::SetNumaNode(int myNode)
+{
+    numaNode = myNode;
+}
+
+/*
+initialize a newly-allocated block of CPU memory. The pages of the block
+are placed where they are touched for the first time, i.e., on the node
+of the pool, or over the threads of the global runner.
+>> mem - the block
+>> size - size of the block
+*/
+void XMem::TouchBlock(void * mem, MTYPE size)
+{
+    if(numaNode == NUMA_NODE_SPREAD)
+        GNuma.TouchSpread(mem, size, globalPRunner);
+    else if(numaNode >= 0)
+        GNuma.Touch(mem, size, numaNode);
+    else
+        memset(mem, 0, size);
+}
+
 /* 
 specify if the memory pool is used for tensor computation (rather
 than storage 
@@ -417,7 +450,7 @@ void * XMem::AllocDynamic(int myDevID, MTYPE mySize)
         /* on CPUs */
         if (myDevID < 0) {
             mem = new char[(unsigned int)b->size + 2 * CUDA_PITCH];
-            memset(mem, 0, (unsigned int)b->size + 2 * CUDA_PITCH);
+            TouchBlock(mem, b->size + 2 * CUDA_PITCH);
         }
         /* on GPUs */
         else {
@@ -529,6 +562,8 @@ void * XMem::AllocBuf(int myDevID, MTYPE mySize, int pitch)
 
     CheckNTErrors((bufSize >= bufUsed), "Something is wrong with the memory block.");
 
+    UpdatePeak();
+
     return required;
 }
 
@@ -679,6 +714,8 @@ void * XMem::AllocStandard(int myDevID, MTYPE mySize, bool myIsRebuiltIndex)
         
         RemoveIndexNode(hit);
         AddAllocIndexNode(hit);
+
+        UpdatePeak();
         
         result = beg;
     }
@@ -701,7 +738,7 @@ void * XMem::AllocStandard(int myDevID, MTYPE mySize, bool myIsRebuiltIndex)
                     block->size = MAX(block->sizeDesired, mySize + 2 * MY_PITCH);
                     if (myDevID < 0) {
                         block->mem = new char[block->size];
-                        memset(block->mem, 0, block->size);
+                        TouchBlock(block->mem, block->size);
                     }
                     else {
 #ifdef USE_CUDA
@@ -1478,6 +1515,50 @@ void XMem::ShowMemUsage(FILE * file)
            (DTYPE)used/MILLION, (DTYPE)total/MILLION, (DTYPE)used/total);
 }
 
+/* get the size of the used memory (blocks and buffer) */
+MTYPE XMem::GetUsedSize()
+{
+    MTYPE used = bufUsed;
+
+    for(int i = 0; i <= curBlockID && i < blockNum; i++){
+        if(blocks[i].mem != NULL)
+            used += blocks[i].used;
+    }
+
+    return used;
+}
+
+/* reset the peak size of the used memory (and the over-limit flag) */
+void XMem::ResetPeak()
+{
+    peakUsed = GetUsedSize();
+    isOverLimit = sizeLimit > 0 && peakUsed > sizeLimit;
+}
+
+/* 
+set a soft limit of the used memory. Allocation goes on over the limit,
+but "isOverLimit" is set, so the caller can retry with less memory
+(e.g., a smaller batch) instead of running out of the memory later on.
+>> mySize - the limit (0 means no limit)
+*/
+void XMem::SetSizeLimit(MTYPE mySize)
+{
+    sizeLimit = mySize;
+    ResetPeak();
+}
+
+/* update the peak size of the used memory */
+void XMem::UpdatePeak()
+{
+    MTYPE used = GetUsedSize();
+
+    if(used > peakUsed)
+        peakUsed = used;
+
+    if(sizeLimit > 0 && used > sizeLimit)
+        isOverLimit = true;
+}
+
 #ifdef USE_CUDA
 
 /* get the handle of cublas */
@@ -235,6 +235,19 @@ public:
     /* indicates whether we merge free memory pieces on the fly */
     bool mergeFreeOTF;
 
+    /* NUMA node where the memory blocks are placed (NUMA_NODE_NONE: by the allocating
+       thread, NUMA_NODE_SPREAD: over the threads of the global runner) */
+    int numaNode;
+
+    /* peak size of the used memory (blocks and buffer) since the last reset */
+    MTYPE peakUsed;
+
+    /* a soft limit of the used memory (0 means no limit) */
+    MTYPE sizeLimit;
+
+    /* indicates whether the used memory has gone over the limit */
+    bool isOverLimit;
+
 public:
 
     /* constructor */
@@ -274,6 +287,12 @@ public:
     /* run in static mode */
     void SetStaticMode(bool myIsStatic);
 
+    /* specify the NUMA node where the memory blocks are placed */
+    void SetNumaNode(int myNode);
+
+    /* initialize a newly-allocated block of CPU memory (and place its pages) */
+    void TouchBlock(void * mem, MTYPE size);
+
     /* specify if the memory pool is used for tensor computation (rather
        than storage */
     void SetComputationMode(bool myIsForComputation);
@@ -406,6 +425,21 @@ public:
     /* show profile of the memory pool */
     void ShowMemUsage(FILE * file);
 
+    /* get the size of the used memory (blocks and buffer) */
+    MTYPE GetUsedSize();
+
+    /* reset the peak size of the used memory (and the over-limit flag) */
+    void ResetPeak();
+
+    /* set a soft limit of the used memory */
+    void SetSizeLimit(MTYPE mySize);
+
+protected:
+    /* update the peak size of the used memory */
+    void UpdatePeak();
+
+public:
+
 #ifdef USE_CUDA
     /* get the handle of cublas */
     cublasHandle_t * GetCublasHandle();
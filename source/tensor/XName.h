@@ -28,6 +28,9 @@
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
+/* max length of the operator name */
+#define MAX_OP_NAME_LENGTH      32
+
 /* math operations */
 #define MATH_BASE               0x00001000
 
@@ -108,6 +111,10 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 #define FUNC_SIGMOID            FUNC_RECTIFY + 1
 #define FUNC_SOFTMAX            FUNC_SIGMOID + 1
 
+/* user-defined (e.g., fused) operations. Their ids are assigned when they
+   are registered (see XOperator.h) */
+#define CUSTOM_BASE             FUNCTION_BASE * 2
+
 /* get operator name */
 const char * GetOPName(int type);
 
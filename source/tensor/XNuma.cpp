@@ -0,0 +1,343 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "XNuma.h"
+#include "XPRunner.h"
+#include "XList.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* size of a memory page (for first touch) */
+#define NUMA_PAGE_SIZE 4096
+
+XNumaManager GNuma;
+
+/* constructor */
+XNumaManager::XNumaManager()
+{
+    isInitialized = false;
+    nodeNum = 0;
+    cpuNum = 0;
+    cpus = NULL;
+    cpuNodes = NULL;
+    nodeBeg = NULL;
+    nodeCPUNum = NULL;
+    nodeMems = NULL;
+    MUTEX_INIT(mutex);
+}
+
+/* de-constructor */
+XNumaManager::~XNumaManager()
+{
+    Clear();
+    MUTEX_DELE(mutex);
+}
+
+/*
+parse a cpu list (e.g., "0-3,8,10-11")
+>> list - the list
+>> result - the cpus
+>> maxNum - size of "result"
+<< return - number of the cpus
+*/
+int XNumaManager::ParseCPUList(const char * list, int * result, int maxNum)
+{
+    int num = 0;
+    const char * p = list;
+
+    while(*p){
+        if(*p < '0' || *p > '9'){
+            p++;
+            continue;
+        }
+
+        char * end = NULL;
+        int beg = (int)strtol(p, &end, 10);
+        int last = beg;
+        p = end;
+
+        if(*p == '-'){
+            last = (int)strtol(p + 1, &end, 10);
+            p = end;
+        }
+
+        for(int c = beg; c <= last && num < maxNum; c++)
+            result[num++] = c;
+    }
+
+    return num;
+}
+
+/* load the topology */
+void XNumaManager::Init()
+{
+    if(isInitialized)
+        return;
+
+    Clear();
+
+    cpus = new int[MAX_NUMA_CPU_NUM];
+    cpuNodes = new int[MAX_NUMA_CPU_NUM];
+    nodeBeg = new int[MAX_NUMA_NODE_NUM];
+    nodeCPUNum = new int[MAX_NUMA_NODE_NUM];
+    nodeMems = new XMem*[MAX_NUMA_NODE_NUM];
+    memset(nodeMems, 0, sizeof(XMem*) * MAX_NUMA_NODE_NUM);
+
+    char fn[128];
+    char line[4096];
+
+    for(int node = 0; node < MAX_NUMA_NODE_NUM; node++){
+        sprintf(fn, "/sys/devices/system/node/node%d/cpulist", node);
+        FILE * file = fopen(fn, "rb");
+        if(file == NULL)
+            break;
+
+        int num = 0;
+        if(fgets(line, sizeof(line), file))
+            num = ParseCPUList(line, cpus + cpuNum, MAX_NUMA_CPU_NUM - cpuNum);
+        fclose(file);
+
+        nodeBeg[node] = cpuNum;
+        nodeCPUNum[node] = num;
+        for(int i = 0; i < num; i++)
+            cpuNodes[cpuNum + i] = node;
+        cpuNum += num;
+        nodeNum++;
+    }
+
+    /* a single node with all online cpus */
+    if(nodeNum == 0 || cpuNum == 0){
+#ifndef WIN32
+        int num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+        int num = 1;
+#endif
+        num = MIN(MAX(num, 1), MAX_NUMA_CPU_NUM);
+        for(int i = 0; i < num; i++){
+            cpus[i] = i;
+            cpuNodes[i] = 0;
+        }
+        nodeNum = 1;
+        cpuNum = num;
+        nodeBeg[0] = 0;
+        nodeCPUNum[0] = num;
+    }
+
+    isInitialized = true;
+}
+
+/* clear everything */
+void XNumaManager::Clear()
+{
+    if(nodeMems != NULL){
+        for(int i = 0; i < MAX_NUMA_NODE_NUM; i++)
+            delete nodeMems[i];
+    }
+
+    delete[] cpus;
+    delete[] cpuNodes;
+    delete[] nodeBeg;
+    delete[] nodeCPUNum;
+    delete[] nodeMems;
+
+    cpus = NULL;
+    cpuNodes = NULL;
+    nodeBeg = NULL;
+    nodeCPUNum = NULL;
+    nodeMems = NULL;
+    nodeNum = 0;
+    cpuNum = 0;
+    isInitialized = false;
+}
+
+/*
+cpu where the i-th thread is placed. Threads fill the cpus node by node.
+>> i - id of the thread
+*/
+int XNumaManager::GetThreadCPU(int i)
+{
+    Init();
+    return cpus[i % cpuNum];
+}
+
+/*
+node where the i-th thread is placed
+>> i - id of the thread
+*/
+int XNumaManager::GetThreadNode(int i)
+{
+    Init();
+    return cpuNodes[i % cpuNum];
+}
+
+/*
+pin a thread to a cpu
+>> hnd - the thread
+>> cpu - the cpu
+<< return - succeeded or not
+*/
+bool XNumaManager::BindThread(THREAD_HANDLE hnd, int cpu)
+{
+#if defined(__linux__) && defined(USE_PTHREAD)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(hnd, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+/*
+touch a piece of memory on a node, i.e., the pages are placed on the node
+(by the first-touch policy of the OS) when they are written there for the
+first time. The calling thread is moved to the node for a while.
+>> p - the memory
+>> size - size of the memory
+>> node - the node
+*/
+void XNumaManager::Touch(void * p, MTYPE size, int node)
+{
+    Init();
+
+#if defined(__linux__) && defined(USE_PTHREAD)
+    if(node >= 0 && node < nodeNum && nodeNum > 1){
+        pthread_t self = pthread_self();
+        cpu_set_t backup;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int i = 0; i < nodeCPUNum[node]; i++)
+            CPU_SET(cpus[nodeBeg[node] + i], &set);
+
+        if(pthread_getaffinity_np(self, sizeof(backup), &backup) == 0 &&
+           pthread_setaffinity_np(self, sizeof(set), &set) == 0)
+        {
+            memset(p, 0, size);
+            pthread_setaffinity_np(self, sizeof(backup), &backup);
+            return;
+        }
+    }
+#endif
+
+    memset(p, 0, size);
+}
+
+/* touch a segment of memory (in a thread) */
+void _NumaTouchSegment(XList * args)
+{
+    char * p = (char*)args->GetItem(0);
+    MTYPE size = *(MTYPE*)args->GetItem(1);
+    memset(p, 0, size);
+}
+
+/*
+touch a piece of memory in segments by the threads of a runner. Like
+RunParallel1D, the i-th of n equal segments goes to the i-th job (and
+the i-th thread if the runner is pinned), so the segments processed by a
+thread later on are placed on its node.
+>> p - the memory
+>> size - size of the memory
+>> parallelRunner - the runner
+*/
+void XNumaManager::TouchSpread(void * p, MTYPE size, XPRunner * parallelRunner)
+{
+    if(parallelRunner == NULL || parallelRunner->method != PRUNNER_MULTIPLE ||
+       parallelRunner->threadNum <= 1 || size < 2 * NUMA_PAGE_SIZE)
+    {
+        memset(p, 0, size);
+        return;
+    }
+
+    int jobNum = parallelRunner->threadNum;
+    MTYPE segSize = (size + jobNum - 1) / jobNum;
+
+    XList * jobs = new XList(jobNum);
+    XList * args = new XList(jobNum);
+    MTYPE * sizes = new MTYPE[jobNum];
+
+    for(int i = 0; i < jobNum; i++){
+        MTYPE beg = segSize * i;
+        MTYPE end = MIN(segSize * (i + 1), size);
+        if(beg >= end)
+            break;
+
+        sizes[i] = end - beg;
+
+        XList * jobArgs = new XList(2);
+        jobArgs->Add((char*)p + beg);
+        jobArgs->Add(sizes + i);
+
+        jobs->Add((void*)_NumaTouchSegment);
+        args->Add(jobArgs);
+    }
+
+    parallelRunner->Run(jobs, args);
+
+    for(int i = 0; i < args->count; i++)
+        delete (XList*)args->GetItem(i);
+    delete jobs;
+    delete args;
+    delete[] sizes;
+}
+
+/*
+get the memory pool of a node. The blocks of the pool are
+placed on the node.
+>> node - the node
+*/
+XMem * XNumaManager::GetMem(int node)
+{
+    Init();
+
+    CheckNTErrors(node >= 0 && node < nodeNum, "Illegal node id!");
+
+    MUTEX_LOCK(mutex);
+
+    if(nodeMems[node] == NULL){
+        XMem * mem = new XMem();
+        mem->SetNumaNode(node);
+        mem->Initialize(-1, FREE_ON_THE_FLY, MIN_BLOCK_SIZE_FOR_MEMPOOL, MIN_BLOCK_NUM_FOR_MEMPOOL, 0);
+        nodeMems[node] = mem;
+    }
+
+    MUTEX_UNLOCK(mutex);
+
+    return nodeMems[node];
+}
+
+/* show the topology */
+void XNumaManager::Show(FILE * file)
+{
+    Init();
+
+    fprintf(file, "NUMA nodes: %d, cpus: %d\n", nodeNum, cpuNum);
+    for(int node = 0; node < nodeNum; node++){
+        fprintf(file, " node %d:", node);
+        for(int i = 0; i < nodeCPUNum[node]; i++)
+            fprintf(file, " %d", cpus[nodeBeg[node] + i]);
+        fprintf(file, "\n");
+    }
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
@@ -0,0 +1,121 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * NUMA topology and placement. The nodes and their cpus are read from
+ * /sys/devices/system/node (a single node with all online cpus is assumed
+ * if it is not there). Threads are placed on cpus node by node, so that
+ * thread i of a pinned XPRunner (and job i of a parallel kernel) always runs
+ * on the same node. Memory is placed by first touch: a block is either
+ * touched on a given node, or "spread", i.e., touched in segments by the
+ * threads that will later process the same segments.
+ */
+
+#ifndef __XNUMA_H__
+#define __XNUMA_H__
+
+#include "XGlobal.h"
+#include "XThread.h"
+#include "XMem.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+#define MAX_NUMA_NODE_NUM 64
+#define MAX_NUMA_CPU_NUM 1024
+
+/* memory placement of a pool: by the allocating thread, on a node, or spread over the threads */
+#define NUMA_NODE_NONE -1
+#define NUMA_NODE_SPREAD -2
+
+class XPRunner;
+
+/* NUMA topology and per-node resources */
+class XNumaManager
+{
+public:
+    /* indicates whether the topology is loaded */
+    bool isInitialized;
+
+    /* number of nodes */
+    int nodeNum;
+
+    /* number of cpus */
+    int cpuNum;
+
+    /* cpus ordered node by node */
+    int * cpus;
+
+    /* node of each cpu in "cpus" */
+    int * cpuNodes;
+
+    /* the first cpu (in "cpus") of each node */
+    int * nodeBeg;
+
+    /* number of cpus of each node */
+    int * nodeCPUNum;
+
+    /* memory pools of the nodes (created when they are used) */
+    XMem ** nodeMems;
+
+    /* mutex for creating the memory pools */
+    MUTEX_HANDLE mutex;
+
+public:
+    /* constructor */
+    XNumaManager();
+
+    /* de-constructor */
+    ~XNumaManager();
+
+    /* load the topology */
+    void Init();
+
+    /* clear everything */
+    void Clear();
+
+    /* parse a cpu list (e.g., "0-3,8,10-11") */
+    static int ParseCPUList(const char * list, int * result, int maxNum);
+
+    /* cpu where the i-th thread is placed */
+    int GetThreadCPU(int i);
+
+    /* node where the i-th thread is placed */
+    int GetThreadNode(int i);
+
+    /* pin a thread to a cpu */
+    bool BindThread(THREAD_HANDLE hnd, int cpu);
+
+    /* touch a piece of memory on a node */
+    void Touch(void * p, MTYPE size, int node);
+
+    /* touch a piece of memory in segments by the threads of a (pinned) runner */
+    void TouchSpread(void * p, MTYPE size, XPRunner * parallelRunner);
+
+    /* get the memory pool of a node */
+    XMem * GetMem(int node);
+
+    /* show the topology */
+    void Show(FILE * file);
+};
+
+extern XNumaManager GNuma;
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
@@ -0,0 +1,545 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "XOperator.h"
+#include "XLink.h"
+#include "core/CHeader.h"
+#include "function/FHeader.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+XOperatorRegistry GOPs;
+
+/* the first id of each category */
+static const int opBases[OP_CATEGORY_NUM] = {MATH_BASE, DATA_BASE, FUNCTION_BASE, CUSTOM_BASE};
+
+/* forward kernels of the operators in the form of "b = f(a)" */
+#define UNARY_FORWARD(forwardName, _funcName)                                  \
+static                                                                         \
+void forwardName(const XTensor ** inputs, int inputNum, XTensor * output,      \
+                 const DTYPE * params, int paramNum)                           \
+{                                                                              \
+    CheckNTErrors(inputNum == 1, "Wrong number of the input tensors!");        \
+    _funcName(inputs[0], output);                                              \
+}
+
+UNARY_FORWARD(ForwardAbsolute, _Absolute)
+UNARY_FORWARD(ForwardCeil, _Ceil)
+UNARY_FORWARD(ForwardExp, _Exp)
+UNARY_FORWARD(ForwardFloor, _Floor)
+UNARY_FORWARD(ForwardIsNonZero, _IsNonZero)
+UNARY_FORWARD(ForwardIsZero, _IsZero)
+UNARY_FORWARD(ForwardLog, _Log)
+UNARY_FORWARD(ForwardSqrt, _Sqrt)
+UNARY_FORWARD(ForwardSquare, _Square)
+UNARY_FORWARD(ForwardSin, _Sin)
+UNARY_FORWARD(ForwardCos, _Cos)
+UNARY_FORWARD(ForwardTan, _Tan)
+UNARY_FORWARD(ForwardRound, _Round)
+UNARY_FORWARD(ForwardNegate, _Negate)
+UNARY_FORWARD(ForwardSign, _Sign)
+UNARY_FORWARD(ForwardHardTanH, _HardTanH)
+UNARY_FORWARD(ForwardIdentity, _Identity)
+UNARY_FORWARD(ForwardRectify, _Rectify)
+UNARY_FORWARD(ForwardSigmoid, _Sigmoid)
+
+/* forward kernels of softmax and log-softmax. params[0] is the leading
+   dimension (the last dimension by default) */
+#define SOFTMAX_FORWARD(forwardName, _funcName)                                \
+static                                                                         \
+void forwardName(const XTensor ** inputs, int inputNum, XTensor * output,      \
+                 const DTYPE * params, int paramNum)                           \
+{                                                                              \
+    CheckNTErrors(inputNum == 1, "Wrong number of the input tensors!");        \
+    int leadDim = paramNum > 0 ? (int)params[0] : inputs[0]->order - 1;        \
+    _funcName(inputs[0], output, leadDim);                                     \
+}
+
+SOFTMAX_FORWARD(ForwardSoftmax, _Softmax)
+SOFTMAX_FORWARD(ForwardLogSoftmax, _LogSoftmax)
+
+/* forward kernel of c = a + b * \beta. params[0] is \beta (1 by default) */
+static
+void ForwardSum(const XTensor ** inputs, int inputNum, XTensor * output,
+                const DTYPE * params, int paramNum)
+{
+    CheckNTErrors(inputNum == 2, "Wrong number of the input tensors!");
+    _Sum(inputs[0], inputs[1], output, paramNum > 0 ? params[0] : (DTYPE)1.0);
+}
+
+/* forward kernel of c = a * b + c * \alpha. params[0] is \alpha (0 by default) */
+static
+void ForwardMultiply(const XTensor ** inputs, int inputNum, XTensor * output,
+                     const DTYPE * params, int paramNum)
+{
+    CheckNTErrors(inputNum == 2, "Wrong number of the input tensors!");
+    _Multiply(inputs[0], inputs[1], output, paramNum > 0 ? params[0] : 0);
+}
+
+/* the built-in operator */
+struct XOperatorDef
+{
+    int id;
+    const char * name;
+    OP_COST cost;
+    bool inPlace;
+    OP_FORWARD forward;
+};
+
+/* the built-in operators. The forward kernels are given for the operators
+   of the uniform form only, and the others are run by their own functions
+   (e.g., _MatrixMul) */
+static const XOperatorDef builtinOPs[] = {
+    {MATH_ABSOLUTE,           "M_ABSOLUTE",          CostElementwise, true,  ForwardAbsolute},
+    {MATH_CEIL,               "M_CEIL",              CostElementwise, true,  ForwardCeil},
+    {MATH_EXP,                "M_EXP",               CostElementwise, true,  ForwardExp},
+    {MATH_FLOOR,              "M_FLOOR",             CostElementwise, true,  ForwardFloor},
+    {MATH_ISNONZERO,          "M_ISNONZERO",         CostElementwise, true,  ForwardIsNonZero},
+    {MATH_ISZERO,             "M_ISZERO",            CostElementwise, true,  ForwardIsZero},
+    {MATH_LOG,                "M_LOG",               CostElementwise, true,  ForwardLog},
+    {MATH_SQRT,               "M_SQRT",              CostElementwise, true,  ForwardSqrt},
+    {MATH_SQUARE,             "M_SQUARE",            CostElementwise, true,  ForwardSquare},
+    {MATH_SIN,                "M_SIN",               CostElementwise, true,  ForwardSin},
+    {MATH_COS,                "M_COS",               CostElementwise, true,  ForwardCos},
+    {MATH_TAN,                "M_TAN",               CostElementwise, true,  ForwardTan},
+    {MATH_ROUND,              "M_ROUND",             CostElementwise, true,  ForwardRound},
+    {MATH_CLIP,               "M_CLIP",              CostElementwise, true,  NULL},
+    {MATH_DIV,                "M_DIV",               CostElementwise, true,  NULL},
+    {MATH_DIVDIM,             "M_DIVDIM",            CostElementwise, true,  NULL},
+    {MATH_MATRIXMUL,          "M_MATRIXMUL",         CostMatrixMul,   false, NULL},
+    {MATH_MATRIXMULBATCHED,   "M_MATRIXMULBATCHED",  CostMatrixMul,   false, NULL},
+    {MATH_MULTIPLY,           "M_MULTIPLY",          CostElementwise, true,  ForwardMultiply},
+    {MATH_MULTIPLYDIM,        "M_MULTIPLYDIM",       CostElementwise, true,  NULL},
+    {MATH_MULTIPLYBROADCAST,  "M_MULTIPLYBROADCAST", CostElementwise, false, NULL},
+    {MATH_NEGATE,             "M_NEGATE",            CostElementwise, true,  ForwardNegate},
+    {MATH_NORMALIZE,          "M_NORMALIZE",         CostElementwise, true,  NULL},
+    {MATH_POWER,              "M_POWER",             CostElementwise, true,  NULL},
+    {MATH_SCALEANDSHIFT,      "M_SCALEANDSHIFT",     CostElementwise, true,  NULL},
+    {MATH_MULANDSHIFT,        "M_OPERATION",         CostMatrixMul,   false, NULL},
+    {MATH_SIGN,               "M_SIGN",              CostElementwise, true,  ForwardSign},
+    {MATH_SUB,                "M_SUB",               CostElementwise, true,  NULL},
+    {MATH_SUBDIM,             "M_SUBDIM",            CostElementwise, true,  NULL},
+    {MATH_SUM,                "M_SUM",               CostElementwise, true,  ForwardSum},
+    {MATH_SUMDIM,             "M_SUMDIM",            CostElementwise, true,  NULL},
+    {MATH_SUMBROADCAST,       "M_SUMBROADCAST",      CostElementwise, false, NULL},
+    {REDUCE_REDUCEMAX,        "R_REDUCEMAX",         CostReduce,      false, NULL},
+    {REDUCE_REDUCEMEAN,       "R_REDUCEMEAN",        CostReduce,      false, NULL},
+    {REDUCE_REDUCESUM,        "R_REDUCESUM",         CostReduce,      false, NULL},
+    {REDUCE_REDUCESUMSQUARED, "R_REDUCESUMSQUARED",  CostReduce,      false, NULL},
+    {REDUCE_REDUCEVARIANCE,   "R_REDUCEVARIANCE",    CostReduce,      false, NULL},
+
+    {GETANDSET_SELECT,        "G_SELECT",            CostMovement,    false, NULL},
+    {MOVEMENT_COPYINDEXED,    "M_COPYINDEXED",       CostMovement,    false, NULL},
+    {MOVEMENT_COPYVALUES,     "M_COPYVALUES",        CostMovement,    false, NULL},
+    {MOVEMENT_GATHER,         "M_GATHER",            CostMovement,    false, NULL},
+    {SHAPE_CONCATENATE,       "S_CONCATENATE",       CostMovement,    false, NULL},
+    {SHAPE_MERGE,             "S_MERGE",             CostMovement,    false, NULL},
+    {SHAPE_MERGE_LIST,        "S_MERGE_LIST",        CostMovement,    false, NULL},
+    {SHAPE_PERMUTE,           "S_PERMUTE",           CostMovement,    false, NULL},
+    {SHAPE_RESHAPE,           "S_RESHAPE",           CostMovement,    true,  NULL},
+    {SHAPE_SPLIT,             "S_SPLIT",             CostMovement,    false, NULL},
+    {SHAPE_SPLIT_LIST,        "S_SPLIT_LIST",        CostMovement,    false, NULL},
+    {SHAPE_SQUEEZE,           "S_SQUEEZE",           CostMovement,    false, NULL},
+    {SHAPE_TRANSPOSE,         "S_TRANSPOSE",         CostMovement,    false, NULL},
+    {SHAPE_UNSQUEEZE,         "S_UNSQUEEZE",         CostMovement,    false, NULL},
+    {SORT_SORT,               "S_SORT",              CostMovement,    false, NULL},
+    {SORT_TOPK,               "S_TOPK",              CostMovement,    false, NULL},
+
+    {FUNC_DROPOUT,            "F_DROPOUT",           CostElementwise, true,  NULL},
+    {FUNC_HARDTANH,           "F_HARDTANH",          CostElementwise, true,  ForwardHardTanH},
+    {FUNC_IDENTITY,           "F_IDENTITY",          CostElementwise, true,  ForwardIdentity},
+    {FUNC_LOGSOFTMAX,         "F_LOGSOFTMAX",        CostReduce,      false, ForwardLogSoftmax},
+    {FUNC_RECTIFY,            "F_RECTIFY",           CostElementwise, true,  ForwardRectify},
+    {FUNC_SIGMOID,            "F_SIGMOID",           CostElementwise, true,  ForwardSigmoid},
+    {FUNC_SOFTMAX,            "F_SOFTMAX",           CostReduce,      false, ForwardSoftmax}
+};
+
+/* declare the built-in operators */
+void XOperatorRegistry::Init()
+{
+    if(isInited)
+        return;
+
+    isInited = true;
+
+    int num = sizeof(builtinOPs) / sizeof(XOperatorDef);
+    for(int i = 0; i < num; i++){
+        const XOperatorDef &def = builtinOPs[i];
+        Declare(def.id, def.name, def.cost, def.inPlace);
+
+        /* the kernels dispatch the job to the device themselves */
+        if(def.forward != NULL){
+            SetForward(def.id, def.forward, -1, X_FLOAT);
+            SetForward(def.id, def.forward, 0, X_FLOAT);
+        }
+    }
+}
+
+/*
+the slot of an operator id
+>> id - id of the operator
+<< return - the slot (NULL if the id is out of range)
+*/
+XOperator * XOperatorRegistry::GetSlot(int id)
+{
+    for(int i = 0; i < OP_CATEGORY_NUM; i++){
+        int base = opBases[i];
+        if(id > base && id < base + OP_SLOT_NUM)
+            return &ops[i][id - base];
+    }
+
+    return NULL;
+}
+
+/*
+get an operator
+>> id - id of the operator
+<< return - the operator (NULL if it is not declared)
+*/
+XOperator * XOperatorRegistry::Get(int id)
+{
+    if(!isInited)
+        Init();
+
+    XOperator * op = GetSlot(id);
+
+    return op != NULL && op->isDeclared ? op : NULL;
+}
+
+/*
+declare an operator with a given id. The forward kernels and the gradient
+function are kept if they have been set
+>> id - id of the operator
+>> name - name of the operator
+>> cost - the cost model (NULL if it is unknown)
+>> inPlace - indicates whether the output can be one of the inputs
+<< return - the operator
+*/
+XOperator * XOperatorRegistry::Declare(int id, const char * name, OP_COST cost, bool inPlace)
+{
+    XOperator * op = GetSlot(id);
+
+    CheckNTErrors(op != NULL, "Illegal operator id!");
+    CheckNTErrors(name != NULL && strlen(name) < MAX_OP_NAME_LENGTH, "Illegal operator name!");
+
+    op->id = id;
+    strcpy(op->name, name);
+    op->cost = cost;
+    op->inPlace = inPlace;
+    op->isDeclared = true;
+
+    return op;
+}
+
+/*
+register a custom operator, e.g., a fused operator. It is called before
+the threads start as the registry is not thread-safe
+>> name - name of the operator
+>> forward - the forward kernel (for all devices and data types)
+>> backward - the gradient function (NULL if it is not differentiable)
+>> cost - the cost model (NULL if it is unknown)
+>> inPlace - indicates whether the output can be one of the inputs
+<< return - id of the operator
+*/
+int XOperatorRegistry::Register(const char * name, OP_FORWARD forward, OP_BACKWARD backward,
+                                OP_COST cost, bool inPlace)
+{
+    if(!isInited)
+        Init();
+
+    CheckNTErrors(customNum + 1 < OP_SLOT_NUM, "Too many custom operators!");
+
+    int id = CUSTOM_BASE + (++customNum);
+    Declare(id, name, cost, inPlace);
+    SetForward(id, forward);
+    SetBackward(id, backward);
+
+    return id;
+}
+
+/*
+set the forward kernel for a device and a data type
+>> id - id of the operator
+>> forward - the forward kernel
+>> devID - the device id (< 0 means the CPU)
+>> dataType - the data type
+*/
+void XOperatorRegistry::SetForward(int id, OP_FORWARD forward, int devID, TENSOR_DATA_TYPE dataType)
+{
+    XOperator * op = Get(id);
+
+    CheckNTErrors(op != NULL, "The operator is not declared!");
+    CheckNTErrors(dataType >= 0 && dataType < OP_DTYPE_NUM, "Illegal data type!");
+
+    op->forward[devID < 0 ? 0 : 1][dataType] = forward;
+}
+
+/*
+set the forward kernel for all the devices and data types
+>> id - id of the operator
+>> forward - the forward kernel
+*/
+void XOperatorRegistry::SetForward(int id, OP_FORWARD forward)
+{
+    XOperator * op = Get(id);
+
+    CheckNTErrors(op != NULL, "The operator is not declared!");
+
+    for(int i = 0; i < OP_DEVICE_NUM; i++){
+        for(int j = 0; j < OP_DTYPE_NUM; j++)
+            op->forward[i][j] = forward;
+    }
+}
+
+/*
+set the gradient function
+>> id - id of the operator
+>> backward - the gradient function
+*/
+void XOperatorRegistry::SetBackward(int id, OP_BACKWARD backward)
+{
+    XOperator * op = Get(id);
+
+    CheckNTErrors(op != NULL, "The operator is not declared!");
+
+    op->backward = backward;
+}
+
+/*
+get the forward kernel for a device and a data type
+>> id - id of the operator
+>> devID - the device id (< 0 means the CPU)
+>> dataType - the data type
+<< return - the forward kernel (NULL if there is no kernel)
+*/
+OP_FORWARD XOperatorRegistry::GetForward(int id, int devID, TENSOR_DATA_TYPE dataType)
+{
+    XOperator * op = Get(id);
+
+    if(op == NULL || dataType < 0 || dataType >= OP_DTYPE_NUM)
+        return NULL;
+
+    return op->forward[devID < 0 ? 0 : 1][dataType];
+}
+
+/*
+get the gradient function
+>> id - id of the operator
+<< return - the gradient function (NULL if there is no function)
+*/
+OP_BACKWARD XOperatorRegistry::GetBackward(int id)
+{
+    XOperator * op = Get(id);
+
+    return op != NULL ? op->backward : NULL;
+}
+
+/*
+get the name of an operator
+>> id - id of the operator
+<< return - the name ("NULL" if the operator is not declared)
+*/
+const char * XOperatorRegistry::GetName(int id)
+{
+    XOperator * op = Get(id);
+
+    return op != NULL ? op->name : "NULL";
+}
+
+/*
+indicates whether an operator can run in place
+>> id - id of the operator
+*/
+bool XOperatorRegistry::IsInPlace(int id)
+{
+    XOperator * op = Get(id);
+
+    return op != NULL && op->inPlace;
+}
+
+/*
+compute the gradient for a node (i.e., dE/dx for the tails of the node)
+with the function that is registered for the operator of the node
+>> node - the node
+>> isEfficient - indicates whether the computation is in an efficient manner
+*/
+void XOperatorRegistry::Backward(XTensor * node, bool isEfficient)
+{
+    OP_BACKWARD backward = GetBackward(node->income.typeID);
+
+    CheckNTErrors(backward != NULL, "No gradient function is registered for the operator!");
+
+    backward(node, isEfficient);
+}
+
+/*
+the cost of generating a node
+>> node - the node
+>> flops - number of floating-point operations
+>> bytes - number of bytes that are read and written
+<< return - false if the cost is unknown
+*/
+bool XOperatorRegistry::GetCost(XTensor * node, double * flops, double * bytes)
+{
+    XOperator * op = Get(node->income.typeID);
+
+    *flops = 0;
+    *bytes = 0;
+
+    if(op == NULL || op->cost == NULL)
+        return false;
+
+    op->cost(node, flops, bytes);
+
+    return true;
+}
+
+/*
+run the forward kernel of an operator
+>> id - id of the operator
+>> inputs - the input tensors
+>> inputNum - number of the input tensors
+>> output - the output tensor
+>> params - the parameters
+>> paramNum - number of the parameters
+*/
+void _RunOperator(int id, const XTensor ** inputs, int inputNum, XTensor * output,
+                  const DTYPE * params, int paramNum)
+{
+    OP_FORWARD forward = GOPs.GetForward(id, output->devID, output->dataType);
+
+    CheckNTErrors(forward != NULL, "No forward kernel is registered for the operator!");
+
+    forward(inputs, inputNum, output, params, paramNum);
+}
+
+/*
+run the forward kernel of an operator (return an XTensor structure). The
+output is of the same shape as the first input, and the edge is kept for
+the backward computation (with the parameters in the same order)
+>> id - id of the operator
+>> inputs - the input tensors
+>> inputNum - number of the input tensors
+>> params - the parameters
+>> paramNum - number of the parameters
+<< return - the output tensor
+*/
+XTensor RunOperator(int id, const XTensor ** inputs, int inputNum,
+                    const DTYPE * params, int paramNum)
+{
+    CheckNTErrors(inputNum > 0 && inputs[0] != NULL, "No input tensor!");
+
+    XTensor output(inputs[0]);
+    output.SetTMPFlag();
+
+    /* call _RunOperator function */
+    _RunOperator(id, inputs, inputNum, &output, params, paramNum);
+
+    /* tensor connections */
+    XLink::MakeLink(inputs, inputNum, &output, id);
+    for(int i = 0; i < paramNum; i++)
+        XLink::AddParamToHead(&output, params[i]);
+
+    return output;
+}
+
+/* number of bytes of the tails and the node itself */
+static
+double GetEdgeBytes(XTensor * node)
+{
+    XLink &income = node->income;
+    double bytes = (double)node->unitNum * node->unitSize;
+
+    for(int i = 0; i < income.tailNum; i++){
+        XTensor * tail = income.tails[i];
+        if(tail != NULL)
+            bytes += (double)tail->unitNum * tail->unitSize;
+    }
+
+    return bytes;
+}
+
+/*
+cost model of the element-wise operators: an operation for each entry
+of the output
+>> node - the node
+>> flops - number of floating-point operations
+>> bytes - number of bytes that are read and written
+*/
+void CostElementwise(XTensor * node, double * flops, double * bytes)
+{
+    *flops = (double)node->unitNum;
+    *bytes = GetEdgeBytes(node);
+}
+
+/*
+cost model of the reduction operators: an operation for each entry
+of the input
+>> node - the node
+>> flops - number of floating-point operations
+>> bytes - number of bytes that are read and written
+*/
+void CostReduce(XTensor * node, double * flops, double * bytes)
+{
+    XLink &income = node->income;
+    XTensor * input = income.tailNum > 0 ? income.tails[0] : node;
+
+    *flops = (double)input->unitNum;
+    *bytes = GetEdgeBytes(node);
+}
+
+/*
+cost model of the data movement: no arithmetic operation
+>> node - the node
+>> flops - number of floating-point operations
+>> bytes - number of bytes that are read and written
+*/
+void CostMovement(XTensor * node, double * flops, double * bytes)
+{
+    *flops = 0;
+    *bytes = GetEdgeBytes(node);
+}
+
+/*
+cost model of matrix multiplication: c = a * b has 2 * |c| * k operations
+where k is the inner dimension. For c = mulandshift(x, w, b), x plays the
+role of a.
+>> node - the node
+>> flops - number of floating-point operations
+>> bytes - number of bytes that are read and written
+*/
+void CostMatrixMul(XTensor * node, double * flops, double * bytes)
+{
+    XLink &income = node->income;
+    CheckNTErrors(income.tailNum >= 2, "Wrong input tensor number for matrix multiplication!");
+
+    XTensor * a = income.tails[0];
+    MATRIX_TRANS_TYPE transA = X_NOTRANS;
+    if(income.typeID != MATH_MULANDSHIFT && income.paramNum > 0)
+        transA = income.GetParamTrans(0);
+
+    int k = transA == X_NOTRANS ? a->dimSize[a->order - 1] : a->dimSize[a->order - 2];
+
+    *flops = 2.0 * node->unitNum * k;
+    *bytes = GetEdgeBytes(node);
+}
+
+/* declare the built-in operators before main() runs */
+static bool builtinOPsInited = (GOPs.Init(), true);
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,174 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * The registry of operators. An operator (identified by the id in XName.h)
+ * declares its name, the forward kernels (for each device and data type), the
+ * gradient function, whether it can run in place and a cost model (FLOPs and
+ * bytes that are accessed). The backward computation of the network is
+ * dispatched by this table, and the other passes (e.g., fusion, profiling and
+ * scheduling) can read the metadata of the nodes from it. Users can register
+ * their own (e.g., fused) operators with ids from CUSTOM_BASE.
+ *
+ * Note that the registry is not thread-safe. Operators should be registered
+ * before the threads start, e.g., in static initializers or in main().
+ *
+ */
+
+#ifndef __XOPERATOR_H__
+#define __XOPERATOR_H__
+
+#include "XGlobal.h"
+#include "XDataType.h"
+#include "XName.h"
+#include "XTensor.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* number of the operators in a category (math, data, function and custom) */
+#define OP_SLOT_NUM 128
+
+/* number of the operator categories */
+#define OP_CATEGORY_NUM 4
+
+/* number of the device types (CPU and GPU) */
+#define OP_DEVICE_NUM 2
+
+/* number of the data types (see TENSOR_DATA_TYPE) */
+#define OP_DTYPE_NUM 5
+
+/* forward kernel: output = op(inputs; params) */
+typedef void (*OP_FORWARD)(const XTensor ** inputs, int inputNum, XTensor * output,
+                           const DTYPE * params, int paramNum);
+
+/* gradient function: it computes dE/dx for the tails of the node */
+typedef void (*OP_BACKWARD)(XTensor * node, bool isEfficient);
+
+/* cost model: number of FLOPs and bytes of generating the node */
+typedef void (*OP_COST)(XTensor * node, double * flops, double * bytes);
+
+/* an operator */
+struct XOperator
+{
+    /* id of the operator */
+    int id;
+
+    /* name of the operator */
+    char name[MAX_OP_NAME_LENGTH];
+
+    /* forward kernels (indexed by [device][data type]) */
+    OP_FORWARD forward[OP_DEVICE_NUM][OP_DTYPE_NUM];
+
+    /* gradient function */
+    OP_BACKWARD backward;
+
+    /* cost model */
+    OP_COST cost;
+
+    /* indicates whether the output can be one of the inputs */
+    bool inPlace;
+
+    /* indicates whether the operator is declared */
+    bool isDeclared;
+};
+
+/* the registry of operators */
+class XOperatorRegistry
+{
+public:
+    /* the operators (indexed by [category][id offset]) */
+    XOperator ops[OP_CATEGORY_NUM][OP_SLOT_NUM];
+
+    /* number of the custom operators */
+    int customNum;
+
+    /* indicates whether the built-in operators are declared */
+    bool isInited;
+
+    /* NOTE: there is no constructor. The registry is a global object that
+       is zero-initialized before any static initializer runs, so that it is
+       safe to register operators in the static initializers of other files */
+
+public:
+    /* declare the built-in operators */
+    void Init();
+
+    /* get an operator */
+    XOperator * Get(int id);
+
+    /* declare an operator with a given id */
+    XOperator * Declare(int id, const char * name, OP_COST cost, bool inPlace);
+
+    /* register a custom operator (a new id is assigned) */
+    int Register(const char * name, OP_FORWARD forward, OP_BACKWARD backward,
+                 OP_COST cost, bool inPlace);
+
+    /* set the forward kernel for a device and a data type */
+    void SetForward(int id, OP_FORWARD forward, int devID, TENSOR_DATA_TYPE dataType);
+
+    /* set the forward kernel for all the devices and data types */
+    void SetForward(int id, OP_FORWARD forward);
+
+    /* set the gradient function */
+    void SetBackward(int id, OP_BACKWARD backward);
+
+    /* get the forward kernel for a device and a data type */
+    OP_FORWARD GetForward(int id, int devID, TENSOR_DATA_TYPE dataType);
+
+    /* get the gradient function */
+    OP_BACKWARD GetBackward(int id);
+
+    /* get the name of an operator */
+    const char * GetName(int id);
+
+    /* indicates whether an operator can run in place */
+    bool IsInPlace(int id);
+
+    /* compute the gradient for a node with the registered function */
+    void Backward(XTensor * node, bool isEfficient);
+
+    /* the cost of generating a node */
+    bool GetCost(XTensor * node, double * flops, double * bytes);
+
+protected:
+    /* the slot of an operator id */
+    XOperator * GetSlot(int id);
+};
+
+/* the operators */
+extern XOperatorRegistry GOPs;
+
+/* run the forward kernel of an operator */
+void _RunOperator(int id, const XTensor ** inputs, int inputNum, XTensor * output,
+                  const DTYPE * params = NULL, int paramNum = 0);
+
+/* run the forward kernel of an operator (return an XTensor structure). The
+   output is of the same shape as the first input, and the edge is kept for
+   the backward computation */
+XTensor RunOperator(int id, const XTensor ** inputs, int inputNum,
+                    const DTYPE * params = NULL, int paramNum = 0);
+
+/* cost models of the built-in operators */
+void CostElementwise(XTensor * node, double * flops, double * bytes);
+void CostReduce(XTensor * node, double * flops, double * bytes);
+void CostMovement(XTensor * node, double * flops, double * bytes);
+void CostMatrixMul(XTensor * node, double * flops, double * bytes);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XOPERATOR_H__
@@ -26,6 +26,7 @@
 #include <string.h>
 #include "XPRunner.h"
 #include "XGlobal.h"
+#include "XNuma.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
 namespace nts{
@@ -57,6 +58,7 @@ XPRunner::XPRunner()
     isMultiThreaded = true;
     availableThreadNum = 0;
     runningThreadNum = 0;
+    isPinned = false;
     runningThreads = new int[MAX_THREAD_NUM];
     memset(runningThreads, 0 ,sizeof(int) * MAX_THREAD_NUM);
     runningStates = new int[MAX_THREAD_NUM];
@@ -140,6 +142,22 @@ void XPRunner::KillThreads()
 }
 
 
+/* 
+pin the threads to cpus. Thread i is placed on the i-th cpu in the
+order of the NUMA nodes, so that neighbouring jobs run on the same node.
+*/
+void XPRunner::PinThreads()
+{
+    GNuma.Init();
+
+    for(int i = 0; i < threadNum; i++){
+        if(!GNuma.BindThread(threads[i].hnd, GNuma.GetThreadCPU(i)))
+            XPRINT1(1, stderr, "[XPRunner::PinThreads] Warning! cannot pin thread %d\n", i);
+    }
+
+    isPinned = true;
+}
+
 /* 
 run a set of jobs in parallel 
 >> jobFunctions - the function for each job
@@ -190,7 +208,21 @@ void XPRunner::Run(XList * jobFunctions, XList * jobArgs, float sleepTime)
         }
 
         /* assign the jobs */
-        for(int i = availableThreadNum - 1; i >= 0 && c > 0; i--){
+        while(availableThreadNum > 0 && c > 0){
+            int i = availableThreadNum - 1;
+
+            /* a pinned runner waits for the thread of the job */
+            if(isPinned){
+                int t = (jobArgs->count - c) % threadNum;
+                int k = i;
+                while(k >= 0 && availableThreads[k] != t)
+                    k--;
+                if(k < 0)
+                    break;
+                availableThreads[k] = availableThreads[i];
+                availableThreads[i] = t;
+            }
+
             /* the function to run*/
             TFunction function = (TFunction)jobFunctions->GetItem(jobArgs->count - c);
 
@@ -239,7 +271,7 @@ void XPRunner::Run(XList * jobFunctions, XList * jobArgs, float sleepTime)
 #ifdef _WIN32
             Sleep((DWORD)sleepTime);
 #else
-            sleep(sleepTime/1000);
+            usleep((unsigned int)(sleepTime * 1000));
 #endif
         }
     }
@@ -258,4 +290,36 @@ int XPRunner::GetJobNum(int size)
     return MIN(jobNum, threadNum);
 }
 
+/* 
+create the global runner, i.e., the threads that the operators use when no
+runner is given (e.g., block copy, top-k and the update of the optimizer).
+Nothing is created for a single thread, and a global runner that is already 
+there (e.g., of the benchmark) is kept.
+>> threadNum - number of the threads
+>> isPinned - pin the threads to the cpus node by node, so that the memory 
+              spread over them (see NUMA_NODE_SPREAD) stays on their nodes
+<< return - indicates whether the runner is created (and should be deleted 
+            by the caller with FreeGlobalPRunner)
+*/
+bool InitGlobalPRunner(int threadNum, bool isPinned)
+{
+    if(threadNum <= 1 || globalPRunner != NULL)
+        return false;
+
+    globalPRunner = new XPRunner();
+    globalPRunner->Init(MIN(threadNum, MAX_THREAD_NUM));
+
+    if(isPinned)
+        globalPRunner->PinThreads();
+
+    return true;
+}
+
+/* delete the global runner */
+void FreeGlobalPRunner()
+{
+    delete globalPRunner;
+    globalPRunner = NULL;
+}
+
 } /* end of the nts (NiuTrans.Tensor) namespace */
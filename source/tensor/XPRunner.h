@@ -86,6 +86,10 @@ public:
     /* number of available threads */
     int availableThreadNum;
 
+    /* indicates whether the threads are pinned to cpus. If so, job i
+       of a run always goes to thread i (mod the number of threads) */
+    bool isPinned;
+
 /* general methods */
 public:
     /* constructor */
@@ -105,6 +109,9 @@ public:
     /* kill all running threads in the pool */
     void KillThreads();
 
+    /* pin the threads to cpus (node by node) */
+    void PinThreads();
+
     /* run a set of jobs in parallel */
     void Run(XList * jobFunctions, XList * jobArgs, float sleepTime = 0);
 
@@ -114,6 +121,12 @@ public:
 
 extern XPRunner * globalPRunner;
 
+/* create the global runner (and pin its threads to the cpus node by node) */
+bool InitGlobalPRunner(int threadNum, bool isPinned = false);
+
+/* delete the global runner */
+void FreeGlobalPRunner();
+
 } /* end of the nts (NiuTrans.Tensor) namespace */
 
 #endif
\ No newline at end of file
@@ -52,112 +52,420 @@ JobQueueNode::~JobQueueNode()
 }
 
 /**************************************
-This class provides standard utilities of Queue.
+a bounded lock-free queue on a ring buffer
 */
 
-/* constuctor */
-XQueue::XQueue(int mySize)
+/* 
+constructor 
+>> mySize - capacity of the queue (rounded up to a power of 2)
+*/
+XRingQueue::XRingQueue(int mySize)
 {
-    queue = new void*[mySize];
+    CheckNTErrors(mySize > 0, "Illegal queue size!");
 
-    memset(queue, 0, sizeof(void*) * mySize);
+    size = 1;
+    while(size < mySize)
+        size <<= 1;
+    mask = size - 1;
+
+    cells = new XRingCell[size];
+    for(long long i = 0; i < size; i++){
+        cells[i].seq = i;
+        cells[i].item = NULL;
+    }
 
-    size = mySize;
-    itemCount = 0;
     head = 0;
     tail = 0;
+    spinNum = MIN_QUEUE_SPIN_NUM * 8;
+    emptyWaiterNum = 0;
+    fullWaiterNum = 0;
+
+    MUTEX_INIT(parkMutex);
+    COND_INIT(notEmptyCond);
+    COND_INIT(notFullCond);
+}
+
+/* de-constructor */
+XRingQueue::~XRingQueue()
+{
+    delete[] cells;
+
+    MUTEX_DELE(parkMutex);
+    COND_DELE(notEmptyCond);
+    COND_DELE(notFullCond);
+}
+
+/* 
+put an item in the tail of the queue if there is room
+>> item - the item
+<< return - false if the queue is full
+*/
+bool XRingQueue::TryEnqueue(void * item)
+{
+    return TryEnqueueBatch(&item, 1) == 1;
+}
+
+/* 
+fetch an item from the head of the queue if there is one
+>> item - the item we fetch
+<< return - false if the queue is empty
+*/
+bool XRingQueue::TryDequeue(void ** item)
+{
+    return TryDequeueBatch(item, 1) == 1;
+}
+
+/* 
+put up to n items in the queue if there is room. The free cells from the
+tail on are claimed by a single CAS, so the items are kept in order.
+>> items - the items
+>> n - number of the items
+<< return - number of the items that are put in the queue
+*/
+int XRingQueue::TryEnqueueBatch(void ** items, int n)
+{
+    long long pos = 0;
+    int num = 0;
+
+    while(n > 0){
+        pos = ATOMIC_LOAD(tail);
+
+        /* a cell is free for position "pos" when its sequence number is "pos" */
+        for(num = 0; num < n; num++){
+            if(ATOMIC_LOAD(cells[(pos + num) & mask].seq) != pos + num)
+                break;
+        }
+
+        if(num == 0){
+            /* the queue is full, or other producers have moved on */
+            if(ATOMIC_LOAD(cells[pos & mask].seq) - pos < 0)
+                return 0;
+            continue;
+        }
+
+        if(ATOMIC_CAS(tail, pos, pos + num))
+            break;
+    }
+
+    for(int i = 0; i < num; i++){
+        XRingCell * cell = cells + ((pos + i) & mask);
+        cell->item = items[i];
+        ATOMIC_STORE(cell->seq, pos + i + 1);
+    }
+
+    if(num > 0)
+        Wake(&emptyWaiterNum, &notEmptyCond, num);
+
+    return num;
+}
+
+/* 
+fetch up to n items from the queue
+>> items - the items we fetch
+>> n - the maximum number of the items
+<< return - number of the items that we fetch
+*/
+int XRingQueue::TryDequeueBatch(void ** items, int n)
+{
+    long long pos = 0;
+    int num = 0;
+
+    while(n > 0){
+        pos = ATOMIC_LOAD(head);
+
+        /* a cell is filled for position "pos" when its sequence number is "pos + 1" */
+        for(num = 0; num < n; num++){
+            if(ATOMIC_LOAD(cells[(pos + num) & mask].seq) != pos + num + 1)
+                break;
+        }
+
+        if(num == 0){
+            /* the queue is empty, or other consumers have moved on */
+            if(ATOMIC_LOAD(cells[pos & mask].seq) - (pos + 1) < 0)
+                return 0;
+            continue;
+        }
+
+        if(ATOMIC_CAS(head, pos, pos + num))
+            break;
+    }
+
+    for(int i = 0; i < num; i++){
+        XRingCell * cell = cells + ((pos + i) & mask);
+        items[i] = cell->item;
+
+        /* the cell is free for the next round */
+        ATOMIC_STORE(cell->seq, pos + i + size);
+    }
+
+    if(num > 0)
+        Wake(&fullWaiterNum, &notFullCond, num);
+
+    return num;
+}
+
+/* 
+put an item in the queue. We wait if the queue is full.
+>> item - the item
+*/
+void XRingQueue::Enqueue(void * item)
+{
+    for(int round = 0; !TryEnqueue(item); round++)
+        Wait(false, round);
+}
+
+/* 
+fetch an item from the queue. We wait if the queue is empty.
+<< return - the item
+*/
+void * XRingQueue::Dequeue()
+{
+    void * item = NULL;
+
+    for(int round = 0; !TryDequeue(&item); round++)
+        Wait(true, round);
+
+    return item;
+}
+
+/* 
+put n items in the queue. We wait if the queue is full.
+>> items - the items
+>> n - number of the items
+*/
+void XRingQueue::EnqueueBatch(void ** items, int n)
+{
+    int num = TryEnqueueBatch(items, n);
+
+    for(int round = 0; num < n; round++){
+        Wait(false, round);
+        num += TryEnqueueBatch(items + num, n - num);
+    }
+}
+
+/* 
+fetch 1 to n items from the queue. We wait if the queue is empty.
+>> items - the items we fetch
+>> n - the maximum number of the items
+<< return - number of the items that we fetch
+*/
+int XRingQueue::DequeueBatch(void ** items, int n)
+{
+    int num = 0;
+
+    for(int round = 0; n > 0 && (num = TryDequeueBatch(items, n)) == 0; round++)
+        Wait(true, round);
+
+    return num;
+}
+
+/* number of items in the queue */
+int XRingQueue::GetItemNum()
+{
+    long long num = ATOMIC_LOAD(tail) - ATOMIC_LOAD(head);
+    return (int)MIN(MAX(num, 0), size);
+}
+
+/* return if the queue is empty */
+bool XRingQueue::IsEmpty()
+{
+    return GetItemNum() == 0;
+}
+
+/* get the capacity */
+int XRingQueue::GetSize()
+{
+    return (int)size;
+}
+
+/* 
+check whether a try would succeed, i.e., the queue is not empty (for
+a consumer) or not full (for a producer)
+>> toDequeue - indicates whether we are a consumer
+*/
+bool XRingQueue::IsReady(bool toDequeue)
+{
+    long long pos = toDequeue ? ATOMIC_LOAD(head) : ATOMIC_LOAD(tail);
+    long long seq = ATOMIC_LOAD(cells[pos & mask].seq);
+
+    return toDequeue ? seq - (pos + 1) >= 0 : seq - pos >= 0;
+}
+
+/* 
+wait after a failed try. We spin first (only for the first round of a
+call) and park the thread if spinning is not enough.
+>> toDequeue - indicates whether we are a consumer
+>> round - how many times we have waited in the call
+*/
+void XRingQueue::Wait(bool toDequeue, int round)
+{
+    if(round == 0){
+        int num = spinNum;
+        for(int i = 0; i < num; i++){
+            CPU_RELAX();
+            if(IsReady(toDequeue)){
+                AdaptSpin(true);
+                return;
+            }
+        }
+        AdaptSpin(false);
+    }
+
+    if(toDequeue)
+        Park(&emptyWaiterNum, &notEmptyCond, true);
+    else
+        Park(&fullWaiterNum, &notFullCond, false);
+}
+
+/* 
+wake up parked threads
+>> waiterNum - number of the threads that are parked
+>> cond - the condition they wait for
+>> n - the maximum number of the threads we wake up
+*/
+void XRingQueue::Wake(long long * waiterNum, COND_HANDLE * cond, int n)
+{
+    /* pairs with the counting in Park(): either we see the parked
+       thread or it sees the cells we have just published */
+    ATOMIC_FENCE();
+
+    if(ATOMIC_LOAD(*waiterNum) == 0)
+        return;
+
+    MUTEX_LOCK(parkMutex);
+
+    long long num = MIN(ATOMIC_LOAD(*waiterNum), (long long)n);
+    for(long long i = 0; i < num; i++)
+        COND_SIGNAL(*cond);
+
+    MUTEX_UNLOCK(parkMutex);
+}
+
+/* 
+park the thread until the queue is not empty (or not full)
+>> waiterNum - number of the threads that are parked
+>> cond - the condition to wait for
+>> toDequeue - indicates whether we are a consumer
+*/
+void XRingQueue::Park(long long * waiterNum, COND_HANDLE * cond, bool toDequeue)
+{
+    MUTEX_LOCK(parkMutex);
+
+    ATOMIC_ADD(*waiterNum, 1);
+
+    /* check again after we are counted, so that a wake-up between
+       the failed try and the wait is not lost */
+    if(!IsReady(toDequeue)){
+#ifdef  WIN32
+        MUTEX_UNLOCK(parkMutex);
+#endif
+        COND_WAIT(*cond, parkMutex);
+#ifdef  WIN32
+        MUTEX_LOCK(parkMutex);
+#endif
+    }
+
+    ATOMIC_ADD(*waiterNum, -1);
+
+    MUTEX_UNLOCK(parkMutex);
+}
+
+/* 
+update the number of spins: we spin longer if spinning was enough
+last time and shorter if it was not. It is a hint, so races are fine.
+>> isSpinEnough - indicates whether spinning was enough
+*/
+void XRingQueue::AdaptSpin(bool isSpinEnough)
+{
+    if(isSpinEnough)
+        spinNum = MIN(spinNum * 2, MAX_QUEUE_SPIN_NUM);
+    else
+        spinNum = MAX(spinNum / 2, MIN_QUEUE_SPIN_NUM);
+}
+
+/**************************************
+This class provides standard utilities of Queue.
+*/
+
+/* constuctor */
+XQueue::XQueue(int mySize)
+{
+    queue = new XRingQueue(mySize);
+
+    size = queue->GetSize();
     isJobQueue = false;
+    jobDequeuers = NULL;
+    jobDequeuerNum = 0;
     jobDequeuerArgs = new XList(1);
     jobDequeuerBreak = false;
     runningJobCount = 0;
     jobStream = NULL;
     jobStream1 = NULL;
     jobStream2 = NULL;
-    
-    MUTEX_INIT(enqueueMutex);
-    MUTEX_INIT(dequeueMutex);
-    COND_INIT(queueCond);
-    MUTEX_INIT(jobQueueMutex);
 }
 
 /* deconstructor */
 XQueue::~XQueue()
 {
-    delete[] queue;
+    if(jobDequeuers != NULL)
+        StopJobConsumer();
+
+    delete queue;
     delete jobDequeuerArgs;
     delete jobStream;
     delete jobStream1;
     delete jobStream2;
-
-    //if(isJobQueue)
-    //    StopJobConsumer();
-
-    MUTEX_DELE(enqueueMutex);
-    MUTEX_DELE(dequeueMutex);
-    COND_DELE(queueCond);
-    MUTEX_DELE(jobQueueMutex);
 }
 
 /* 
-put an item in the tail of the queue 
+put an item in the tail of the queue. We wait if the queue is full.
 >> item - the item we intend to add into the queue
 */
 void XQueue::Enqueue(void * item)
 {
-
-    MUTEX_LOCK(enqueueMutex);
-    MUTEX_LOCK(dequeueMutex);
-
-    CheckNTErrors((itemCount < size), "Put too many items into the queue!");
-
-    queue[tail] = item;
-    tail = (tail + 1) % size;
-    itemCount++;
-    
-    COND_SIGNAL(queueCond);
-
-    MUTEX_UNLOCK(dequeueMutex);
-    MUTEX_UNLOCK(enqueueMutex);
+    queue->Enqueue(item);
 }
 
 /* 
-fetch an item from head of the queue 
+fetch an item from head of the queue. We wait if the queue is empty.
 << return - the head item of the queue
 */
 void * XQueue::Dequeue()
 {
-    MUTEX_LOCK(dequeueMutex);
-
-    while(itemCount == 0)
-    {
-#ifdef  WIN32
-        MUTEX_UNLOCK(dequeueMutex);
-#endif
-        COND_WAIT(queueCond, dequeueMutex);
-#ifdef  WIN32
-        MUTEX_LOCK(dequeueMutex);
-#endif
-    }
-
-    void * r = queue[head];
-    head = (head + 1) % size;
-    itemCount--;
+    return queue->Dequeue();
+}
 
-    MUTEX_UNLOCK(dequeueMutex);
+/* 
+put a number of items in the queue (in order)
+>> items - the items
+>> n - number of the items
+*/
+void XQueue::EnqueueBatch(void ** items, int n)
+{
+    queue->EnqueueBatch(items, n);
+}
 
-    return r;
+/* 
+fetch 1 to n items from the queue
+>> items - the items we fetch
+>> n - the maximum number of the items
+<< return - number of the items that we fetch
+*/
+int XQueue::DequeueBatch(void ** items, int n)
+{
+    return queue->DequeueBatch(items, n);
 }
 
 /* return if the queue is empty */
 bool XQueue::IsEmpty()
 {
-    return itemCount == 0;
+    return queue->IsEmpty();
 }
 
 /* wait until the queue is empty */
 void XQueue::WaitForEmptyJobQueue()
 {
-    while(runningJobCount > 0){
+    while(ATOMIC_LOAD(runningJobCount) > 0){
         XSleep(10);
     }
 
@@ -179,43 +487,65 @@ int devids[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
 int cpuid = -1;
 
 /* 
-run job consumer (in another thread) 
+run job consumers (in other threads). The consumers share the queue,
+so the jobs run in parallel if there are more than one of them.
 >> jobDevID - id of the device for running the jobs
+>> consumerNum - number of the consumers
 */
-void XQueue::RunJobConsumer(int jobDevID)
+void XQueue::RunJobConsumer(int jobDevID, int consumerNum)
 {
     CheckNTErrors((jobDevID < 16), "device id is out of scope!");
+    CheckNTErrors((consumerNum > 0), "Illegal number of job consumers!");
+    CheckNTErrors((jobDequeuers == NULL), "The job consumers are running!");
 
     isJobQueue = true;
+    jobDequeuerBreak = false;
     jobDequeuerArgs->Clear();
     jobDequeuerArgs->Add(this);
     jobDequeuerArgs->Add(jobDevID >= 0 ? devids + jobDevID : &cpuid);
 
-    jobDequeuer.function = (TFunction)DequeueJobs;
-    jobDequeuer.argv = jobDequeuerArgs;
+    jobDequeuerNum = consumerNum;
+    jobDequeuers = new XThread[consumerNum];
 
-    jobDequeuer.Start();
-    jobDequeuer.LetItGo();
+    for(int i = 0; i < consumerNum; i++){
+        jobDequeuers[i].function = (TFunction)DequeueJobs;
+        jobDequeuers[i].argv = jobDequeuerArgs;
+        jobDequeuers[i].Start();
+        jobDequeuers[i].LetItGo();
+    }
 }
 
-/* stop the job consumer */
+/* stop the job consumers. The jobs in the queue are done before they stop. */
 void XQueue::StopJobConsumer()
 {
+    if(jobDequeuers == NULL)
+        return;
+
     jobDequeuerBreak = true;
-    XSleep(10);
 
-    EnqueueJob(NULL, NULL);
+    /* an empty item for each consumer to stop */
+    for(int i = 0; i < jobDequeuerNum; i++)
+        Enqueue(NULL);
+
+    for(int i = 0; i < jobDequeuerNum; i++)
+        jobDequeuers[i].End();
 
-    jobDequeuer.End();
+    delete[] jobDequeuers;
+    jobDequeuers = NULL;
+    jobDequeuerNum = 0;
     isJobQueue = false;
 }
 
-/* add a job item to process */
+/* 
+add a job item to process
+>> job - the job function
+>> jobArgs - arguments of the job
+*/
 void XQueue::EnqueueJob(void * job, XList * jobArgs)
 {
-    MUTEX_LOCK(jobQueueMutex);
-    runningJobCount++;
-    MUTEX_UNLOCK(jobQueueMutex);
+    CheckNTErrors((job != NULL), "Illegal job!");
+
+    ATOMIC_ADD(runningJobCount, 1);
 
     JobQueueNode * node = new JobQueueNode();
     node->job = job;
@@ -232,28 +562,28 @@ void XQueue::DequeueJobs(XList * args)
     XQueue * q = (XQueue*)args->GetItem(0);
     int devID = *(int*)args->GetItem(1);
 
-    int devIDBackup = XDevice::GetGPUDevice();
+    int devIDBackup = -1;
 
-    if(devID >= 0)
+    if(devID >= 0){
+        devIDBackup = XDevice::GetGPUDevice();
         XDevice::SetGPUDevice(devID);
+    }
 
     while(1){
         JobQueueNode * node = (JobQueueNode*)q->Dequeue();
 
-        if(q->GetJobBreak())
+        /* an empty item tells the consumer to stop */
+        if(node == NULL){
+            CheckNTErrors((q->GetJobBreak()), "Illegal job!");
             break;
-
-        CheckNTErrors((node != NULL), "Illegal job!");
+        }
 
         /* process a job */
         ((TFunction)node->job)(node->args);
 
         delete node;
 
-        MUTEX_LOCK(q->jobQueueMutex);
-        q->runningJobCount--;
-        MUTEX_UNLOCK(q->jobQueueMutex);
-
+        ATOMIC_ADD(q->runningJobCount, -1);
     }
 
     if(devID >= 0)
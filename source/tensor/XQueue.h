@@ -42,6 +42,134 @@ namespace nts{
 
 #define MAX_QUEUE_SIZE 1024 * 8
 
+/* bounds of the number of spins before a thread is parked */
+#define MIN_QUEUE_SPIN_NUM 16
+#define MAX_QUEUE_SPIN_NUM 1024 * 4
+
+/* size of a cache line (to keep the producers and consumers apart) */
+#define QUEUE_CACHE_LINE_SIZE 64
+
+/*
+a cell of the ring buffer. "seq" is the position the cell waits for: it is
+equal to the position when the cell is free, and to the position plus 1 when
+the cell is filled and can be consumed.
+*/
+struct XRingCell
+{
+    /* sequence number */
+    long long seq;
+
+    /* the item */
+    void * item;
+};
+
+/*
+A bounded multi-producer/multi-consumer queue on a ring buffer. A producer
+(consumer) claims a position by a CAS on the tail (head) and publishes the
+cell by its sequence number, so no lock is taken as long as the queue is
+neither full nor empty. A blocking call spins for a while and then parks
+the thread on a condition variable. The number of spins adapts to how
+often spinning is enough.
+*/
+class XRingQueue
+{
+private:
+    /* the cells */
+    XRingCell * cells;
+
+    /* size of the ring (a power of 2) */
+    long long size;
+
+    /* size - 1 */
+    long long mask;
+
+    char pad0[QUEUE_CACHE_LINE_SIZE];
+
+    /* the next position to enqueue */
+    long long tail;
+
+    char pad1[QUEUE_CACHE_LINE_SIZE];
+
+    /* the next position to dequeue */
+    long long head;
+
+    char pad2[QUEUE_CACHE_LINE_SIZE];
+
+    /* number of spins before a thread is parked */
+    int spinNum;
+
+    /* number of consumers that are parked */
+    long long emptyWaiterNum;
+
+    /* number of producers that are parked */
+    long long fullWaiterNum;
+
+    /* mutex for parking */
+    MUTEX_HANDLE parkMutex;
+
+    /* parked consumers wait for this */
+    COND_HANDLE notEmptyCond;
+
+    /* parked producers wait for this */
+    COND_HANDLE notFullCond;
+
+public:
+    /* constructor */
+    XRingQueue(int mySize = MAX_QUEUE_SIZE);
+
+    /* de-constructor */
+    ~XRingQueue();
+
+    /* put an item in the tail of the queue if there is room */
+    bool TryEnqueue(void * item);
+
+    /* fetch an item from the head of the queue if there is one */
+    bool TryDequeue(void ** item);
+
+    /* put up to n items in the queue if there is room */
+    int TryEnqueueBatch(void ** items, int n);
+
+    /* fetch up to n items from the queue */
+    int TryDequeueBatch(void ** items, int n);
+
+    /* put an item in the queue (wait if it is full) */
+    void Enqueue(void * item);
+
+    /* fetch an item from the queue (wait if it is empty) */
+    void * Dequeue();
+
+    /* put n items in the queue (wait if it is full) */
+    void EnqueueBatch(void ** items, int n);
+
+    /* fetch 1 to n items from the queue (wait if it is empty) */
+    int DequeueBatch(void ** items, int n);
+
+    /* number of items in the queue */
+    int GetItemNum();
+
+    /* return if the queue is empty */
+    bool IsEmpty();
+
+    /* get the capacity */
+    int GetSize();
+
+protected:
+    /* check whether a try would succeed */
+    bool IsReady(bool toDequeue);
+
+    /* wait after a failed try */
+    void Wait(bool toDequeue, int round);
+
+    /* wake up parked threads */
+    void Wake(long long * waiterNum, COND_HANDLE * cond, int n);
+
+    /* park the thread until the queue is not empty or not full */
+    void Park(long long * waiterNum, COND_HANDLE * cond, bool toDequeue);
+
+    /* update the number of spins */
+    void AdaptSpin(bool isSpinEnough);
+};
+
 /*
 job item used in queues
 */
@@ -63,43 +191,27 @@ public:
 };
 
 /*
-This class provides standard utilities of Queue.
+This class provides standard utilities of Queue. The items are kept
+in a lock-free ring buffer, and the jobs of a job queue are consumed by
+a pool of threads.
 */
 class XQueue
 {
 private:
-    /* mutex for the enqueue process */
-    MUTEX_HANDLE enqueueMutex;
-
-    /* mutex for the dequeue process */
-    MUTEX_HANDLE dequeueMutex;
-
-    /* conditional mutex for the dequeue process */
-    COND_HANDLE  queueCond;
-
-    /* mutex for the job queue */
-    MUTEX_HANDLE jobQueueMutex;
-
-    /* the array for the queue */
-    void ** queue;
+    /* the ring buffer for the queue */
+    XRingQueue * queue;
 
     /* max size of the queue */
     int size;
 
-    /* number of item in queue */
-    int itemCount;
-
-    /* head of the queue */
-    int head;
-
-    /* tail of the queue */
-    int tail;
-
     /* indicates whether we are using a job queue */
     bool isJobQueue;
 
-    /* consume the job items in the queue */
-    XThread jobDequeuer;
+    /* the threads that consume the job items in the queue */
+    XThread * jobDequeuers;
+
+    /* number of the job consumers */
+    int jobDequeuerNum;
 
     /* argument list of jobDequeuer */
     XList * jobDequeuerArgs;
@@ -108,7 +220,7 @@ private:
     bool jobDequeuerBreak;
 
     /* running job count */
-    int runningJobCount;
+    long long runningJobCount;
 
     /* job streams (we think that three streams is enough :)) */
     XStream * jobStream;
@@ -128,16 +240,22 @@ public:
     /* fetch an item from head of the queue */
     void * Dequeue();
 
+    /* put a number of items in the queue */
+    void EnqueueBatch(void ** items, int n);
+
+    /* fetch 1 to n items from the queue */
+    int DequeueBatch(void ** items, int n);
+
     /* return if the queue is empty */
     bool IsEmpty();
 
     /* wait until the queue is empty */
     void WaitForEmptyJobQueue();
 
-    /* run the job consumer */
-    void RunJobConsumer(int jobDevID = 0);
+    /* run the job consumers */
+    void RunJobConsumer(int jobDevID = 0, int consumerNum = 1);
 
-    /* stop the job consumer */
+    /* stop the job consumers */
     void StopJobConsumer();
 
     /* add a job item to process */
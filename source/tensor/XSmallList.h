@@ -0,0 +1,151 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A typed list with inline storage. The first N items are kept in the
+ * list itself (e.g., on the stack), and the items are moved to an array
+ * on the heap (or in a memory pool) only if the list grows beyond N.
+ * It is for the short lists that are made in every call of an operation
+ * or a step of training, e.g., the arguments of the jobs and the tensors
+ * of a split, where the allocation costs more than the work on the list.
+ *
+ */
+
+#ifndef __XSMALLLIST_H__
+#define __XSMALLLIST_H__
+
+#include <string.h>
+#include "XMem.h"
+#include "XGlobal.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* number of the arrays that are allocated by the lists (XList and XSmallList) */
+extern long long listAllocCount;
+
+/* count an array allocated by a list (thread-safe) */
+void CountListAlloc();
+
+/* a list of T that keeps at most N items in itself */
+template<typename T, int N>
+class XSmallList
+{
+public:
+    /* the items (inlineItems or an array on the heap or in the memory pool) */
+    T * items;
+
+    /* number of items */
+    int count;
+
+    /* maximum number of items can be kept in the current array */
+    int maxNum;
+
+    /* the memory pool for the array (NULL = the heap) */
+    XMem * mem;
+
+    /* the inline storage */
+    T inlineItems[N];
+
+public:
+    /* constructor */
+    XSmallList(XMem * myMem = NULL)
+    {
+        items = inlineItems;
+        count = 0;
+        maxNum = N;
+        mem = myMem;
+    }
+
+    /* constructor (the array is allocated at once if there are more than N items) */
+    XSmallList(int myMaxNum, XMem * myMem = NULL)
+    {
+        items = inlineItems;
+        count = 0;
+        maxNum = N;
+        mem = myMem;
+        Reserve(myMaxNum);
+    }
+
+    /* de-constructor */
+    ~XSmallList()
+    {
+        if(items != inlineItems && mem == NULL)
+            delete[] items;
+    }
+
+    /* make sure that num items can be kept without reallocation */
+    void Reserve(int num)
+    {
+        if(num <= maxNum)
+            return;
+
+        T * newItems;
+        if(mem == NULL)
+            newItems = new T[num];
+        else
+            newItems = (T*)mem->Alloc(mem->devID, sizeof(T) * num);
+        memcpy(newItems, items, sizeof(T) * count);
+
+        if(items != inlineItems && mem == NULL)
+            delete[] items;
+
+        items = newItems;
+        maxNum = num;
+
+        CountListAlloc();
+    }
+
+    /* set the number of items (the new items are not initialized) */
+    void Resize(int num)
+    {
+        Reserve(num);
+        count = num;
+    }
+
+    /* add an item */
+    _XINLINE_ void Add(const T &item)
+    {
+        if(count == maxNum)
+            Reserve(maxNum * 2 + 1);
+        items[count++] = item;
+    }
+
+    /* get the item at position i */
+    _XINLINE_ T &Get(int i)
+    {
+        CheckNTErrors(i >= 0 && i < count, "Index of a list item is out of scope!");
+        return items[i];
+    }
+
+    /* the item at position i (without checking) */
+    _XINLINE_ T &operator[] (int i) {return items[i];};
+    _XINLINE_ const T &operator[] (int i) const {return items[i];};
+
+    /* remove all items (the array is kept) */
+    _XINLINE_ void Clear() {count = 0;};
+
+private:
+    /* the items are not copied together with the list */
+    XSmallList(const XSmallList &list);
+    XSmallList &operator= (const XSmallList &list);
+};
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XSMALLLIST_H__
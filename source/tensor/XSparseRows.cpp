@@ -0,0 +1,85 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A set of rows of a matrix (for row-sparse gradients).
+ *
+ */
+
+#include <string.h>
+#include "XSparseRows.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* 
+constructor 
+>> myRowNum - number of rows of the matrix
+*/
+XSparseRows::XSparseRows(int myRowNum)
+{
+    CheckNTErrors(myRowNum > 0, "Illegal row number!");
+
+    rowNum = myRowNum;
+    count = 0;
+    rows = new int[rowNum];
+    marks = new bool[rowNum];
+    memset(marks, 0, sizeof(bool) * rowNum);
+}
+
+/* de-constructor */
+XSparseRows::~XSparseRows()
+{
+    delete[] rows;
+    delete[] marks;
+}
+
+/* 
+add a row 
+>> row - index of the row
+*/
+void XSparseRows::Add(int row)
+{
+    CheckNTErrors(row >= 0 && row < rowNum, "Illegal row index!");
+
+    if(!marks[row]){
+        marks[row] = true;
+        rows[count++] = row;
+    }
+}
+
+/* 
+add a number of rows 
+>> newRows - indices of the rows
+>> num - number of the rows
+*/
+void XSparseRows::Add(const int * newRows, int num)
+{
+    for(int i = 0; i < num; i++)
+        Add(newRows[i]);
+}
+
+/* clear the set */
+void XSparseRows::Clear()
+{
+    for(int i = 0; i < count; i++)
+        marks[rows[i]] = false;
+    count = 0;
+}
+
+} // namespace nts(NiuTrans.Tensor)
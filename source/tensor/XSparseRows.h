@@ -0,0 +1,69 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A set of rows of a matrix. It is used to represent row-sparse gradients,
+ * e.g., the gradient of an embedding matrix where only the rows of the
+ * words in the batch are non-zero.
+ *
+ */
+
+#ifndef __XSPARSEROWS_H__
+#define __XSPARSEROWS_H__
+
+#include "XGlobal.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* a set of row indices (without duplicates) */
+struct XSparseRows
+{
+public:
+    /* number of rows of the matrix */
+    int rowNum;
+
+    /* the rows in the set (in the order that they are added) */
+    int * rows;
+
+    /* number of rows in the set */
+    int count;
+
+    /* marks[i] = true if row i is in the set */
+    bool * marks;
+
+public:
+    /* constructor */
+    XSparseRows(int myRowNum);
+
+    /* de-constructor */
+    ~XSparseRows();
+
+    /* add a row */
+    void Add(int row);
+
+    /* add a number of rows */
+    void Add(const int * newRows, int num);
+
+    /* clear the set (the cost is proportional to the row number in the set) */
+    void Clear();
+};
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XSPARSEROWS_H__
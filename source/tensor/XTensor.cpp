@@ -68,6 +68,10 @@ int tensorIDGlobal = 0;
 MUTEX_HANDLE tensorMutex;
 XTensor NULLTensor;
 
+/* number of the deep copies of tensors (by the copy constructor and the
+   assignment of a tensor that is not going to die) */
+long long tensorCopyCount = 0;
+
 /* generate a tensor id */
 int MakeTensorID()
 {
@@ -89,7 +93,6 @@ constructor
 XTensor::XTensor()
 {
     Init();
-    SetDataPointer();
 
     id = MakeTensorID();
     isDefaultDType = true;
@@ -102,7 +105,6 @@ XTensor::XTensor()
 XTensor::XTensor(const XTensor * reference)
 {
     Init();
-    SetDataPointer();
     id = MakeTensorID();
 
     InitTensor(this, reference);
@@ -119,7 +121,6 @@ XTensor::XTensor(const int myOrder, int myDevID, XMem * myMem)
     CheckNTErrors((myOrder > 0), "Illegal tensor order1");
 
     Init();
-    SetDataPointer();
 
     id = MakeTensorID();
     order = myOrder;
@@ -140,7 +141,6 @@ XTensor::XTensor(const int myOrder, const int * myDimSize, const TENSOR_DATA_TYP
                  const float myDenseRatio, int myDevID, XMem * myMem)
 {
     Init();
-    SetDataPointer();
 
     id = MakeTensorID();
     order = myOrder;
@@ -151,42 +151,61 @@ XTensor::XTensor(const int myOrder, const int * myDimSize, const TENSOR_DATA_TYP
         Resize(myOrder, myDimSize, myDataType, myDenseRatio);
 }
 
-/* copy constructor */
+/* 
+copy constructor. It makes a hard copy of the data. A tensor that is going
+to die (e.g., the result of an operation) is moved rather than copied, 
+see the move constructor.
+*/
 XTensor::XTensor(const XTensor &reference)
 {
     Init();
-    SetDataPointer();
     id = MakeTensorID();
     ShallowCopy(reference);
     data = NULL;
     dataHost = NULL;
     
-    if(reference.isTmp){
-        devID = reference.devID;
-        mem = reference.mem;
-        data = reference.data;
-        signature = reference.signature;
-        
-        /* what we really want to do is "reference.data = NULL;"
-           As "reference" is constant, we cannot reset reference.data
-           here. So we save the ADDRESS of reference.data in
-           reference.dataP, and do this work by updating "*reference.dataP".
-           This is VERY trick and might not be the best solution :) */
-        *reference.dataP = NULL;
-    }
-    else{
-        devID = reference.devID;
-        mem = reference.mem;
-        InitTensor(this, &reference);
-        _CopyValues(&reference, this);
-    }
+    devID = reference.devID;
+    mem = reference.mem;
+    InitTensor(this, &reference);
+    _CopyValues(&reference, this);
+    ATOMIC_ADD(tensorCopyCount, 1);
 
-    if(reference.isTmp)
-        XLink::Replace(&reference, this);
-    else{
-        CheckNTErrors(outgo.tailNum == 0, "The node has outgoing edge to other nodes!");
-        XLink::CopyIncoming(&reference, this);
-    }
+    CheckNTErrors(outgo.tailNum == 0, "The node has outgoing edge to other nodes!");
+    XLink::CopyIncoming(&reference, this);
+
+    isInit = true;
+    isTmp  = false;
+}
+
+/* 
+move constructor. We take the data array and the links of the reference
+tensor (which is going to die), and leave it empty. Nothing is copied or
+allocated here.
+*/
+XTensor::XTensor(XTensor &&reference)
+{
+    Init();
+    id = MakeTensorID();
+    ShallowCopy(reference);
+
+    devID = reference.devID;
+    mem = reference.mem;
+    signature = reference.signature;
+    data = reference.data;
+    dataHost = reference.dataHost;
+    grad = reference.grad;
+    gradRows = reference.gradRows;
+    blockSparse = reference.blockSparse;
+    isGrad = reference.isGrad;
+    isVar = reference.isVar;
+
+    reference.data = NULL;
+    reference.dataHost = NULL;
+    reference.grad = NULL;
+    reference.gradRows = NULL;
+    reference.blockSparse = NULL;
+
+    XLink::Move(&reference, this);
 
     isInit = true;
     isTmp  = reference.isTmp;
@@ -219,6 +238,8 @@ XTensor::~XTensor()
 
     if(grad != NULL)
         delete grad;
+
+    delete gradRows;
 }
 
 /* initialize member variables */
@@ -229,7 +250,6 @@ void XTensor::Init()
     signature = 0;
     data = NULL;
     dataHost = NULL;
-    dataP = NULL;
     devID = -1;
     order = -1;
     memset(dimSize, 0, sizeof(int) * MAX_TENSOR_DIM_NUM);
@@ -250,12 +270,21 @@ void XTensor::Init()
     isVar  = false;
     visitMark = 0;
     grad = NULL;
+    gradRows = NULL;
+    blockSparse = NULL;
 }
 
 /* delete data arrays */
 void XTensor::DestroyData()
 {
-    if(data != NULL && mem == NULL && !isShared)
+    /* the block index is for the data array that we destroy */
+    delete blockSparse;
+    blockSparse = NULL;
+
+    if(data != NULL && isShared){
+        /* the data array is kept by others (e.g., a flat buffer of parameters) */
+    }
+    else if(data != NULL && mem == NULL)
         XMemFree(devID, data);
     else if(data != NULL && isInGlobalMem)
         FreeData(this, mem);
@@ -291,31 +320,42 @@ void XTensor::ShallowCopy(const XTensor &tensor)
     memcpy(isAllValued, tensor.isAllValued, sizeof(bool) * MAX_TENSOR_DIM_NUM);
 }
 
+/* 
+hand over the data and the place in the network of a node to a new 
+(temporary) node, so that the node can be assigned without breaking 
+the nodes that use it as an input 
+>> node - the node
+*/
+void DetachFromNetwork(XTensor * node)
+{
+    int dims[MAX_TENSOR_DIM_NUM];
+    memcpy(dims, node->dimSize, node->order * sizeof(int));
+    dims[0] = -dims[0];
+    
+    XTensor * newTensor = new XTensor(node->order, dims, node->dataType, node->denseRatio, 
+                                      node->devID, node->mem);
+    newTensor->SetTMPFlag();
+    newTensor->data = node->data;
+    newTensor->dataHost = node->dataHost;
+    newTensor->signature = node->signature;
+    
+    XLink::Replace(node, newTensor);
+    XLink::ClearOutgoing(node);
+    XLink::ClearIncoming(node);
+    newTensor->ShallowCopy(*node);
+
+    node->data = NULL;
+    node->dataHost = NULL;
+}
+
 /* overloading of the equal-sign */
 XTensor& XTensor::operator= (const XTensor& tensor)
 {
     
     /* we must make a hard copy of the tensor if it is the input
        of another node. */
-    if(outgo.tailNum > 0){
-        int dims[MAX_TENSOR_DIM_NUM];
-        memcpy(dims, dimSize, order * sizeof(int));
-        dims[0] = -dims[0];
-        
-        XTensor * newTensor = new XTensor(order, dims, dataType, denseRatio, devID, mem);
-        newTensor->SetTMPFlag();
-        newTensor->data = data;
-        newTensor->dataHost = dataHost;
-        newTensor->signature = tensor.signature;
-        
-        XLink::Replace(this, newTensor);
-        XLink::ClearOutgoing(this);
-        XLink::ClearIncoming(this);
-        newTensor->ShallowCopy(this);
-
-        data = NULL;
-        dataHost = NULL;
-    }
+    if(outgo.tailNum > 0)
+        DetachFromNetwork(this);
 
     if(false && !tensor.isTmp){
         /* NOTE: this might lead to additional data copy on Mac machines */
@@ -332,7 +372,9 @@ XTensor& XTensor::operator= (const XTensor& tensor)
         XLink::MakeLink(&tensor, NULL, this, FUNC_IDENTITY);
     }
     else{
-        /* hard copy of the data array */
+        /* hard copy of the data array (the block index is for the old values) */
+        SetBlockSparse(0, 0);
+
         int size = unitNum * unitSize;
         if( isInit && !isSparse && !tensor.isSparse &&
             size == tensor.unitNum * tensor.unitSize &&
@@ -354,6 +396,8 @@ XTensor& XTensor::operator= (const XTensor& tensor)
             _CopyValues(&tensor, this);
         }
 
+        ATOMIC_ADD(tensorCopyCount, 1);
+
         /* copy member variables */
         ShallowCopy(tensor);
 
@@ -369,6 +413,50 @@ XTensor& XTensor::operator= (const XTensor& tensor)
     return *this;
 }
 
+/* 
+overloading of the equal-sign (move assignment). The tensor on the right-hand
+side is going to die, e.g., "c = a + b", so we take its data array and its
+place in the network rather than copying them.
+*/
+XTensor& XTensor::operator= (XTensor &&tensor)
+{
+    if(this == &tensor)
+        return *this;
+
+    /* we copy the data if we cannot take the data array of the tensor, i.e.,
+       the data of this tensor is shared with others (e.g., a flat buffer of 
+       parameters), or it is kept on another device */
+    if(isShared || (isInit && devID != tensor.devID))
+        return operator=((const XTensor&)tensor);
+
+    /* we must keep the data of this tensor in a new node if it is the input
+       of another node (see the copy assignment) */
+    if(outgo.tailNum > 0)
+        DetachFromNetwork(this);
+
+    DestroyData();
+
+    ShallowCopy(tensor);
+    devID = tensor.devID;
+    mem = tensor.mem;
+    signature = tensor.signature;
+    data = tensor.data;
+    dataHost = tensor.dataHost;
+    blockSparse = tensor.blockSparse;
+
+    tensor.data = NULL;
+    tensor.dataHost = NULL;
+    tensor.blockSparse = NULL;
+
+    isInit = true;
+    isTmp  = false;
+
+    /* take the place of the tensor in the network */
+    XLink::Move(&tensor, this);
+
+    return *this;
+}
+
 /* overloading of the plus-sign */
 XTensor XTensor::operator+ (const XTensor& tensor)
 {
@@ -838,12 +926,6 @@ bool XTensor::CheckData(const void * d, int num, int beg)
     return true;
 }
     
-/* set the pointer to "data" */
-void XTensor::SetDataPointer()
-{
-    dataP = &data;
-}
-
 /* compare two number */
 bool IsFloatEqual(DTYPE a, DTYPE b, float absError, float relError)
 {
@@ -1335,6 +1417,58 @@ void XTensor::SetVarFlag(bool myIsVar)
         SetGradFlag(true);
 }
 
+/* 
+set the tensor as "keep-row-sparse-gradient". The rows that are used in
+gather are recorded in backward propagation, and the update of the tensor
+can go over these rows only. This is for matrices that are accessed by
+gather alone, such as word embeddings.
+>> myIsSparseGrad - the flag
+*/
+void XTensor::SetSparseGradFlag(bool myIsSparseGrad)
+{
+    delete gradRows;
+    gradRows = NULL;
+
+    if(myIsSparseGrad){
+        CheckNTErrors(order == 2, "Row-sparse gradients are available for matrices only!");
+        gradRows = new XSparseRows(dimSize[0]);
+    }
+}
+
+/* 
+index the non-zero blocks of a matrix, e.g., a pruned weight matrix (see 
+_PruneBlocks). Matrix multiplication then goes over these blocks only. Note 
+that the values are still read from the data array, but the index is not 
+updated when the data changes: it has to be made again if other blocks 
+become non-zero.
+>> blockRow - number of rows of a block
+>> blockCol - number of columns of a block (blockRow <= 0 or blockCol <= 0 
+              removes the index)
+*/
+void XTensor::SetBlockSparse(int blockRow, int blockCol)
+{
+    delete blockSparse;
+    blockSparse = NULL;
+
+    if(blockRow <= 0 || blockCol <= 0)
+        return;
+
+    CheckNTErrors(order == 2, "Block-sparse tensors must be matrices!");
+    CheckNTErrors(dataType == DEFAULT_DTYPE && !isSparse, "TODO!");
+    CheckNTErrors(data != NULL, "Empty tensor!");
+
+    blockSparse = new XBlockSparse(dimSize[0], dimSize[1], blockRow, blockCol);
+
+    if(devID < 0)
+        blockSparse->Build((DTYPE*)data);
+    else{
+        DTYPE * dataOnHost = new DTYPE[unitNum];
+        XMemCopy(dataOnHost, -1, data, devID, sizeof(DTYPE) * unitNum);
+        blockSparse->Build(dataOnHost);
+        delete[] dataOnHost;
+    }
+}
+
 /* 
 resize a tensor with a specified tensor size
 >> myOrder - order of the tensor
@@ -1347,13 +1481,16 @@ bool XTensor::Resize(const int myOrder, const int * myDimSize,
                      const TENSOR_DATA_TYPE myDataType, const float myDenseRatio)
 {
     /* free old mem */
-    if(data != NULL){
+    if(data != NULL && !isShared){
         if (mem == NULL)
             XMemFree(devID, data);
         else
             mem->Release(data, GetDataSizeInChar(), signature);
     }
 
+    /* the new data array is owned by the tensor itself */
+    isShared = false;
+
     signature = mem != NULL ? mem->GetSignature() : 0;
     
     order = myOrder;
@@ -34,6 +34,8 @@
 #include "XStream.h"
 #include "XHeap.h"
 #include "XList.h"
+#include "XSparseRows.h"
+#include "XBlockSparse.h"
 #include "XDataType.h"
 #include "XMem.h"
 #include "XLink.h"
@@ -76,10 +78,6 @@ public:
     /* copy of data on the host memory. It is only activated 
        when the matrix is operated on GPUs */
     void * dataHost;
-    
-    /* a pointer to data (i.e., a pointer to the address of "data".
-       This is for reset "data" when XTensor is used as a const variable. */
-    void ** dataP;
 
     /* 
     device id 
@@ -155,6 +153,15 @@ public:
 
     /* gradient (for back-propagation) */
     XTensor * grad;
+
+    /* rows of the gradient that can be non-zero. It is used when the gradient
+       is row-sparse (see SetSparseGradFlag), and is NULL for dense gradients. */
+    XSparseRows * gradRows;
+
+    /* the non-zero blocks of a block-sparse matrix (see SetBlockSparse). Matrix 
+       multiplication uses it when the matrix is the right operand, and it is 
+       NULL for dense tensors. */
+    XBlockSparse * blockSparse;
     
     /*
     the link used to form networks. Note that when we compute on tensors, we actually create a
@@ -189,6 +196,9 @@ public:
     /* copy constructor */
     XTensor(const XTensor &reference);
 
+    /* move constructor */
+    XTensor(XTensor &&reference);
+
     /* de-constructor */
     ~XTensor();
 
@@ -204,6 +214,9 @@ public:
     /* overloading of the equal-sign */
     XTensor& operator= (const XTensor &tensor);
 
+    /* overloading of the equal-sign (move assignment) */
+    XTensor& operator= (XTensor &&tensor);
+
     /* overloading of the plus-sign */
     XTensor  operator+ (const XTensor &tensor);
     
@@ -292,9 +305,7 @@ public:
 
     /* check whether the data array is the same as the answer */
     bool CheckData(const void * answer, int num, float tolerance, int beg = 0);
-    
-    /* set the pointer to "data" */
-    void SetDataPointer();
+
 
     /* set the cell to the ascending order along a given dimension */
     void SetAscendingOrder(int dim);
@@ -368,6 +379,12 @@ public:
     /* set the tensor as "variable" */
     void SetVarFlag(bool myIsVar = true);
 
+    /* set the tensor as "keep-row-sparse-gradient" */
+    void SetSparseGradFlag(bool myIsSparseGrad = true);
+
+    /* index the non-zero blocks of a matrix for block-sparse multiplication */
+    void SetBlockSparse(int blockRow, int blockCol);
+
     /* resize a matrix with a specified matrix size */
     bool Resize(const int myOrder, const int * myDimSize,
                 const TENSOR_DATA_TYPE myDataType = DEFAULT_DTYPE,
@@ -405,6 +422,7 @@ public:
 extern int tensorIDGlobal;
 extern MUTEX_HANDLE tensorMutex;
 extern XTensor NULLTensor;
+extern long long tensorCopyCount;
 extern int MakeTensorID();
 
 /************************************************
@@ -85,6 +85,28 @@ namespace nts{
 
 #endif
 
+//////////////////////////////////////////////////
+// atomic operations on 64-bit integers (with full memory barriers)
+#if(defined(_WIN32) && !defined (__CYGWIN__))
+#define      ATOMIC_LOAD( x )         InterlockedCompareExchange64( (volatile LONGLONG*)&(x), 0, 0 )
+#define      ATOMIC_STORE( x, v )     InterlockedExchange64( (volatile LONGLONG*)&(x), (v) )
+#define      ATOMIC_ADD( x, v )       InterlockedExchangeAdd64( (volatile LONGLONG*)&(x), (v) )
+#define      ATOMIC_CAS( x, e, v )    ( InterlockedCompareExchange64( (volatile LONGLONG*)&(x), (v), (e) ) == (e) )
+#define      ATOMIC_FENCE()           MemoryBarrier()
+#define      CPU_RELAX()              YieldProcessor()
+#else
+#define      ATOMIC_LOAD( x )         __atomic_load_n( &(x), __ATOMIC_SEQ_CST )
+#define      ATOMIC_STORE( x, v )     __atomic_store_n( &(x), (v), __ATOMIC_SEQ_CST )
+#define      ATOMIC_ADD( x, v )       __sync_fetch_and_add( &(x), (v) )
+#define      ATOMIC_CAS( x, e, v )    __sync_bool_compare_and_swap( &(x), (e), (v) )
+#define      ATOMIC_FENCE()           __sync_synchronize()
+#if defined(__x86_64__) || defined(__i386__)
+#define      CPU_RELAX()              __builtin_ia32_pause()
+#else
+#define      CPU_RELAX()
+#endif
+#endif
+
 typedef void (*TFunction) (volatile XList*);
 
 /*
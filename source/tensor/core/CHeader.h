@@ -33,6 +33,9 @@
 #include "arithmetic/MatrixMul2DMultiTheading.h"
 #include "arithmetic/MatrixMul2DParallel.h"
 #include "arithmetic/MatrixMulBatched.h"
+#include "arithmetic/MatrixMulBatchedStrided.h"
+#include "arithmetic/MatrixMulTuned.h"
+#include "arithmetic/MatrixMulBlockSparse.h"
 #include "arithmetic/Multiply.h"
 #include "arithmetic/MultiplyDim.h"
 #include "arithmetic/Negate.h"
@@ -43,6 +46,7 @@
 #include "arithmetic/SumByColumnTV.h"
 #include "arithmetic/SumByColumnVT.h"
 #include "arithmetic/SumDim.h"
+#include "arithmetic/SumRows.h"
 #include "arithmetic/XTensorBLAS.h"
 #include "arithmetic/MulAndShift.h"
 
@@ -66,6 +70,7 @@
 #include "movement/CopyInGrid.h"
 #include "movement/CopyValues.h"
 #include "movement/Gather.h"
+#include "movement/GatherByIndex.h"
 #include "movement/Spread.h"
 
 #include "reduce/ReduceMax.h"
@@ -90,6 +95,7 @@
 #include "shape/Unsqueeze.h"
 
 #include "sort/Sort.h"
+#include "sort/RadixSort.h"
 #include "sort/TopK.h"
 
 #include "utilities/XMatrixSegment.h"
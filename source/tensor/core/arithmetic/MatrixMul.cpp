@@ -77,6 +77,13 @@ void _MatrixMul(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
         return;
     }
 
+    /* the block index of a block-sparse matrix is kept in b itself, so we 
+       do not cut b into sub-matrices (see _MatrixMul2D) */
+    if(b->blockSparse != NULL && a->order == 2 && b->order == 2){
+        _MatrixMul2D(a, transposedA, b, transposedB, c, alpha, beta, parallelRunner);
+        return;
+    }
+
     int an = transposedA == X_TRANS ? a->dimSizeRDI[0] : a->dimSizeRDI[1];
     int am = transposedA == X_TRANS ? a->dimSizeRDI[1] : a->dimSizeRDI[0];
     int bn = transposedB == X_TRANS ? b->dimSizeRDI[0] : b->dimSizeRDI[1];
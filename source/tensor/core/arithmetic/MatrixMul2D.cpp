@@ -25,6 +25,8 @@
 #include "MatrixMul2D.cuh"
 #include "MatrixMul2DParallel.h"
 #include "XTensorBLAS.h"
+#include "MatrixMulTuned.h"
+#include "MatrixMulBlockSparse.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -74,15 +76,27 @@ void _MatrixMul2D(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
     }
 #endif
 
+    /* a dense matrix multiply a block-sparse matrix */
+    if (b->blockSparse != NULL && !a->isSparse && !c->isSparse &&
+        transposedA == X_NOTRANS && transposedB == X_NOTRANS &&
+        a->dataType == DEFAULT_DTYPE && c->dataType == DEFAULT_DTYPE)
+    {
+        _MatrixMulBlockSparseCPU(a, b, c, alpha, beta, parallelRunner);
+    }
     /* a dense matrix multiply a dense matrix */
-    if (!a->isSparse && !b->isSparse) {
+    else if (!a->isSparse && !b->isSparse) {
         CheckNTErrors(!c->isSparse, "Illegal use of sparse matrix in multiplication!");
 
         if (a->dataType == DEFAULT_DTYPE &&
             b->dataType == DEFAULT_DTYPE &&
             c->dataType == DEFAULT_DTYPE)
         {
-            if (useBLAS)
+            if (GTuner.isEnabled)
+                _MatrixMulTunedCPU((DTYPE*)a->data, transposedA, an, am, an * am,
+                                   (DTYPE*)b->data, transposedB, bn, bm, bn * bm,
+                                   (DTYPE*)c->data, cn, cm, cn * cm, 1,
+                                   alpha, beta, parallelRunner);
+            else if (useBLAS)
                 _MatrixMULCPU(a, transposedA, b, transposedB, c, alpha, beta);
             else
                 _MatrixMul2DParallel(a, transposedA, b, transposedB, c, alpha, beta, parallelRunner);
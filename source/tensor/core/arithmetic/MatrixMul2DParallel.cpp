@@ -76,7 +76,7 @@ void _MatrixMul2DParallel(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
                     p2 += bColNum;
                 }
 
-                *p3 = *p3 * beta + r;
+                *p3 = beta == 0 ? r : *p3 * beta + r;
                 p3 += 1;
             }
         }
@@ -97,7 +97,7 @@ void _MatrixMul2DParallel(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
                     p2 += 1;
                 }
 
-                *p3 = *p3 * beta + r;
+                *p3 = beta == 0 ? r : *p3 * beta + r;
                 p3 += 1;
             }
         }
@@ -118,7 +118,7 @@ void _MatrixMul2DParallel(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
                     p2 += 1;
                 }
 
-                *p3 = *p3 * beta + r;
+                *p3 = beta == 0 ? r : *p3 * beta + r;
                 p3 += 1;
             }
         }
@@ -25,6 +25,8 @@
 #include "MatrixMulBatched.h"
 #include "XTensorBLAS.h"
 #include "MatrixMul2D.h"
+#include "MatrixMulBatchedStrided.h"
+#include "MatrixMulTuned.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -60,7 +62,8 @@ void _MatrixMulBatched(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
     if (a->devID >= 0 || b->devID >= 0 || c->devID >= 0)
         _MatrixMulBatchedGPU(a, transposedA, b, transposedB, c, alpha, beta);
     else
-        _MatrixMulBatchedCPU(a, transposedA, b, transposedB, c, alpha, beta);
+        _MatrixMulBatchedCPU(a, transposedA, b, transposedB, c, alpha, beta, 
+                             parallelRunner != NULL ? parallelRunner : globalPRunner);
 }
 
 /*
@@ -149,12 +152,13 @@ where trans() returns the transposed matrix if the flag is fired
 >> c - where we keep a*b
 >> alpha - a coefficient
 >> beta - another coefficient
+>> parallelRunner - parallel processing module
 */
 void _MatrixMulBatchedCPU(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
                           const XTensor * b, MATRIX_TRANS_TYPE transposedB,
-                          XTensor * c, DTYPE alpha, DTYPE beta)
+                          XTensor * c, DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
 {
-CheckNTErrors((a && b && c), "Empty input tensors!");
+    CheckNTErrors((a && b && c), "Empty input tensors!");
     CheckNTErrors(a->dataType == b->dataType && a->dataType == c->dataType,
                  "Input tensors should have the same data type!");
     CheckNTErrors(a->order >= 2 && b->order >= 2 && c->order >= 2,
@@ -186,6 +190,26 @@ CheckNTErrors((a && b && c), "Empty input tensors!");
         blockNum *= a->dimSizeRDI[i];
     }
 
+    /* dense float matrices are multiplied in one go by the strided kernel
+       (or with the tuned setting of the shape) */
+    if ((!useBLAS || GTuner.isEnabled) && !a->isSparse && !b->isSparse && !c->isSparse &&
+        a->dataType == X_FLOAT && b->dataType == X_FLOAT && c->dataType == X_FLOAT)
+    {
+        if (GTuner.isEnabled) {
+            _MatrixMulTunedCPU((DTYPE*)a->data, transposedA, a->dimSizeRDI[1], a->dimSizeRDI[0], aBlockSize,
+                               (DTYPE*)b->data, transposedB, b->dimSizeRDI[1], b->dimSizeRDI[0], bBlockSize,
+                               (DTYPE*)c->data, c->dimSizeRDI[1], c->dimSizeRDI[0], cBlockSize, blockNum,
+                               alpha, beta, parallelRunner);
+            return;
+        }
+
+        _MatrixMulBatchedStridedCPU((DTYPE*)a->data, transposedA, a->dimSizeRDI[1], a->dimSizeRDI[0], aBlockSize,
+                                    (DTYPE*)b->data, transposedB, b->dimSizeRDI[1], b->dimSizeRDI[0], bBlockSize,
+                                    (DTYPE*)c->data, c->dimSizeRDI[1], c->dimSizeRDI[0], cBlockSize, blockNum,
+                                    alpha, beta, parallelRunner);
+        return;
+    }
+
     int aDimSize[2] = {-a->dimSizeRDI[1], a->dimSizeRDI[0]};
     int bDimSize[2] = {-b->dimSizeRDI[1], b->dimSizeRDI[0]};
     int cDimSize[2] = {-c->dimSizeRDI[1], c->dimSizeRDI[0]};
@@ -49,10 +49,10 @@ void _MatrixMulBatchedGPU(const XTensor * a, MATRIX_TRANS_TYPE transposedA, cons
 
 /*
 matrix multiplication of the two tensors c = trans(a) * trans(b) * alpha + c * beta
-optimized for GPU
+optimized for CPU
 */
 void _MatrixMulBatchedCPU(const XTensor * a, MATRIX_TRANS_TYPE transposedA, const XTensor * b, MATRIX_TRANS_TYPE transposedB, 
-                          XTensor * c, DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0);
+                          XTensor * c, DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, XPRunner * parallelRunner = NULL);
 
 /*
 matrix multiplication of the two tensors c = trans(a) * trans(b) * alpha + c * beta (for list inputs)
@@ -0,0 +1,350 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "../../XTensor.h"
+#include "../../XCPU.h"
+#include "../utilities/XMatrixSegment.h"
+#include "MatrixMulBatchedStrided.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* description of a strided batched multiplication */
+struct BMMParam
+{
+    /* base pointers */
+    const DTYPE * a;
+    const DTYPE * b;
+    DTYPE * c;
+
+    /* element (i, k) of a_j is a[j * strideA + i * aRowStride + k * aColStride] */
+    int aRowStride;
+    int aColStride;
+    int strideA;
+
+    /* row (k) of b_j is b + j * strideB + k * ldb */
+    int ldb;
+    int strideB;
+
+    /* row (i) of c_j is c + j * strideC + i * mc */
+    int strideC;
+
+    /* c_j is of size n * m, and k is the inner dimension */
+    int n;
+    int m;
+    int k;
+
+    /* sizes of the row and column tiles */
+    int tileRow;
+    int tileCol;
+
+    /* numbers of the row and column tiles */
+    int rowTileNum;
+    int colTileNum;
+
+    DTYPE alpha;
+    DTYPE beta;
+};
+
+/*
+transpose matrices so that the rows of trans(b_i) are continuous (in a thread)
+>> args - the arguments: range of the matrices, b, nb, mb, strideB, packed b
+*/
+void _BMMPackTransposed(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    const DTYPE * b = (const DTYPE*)args->GetItem(2);
+    int nb = *(int*)args->GetItem(3);
+    int mb = *(int*)args->GetItem(4);
+    int strideB = *(int*)args->GetItem(5);
+    DTYPE * packed = (DTYPE*)args->GetItem(6);
+
+    for (int i = beg; i < end; i++) {
+        const DTYPE * src = b + (MTYPE)i * strideB;
+        DTYPE * tgt = packed + (MTYPE)i * nb * mb;
+
+        /* blocked transposition: tgt(k, j) = src(j, k) */
+        for (int j0 = 0; j0 < nb; j0 += 16) {
+            int j1 = MIN(j0 + 16, nb);
+            for (int k0 = 0; k0 < mb; k0 += 16) {
+                int k1 = MIN(k0 + 16, mb);
+                for (int j = j0; j < j1; j++) {
+                    for (int k = k0; k < k1; k++)
+                        tgt[k * nb + j] = src[j * mb + k];
+                }
+            }
+        }
+    }
+}
+
+/*
+initialize rows of c with c * beta
+>> c - the first row
+>> ldc - row size
+>> rowNum - number of rows
+>> colNum - number of columns
+>> beta - the coefficient
+*/
+inline void _BMMScaleRows(DTYPE * c, int ldc, int rowNum, int colNum, DTYPE beta)
+{
+    for (int i = 0; i < rowNum; i++) {
+        DTYPE * ci = c + i * ldc;
+        if (beta == 0)
+            memset(ci, 0, sizeof(DTYPE) * colNum);
+        else if (beta != 1.0F) {
+            for (int j = 0; j < colNum; j++)
+                ci[j] *= beta;
+        }
+    }
+}
+
+/* the body is inlined into the versions for the instruction sets */
+#ifdef USE_ISA_DISPATCH
+#define BMM_INLINE inline __attribute__((always_inline))
+#else
+#define BMM_INLINE inline
+#endif
+
+/*
+compute blocks of the strided batched multiplication
+>> beg - the first block
+>> end - the block after the last one
+>> p - the description of the multiplication
+*/
+BMM_INLINE void _BMMBlocksBody(int beg, int end, const BMMParam * p)
+{
+    int tileNum = p->rowTileNum * p->colTileNum;
+    int ars = p->aRowStride;
+    int acs = p->aColStride;
+    int ldb = p->ldb;
+    int ldc = p->m;
+    int kNum = p->k;
+    DTYPE alpha = p->alpha;
+
+    for (int t = beg; t < end; t++) {
+        int id = t / tileNum;
+        int rowTile = (t % tileNum) / p->colTileNum;
+        int colTile = t % p->colTileNum;
+        int r0 = rowTile * p->tileRow;
+        int r1 = MIN(r0 + p->tileRow, p->n);
+        int j0 = colTile * p->tileCol;
+        int w = MIN(j0 + p->tileCol, p->m) - j0;
+
+        const DTYPE * a = p->a + (MTYPE)id * p->strideA;
+        const DTYPE * b = p->b + (MTYPE)id * p->strideB + j0;
+        DTYPE * c = p->c + (MTYPE)id * p->strideC + j0;
+
+        _BMMScaleRows(c + r0 * ldc, ldc, r1 - r0, w, p->beta);
+
+        int i = r0;
+
+        /* four rows at a time so that each row of b is loaded once for them */
+        for (; i + 4 <= r1; i += 4) {
+            DTYPE * c0 = c + i * ldc;
+            DTYPE * c1 = c0 + ldc;
+            DTYPE * c2 = c1 + ldc;
+            DTYPE * c3 = c2 + ldc;
+            const DTYPE * ai = a + i * ars;
+            for (int k = 0; k < kNum; k++) {
+                DTYPE a0 = ai[k * acs] * alpha;
+                DTYPE a1 = ai[ars + k * acs] * alpha;
+                DTYPE a2 = ai[2 * ars + k * acs] * alpha;
+                DTYPE a3 = ai[3 * ars + k * acs] * alpha;
+                const DTYPE * bk = b + k * ldb;
+                for (int j = 0; j < w; j++) {
+                    DTYPE v = bk[j];
+                    c0[j] += a0 * v;
+                    c1[j] += a1 * v;
+                    c2[j] += a2 * v;
+                    c3[j] += a3 * v;
+                }
+            }
+        }
+
+        /* the remaining rows */
+        for (; i < r1; i++) {
+            DTYPE * c0 = c + i * ldc;
+            const DTYPE * ai = a + i * ars;
+            for (int k = 0; k < kNum; k++) {
+                DTYPE a0 = ai[k * acs] * alpha;
+                const DTYPE * bk = b + k * ldb;
+                for (int j = 0; j < w; j++)
+                    c0[j] += a0 * bk[j];
+            }
+        }
+    }
+}
+
+/*
+compute blocks of the strided batched multiplication (in a thread)
+>> args - the arguments: range of the blocks, the description of the multiplication
+*/
+void _BMMBlocks(XList * args)
+{
+    _BMMBlocksBody(*(int*)args->GetItem(0), *(int*)args->GetItem(1), (BMMParam*)args->GetItem(2));
+}
+
+#ifdef USE_ISA_DISPATCH
+
+/* compute blocks with AVX2 and FMA (in a thread) */
+__attribute__((target("avx2,fma")))
+void _BMMBlocksAVX2(XList * args)
+{
+    _BMMBlocksBody(*(int*)args->GetItem(0), *(int*)args->GetItem(1), (BMMParam*)args->GetItem(2));
+}
+
+/* compute blocks with AVX-512 (in a thread) */
+__attribute__((target("avx512f,avx2,fma")))
+void _BMMBlocksAVX512(XList * args)
+{
+    _BMMBlocksBody(*(int*)args->GetItem(0), *(int*)args->GetItem(1), (BMMParam*)args->GetItem(2));
+}
+
+#endif
+
+/* the highest instruction set (in XCPU_ISA) for which the blocks can be computed on this CPU */
+int GetBMMISA()
+{
+#ifdef USE_ISA_DISPATCH
+    XCPU_ISA isa = GetCPUISA();
+    if (isa >= ISA_AVX512)
+        return ISA_AVX512;
+    if (isa >= ISA_AVX2)
+        return ISA_AVX2;
+#endif
+    return ISA_GENERIC;
+}
+
+/*
+get the job that computes the blocks with an instruction set
+>> isa - the instruction set (in XCPU_ISA, -1 means the best one of the CPU)
+*/
+void * _GetBMMJob(int isa)
+{
+    if (isa < 0 || isa > GetBMMISA())
+        isa = GetBMMISA();
+
+#ifdef USE_ISA_DISPATCH
+    if (isa == ISA_AVX512)
+        return (void*)_BMMBlocksAVX512;
+    if (isa == ISA_AVX2)
+        return (void*)_BMMBlocksAVX2;
+#endif
+
+    return (void*)_BMMBlocks;
+}
+
+/*
+strided batched matrix multiplication (float only)
+c_i = trans(a_i) * trans(b_i) * alpha + c_i * beta for each i in [0, count - 1]
+where a_i = a + i * strideA, b_i = b + i * strideB and c_i = c + i * strideC.
+A zero stride means that the matrix is shared by all the multiplications.
+
+>> a - base pointer of the matrices a_i
+>> transposedA - indicates whether the matrices a_i are transposed
+>> na - number of rows of a_i (as it is stored)
+>> ma - number of columns of a_i (as it is stored)
+>> strideA - distance (in items) between a_i and a_{i+1}
+>> b - base pointer of the matrices b_i
+>> transposedB - indicates whether the matrices b_i are transposed
+>> nb - number of rows of b_i (as it is stored)
+>> mb - number of columns of b_i (as it is stored)
+>> strideB - distance (in items) between b_i and b_{i+1}
+>> c - base pointer of the matrices c_i
+>> nc - number of rows of c_i
+>> mc - number of columns of c_i
+>> strideC - distance (in items) between c_i and c_{i+1}
+>> count - number of the multiplications
+>> alpha - a coefficient
+>> beta - another coefficient
+>> parallelRunner - parallel processing module
+>> isa - instruction set of the kernel (in XCPU_ISA, -1 means the best one of the CPU)
+>> tileRow - number of rows of c in a block
+>> tileCol - number of columns of c in a block
+>> jobNum - number of the parallel jobs (0 means it is decided by the runner)
+*/
+void _MatrixMulBatchedStridedCPU(const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                                 const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                                 DTYPE * c, int nc, int mc, int strideC, int count,
+                                 DTYPE alpha, DTYPE beta, XPRunner * parallelRunner,
+                                 int isa, int tileRow, int tileCol, int jobNum)
+{
+    CheckNTErrors(a && b && c, "Empty input matrices!");
+
+    int an = transposedA == X_TRANS ? ma : na;
+    int am = transposedA == X_TRANS ? na : ma;
+    int bn = transposedB == X_TRANS ? mb : nb;
+    int bm = transposedB == X_TRANS ? nb : mb;
+
+    CheckNTErrors(am == bn && an == nc && bm == mc, "Unmatched matrices in multiplication!");
+    CheckNTErrors(strideC != 0 || count <= 1, "The result matrices cannot be shared!");
+    CheckNTErrors(tileRow > 0 && tileCol > 0, "Illegal tile size!");
+
+    if (count <= 0 || nc == 0 || mc == 0)
+        return;
+
+    BMMParam param;
+    param.a = a;
+    param.c = c;
+    param.aRowStride = transposedA == X_TRANS ? 1 : ma;
+    param.aColStride = transposedA == X_TRANS ? ma : 1;
+    param.strideA = strideA;
+    param.strideC = strideC;
+    param.n = nc;
+    param.m = mc;
+    param.k = am;
+    param.tileRow = tileRow;
+    param.tileCol = tileCol;
+    param.rowTileNum = (nc + tileRow - 1) / tileRow;
+    param.colTileNum = (mc + tileCol - 1) / tileCol;
+    param.alpha = alpha;
+    param.beta = beta;
+
+    DTYPE * packed = NULL;
+
+    if (transposedB == X_TRANS) {
+        /* a shared b is packed only once */
+        int packNum = strideB == 0 ? 1 : count;
+        packed = new DTYPE[(MTYPE)packNum * nb * mb];
+
+        RunParallel1D(parallelRunner, (void*)_BMMPackTransposed, (int)MIN((double)packNum * nb * mb, 2e9), packNum, 5,
+                      b, &nb, &mb, &strideB, packed);
+
+        param.b = packed;
+        param.ldb = nb;
+        param.strideB = strideB == 0 ? 0 : nb * mb;
+    }
+    else {
+        param.b = b;
+        param.ldb = mb;
+        param.strideB = strideB;
+    }
+
+    int blockNum = count * param.rowTileNum * param.colTileNum;
+    int opNum = (int)MIN((double)count * nc * mc * am, 2e9);
+
+    /* a given number of jobs is made by the number of operations that leads to it */
+    if (jobNum > 0 && parallelRunner != NULL)
+        opNum = jobNum * parallelRunner->minimumOPNum;
+
+    RunParallel1D(parallelRunner, _GetBMMJob(isa), opNum, blockNum, 1, &param);
+
+    delete[] packed;
+}
+
+} // namespace nts(NiuTrans.Tensor)
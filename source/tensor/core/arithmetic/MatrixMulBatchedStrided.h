@@ -0,0 +1,57 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Strided batched matrix multiplication on CPUs. The matrices of a batch are
+* given by base pointers and strides (like cublasSgemmStridedBatched), and the
+* work is split into (matrix, row tile, column tile) blocks which are run in
+* parallel. A transposed b is packed once for each matrix, and only once for
+* all the matrices if it is shared (stride = 0). The blocks are computed by
+* code that is compiled for several instruction sets, and the version is
+* picked by the CPU at run time (see XCPU.h).
+*/
+
+#ifndef __MATRIXMULBATCHEDSTRIDED_H__
+#define __MATRIXMULBATCHEDSTRIDED_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* number of rows of c in a block */
+#define BMM_TILE_ROW 32
+
+/* number of columns of c in a block */
+#define BMM_TILE_COL 256
+
+/*
+strided batched matrix multiplication (float only)
+c_i = trans(a_i) * trans(b_i) * alpha + c_i * beta for each i in [0, count - 1]
+where a_i = a + i * strideA, b_i = b + i * strideB and c_i = c + i * strideC
+*/
+void _MatrixMulBatchedStridedCPU(const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                                 const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                                 DTYPE * c, int nc, int mc, int strideC, int count,
+                                 DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, XPRunner * parallelRunner = NULL,
+                                 int isa = -1, int tileRow = BMM_TILE_ROW, int tileCol = BMM_TILE_COL, int jobNum = 0);
+
+/* the highest instruction set (in XCPU_ISA) for which the blocks can be computed on this CPU */
+int GetBMMISA();
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __MATRIXMULBATCHEDSTRIDED_H__
@@ -0,0 +1,196 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "../../XTensor.h"
+#include "../../XUtility.h"
+#include "../utilities/XMatrixSegment.h"
+#include "MatrixMulBlockSparse.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* description of a dense * block-sparse multiplication */
+struct BSMMParam
+{
+    const DTYPE * a;
+    const DTYPE * b;
+    DTYPE * c;
+    const XBlockSparse * index;
+
+    /* a is of size n * k, and b and c are of size k * m and n * m */
+    int n;
+    int k;
+    int m;
+
+    DTYPE alpha;
+    DTYPE beta;
+};
+
+/* acc += av * (a row of a block) */
+inline void _AccumulateBlockRow(DTYPE * acc, DTYPE av, const DTYPE * bp, int blockCol)
+{
+    for (int s = 0; s < blockCol; s++)
+        acc[s] += av * bp[s];
+}
+
+/*
+multiply a tile of rows of a (at most BLOCK_SPARSE_ROW_TILE rows) by the
+block-sparse matrix. For each block column of b, the results of the rows
+are accumulated in a small buffer over the non-zero blocks of the column,
+so that a block is loaded once for all the rows of the tile.
+>> p - the multiplication
+>> row - the first row of the tile
+>> rowNum - number of the rows in the tile
+*/
+void _MatrixMulBlockSparseTile(const BSMMParam * p, int row, int rowNum)
+{
+    const XBlockSparse * index = p->index;
+    const int blockRow = index->blockRow;
+    const int blockCol = index->blockCol;
+    const int k = p->k;
+    const int m = p->m;
+
+    DTYPE acc[BLOCK_SPARSE_ROW_TILE][MAX_SPARSE_BLOCK_COL];
+    const DTYPE * aRows[BLOCK_SPARSE_ROW_TILE];
+
+    for (int t = 0; t < rowNum; t++)
+        aRows[t] = p->a + (row + t) * k;
+
+    for (int j = 0; j < index->blockColNum; j++) {
+        for (int t = 0; t < rowNum; t++)
+            memset(acc[t], 0, sizeof(DTYPE) * blockCol);
+
+        for (int q = index->colOffsets[j]; q < index->colOffsets[j + 1]; q++) {
+            int kBeg = index->blockRows[q] * blockRow;
+            for (int r = 0; r < blockRow; r++) {
+                const DTYPE * bp = p->b + (kBeg + r) * m + j * blockCol;
+                for (int t = 0; t < rowNum; t++) {
+                    DTYPE av = aRows[t][kBeg + r];
+
+                    /* the common block sizes are given as constants so that
+                       the loop is unrolled (and vectorized) */
+                    if (blockCol == 16)
+                        _AccumulateBlockRow(acc[t], av, bp, 16);
+                    else if (blockCol == 4)
+                        _AccumulateBlockRow(acc[t], av, bp, 4);
+                    else
+                        _AccumulateBlockRow(acc[t], av, bp, blockCol);
+                }
+            }
+        }
+
+        for (int t = 0; t < rowNum; t++) {
+            DTYPE * cp = p->c + (row + t) * m + j * blockCol;
+            if (p->beta == 0) {
+                for (int s = 0; s < blockCol; s++)
+                    cp[s] = acc[t][s] * p->alpha;
+            }
+            else {
+                for (int s = 0; s < blockCol; s++)
+                    cp[s] = acc[t][s] * p->alpha + cp[s] * p->beta;
+            }
+        }
+    }
+}
+
+/*
+multiply a range of row tiles (a job of RunParallel1D)
+>> args - the range [beg, end) of the tiles and the multiplication
+*/
+void _MatrixMulBlockSparseTiles(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    const BSMMParam * p = (const BSMMParam*)args->GetItem(2);
+
+    for (int i = beg; i < end; i++) {
+        int row = i * BLOCK_SPARSE_ROW_TILE;
+        _MatrixMulBlockSparseTile(p, row, MIN(BLOCK_SPARSE_ROW_TILE, p->n - row));
+    }
+}
+
+/*
+dense * block-sparse matrix multiplication (on CPUs)
+c = a * b * alpha + c * beta
+where b has a block index (b->blockSparse). The cost is proportional to
+the number of the non-zero blocks of b.
+
+>> a - tensor a (n * k)
+>> b - tensor b (k * m) with a block index
+>> c - where we put a * b (n * m)
+>> alpha - a coefficient
+>> beta - another coefficient
+>> parallelRunner - parallel processing module
+*/
+void _MatrixMulBlockSparseCPU(const XTensor * a, const XTensor * b, XTensor * c,
+                              DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
+{
+    CheckNTErrors(a && b && c, "Empty input tensors!");
+    CheckNTErrors(a->order == 2 && b->order == 2 && c->order == 2, "Input tensors must have a order = 2!");
+    CheckNTErrors(b->blockSparse != NULL, "No block index is found!");
+    CheckNTErrors(a->devID < 0 && b->devID < 0 && c->devID < 0, "The kernel runs on CPUs only!");
+    CheckNTErrors(a->dataType == DEFAULT_DTYPE && b->dataType == DEFAULT_DTYPE &&
+                  c->dataType == DEFAULT_DTYPE, "TODO!");
+    CheckNTErrors(a->dimSize[1] == b->dimSize[0] && a->dimSize[0] == c->dimSize[0] &&
+                  b->dimSize[1] == c->dimSize[1], "Unmatched tensors in multiplication!");
+    CheckNTErrors(b->blockSparse->rowNum == b->dimSize[0] && b->blockSparse->colNum == b->dimSize[1],
+                  "The block index does not match the matrix!");
+
+    BSMMParam p;
+    p.a = (const DTYPE*)a->data;
+    p.b = (const DTYPE*)b->data;
+    p.c = (DTYPE*)c->data;
+    p.index = b->blockSparse;
+    p.n = a->dimSize[0];
+    p.k = a->dimSize[1];
+    p.m = b->dimSize[1];
+    p.alpha = alpha;
+    p.beta = beta;
+
+    int tileNum = (p.n + BLOCK_SPARSE_ROW_TILE - 1) / BLOCK_SPARSE_ROW_TILE;
+    int opNum = p.n * p.index->blockNum * p.index->blockRow * p.index->blockCol;
+
+    RunParallel1D(parallelRunner, (void*)_MatrixMulBlockSparseTiles, opNum, tileNum, 1, &p);
+}
+
+/*
+magnitude pruning of a matrix: the blocks of the smallest l2-norm are set
+to zero, and the non-zero blocks are indexed for block-sparse multiplication
+>> m - the matrix
+>> blockRow - number of rows of a block
+>> blockCol - number of columns of a block
+>> sparsity - the fraction of the blocks that we set to zero
+*/
+void _PruneBlocks(XTensor * m, int blockRow, int blockCol, float sparsity)
+{
+    CheckNTErrors(m->order == 2, "Only matrices can be pruned!");
+    CheckNTErrors(m->dataType == DEFAULT_DTYPE && !m->isSparse, "TODO!");
+
+    if (m->devID < 0)
+        XBlockSparse::Prune((DTYPE*)m->data, m->dimSize[0], m->dimSize[1], blockRow, blockCol, sparsity);
+    else {
+        DTYPE * dataOnHost = new DTYPE[m->unitNum];
+        XMemCopy(dataOnHost, -1, m->data, m->devID, sizeof(DTYPE) * m->unitNum);
+        XBlockSparse::Prune(dataOnHost, m->dimSize[0], m->dimSize[1], blockRow, blockCol, sparsity);
+        XMemCopy(m->data, m->devID, dataOnHost, -1, sizeof(DTYPE) * m->unitNum);
+        delete[] dataOnHost;
+    }
+
+    m->SetBlockSparse(blockRow, blockCol);
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,49 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Multiplication of a dense matrix and a block-sparse matrix (see
+* XBlockSparse.h), and magnitude pruning of the blocks of a matrix.
+* _MatrixMul2D calls the kernel when the right operand has a block
+* index, so that the layers need no change.
+*/
+
+#ifndef __MATRIXMULBLOCKSPARSE_H__
+#define __MATRIXMULBLOCKSPARSE_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* number of the rows of a that are multiplied together (for the reuse of the blocks) */
+#define BLOCK_SPARSE_ROW_TILE 4
+
+/*
+dense * block-sparse matrix multiplication (on CPUs)
+c = a * b * alpha + c * beta
+where b has a block index (b->blockSparse)
+*/
+void _MatrixMulBlockSparseCPU(const XTensor * a, const XTensor * b, XTensor * c,
+                              DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, 
+                              XPRunner * parallelRunner = NULL);
+
+/* set the blocks of the smallest magnitude of a matrix to zero and index the rest */
+void _PruneBlocks(XTensor * m, int blockRow, int blockCol, float sparsity);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __MATRIXMULBLOCKSPARSE_H__
@@ -0,0 +1,186 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "../../XTensor.h"
+#include "../../XUtility.h"
+#include "../../XBLAS.h"
+#include "../../XCPU.h"
+#include "MatrixMulBatchedStrided.h"
+#include "MatrixMulTuned.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* tile sizes (rows and columns of c) that are tried */
+static const int tuneTiles[][2] = {{8, 512}, {16, 256}, {32, 256}, {32, 128}, {64, 128}};
+
+/*
+run a strided batched matrix multiplication with a given setting
+>> choice - the setting
+>> a ... parallelRunner - see _MatrixMulBatchedStridedCPU
+*/
+void _MatrixMulWithChoiceCPU(const XTuneChoice &choice,
+                             const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                             const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                             DTYPE * c, int nc, int mc, int strideC, int count,
+                             DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
+{
+    if (choice.kernel == XTUNE_KERNEL_BLAS) {
+#ifdef USE_BLAS
+        int k = transposedA == X_TRANS ? na : ma;
+
+        /* the thread number of BLAS is for the whole process, so the
+           one of the choice is set for this call only */
+        int threadNumBackup = 0;
+        if (XBLAS_SET_THREAD_NUM != NULL && XBLAS_GET_THREAD_NUM != NULL) {
+            threadNumBackup = XBLAS_GET_THREAD_NUM();
+            XBLAS_SET_THREAD_NUM(choice.threadNum);
+        }
+
+        for (int i = 0; i < count; i++) {
+            GEMM(CblasRowMajor, transposedA == X_TRANS ? CblasTrans : CblasNoTrans,
+                 transposedB == X_TRANS ? CblasTrans : CblasNoTrans,
+                 nc, mc, k, alpha, a + (MTYPE)i * strideA, ma, b + (MTYPE)i * strideB, mb,
+                 beta, c + (MTYPE)i * strideC, mc);
+        }
+
+        if (threadNumBackup > 0)
+            XBLAS_SET_THREAD_NUM(threadNumBackup);
+
+        return;
+#else
+        ShowNTErrors("Please specify USE_BLAS for compiling this program.");
+#endif
+    }
+
+    _MatrixMulBatchedStridedCPU(a, transposedA, na, ma, strideA,
+                                b, transposedB, nb, mb, strideB,
+                                c, nc, mc, strideC, count, alpha, beta, parallelRunner,
+                                choice.kernel, choice.tileRow, choice.tileCol, choice.threadNum);
+}
+
+/*
+time a setting (in ms per run). The fastest of a few runs is taken.
+*/
+double _TimeMatrixMulChoice(const XTuneChoice &choice,
+                            const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                            const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                            DTYPE * c, int nc, int mc, int strideC, int count,
+                            DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
+{
+    /* warm-up */
+    _MatrixMulWithChoiceCPU(choice, a, transposedA, na, ma, strideA, b, transposedB, nb, mb, strideB,
+                            c, nc, mc, strideC, count, alpha, beta, parallelRunner);
+
+    double best = 1e30;
+    double total = 0;
+
+    for (int r = 0; r < 10 && (r < 3 || total < 5.0); r++) {
+        double startT = GetClock();
+        _MatrixMulWithChoiceCPU(choice, a, transposedA, na, ma, strideA, b, transposedB, nb, mb, strideB,
+                                c, nc, mc, strideC, count, alpha, beta, parallelRunner);
+        double t = GetClock() - startT;
+        best = MIN(best, t);
+        total += t;
+    }
+
+    return best;
+}
+
+/*
+strided batched matrix multiplication with the tuned setting of the shape (float only)
+c_i = trans(a_i) * trans(b_i) * alpha + c_i * beta for each i in [0, count - 1]
+where a_i = a + i * strideA, b_i = b + i * strideB and c_i = c + i * strideC.
+The setting is tuned when the shape is seen for the first time. The runs for
+tuning write to a copy of c.
+
+>> a ... parallelRunner - see _MatrixMulBatchedStridedCPU
+*/
+void _MatrixMulTunedCPU(const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                        const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                        DTYPE * c, int nc, int mc, int strideC, int count,
+                        DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
+{
+    int k = transposedA == X_TRANS ? na : ma;
+    int maxThreadNum = 1;
+    if (parallelRunner != NULL && parallelRunner->method == PRUNNER_MULTIPLE)
+        maxThreadNum = parallelRunner->threadNum;
+
+    int dims[XTUNE_DIM_NUM] = {(transposedA == X_TRANS) * 2 + (transposedB == X_TRANS),
+                               nc, mc, k, count, strideB == 0, (int)sizeof(DTYPE), maxThreadNum};
+    XTuneKey key;
+    XAutoTuner::MakeKey(key, "matrixmul", XTUNE_DIM_NUM, dims);
+
+    XTuneChoice choice;
+
+    if (!GTuner.Find(key, choice)) {
+        MTYPE cSize = (MTYPE)(count - 1) * strideC + (MTYPE)nc * mc;
+        DTYPE * cCopy = new DTYPE[cSize];
+        memcpy(cCopy, c, sizeof(DTYPE) * cSize);
+
+        XTuneChoice tried;
+        choice.time = 1e30;
+
+        /* the BLAS library with the numbers of threads */
+#ifdef USE_BLAS
+        if (useBLAS) {
+            for (int t = 1; t <= maxThreadNum; t = t < maxThreadNum ? MIN(t * 2, maxThreadNum) : t + 1) {
+                tried.kernel = XTUNE_KERNEL_BLAS;
+                tried.threadNum = t;
+                tried.tileRow = 0;
+                tried.tileCol = 0;
+                tried.time = _TimeMatrixMulChoice(tried, a, transposedA, na, ma, strideA, b, transposedB, nb, mb, strideB,
+                                                  cCopy, nc, mc, strideC, count, alpha, beta, parallelRunner);
+                if (tried.time < choice.time)
+                    choice = tried;
+            }
+        }
+#endif
+
+        /* the strided kernel with the instruction sets, numbers of threads and tile sizes */
+        int isas[3] = {GetBMMISA(), ISA_AVX2, ISA_GENERIC};
+        for (int i = 0; i < 3; i++) {
+            if (isas[i] > isas[0] || (i > 0 && isas[i] == isas[i - 1]))
+                continue;
+
+            for (int t = 1; t <= maxThreadNum; t = t < maxThreadNum ? MIN(t * 2, maxThreadNum) : t + 1) {
+                for (int j = 0; j < (int)(sizeof(tuneTiles) / sizeof(tuneTiles[0])); j++) {
+                    tried.kernel = isas[i];
+                    tried.threadNum = t;
+                    tried.tileRow = tuneTiles[j][0];
+                    tried.tileCol = tuneTiles[j][1];
+                    tried.time = _TimeMatrixMulChoice(tried, a, transposedA, na, ma, strideA, b, transposedB, nb, mb, strideB,
+                                                      cCopy, nc, mc, strideC, count, alpha, beta, parallelRunner);
+                    if (tried.time < choice.time)
+                        choice = tried;
+                }
+            }
+        }
+
+        delete[] cCopy;
+
+        GTuner.Add(key, choice);
+
+        XPRINT8(1, stderr, "[AutoTune] matrixmul %dx%dx%d (count=%d): kernel=%d threads=%d tile=%dx%d\n",
+                nc, mc, k, count, choice.kernel, choice.threadNum, choice.tileRow, choice.tileCol);
+    }
+
+    _MatrixMulWithChoiceCPU(choice, a, transposedA, na, ma, strideA, b, transposedB, nb, mb, strideB,
+                            c, nc, mc, strideC, count, alpha, beta, parallelRunner);
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,51 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Matrix multiplication with tuned settings. For each shape, the BLAS library
+* (if it is there) and the strided kernel with different instruction sets,
+* numbers of threads and tile sizes are tried once, and the fastest setting is
+* kept in GTuner (see XAutoTune.h) and used for the shape afterwards.
+*/
+
+#ifndef __MATRIXMULTUNED_H__
+#define __MATRIXMULTUNED_H__
+
+#include "../../XTensor.h"
+#include "../../XAutoTune.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+strided batched matrix multiplication with the tuned setting of the shape (float only)
+c_i = trans(a_i) * trans(b_i) * alpha + c_i * beta for each i in [0, count - 1]
+*/
+void _MatrixMulTunedCPU(const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                        const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                        DTYPE * c, int nc, int mc, int strideC, int count,
+                        DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, XPRunner * parallelRunner = NULL);
+
+/* run a strided batched matrix multiplication with a given setting */
+void _MatrixMulWithChoiceCPU(const XTuneChoice &choice,
+                             const DTYPE * a, MATRIX_TRANS_TYPE transposedA, int na, int ma, int strideA,
+                             const DTYPE * b, MATRIX_TRANS_TYPE transposedB, int nb, int mb, int strideB,
+                             DTYPE * c, int nc, int mc, int strideC, int count,
+                             DTYPE alpha, DTYPE beta, XPRunner * parallelRunner);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __MATRIXMULTUNED_H__
@@ -23,6 +23,7 @@
 #include "../../XName.h"
 #include "Multiply.h"
 #include "Multiply.cuh"
+#include "../utilities/XTypedKernel.h"
 #include "MultiplyDim.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
@@ -54,67 +55,17 @@ void _Multiply(const XTensor * a, const XTensor * b, XTensor * c, DTYPE alpha, i
     }
 #endif
 
-    int stride = 1;
-    int blockSizeA = 1;
-    int blockSizeB = 1;
-    int blockSizeC = 1;
-    int blockNum = 1;
-    int dimensionSizeA = a->dimSizeRDI[leadingDimRDI];
-    int dimensionSizeB = b->dimSizeRDI[leadingDimRDI];
-    int dimensionSizeC = c->dimSizeRDI[leadingDimRDI];
-
     for (int i = 0; i < a->order; i++) {
         if (i != leadingDimRDI) {
             CheckNTErrors((a->dimSizeRDI[i] == b->dimSizeRDI[i] &&
                            a->dimSizeRDI[i] == c->dimSizeRDI[i]),
                           "Unmatched tensors!");
         }
-        if (i < leadingDimRDI)
-            stride *= a->dimSizeRDI[i];
     }
 
-    blockSizeA = stride * dimensionSizeA;
-    blockSizeB = stride * dimensionSizeB;
-    blockSizeC = stride * dimensionSizeC;
-    blockNum = a->unitNum / blockSizeA;
-
     if (!a->isSparse && !b->isSparse) {
-        if (a->dataType == DEFAULT_DTYPE && b->dataType == DEFAULT_DTYPE) {
-            if (a->unitNum == c->unitNum && b->unitNum == c->unitNum) {
-                int size = a->unitNum;
-                DTYPE * ap = (DTYPE*)a->data;
-                DTYPE * bp = (DTYPE*)b->data;
-                DTYPE * cp = (DTYPE*)c->data;
-                if (alpha == 0) {
-                    for (int i = 0; i < size; i++)
-                        cp[i] = ap[i] * bp[i];
-                }
-                else {
-                    for (int i = 0; i < size; i++)
-                        cp[i] = ap[i] * bp[i] + alpha * cp[i];
-                }
-            }
-            else {
-                for (int k = 0; k < blockNum; k++) {
-
-                    for (int ci = 0, ai = 0, bi = 0; ci < dimensionSizeC; ci++, ai++, bi++) {
-                        if (ai >= dimensionSizeA)
-                            ai = 0;
-                        if (bi >= dimensionSizeB)
-                            bi = 0;
-                        DTYPE * ap = (DTYPE*)a->data + k * blockSizeA + ai * stride;
-                        DTYPE * bp = (DTYPE*)b->data + k * blockSizeB + bi * stride;
-                        DTYPE * cp = (DTYPE*)c->data + k * blockSizeC + ci * stride;
-                        for (int j = 0; j < stride; j++)
-                            cp[j] = ap[j] * bp[j] + cp[j] * alpha;
-                    }
-                }
-            }
-        }
-        else {
-            // TODO!!
-            ShowNTErrors("TODO!");
-        }
+        /* the kernel is specialized for the data type, the layout and alpha */
+        _KernelBinaryLeading<XOpMul>(a, b, c, leadingDim, alpha);
     }
     else {
         // TODO!!
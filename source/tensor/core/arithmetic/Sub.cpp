@@ -24,6 +24,7 @@
 #include "../../XUtility.h"
 #include "Sub.h"
 #include "Sub.cuh"
+#include "../utilities/XTypedKernel.h"
 #include "SubDim.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
@@ -69,41 +70,9 @@ void _Sub(const XTensor * a, const XTensor * b, XTensor * c, DTYPE beta)
     else {
         if (!a->isSparse && !b->isSparse) {
             CheckNTErrors(!c->isSparse, "Illegal use of sparse tensor in addition!");
-    
-            if (a->dataType == DEFAULT_DTYPE &&
-                b->dataType == DEFAULT_DTYPE &&
-                c->dataType == DEFAULT_DTYPE)
-            {
-                DTYPE * ap = (DTYPE*)a->data;
-                DTYPE * bp = (DTYPE*)b->data;
-                DTYPE * cp = (DTYPE*)c->data;
-    
-                /* unrolling */
-                int num = a->unitNum;
-                if (num % 4 == 0) {
-                    for (int i = 0; i < num; i += 4) {
-                        cp[i] = ap[i] - bp[i] * beta;
-                        cp[i + 1] = ap[i + 1] - bp[i + 1] * beta;
-                        cp[i + 2] = ap[i + 2] - bp[i + 2] * beta;
-                        cp[i + 3] = ap[i + 3] - bp[i + 3] * beta;
-                    }
-                }
-                else if (num % 2 == 0) {
-                    for (int i = 0; i < num; i += 2) {
-                        cp[i] = ap[i] - bp[i] * beta;
-                        cp[i + 1] = ap[i + 1] - bp[i + 1] * beta;
-                    }
-                }
-                else {
-                    for (int i = 0; i < num; i++) {
-                        cp[i] = ap[i] - bp[i] * beta;
-                    }
-                }
-            }
-            else {
-                // TODO!!
-                ShowNTErrors("TODO!");
-            }
+
+            /* the kernel is specialized for the data type and beta */
+            _KernelBinary<XOpSub>(a, b, c, -1, beta, 0);
         }
         else {
             // TODO!!
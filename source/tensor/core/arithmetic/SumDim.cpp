@@ -24,6 +24,7 @@
 #include "Sum.h"
 #include "SumDim.h"
 #include "SumDim.cuh"
+#include "../utilities/XTypedKernel.h"
 #include "../shape/Unsqueeze.h"
 #include "../../XName.h"
 #include "../../XUtility.h"
@@ -86,50 +87,8 @@ void _SumDim(const XTensor * a, const XTensor * b, XTensor * c, int n, DTYPE bet
 #endif
     }
     else{
-        int stride = 1;
-        int blockSize = a->dimSize[n];
-        int blockNum = 1;
-
-        for(int i = a->order - 1; i >= 0; i--){
-            if(i > n)
-                stride *= a->dimSize[i];
-            else if(i < n)
-                blockNum *= a->dimSize[i];
-        }
-    
-        if (a->dataType == DEFAULT_DTYPE){
-            int num = a->unitNum;
-            if(stride > 1){
-                for(int i = 0, j = 0; i < num; i += stride, j++){
-                    DTYPE * ap =   (DTYPE*)a->data + i;
-                    DTYPE   bv = *((DTYPE*)b->data + j % blockSize) * beta;
-                    DTYPE * cp =   (DTYPE*)c->data + i;
-                    for(int k = 0; k < stride; k++)
-                        cp[k] = ap[k] + bv;
-                }
-            }
-            else if(stride == 1){
-                DTYPE * bp = (DTYPE*)b->data;
-                for(int i = 0; i < num; i += blockSize){
-                    DTYPE * ap = (DTYPE*)a->data + i;
-                    DTYPE * cp = (DTYPE*)c->data + i;
-                    if(beta == 1.0F){
-                        for(int j = 0; j < blockSize; j++)
-                            cp[j] = ap[j] + bp[j];
-                    }
-                    else{
-                        for(int j = 0; j < blockSize; j++)
-                            cp[j] = ap[j] + bp[j] * beta;
-                    }
-                }
-            }
-            else{
-                ShowNTErrors("Something is wrong!");
-            }
-        }
-        else {
-            ShowNTErrors("TODO!");
-        }
+        /* the kernel is specialized for the data type, the layout and the coefficients */
+        _KernelBinary<XOpSum>(a, b, c, n, beta, 0);
     }
 }
     
@@ -0,0 +1,86 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Summation over a subset of rows (for row-sparse gradients).
+ */
+
+#include "../../XTensor.h"
+#include "SumRows.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+summation over the given rows of a matrix
+c[r] = a[r] + b[r] * \beta for every row r in rows
+the remaining rows of c are unchanged. The cost is proportional
+to the number of the given rows rather than the size of the matrix.
+
+>> a - a matrix
+>> b - another matrix of the same size
+>> c - where we put a + b * \beta (it can be a or b)
+>> rows - the rows that are involved in the summation
+>> beta - the scaling factor
+*/
+void _SumRows(const XTensor * a, const XTensor * b, XTensor * c, const XSparseRows * rows, DTYPE beta)
+{
+    CheckNTErrors(a && b && c && rows, "Empty tensor input!");
+    CheckNTErrors(XTensor::IsSameShaped(a, b) && XTensor::IsSameShaped(a, c), "Unmatched tensors in addition!");
+    CheckNTErrors(a->order == 2 && a->dimSize[0] == rows->rowNum, "Unmatched row set!");
+    CheckNTErrors(a->dataType == DEFAULT_DTYPE && b->dataType == DEFAULT_DTYPE && c->dataType == DEFAULT_DTYPE,
+                  "TODO!");
+    CheckNTErrors(a->devID < 0 && b->devID < 0 && c->devID < 0, "TODO!");
+
+    int stride = a->dimSize[1];
+    DTYPE * ap = (DTYPE*)a->data;
+    DTYPE * bp = (DTYPE*)b->data;
+    DTYPE * cp = (DTYPE*)c->data;
+
+    for(int k = 0; k < rows->count; k++){
+        int offset = rows->rows[k] * stride;
+        DTYPE * ar = ap + offset;
+        DTYPE * br = bp + offset;
+        DTYPE * cr = cp + offset;
+
+        if(beta == 1.0F){
+            for(int j = 0; j < stride; j++)
+                cr[j] = ar[j] + br[j];
+        }
+        else{
+            for(int j = 0; j < stride; j++)
+                cr[j] = ar[j] + br[j] * beta;
+        }
+    }
+}
+
+/*
+summation over the given rows of a matrix (do it on site)
+keep the result in the input tensor a and return nothing
+
+a[r] = a[r] + b[r] * \beta for every row r in rows
+
+>> a - a matrix
+>> b - another matrix of the same size
+>> rows - the rows that are involved in the summation
+>> beta - the scaling factor
+*/
+void _SumRowsMe(XTensor * a, const XTensor * b, const XSparseRows * rows, DTYPE beta)
+{
+    _SumRows(a, b, a, rows, beta);
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,41 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Summation over a subset of rows, e.g., for updating the parameters
+ * that have row-sparse gradients.
+ */
+
+#ifndef __SUMROWS_H__
+#define __SUMROWS_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* summation over the given rows: c[r] = a[r] + b[r] * \beta for every row r in rows */
+void _SumRows(const XTensor * a, const XTensor * b, XTensor * c, const XSparseRows * rows, DTYPE beta = (DTYPE)1.0);
+
+/* 
+summation over the given rows: a[r] = a[r] + b[r] * \beta for every row r in rows
+keep the result in the input tensor a and return nothing
+*/
+void _SumRowsMe(XTensor * a, const XTensor * b, const XSparseRows * rows, DTYPE beta = (DTYPE)1.0);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __SUMROWS_H__
@@ -22,6 +22,7 @@
 #include "../../XTensor.h"
 #include "ConvertDataType.h"
 #include "ConvertDataType.cuh"
+#include "../utilities/XTypedKernel.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -45,20 +46,11 @@ void _ConvertDataType(const XTensor * input, XTensor * output)
     }
 #endif
 
-    if (input->dataType == X_FLOAT && output->dataType == X_INT) {
-        float * inputData = (float*)input->data;
-        int * outputData = (int*)output->data;
-        for (int i = 0; i < input->unitNum; i++) 
-            outputData[i] = (int)inputData[i];
-    }
-    else if (input->dataType == X_INT && output->dataType == X_FLOAT) {
-        int * inputData = (int*)input->data;
-        float * outputData = (float*)output->data;
-        for (int i = 0; i < input->unitNum; i++) 
-            outputData[i] = (float)inputData[i];
-    }
-    else
-        ShowNTErrors("Unsupported data types for conversion!");
+    CheckNTErrors(!input->isSparse && !output->isSparse, "Dense tensors are required!");
+    CheckNTErrors(input->unitNum == output->unitNum, "Unmatched tensors!");
+
+    /* the kernel is specialized for the pair of data types */
+    _KernelConvert(input->data, input->dataType, output->data, output->dataType, input->unitNum);
 
 }
 } // namespace nts(NiuTrans.Tensor)
\ No newline at end of file
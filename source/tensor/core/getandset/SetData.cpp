@@ -264,6 +264,29 @@ void _SetDataDim(XTensor * tensor, int beg, int len, int dim, DTYPE p)
     }
 }
 
+/* 
+set the given rows of a matrix to a fixed value p (and keep the remaining rows unchanged).
+The cost is proportional to the number of the given rows, e.g., this is used to clear
+row-sparse gradients.
+>> tensor - the matrix whose data array would be set
+>> rows - the rows to set
+>> p - the value
+*/
+void _SetDataRows(XTensor * tensor, const XSparseRows * rows, DTYPE p)
+{
+    CheckNTErrors(tensor->dataType == DEFAULT_DTYPE, "TODO!");
+    CheckNTErrors(tensor->order == 2 && tensor->dimSize[0] == rows->rowNum, "Unmatched row set!");
+    CheckNTErrors(tensor->devID < 0, "TODO!");
+
+    int stride = tensor->dimSize[1];
+
+    for(int k = 0; k < rows->count; k++){
+        DTYPE * d = (DTYPE*)tensor->data + rows->rows[k] * stride;
+        for(int j = 0; j < stride; j++)
+            d[j] = p;
+    }
+}
+
 /* 
 modify data items along with a given index and dimension (and keep the remaining items unchanged) 
 >> source - the tensor whose data array would be modified
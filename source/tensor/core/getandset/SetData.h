@@ -48,6 +48,9 @@ void _SetDataFixedDouble(XTensor * tensor, double p);
 /* set data items along with a given dimension (and keep the remaining items unchanged) */
 void _SetDataDim(XTensor * tensor, int beg, int len, int dim, DTYPE p);
 
+/* set the given rows of a matrix to a fixed value p (and keep the remaining rows unchanged) */
+void _SetDataRows(XTensor * tensor, const XSparseRows * rows, DTYPE p);
+
 /* modify data items along with a given index and dimension (and keep the remaining items unchanged) */
 void _SetDataIndexed(XTensor * source, XTensor * modify, int dim, int index);
 
@@ -24,6 +24,7 @@
 #include "../../XUtility.h"
 #include "ScaleAndShift.h"
 #include "ScaleAndShift.cuh"
+#include "../utilities/XTypedKernel.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
 
@@ -47,10 +48,10 @@ void _ScaleAndShift(const XTensor * a, XTensor * b, DTYPE scale, DTYPE shift)
     }
 #endif
 
-    CheckNTErrors((a->dataType == DEFAULT_DTYPE), "The tensor is not in the default data type!");
-
     /* sparse tensor */
     if(a->isSparse){
+        CheckNTErrors((a->dataType == DEFAULT_DTYPE), "The tensor is not in the default data type!");
+
         int num = a->unitNumNonZero;
         char * d = (char*)a->data + sizeof(int);
         char * f = d + (sizeof(int) + sizeof(DTYPE)) * 0 + sizeof(int);
@@ -66,13 +67,8 @@ void _ScaleAndShift(const XTensor * a, XTensor * b, DTYPE scale, DTYPE shift)
     }
     /* dense tensor */
     else{
-        DTYPE * va = (DTYPE*)a->data;
-        DTYPE * vb = (DTYPE*)b->data;
-        for(int i = 0; i < b->unitNum; i++){
-            *vb = *va * scale + shift;
-            va++;
-            vb++;
-        }
+        /* the kernel is specialized for the data type */
+        _KernelScaleAndShift(a, b, scale, shift);
     }
 }
 
@@ -89,15 +89,7 @@ void _CopyBlocks(void * source, int blockSize, int * sourceBlocks, int blockNum,
 #endif
     }
     else {
-        /* 
-        The following code should be fine with GPUs, but too many
-        kernel calls would slow down the system. We prefer to use
-        one kernel to do block copy in batch (kernel fusion). 
-        */
-        for (int i = 0; i < blockNum; i++) {
-            XMemCopy((char*)target + targetBlocks[i] * blockSize, devID,
-                     (char*)source + sourceBlocks[i] * blockSize, devID, blockSize);
-        }
+        _CopyBlocksCPU(source, blockSize, sourceBlocks, blockNum, target, targetBlocks, globalPRunner);
     }
 }
 
@@ -19,13 +19,170 @@
 * $Created by: XIAO Tong (email: xiaotong@mail.neu.edu.cn) 2018-04-24
 */
 
+#include <string.h>
+#include <limits.h>
 #include "../../XTensor.h"
 #include "../../XUtility.h"
+#include "../utilities/XMatrixSegment.h"
 #include "CopyBlocksOnSite.h"
 #include "CopyBlocksOnSite.cuh"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_STREAM_STORE
+#endif
+
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
+/*
+copy a piece of memory with non-temporal stores, i.e., the target is written
+to the memory directly and does not evict the data in the caches
+>> t - target
+>> s - source
+>> size - size of the memory (in bytes)
+*/
+void _MemCopyStream(char * t, const char * s, MTYPE size)
+{
+#ifdef USE_STREAM_STORE
+    /* the stores need a target aligned to 16 bytes */
+    MTYPE head = MIN((16 - ((MTYPE)t & 15)) & 15, size);
+    memcpy(t, s, head);
+    t += head;
+    s += head;
+    size -= head;
+
+    MTYPE lineNum = size / 64;
+    for (MTYPE i = 0; i < lineNum; i++) {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)s);
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_stream_si128((__m128i*)t, v0);
+        _mm_stream_si128((__m128i*)(t + 16), v1);
+        _mm_stream_si128((__m128i*)(t + 32), v2);
+        _mm_stream_si128((__m128i*)(t + 48), v3);
+        s += 64;
+        t += 64;
+    }
+
+    memcpy(t, s, size & 63);
+#else
+    memcpy(t, s, size);
+#endif
+}
+
+/*
+copy the blocks in a range of the data. The range is a number of chunks
+(of COPY_CHUNK_SIZE bytes) of the blocks in the order of copy. The blocks
+next to each other in both the source and the target are copied in a run.
+>> beg - the first chunk
+>> end - the chunk after the last one
+>> source - data array (head of the blocks) to copy from
+>> blockSize - size of block
+>> sourceBlocks - source positions of the copy (NULL means block i is at position i)
+>> blockNum - number of blocks
+>> target - target data array
+>> targetBlocks - target positions of the copy
+>> useStream - indicates whether the long runs are written with non-temporal stores
+*/
+void _CopyBlocksInRange(int beg, int end, char * source, int blockSize, int * sourceBlocks, int blockNum,
+                        char * target, int * targetBlocks, bool useStream)
+{
+    MTYPE size = (MTYPE)blockSize * blockNum;
+    MTYPE pos = (MTYPE)beg * COPY_CHUNK_SIZE;
+    MTYPE posEnd = MIN((MTYPE)end * COPY_CHUNK_SIZE, size);
+
+    while (pos < posEnd) {
+        int i = (int)(pos / blockSize);
+        MTYPE offset = pos - (MTYPE)i * blockSize;
+
+        /* extend the run as long as the blocks are next to each other */
+        int j = i;
+        while (j + 1 < blockNum && (MTYPE)(j + 1) * blockSize < posEnd &&
+               targetBlocks[j + 1] == targetBlocks[j] + 1 &&
+               (sourceBlocks == NULL || sourceBlocks[j + 1] == sourceBlocks[j] + 1))
+            j++;
+
+        MTYPE runEnd = MIN((MTYPE)(j + 1) * blockSize, posEnd);
+        MTYPE runSize = runEnd - pos;
+        int s = sourceBlocks == NULL ? i : sourceBlocks[i];
+        char * tp = target + (MTYPE)targetBlocks[i] * blockSize + offset;
+        char * sp = source + (MTYPE)s * blockSize + offset;
+
+        if (runSize == sizeof(int))
+            *(int*)tp = *(int*)sp;
+        else if (useStream && runSize >= MIN_STREAM_COPY_RUN_SIZE)
+            _MemCopyStream(tp, sp, runSize);
+        else if (tp != sp)
+            memcpy(tp, sp, runSize);
+
+        pos = runEnd;
+    }
+
+#ifdef USE_STREAM_STORE
+    /* make the non-temporal stores visible to the other threads */
+    if (useStream)
+        _mm_sfence();
+#endif
+}
+
+/*
+copy the blocks in a range of the data (for multi-threading)
+>> args - the arguments: the range, source, blockSize, sourceBlocks, blockNum,
+           target, targetBlocks and useStream (see _CopyBlocksInRange)
+*/
+void _CopyBlocksInRangeJob(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    char * source = (char*)args->GetItem(2);
+    int blockSize = *(int*)args->GetItem(3);
+    int * sourceBlocks = (int*)args->GetItem(4);
+    int blockNum = *(int*)args->GetItem(5);
+    char * target = (char*)args->GetItem(6);
+    int * targetBlocks = (int*)args->GetItem(7);
+    bool useStream = *(bool*)args->GetItem(8);
+
+    _CopyBlocksInRange(beg, end, source, blockSize, sourceBlocks, blockNum, target, targetBlocks, useStream);
+}
+
+/*
+copy a number of blocks on CPUs. The blocks next to each other (in both the
+source and the target) are copied in one run, large copies are split into
+pieces for the threads, and long runs of very large copies are written with
+non-temporal stores as the data would not fit in the caches anyway.
+>> source - data array (head of the blocks) to copy from
+>> blockSize - size of block
+>> sourceBlocks - source positions of the copy (NULL means block i is at position i)
+>> blockNum - number of blocks
+>> target - target data array
+>> targetBlocks - target positions of the copy
+>> parallelRunner - parallel processing module. The tensor operators pass 
+                    globalPRunner, which the samples create with "-nthread". 
+                    The copy runs on the calling thread if it is NULL.
+*/
+void _CopyBlocksCPU(void * source, int blockSize, int * sourceBlocks, int blockNum, void * target, int * targetBlocks,
+                    XPRunner * parallelRunner)
+{
+    MTYPE size = (MTYPE)blockSize * blockNum;
+    if (size == 0)
+        return;
+
+    CheckNTErrors(size / COPY_CHUNK_SIZE < INT_MAX, "Too large copy!");
+
+    int chunkNum = (int)((size + COPY_CHUNK_SIZE - 1) / COPY_CHUNK_SIZE);
+    bool useStream = size >= MIN_STREAM_COPY_SIZE;
+
+    if (parallelRunner == NULL || size < MIN_PARALLEL_COPY_SIZE) {
+        _CopyBlocksInRange(0, chunkNum, (char*)source, blockSize, sourceBlocks, blockNum,
+                           (char*)target, targetBlocks, useStream);
+        return;
+    }
+
+    RunParallel1D(parallelRunner, (void*)_CopyBlocksInRangeJob, (int)MIN(size, (MTYPE)INT_MAX), chunkNum, 7,
+                  source, &blockSize, sourceBlocks, &blockNum, target, targetBlocks, &useStream);
+}
+
 /*
 copy a number of blocks to target positions. Here we assume that
 all the data has been on the device (CPU/GPU) already.
@@ -46,23 +203,8 @@ void _CopyBlocksOnSite(void * source, int blockSize, int blockNum, void * target
 #endif
     }
     else {
-        /* 
-        The following code should be fine with GPUs, but too many
-        kernel calls would slow down the system. We prefer to use
-        one kernel to do block copy in batch (kernel fusion). 
-        */
-        if(blockSize == sizeof(int)){
-            for (int i = 0, b = 0; i < blockNum; i++, b += blockSize) {
-                *(int*)((char*)target + targetBlocks[i] * blockSize) = 
-                *(int*)((char*)source + b);
-            }
-        }
-        else{
-            for (int i = 0, b = 0; i < blockNum; i++, b += blockSize) {
-                XMemCopy((char*)target + targetBlocks[i] * blockSize, devID,
-                         (char*)source + b, devID, blockSize);
-            }
-        }
+        _CopyBlocksCPU(source, blockSize, NULL, blockNum, target, targetBlocks, globalPRunner);
     }
 }
+
 } // namespace nts(NiuTrans.Tensor)
@@ -26,9 +26,26 @@
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
+/* copies (in bytes) that are large enough to run in parallel */
+#define MIN_PARALLEL_COPY_SIZE (1024 * 256)
+
+/* copies (in bytes) that are large enough to bypass the caches, i.e., 
+   the runs of the copy are written with non-temporal stores */
+#define MIN_STREAM_COPY_SIZE (1024 * 1024 * 8)
+
+/* the shortest run (in bytes) that is written with non-temporal stores */
+#define MIN_STREAM_COPY_RUN_SIZE (1024 * 4)
+
+/* the piece of data (in bytes) that we assign to the threads */
+#define COPY_CHUNK_SIZE (1024 * 4)
+
 /* copy a number of blocks to target positions (on site) */
 void _CopyBlocksOnSite(void * source, int blockSize, int blockNum, void * target, int * targetBlocks, int devID);
 
+/* copy a number of blocks on CPUs (the blocks next to each other are copied in runs) */
+void _CopyBlocksCPU(void * source, int blockSize, int * sourceBlocks, int blockNum, void * target, int * targetBlocks,
+                    XPRunner * parallelRunner = NULL);
+
 } // namespace nts(NiuTrans.Tensor)
 
 #endif // __COPYBLOCKSONSITE_H__
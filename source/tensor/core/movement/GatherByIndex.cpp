@@ -0,0 +1,96 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GatherByIndex.h"
+#include "GatherByIndex.cuh"
+#include "../../XUtility.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/*
+gather one entry of each row (along the last dimension) by index, i.e., 
+t[i] = s[i][index[i]]. It reads one number per row instead of multiplying 
+the whole tensor by a one-hot tensor and reducing it, e.g., we pick up 
+the log-probability of the gold word from the output distribution of 
+each position. Rows with a negative index or a zero mask are set to 0.
+
+>> s - the source tensor of size (..., n)
+>> t - the target tensor (the same number of rows as s)
+>> index - the index (X_INT) of the entry in each row
+>> mask - the mask of each row (X_FLOAT, NULL means no mask)
+*/
+void _GatherByIndex(const XTensor * s, XTensor * t, const XTensor * index, const XTensor * mask)
+{
+    CheckNTErrors(s && t && index, "Invalid tensors!");
+    CheckNTErrors(s->devID == t->devID && s->devID == index->devID, 
+                  "the data must be kept on the same device!");
+    CheckNTErrors(s->dataType == DEFAULT_DTYPE && t->dataType == DEFAULT_DTYPE, 
+                  "TODO!");
+    CheckNTErrors(index->dataType == X_INT, "The index must be of type X_INT!");
+
+    int stride = s->GetDim(-1);
+    int rowNum = (int)(s->unitNum / stride);
+
+    CheckNTErrors(index->unitNum == rowNum, "Unmatched index tensor!");
+    CheckNTErrors(t->unitNum == rowNum, "Unmatched target tensor!");
+    CheckNTErrors(mask == NULL || (mask->unitNum == rowNum && mask->devID == s->devID &&
+                                   mask->dataType == DEFAULT_DTYPE), 
+                  "Unmatched mask tensor!");
+
+#ifdef USE_CUDA
+    if (s->devID >= 0) {
+        _CudaGatherByIndex(s, t, index, mask);
+        return;
+    }
+#endif
+
+    DTYPE * sData = (DTYPE*)s->data;
+    DTYPE * tData = (DTYPE*)t->data;
+    DTYPE * mData = mask != NULL ? (DTYPE*)mask->data : NULL;
+    int * iData = (int*)index->data;
+
+    for (int i = 0; i < rowNum; i++) {
+        int id = iData[i];
+        if (id < 0 || (mData != NULL && mData[i] == 0)) {
+            tData[i] = 0;
+            continue;
+        }
+
+        CheckNTErrors(id < stride, "The index is out of range!");
+        tData[i] = sData[(MTYPE)i * stride + id];
+    }
+}
+
+/*
+gather one entry of each row by index (return an XTensor structure)
+make a new tensor to keep the result and return it
+
+>> s - the source tensor of size (..., n)
+>> index - the index (X_INT) of the entry in each row
+<< return - the gathered entries (in the shape of the index tensor)
+*/
+XTensor GatherByIndex(const XTensor &s, const XTensor &index)
+{
+    XTensor t(index.order, index.dimSize, s.dataType, 1.0F, s.devID, s.mem);
+    t.SetTMPFlag();
+
+    _GatherByIndex(&s, &t, &index);
+
+    return t;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,85 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GatherByIndex.cuh"
+#include "../../XDevice.h"
+#include "../../XUtility.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+#ifdef USE_CUDA
+
+/*
+gather one entry of each row by index (cuda kernel)
+
+>> sData - the data pointer of the source tensor
+>> tData - the data pointer of the target tensor
+>> index - the index of the entry in each row
+>> mask - the mask of each row (NULL means no mask)
+>> rowNum - number of rows
+>> stride - size of a row
+*/
+__global__
+void KernelGatherByIndex(DTYPE * sData, DTYPE * tData, int * index, DTYPE * mask, int rowNum, int stride)
+{
+    int i = blockDim.x * blockIdx.x + threadIdx.x;
+
+    if (i >= rowNum)
+        return;
+
+    int id = index[i];
+
+    if (id < 0 || id >= stride || (mask != NULL && mask[i] == 0))
+        tData[i] = 0;
+    else
+        tData[i] = sData[(long long)i * stride + id];
+}
+
+/*
+gather one entry of each row by index (cuda version)
+
+>> s - the source tensor of size (..., n)
+>> t - the target tensor
+>> index - the index (X_INT) of the entry in each row
+>> mask - the mask of each row (NULL means no mask)
+*/
+void _CudaGatherByIndex(const XTensor * s, XTensor * t, const XTensor * index, const XTensor * mask)
+{
+    int devID = s->devID;
+    int stride = s->GetDim(-1);
+    int rowNum = (int)(s->unitNum / stride);
+
+    int cudaGrids[3];
+    int cudaBlocks[3];
+
+    int devIDBackup;
+    ProtectCudaDev(devID, devIDBackup);
+
+    GDevs.GetCudaThread(devID, rowNum, cudaGrids, cudaBlocks);
+
+    dim3 blocks(cudaGrids[0]);
+    dim3 threads(cudaBlocks[0]);
+
+    KernelGatherByIndex<<<blocks, threads>>>((DTYPE*)s->data, (DTYPE*)t->data, (int*)index->data,
+                                             mask != NULL ? (DTYPE*)mask->data : NULL, rowNum, stride);
+
+    BacktoCudaDev(devID, devIDBackup);
+}
+
+#endif // USE_CUDA
+
+} // namespace nts(NiuTrans.Tensor)
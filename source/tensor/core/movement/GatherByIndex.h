@@ -0,0 +1,35 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATHERBYINDEX_H__
+#define __GATHERBYINDEX_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* gather one entry of each row (along the last dimension) by index, 
+   e.g., the score of the gold word at each position */
+void _GatherByIndex(const XTensor * s, XTensor * t, const XTensor * index, const XTensor * mask = NULL);
+
+/* gather one entry of each row by index (return an XTensor structure)
+   make a new tensor to keep the result and return it */
+XTensor GatherByIndex(const XTensor &s, const XTensor &index);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __GATHERBYINDEX_H__
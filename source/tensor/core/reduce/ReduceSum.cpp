@@ -23,6 +23,7 @@
 #include "ReduceSum.h"
 #include "ReduceSum.cuh"
 #include "../../XName.h"
+#include "../arithmetic/Sum.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
 
@@ -39,8 +40,10 @@ sum = \sum_i exp((a_i - shift)^power) if isExp == true
 >> shift - shift the input
 >> ieExp - specify if the exp() is performed
 >> power - we perform pow(item_i, power) on each item in the array
+>> beta - the coefficient of the output. The result is accumulated into
+          the output if beta != 0, i.e., output = sum + output * \beta
 */
-void _ReduceSum(const XTensor * input, XTensor * output, int dim, const XTensor * shift, DTYPE power, bool isExp)
+void _ReduceSum(const XTensor * input, XTensor * output, int dim, const XTensor * shift, DTYPE power, bool isExp, DTYPE beta)
 {
     CheckNTErrors((input->devID == output->devID || (input->devID < 0 && output->devID < 0)), 
                   "This code must be run on the same device!");
@@ -64,7 +67,15 @@ void _ReduceSum(const XTensor * input, XTensor * output, int dim, const XTensor
 
     if(input->devID >= 0){
 #ifdef USE_CUDA
-        _CudaReduceSum(input, output, dim, shift, power, isExp);
+        if(beta != 0){
+            /* we reduce the input into a buffer and then sum it up with the output */
+            XTensor * tmp = NewTensorBuf(output, output->devID, output->mem);
+            _CudaReduceSum(input, tmp, dim, shift, power, isExp);
+            _Sum(tmp, output, output, beta);
+            DelTensorBuf(tmp);
+        }
+        else
+            _CudaReduceSum(input, output, dim, shift, power, isExp);
 #endif
     }
     else{
@@ -191,7 +202,7 @@ void _ReduceSum(const XTensor * input, XTensor * output, int dim, const XTensor
                         }
                     }
                 }
-                *(op + i) = sum;
+                *(op + i) = beta == 0 ? sum : sum + *(op + i) * beta;
             }
         }
     }
@@ -31,9 +31,11 @@ sum the items along a dimension of the tensor
 For a 1-dimensional data array a,
 sum = \sum_i (a_i - shift) if isExp == false
 sum = \sum_i exp(a_i - shift) if isExp == true
+the result is accumulated into the output if beta != 0, i.e.,
+output = sum + output * \beta
 */
 void _ReduceSum(const XTensor * input, XTensor * output, int dim, const XTensor * shift = NULL,
-                DTYPE power = (DTYPE)1.0F, bool isExp = false);
+                DTYPE power = (DTYPE)1.0F, bool isExp = false, DTYPE beta = 0);
 
 /* 
 sum the items along a dimension of the tensor (return an XTensor structure)
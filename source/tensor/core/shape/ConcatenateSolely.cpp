@@ -85,18 +85,15 @@ void _ConcatenateSolely(const XList * smalls, XTensor * big, int dim)
         }
     }
     else {
-        XList * sourceArrays = new XList(smalls->count);
-        int * blockSizes = new int[smalls->count];
+        XList sourceArrays(smalls->count);
+        XSmallList<int, XLIST_INLINE_NUM> blockSizes(smalls->count);
         for (int i = 0; i < smalls->count; i++) {
             XTensor * tensor = (XTensor*)smalls->GetItem(i);
-            blockSizes[i] = stride * tensor->dimSizeRDI[dimRDI] * tensor->unitSize;
-            sourceArrays->Add(tensor->data);
+            blockSizes.Add(stride * tensor->dimSizeRDI[dimRDI] * tensor->unitSize);
+            sourceArrays.Add(tensor->data);
         }
 
-        _MergeBlockLists(sourceArrays, blockSizes, blockNum, big->data, big->mem);
-
-        delete[] blockSizes;
-        delete sourceArrays;
+        _MergeBlockLists(&sourceArrays, blockSizes.items, blockNum, big->data, big->mem);
     }
 }
 } // namespace nts(NiuTrans.Tensor)
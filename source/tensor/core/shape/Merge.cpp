@@ -25,6 +25,7 @@
 #include "Merge.h"
 #include "MakeMergeBlockIndex.h"
 #include "../movement/CopyBlocksOnSite.h"
+#include "../arithmetic/Sum.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -39,8 +40,10 @@ e.g., (N/3, M, 3) -> (N, M)
 >> leadingDim - the leading dimension of merging, take (N/3, M, 3) -> (N, M) 
    for example, whereToMerge = 0 (i.e., the dimension for "N/3")
    leadingDim = 2 (i.e., the dimension for "3")
+>> beta - the coefficient of t. The result is accumulated into t if
+          beta != 0, i.e., t = merge(s) + t * \beta
 */
-void _Merge(const XTensor * s, XTensor * t, int whereToMerge, int leadingDim)
+void _Merge(const XTensor * s, XTensor * t, int whereToMerge, int leadingDim, DTYPE beta)
 {
     if(leadingDim < 0)
         leadingDim = 0;
@@ -94,7 +97,34 @@ void _Merge(const XTensor * s, XTensor * t, int whereToMerge, int leadingDim)
     gridSize = blockNum;
     gridNum = s->unitNum / (blockSize * blockNum);
 
-    if (mergedNum * gridNum <= MIN_TENSOR_MERGE_NUM) {
+    if (beta != 0) {
+        CheckNTErrors((s->dataType == DEFAULT_DTYPE && t->dataType == DEFAULT_DTYPE), "TODO!");
+
+        if (t->devID >= 0) {
+            /* we merge s into a buffer and then sum it up with t */
+            XTensor * tmp = NewTensorBuf(t, t->devID, t->mem);
+            _Merge(s, tmp, whereToMerge, leadingDim);
+            _Sum(tmp, t, t, beta);
+            DelTensorBuf(tmp);
+            return;
+        }
+
+        /* block k * n + r of a grid in s goes to block r * mergedNum + k in t */
+        int n = blockNum / mergedNum;
+        for (int g = 0; g < gridNum; g++) {
+            DTYPE * sData = (DTYPE*)s->data + g * blockSize * blockNum;
+            DTYPE * tData = (DTYPE*)t->data + g * blockSize * blockNum;
+            for (int k = 0; k < mergedNum; k++) {
+                for (int r = 0; r < n; r++) {
+                    DTYPE * sp = sData + (k * n + r) * blockSize;
+                    DTYPE * tp = tData + (r * mergedNum + k) * blockSize;
+                    for (int i = 0; i < blockSize; i++)
+                        tp[i] = sp[i] + tp[i] * beta;
+                }
+            }
+        }
+    }
+    else if (mergedNum * gridNum <= MIN_TENSOR_MERGE_NUM) {
         int sPitch = blockSize * s->unitSize;
         int tPtich = blockSize * mergedNum * t->unitSize;
         int mSize = blockSize * t->unitSize;
@@ -26,8 +26,9 @@
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
-/* transform a tensor by merging it alone with a dimension, e.g., (M, N/3, 3) -> (M, N) */
-void _Merge(const XTensor * s, XTensor * t, int whereToMerge, int leadingDim = -1);
+/* transform a tensor by merging it alone with a dimension, e.g., (M, N/3, 3) -> (M, N).
+   The result is accumulated into t if beta != 0, i.e., t = merge(s) + t * \beta */
+void _Merge(const XTensor * s, XTensor * t, int whereToMerge, int leadingDim = -1, DTYPE beta = 0);
 
 /* transform a tensor by merging it alone with a dimension (return an XTensor structure)
    e.g., (M, N/3, 3) -> (M, N) */
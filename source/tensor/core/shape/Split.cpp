@@ -27,6 +27,7 @@
 #include "../../XDevice.h"
 #include "../../XUtility.h"
 #include "../movement/CopyBlocksOnSite.h"
+#include "../arithmetic/Sum.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -37,8 +38,10 @@ transform a tensor by splitting it, e.g., (N, M) -> (N/3, M, 3)
 >> t - the target tensor (for return)
 >> whereToSplit - which dimension of the tensor is to split
 >> splitNum - how many splits
+>> beta - the coefficient of t. The result is accumulated into t if 
+          beta != 0, i.e., t = split(s) + t * \beta
 */
-void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum)
+void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum, DTYPE beta)
 {
     CheckNTErrors((s && t), "Invalid tensors!");
     CheckNTErrors((s->devID == t->devID || (s->devID < 0 && t->devID < 0)),
@@ -60,6 +63,25 @@ void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum)
         }
     }
 
+    if (beta != 0) {
+        CheckNTErrors((s->dataType == DEFAULT_DTYPE && t->dataType == DEFAULT_DTYPE), "TODO!");
+
+        /* s and t have the same memory layout if we split the last dimension */
+        if (s->order - 1 == whereToSplitRDI) {
+            _Sum(s, t, t, beta);
+            return;
+        }
+
+        /* on GPUs we split s into a buffer and then sum it up with t */
+        if (t->devID >= 0) {
+            XTensor * tmp = NewTensorBuf(t, t->devID, t->mem);
+            _Split(s, tmp, whereToSplit, splitNum);
+            _Sum(tmp, t, t, beta);
+            DelTensorBuf(tmp);
+            return;
+        }
+    }
+
     /* for the case that we split the last dimension. Actually
     (N, M) and (N, M/3, 3) have the same memory layout */
     if (s->order - 1 == whereToSplitRDI) {
@@ -82,7 +104,19 @@ void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum)
 
     CheckNTErrors((blockNum % splitNum == 0), "Incorrect split number!");
 
-    if (splitNum <= MIN_TENSOR_SPLIT_NUM) {
+    if (beta != 0) {
+        /* block r * splitNum + k in s goes to block k * n + r in t */
+        int n = blockNum / splitNum;
+        for (int k = 0; k < splitNum; k++) {
+            for (int r = 0; r < n; r++) {
+                DTYPE * sp = (DTYPE*)s->data + (r * splitNum + k) * blockSize;
+                DTYPE * tp = (DTYPE*)t->data + (k * n + r) * blockSize;
+                for (int i = 0; i < blockSize; i++)
+                    tp[i] = sp[i] + tp[i] * beta;
+            }
+        }
+    }
+    else if (splitNum <= MIN_TENSOR_SPLIT_NUM) {
         int sPitch = blockSize * splitNum * s->unitSize;
         int tPitch = blockSize * t->unitSize;
         int mSize = blockSize * t->unitSize;
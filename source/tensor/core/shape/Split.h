@@ -31,8 +31,9 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 /* 
 transform a tensor by splitting it 
 e.g., (M, N) -> (M, N/3, 3) 
+the result is accumulated into t if beta != 0, i.e., t = split(s) + t * \beta
 */
-void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum);
+void _Split(const XTensor * s, XTensor * t, int whereToSplit, int splitNum, DTYPE beta = 0);
 
 /* 
 transform a tensor by splitting it (return an XTensor structure)
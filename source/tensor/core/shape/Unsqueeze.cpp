@@ -29,14 +29,17 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 
 /*
 insert a dimension by copying the blocks for x times
-(where x is the size of the inerted dimension)
+(where x is the size of the inerted dimension), i.e.,
+b = unsqueeze(a) + b * \beta
 
 >> a - input tensor
 >> b - output tensor
 >> dim - where to insert the dimension
 >> dSize - size of the newly-inserted dimension
+>> beta - the coefficient of b. The result is accumulated into b if 
+          beta != 0 (e.g., for gradient accumulation)
 */
-void _Unsqueeze(const XTensor * a, XTensor * b, int dim, int dSize)
+void _Unsqueeze(const XTensor * a, XTensor * b, int dim, int dSize, DTYPE beta)
 {
     CheckNTErrors((a && b), "Empty input tensors!");
     CheckNTErrors((a->order == b->order - 1), "Unmatched tensors!");
@@ -69,30 +72,39 @@ void _Unsqueeze(const XTensor * a, XTensor * b, int dim, int dSize)
     blockNumB = b->unitNum / blockSize;
 
     CheckNTErrors((blockNumA * dSize == blockNumB), "Unmatched tensors!");
+    CheckNTErrors((beta == 0 || (a->dataType == DEFAULT_DTYPE && b->dataType == DEFAULT_DTYPE)),
+                  "TODO!");
 
     if (a->devID >= 0 || b->devID >= 0) {
 #ifdef USE_CUDA
-        _CudaUnsqueeze(a, b, dim, dSize);
+        _CudaUnsqueeze(a, b, dim, dSize, beta);
 #else
         ShowNTErrors("Please specify USE_CUDA and recompile the code!");
 #endif
     }
+    else if (beta != 0) {
+        for (int i = 0; i < blockNumA; i++) {
+            DTYPE * ap = (DTYPE*)a->data + i * blockSize;
+            DTYPE * bp = (DTYPE*)b->data + i * dSize * blockSize;
+            for (int j = 0; j < dSize; j++, bp += blockSize) {
+                for (int k = 0; k < blockSize; k++)
+                    bp[k] = ap[k] + bp[k] * beta;
+            }
+        }
+    }
     else {
-        XList * sourceArrays = new XList(blockNumB);
-        int * blockSizes = new int[blockNumB];
+        XList sourceArrays(blockNumB);
+        XSmallList<int, XLIST_INLINE_NUM> blockSizes(blockNumB);
 
         for (int i = 0; i < blockNumA; i++) {
             char * ap = (char*)a->data + i * realBlockSize;
             for (int j = 0; j < dSize; j++) {
-                sourceArrays->Add(ap);
-                blockSizes[i * dSize + j] = realBlockSize;
+                sourceArrays.Add(ap);
+                blockSizes.Add(realBlockSize);
             }
         }
 
-        _MergeBlockLists(sourceArrays, blockSizes, 1, b->data, b->mem);
-
-        delete sourceArrays;
-        delete[] blockSizes;
+        _MergeBlockLists(&sourceArrays, blockSizes.items, 1, b->data, b->mem);
     }
 }
 
@@ -223,14 +223,40 @@ void KernelUnsqueezeByColBigRow(void * s, int rowNum, int colNum, void * t)
     tData[i] = value;
 }
 
+/*
+insert a dimension by copying the blocks for n times and accumulate 
+the result into the target, i.e., t = unsqueeze(s) + t * beta
+>> s - pointer to the source data array
+>> blockSize - size of a block
+>> n - number of blocks to copy data
+>> t - pointer to the target data array
+>> size - size of the target data array
+>> beta - the coefficient of the target
+*/
+__global__
+void KernelUnsqueezeAccumulate(DTYPE * s, int blockSize, int n, DTYPE * t, int size, DTYPE beta)
+{
+    /* index of data items */
+    int i = blockDim.x * blockIdx.x + threadIdx.x;
+
+    if (i >= size)
+        return;
+
+    int offset = i % blockSize;
+    int block = i / (blockSize * n);
+
+    t[i] = s[block * blockSize + offset] + t[i] * beta;
+}
+
 /*
 insert a dimension by copying the blocks for x times (where x is the size of the inerted dimension)
 >> a - input tensor
 >> b - output tensor
 >> dim - where to insert the dimension
 >> dSize - size of the newly-inserted dimension
+>> beta - the coefficient of b, i.e., b = unsqueeze(a) + b * beta
 */
-void _CudaUnsqueeze(const XTensor * a, XTensor * b, int dim, int dSize)
+void _CudaUnsqueeze(const XTensor * a, XTensor * b, int dim, int dSize, DTYPE beta)
 {
     int blockSize = 1;
     int blockNumA = 1;
@@ -250,7 +276,13 @@ void _CudaUnsqueeze(const XTensor * a, XTensor * b, int dim, int dSize)
     int devIDBackup = 0;
     ProtectCudaDev(a->devID, devIDBackup);
 
-    if (dimRDI == 0) {
+    if (beta != 0) {
+        GDevs.GetCudaThread(a->devID, b->unitNum, cudaGrids, cudaBlocks);
+
+        KernelUnsqueezeAccumulate << <dim3(cudaGrids[0]), dim3(cudaBlocks[0]) >> >
+                                     ((DTYPE*)a->data, blockSize, dSize, (DTYPE*)b->data, b->unitNum, beta);
+    }
+    else if (dimRDI == 0) {
         GDevs.GetCudaThread2D(a->devID, dSize, blockNumA, MAX_INT, cudaGrids, cudaBlocks);
 
         if (a->dataType == X_FLOAT && b->dataType == X_FLOAT) {
@@ -29,7 +29,7 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 #ifdef USE_CUDA
 
 /* duplicate the data along a given dimension */
-void _CudaUnsqueeze(const XTensor * a, XTensor * b, int dim, int dSize);
+void _CudaUnsqueeze(const XTensor * a, XTensor * b, int dim, int dSize, DTYPE beta = 0);
 
 #endif // USE_CUDA
 
@@ -27,8 +27,9 @@
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
 /* insert a dimension by copying the blocks for x times 
-  (where x is the size of the inerted dimension) */
-void _Unsqueeze(const XTensor * a, XTensor * b, int dim, int dSize);
+  (where x is the size of the inerted dimension), i.e., 
+  b = unsqueeze(a) + b * \beta */
+void _Unsqueeze(const XTensor * a, XTensor * b, int dim, int dSize, DTYPE beta = 0);
 
 /* insert a dimension by copying the blocks for x times 
   (where x is the size of the inerted dimension) (return an XTensor structure)
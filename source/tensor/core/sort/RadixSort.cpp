@@ -0,0 +1,617 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* The CPU selection engine for TopK and Sort.
+*/
+
+#include <string.h>
+#include "../../XTensor.h"
+#include "../utilities/XMatrixSegment.h"
+#include "RadixSort.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+map a float to an unsigned key. A smaller key means a larger value, so that
+sorting the keys in ascending order sorts the values in descending order.
+*/
+inline unsigned int ToDescendingKey(float v)
+{
+    unsigned int u;
+    memcpy(&u, &v, sizeof(unsigned int));
+    u = (u & 0x80000000) ? ~u : (u | 0x80000000);
+    return ~u;
+}
+
+/*
+compute the keys of a (contiguous) data array
+>> data - the data array
+>> num - number of items
+>> keys - the resulting keys
+*/
+void MakeDescendingKeys(const float * data, int num, unsigned int * keys)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i signBit = _mm_set1_epi32((int)0x80000000);
+    const __m128i allOnes = _mm_set1_epi32(-1);
+    for (; i + 4 <= num; i += 4) {
+        __m128i u = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i sign = _mm_srai_epi32(u, 31);
+        __m128i asc = _mm_xor_si128(u, _mm_or_si128(sign, signBit));
+        _mm_storeu_si128((__m128i*)(keys + i), _mm_xor_si128(asc, allOnes));
+    }
+#endif
+    for (; i < num; i++)
+        keys[i] = ToDescendingKey(data[i]);
+}
+
+/*
+sort key-value pairs in ascending order of the keys by insertion (stable)
+>> keys - the keys
+>> values - the values that go with the keys
+>> num - number of items
+*/
+void InsertionSortPairs(unsigned int * keys, int * values, int num)
+{
+    for (int i = 1; i < num; i++) {
+        unsigned int key = keys[i];
+        int value = values[i];
+        int j = i - 1;
+        while (j >= 0 && keys[j] > key) {
+            keys[j + 1] = keys[j];
+            values[j + 1] = values[j];
+            j--;
+        }
+        keys[j + 1] = key;
+        values[j + 1] = value;
+    }
+}
+
+/*
+stable LSD radix sort of key-value pairs (in ascending order of the keys).
+Passes where all the keys share the same digit are skipped.
+>> keys - the keys
+>> values - the values that go with the keys
+>> num - number of items
+>> tmpKeys - buffer of num keys
+>> tmpValues - buffer of num values
+*/
+void RadixSortPairs(unsigned int * keys, int * values, int num,
+                    unsigned int * tmpKeys, int * tmpValues)
+{
+    if (num <= RADIX_SHORT_ROW) {
+        InsertionSortPairs(keys, values, num);
+        return;
+    }
+
+    const int passNum = (32 + RADIX_BITS - 1) / RADIX_BITS;
+    int hist[passNum][RADIX_BUCKET_NUM];
+    memset(hist, 0, sizeof(hist));
+
+    /* histograms of all digits in a single pass */
+    for (int i = 0; i < num; i++) {
+        unsigned int key = keys[i];
+        for (int p = 0; p < passNum; p++)
+            hist[p][(key >> (p * RADIX_BITS)) & (RADIX_BUCKET_NUM - 1)]++;
+    }
+
+    unsigned int * srcKeys = keys;
+    int * srcValues = values;
+    unsigned int * tgtKeys = tmpKeys;
+    int * tgtValues = tmpValues;
+
+    for (int p = 0; p < passNum; p++) {
+        int * h = hist[p];
+        int shift = p * RADIX_BITS;
+
+        /* all the keys fall into the same bucket */
+        if (h[(srcKeys[0] >> shift) & (RADIX_BUCKET_NUM - 1)] == num)
+            continue;
+
+        int offset = 0;
+        for (int d = 0; d < RADIX_BUCKET_NUM; d++) {
+            int c = h[d];
+            h[d] = offset;
+            offset += c;
+        }
+
+        for (int i = 0; i < num; i++) {
+            unsigned int key = srcKeys[i];
+            int pos = h[(key >> shift) & (RADIX_BUCKET_NUM - 1)]++;
+            tgtKeys[pos] = key;
+            tgtValues[pos] = srcValues[i];
+        }
+
+        unsigned int * swapKeys = srcKeys;
+        int * swapValues = srcValues;
+        srcKeys = tgtKeys;
+        srcValues = tgtValues;
+        tgtKeys = swapKeys;
+        tgtValues = swapValues;
+    }
+
+    if (srcKeys != keys) {
+        memcpy(keys, srcKeys, sizeof(unsigned int) * num);
+        memcpy(values, srcValues, sizeof(int) * num);
+    }
+}
+
+/*
+find the digit (bucket) where the k-th smallest key lies
+>> hist - histogram of the digits
+>> k - the rank we are looking for (k >= 1)
+>> before - number of items in the buckets before the resulting one
+<< return - the digit
+*/
+int FindRadixBucket(const int * hist, int k, int * before)
+{
+    int sum = 0;
+    for (int d = 0; d < RADIX_BUCKET_NUM; d++) {
+        if (sum + hist[d] >= k) {
+            *before = sum;
+            return d;
+        }
+        sum += hist[d];
+    }
+    *before = sum;
+    return RADIX_BUCKET_NUM - 1;
+}
+
+/*
+select the k smallest keys of a row by radix selection. The selected items
+are returned in ascending order of the keys (ties are in ascending order
+of the positions).
+>> keys - keys of the row
+>> num - number of items in the row
+>> k - number of the items to select (1 <= k < num)
+>> selKeys - keys of the selected items (k items)
+>> selPos - positions of the selected items (k items)
+>> candKeys - buffer of num keys
+>> candPos - buffer of num positions
+>> tmpKeys - buffer of k keys
+>> tmpPos - buffer of k positions
+*/
+void RadixSelectRow(const unsigned int * keys, int num, int k,
+                    unsigned int * selKeys, int * selPos,
+                    unsigned int * candKeys, int * candPos,
+                    unsigned int * tmpKeys, int * tmpPos)
+{
+    int hist[RADIX_BUCKET_NUM];
+    int subHist[4][RADIX_BUCKET_NUM];
+    int shift = 32 - RADIX_BITS;
+
+    /*
+    histogram on the leading bits. The keys of a row are often in a few
+    buckets, so we count with four sub-histograms to break the dependency
+    between successive increments of the same counter.
+    */
+    memset(subHist, 0, sizeof(subHist));
+    int n4 = num - num % 4;
+    for (int i = 0; i < n4; i += 4) {
+        subHist[0][keys[i] >> shift]++;
+        subHist[1][keys[i + 1] >> shift]++;
+        subHist[2][keys[i + 2] >> shift]++;
+        subHist[3][keys[i + 3] >> shift]++;
+    }
+    for (int i = n4; i < num; i++)
+        subHist[0][keys[i] >> shift]++;
+    for (int d = 0; d < RADIX_BUCKET_NUM; d++)
+        hist[d] = subHist[0][d] + subHist[1][d] + subHist[2][d] + subHist[3][d];
+
+    int before = 0;
+    unsigned int digit = (unsigned int)FindRadixBucket(hist, k, &before);
+    unsigned int low = digit << shift;
+    unsigned int high = ((digit + 1) << shift) - 1;
+
+    /*
+    threshold filtering: the items in the buckets before "digit" are selected
+    and the items in the bucket "digit" are the candidates for the next round
+    */
+    int selNum = 0;
+    int candNum = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i signBit = _mm_set1_epi32((int)0x80000000);
+    const __m128i highS = _mm_set1_epi32((int)(high ^ 0x80000000));
+    for (; i + 4 <= num; i += 4) {
+        __m128i k4 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), signBit);
+        int mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k4, highS))) & 0xF;
+        while (mask != 0) {
+            int lane = __builtin_ctz(mask);
+            unsigned int key = keys[i + lane];
+            if (key < low) {
+                selKeys[selNum] = key;
+                selPos[selNum++] = i + lane;
+            }
+            else {
+                candKeys[candNum] = key;
+                candPos[candNum++] = i + lane;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < num; i++) {
+        unsigned int key = keys[i];
+        if (key < low) {
+            selKeys[selNum] = key;
+            selPos[selNum++] = i;
+        }
+        else if (key <= high) {
+            candKeys[candNum] = key;
+            candPos[candNum++] = i;
+        }
+    }
+
+    /* refine the candidates with the following digits */
+    int need = k - selNum;
+    while (need > 0 && need < candNum && shift > 0) {
+        int bits = shift < RADIX_BITS ? shift : RADIX_BITS;
+        unsigned int mask = (1U << bits) - 1;
+        shift -= bits;
+
+        memset(hist, 0, sizeof(int) * (mask + 1));
+        for (int j = 0; j < candNum; j++)
+            hist[(candKeys[j] >> shift) & mask]++;
+
+        int d = FindRadixBucket(hist, need, &before);
+        int m = 0;
+        for (int j = 0; j < candNum; j++) {
+            int dj = (int)((candKeys[j] >> shift) & mask);
+            if (dj < d) {
+                selKeys[selNum] = candKeys[j];
+                selPos[selNum++] = candPos[j];
+            }
+            else if (dj == d) {
+                candKeys[m] = candKeys[j];
+                candPos[m++] = candPos[j];
+            }
+        }
+        candNum = m;
+        need = k - selNum;
+    }
+
+    /* the rest of the candidates have the same key (or all of them are needed) */
+    for (int j = 0; j < need; j++) {
+        selKeys[selNum] = candKeys[j];
+        selPos[selNum++] = candPos[j];
+    }
+
+    RadixSortPairs(selKeys, selPos, k, tmpKeys, tmpPos);
+}
+
+/* is item (key1, pos1) worse than item (key2, pos2) */
+inline bool IsWorse(unsigned int key1, int pos1, unsigned int key2, int pos2)
+{
+    return key1 > key2 || (key1 == key2 && pos1 > pos2);
+}
+
+/*
+move item i of the heap down the tree (the worst item is on the top)
+>> keys - keys of the heap items
+>> pos - positions of the heap items
+>> i - the item to move
+>> num - number of items in the heap
+*/
+inline void HeapDown(unsigned int * keys, int * pos, int i, int num)
+{
+    unsigned int key = keys[i];
+    int p = pos[i];
+    while (2 * i + 1 < num) {
+        int m = 2 * i + 1;
+        if (m + 1 < num && IsWorse(keys[m + 1], pos[m + 1], keys[m], pos[m]))
+            m++;
+        if (!IsWorse(keys[m], pos[m], key, p))
+            break;
+        keys[i] = keys[m];
+        pos[i] = pos[m];
+        i = m;
+    }
+    keys[i] = key;
+    pos[i] = p;
+}
+
+/*
+select the top-k items of a row with a heap that keeps the best k items
+seen so far. The heap is only touched when an item can beat the worst one
+in it, and groups of items that cannot are skipped by a vectorized
+comparison against that threshold. This is the choice for small k where
+most of the row is filtered out. The selected items are returned from the
+best to the worst (ties are in ascending order of the positions).
+>> row - the data array of the row
+>> num - number of items in the row
+>> k - number of the items to select (1 <= k < num)
+>> selKeys - keys of the selected items (k items)
+>> selPos - positions of the selected items (k items)
+*/
+void HeapSelectRow(const float * row, int num, int k, unsigned int * selKeys, int * selPos)
+{
+    for (int i = 0; i < k; i++) {
+        selKeys[i] = ToDescendingKey(row[i]);
+        selPos[i] = i;
+    }
+    for (int i = k / 2 - 1; i >= 0; i--)
+        HeapDown(selKeys, selPos, i, k);
+
+    float threshold = row[selPos[0]];
+    int i = k;
+
+#ifdef __AVX__
+    for (; i + 8 <= num; i += 8) {
+        __m256 v = _mm256_loadu_ps(row + i);
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_set1_ps(threshold), _CMP_GE_OQ));
+        while (mask != 0) {
+            int j = i + __builtin_ctz(mask);
+            unsigned int key = ToDescendingKey(row[j]);
+            if (key < selKeys[0]) {
+                selKeys[0] = key;
+                selPos[0] = j;
+                HeapDown(selKeys, selPos, 0, k);
+                threshold = row[selPos[0]];
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= num; i += 4) {
+        __m128 v = _mm_loadu_ps(row + i);
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(v, _mm_set1_ps(threshold)));
+        while (mask != 0) {
+            int j = i + __builtin_ctz(mask);
+            unsigned int key = ToDescendingKey(row[j]);
+            if (key < selKeys[0]) {
+                selKeys[0] = key;
+                selPos[0] = j;
+                HeapDown(selKeys, selPos, 0, k);
+                threshold = row[selPos[0]];
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < num; i++) {
+        if (row[i] >= threshold) {
+            unsigned int key = ToDescendingKey(row[i]);
+            if (key < selKeys[0]) {
+                selKeys[0] = key;
+                selPos[0] = i;
+                HeapDown(selKeys, selPos, 0, k);
+                threshold = row[selPos[0]];
+            }
+        }
+    }
+
+    /* heap sort: move the worst item to the end each time */
+    for (int last = k - 1; last > 0; last--) {
+        unsigned int key = selKeys[0];
+        int p = selPos[0];
+        selKeys[0] = selKeys[last];
+        selPos[0] = selPos[last];
+        selKeys[last] = key;
+        selPos[last] = p;
+        HeapDown(selKeys, selPos, 0, last);
+    }
+}
+
+/*
+get the top-k items for a range of rows
+NOTE: this is a instance of the TFunction type and would be used in XThread
+>> args - arguments
+argument0: beg - the first row
+argument1: end - the last row + 1
+argument2: a - the input tensor
+argument3: b - the output tensor
+argument4: index - the index tensor
+argument5: dim - the dimension along which we select
+argument6: k - number of the items to select
+*/
+void _RadixTopKRows(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    XTensor * a = (XTensor*)args->GetItem(2);
+    XTensor * b = (XTensor*)args->GetItem(3);
+    XTensor * index = (XTensor*)args->GetItem(4);
+    int dim = *(int*)args->GetItem(5);
+    int k = *(int*)args->GetItem(6);
+
+    int dimRDI = a->order - dim - 1;
+    int stride = 1;
+    int strideNumA = a->dimSizeRDI[dimRDI];
+    int strideNumB = b->dimSizeRDI[dimRDI];
+    for (int i = 0; i < dimRDI; i++)
+        stride *= a->dimSizeRDI[i];
+
+    int blockSizeA = stride * strideNumA;
+    int blockSizeB = stride * strideNumB;
+    int n = strideNumA;
+    int kk = MIN(k, n);
+    bool toGather = stride > 1 || a->data == b->data;
+
+    /* workspace of the job */
+    char * buf = new char[sizeof(float) * n + (sizeof(unsigned int) + sizeof(int)) * (2 * n + kk) + sizeof(int) * kk];
+    float * vals = (float*)buf;
+    unsigned int * keys = (unsigned int*)(vals + n);
+    unsigned int * candKeys = keys + n;
+    int * candPos = (int*)(candKeys + n);
+    int * tmpPos = candPos + n;
+    unsigned int * selKeys = (unsigned int*)(tmpPos + n);
+    int * selPos = (int*)(selKeys + kk);
+
+    for (int r = beg; r < end; r++) {
+        int h = r / stride;
+        int i = r % stride;
+        const float * dataA = (float*)a->data + (h * blockSizeA + i);
+        float * dataB = (float*)b->data + (h * blockSizeB + i);
+        int * indexData = (int*)index->data + (h * blockSizeB + i);
+
+        const float * row = dataA;
+        if (toGather) {
+            for (int j = 0; j < n; j++)
+                vals[j] = dataA[j * stride];
+            row = vals;
+        }
+
+        int * result = selPos;
+
+        if (n <= RADIX_SHORT_ROW || kk == n) {
+            /* sort the whole row */
+            MakeDescendingKeys(row, n, keys);
+            for (int j = 0; j < n; j++)
+                candPos[j] = j;
+            RadixSortPairs(keys, candPos, n, candKeys, tmpPos);
+            result = candPos;
+        }
+        else if (kk <= RADIX_HEAP_K || kk * RADIX_HEAP_RATIO <= n) {
+            HeapSelectRow(row, n, kk, selKeys, selPos);
+        }
+        else {
+            MakeDescendingKeys(row, n, keys);
+            RadixSelectRow(keys, n, kk, selKeys, selPos, candKeys, candPos, candKeys, tmpPos);
+        }
+
+        for (int j = 0; j < kk; j++) {
+            dataB[j * stride] = row[result[j]];
+            indexData[j * stride] = result[j];
+        }
+    }
+
+    delete[] buf;
+}
+
+/*
+get the top-k items along a given dimension by radix selection (float only)
+>> a - input tensor
+>> b - output tensor (top-k result)
+>> index - index of the top-k items
+>> dim - the dimension along which the selection is performed
+>> k - how many items returned
+>> parallelRunner - parallel processing module (rows are processed in parallel)
+*/
+void _RadixTopK(const XTensor * a, XTensor * b, XTensor * index, int dim, int k,
+                XPRunner * parallelRunner)
+{
+    CheckNTErrors(a->devID < 0 && b->devID < 0, "The radix selection is for CPUs only!");
+    CheckNTErrors(a->dataType == X_FLOAT && b->dataType == X_FLOAT, "TODO!");
+    CheckNTErrors(index != NULL && index->dataType == X_INT, "Wrong data type!");
+
+    int dimRDI = a->order - dim - 1;
+    int rowNum = a->unitNum / a->dimSizeRDI[dimRDI];
+
+    if (k <= 0 || rowNum == 0)
+        return;
+
+    RunParallel1D(parallelRunner, (void*)_RadixTopKRows, a->unitNum, rowNum, 5,
+                  a, b, index, &dim, &k);
+}
+
+/*
+sort a range of rows
+NOTE: this is a instance of the TFunction type and would be used in XThread
+>> args - arguments
+argument0: beg - the first row
+argument1: end - the last row + 1
+argument2: a - the input tensor
+argument3: b - the output tensor
+argument4: index - the index tensor
+argument5: dim - the dimension along which we sort
+*/
+void _RadixSortRows(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    XTensor * a = (XTensor*)args->GetItem(2);
+    XTensor * b = (XTensor*)args->GetItem(3);
+    XTensor * index = (XTensor*)args->GetItem(4);
+    int dim = *(int*)args->GetItem(5);
+
+    int dimRDI = a->order - dim - 1;
+    int stride = 1;
+    int n = a->dimSizeRDI[dimRDI];
+    for (int i = 0; i < dimRDI; i++)
+        stride *= a->dimSizeRDI[i];
+    int blockSize = stride * n;
+
+    /* workspace of the job */
+    char * buf = new char[sizeof(float) * n + (sizeof(unsigned int) + sizeof(int)) * 2 * n];
+    float * vals = (float*)buf;
+    unsigned int * keys = (unsigned int*)(vals + n);
+    int * pos = (int*)(keys + n);
+    unsigned int * tmpKeys = (unsigned int*)(pos + n);
+    int * tmpPos = (int*)(tmpKeys + n);
+
+    for (int r = beg; r < end; r++) {
+        int h = r / stride;
+        int i = r % stride;
+        const float * dataA = (float*)a->data + (h * blockSize + i);
+        float * dataB = (float*)b->data + (h * blockSize + i);
+        int * indexData = (int*)index->data + (h * blockSize + i);
+
+        for (int j = 0; j < n; j++) {
+            vals[j] = dataA[j * stride];
+            pos[j] = j;
+        }
+
+        MakeDescendingKeys(vals, n, keys);
+        RadixSortPairs(keys, pos, n, tmpKeys, tmpPos);
+
+        for (int j = 0; j < n; j++) {
+            dataB[j * stride] = vals[pos[j]];
+            indexData[j * stride] = pos[j];
+        }
+    }
+
+    delete[] buf;
+}
+
+/*
+sort the items along a given dimension (in descending order) by key-value
+radix sort (float only). It is stable, i.e., ties are kept in their
+original order. a and b can be the same tensor.
+>> a - input tensor
+>> b - output tensor
+>> index - index of the items in the resulting tensor
+>> dim - the dimension along which the sorting is performed
+>> parallelRunner - parallel processing module (rows are processed in parallel)
+*/
+void _RadixSort(const XTensor * a, XTensor * b, XTensor * index, int dim,
+                XPRunner * parallelRunner)
+{
+    CheckNTErrors(a->devID < 0 && b->devID < 0, "The radix sort is for CPUs only!");
+    CheckNTErrors(a->dataType == X_FLOAT && b->dataType == X_FLOAT, "TODO!");
+    CheckNTErrors(index != NULL && index->dataType == X_INT, "Wrong data type!");
+
+    int dimRDI = a->order - dim - 1;
+    int rowNum = a->unitNum / a->dimSizeRDI[dimRDI];
+
+    if (rowNum == 0)
+        return;
+
+    RunParallel1D(parallelRunner, (void*)_RadixSortRows, a->unitNum, rowNum, 4,
+                  a, b, index, &dim);
+}
+
+} // namespace nts(NiuTrans.Tensor)
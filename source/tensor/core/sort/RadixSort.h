@@ -0,0 +1,60 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* The CPU selection engine for TopK and Sort. Floats are mapped to
+* order-preserving unsigned keys so that the top-k items can be found by
+* radix selection (a histogram on the leading bits plus a vectorized
+* threshold filter) and full rows can be sorted by a stable key-value
+* LSD radix sort. Independent rows are processed in parallel.
+*/
+
+#ifndef __RADIXSORT_H__
+#define __RADIXSORT_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* rows that are not longer than this are simply sorted by insertion */
+#define RADIX_SHORT_ROW 64
+
+/*
+the heap-based selection (with vectorized threshold filtering) is used
+when k <= RADIX_HEAP_K or k * RADIX_HEAP_RATIO <= (row size), and the
+radix selection is used otherwise
+*/
+#define RADIX_HEAP_K 16
+#define RADIX_HEAP_RATIO 512
+
+/* number of bits of a radix digit */
+#define RADIX_BITS 11
+
+/* number of buckets of a radix digit */
+#define RADIX_BUCKET_NUM (1 << RADIX_BITS)
+
+/* get the top-k items along a given dimension by radix selection (float only) */
+void _RadixTopK(const XTensor * a, XTensor * b, XTensor * index, int dim, int k,
+                XPRunner * parallelRunner = NULL);
+
+/* sort the items along a given dimension by key-value radix sort (float only) */
+void _RadixSort(const XTensor * a, XTensor * b, XTensor * index, int dim,
+                XPRunner * parallelRunner = NULL);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __RADIXSORT_H__
@@ -25,6 +25,7 @@
 #include "../../XName.h"
 #include "Sort.h"
 #include "Sort.cuh"
+#include "RadixSort.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -42,42 +43,21 @@ void _Sort(const XTensor * a, XTensor * b, XTensor * index, int dim)
     CheckNTErrors((a->order == index->order), "Unmatched input tensors!");
     CheckNTErrors((index->dataType == X_INT), "Wrong data type!");
 
-	int dimRDI = a->order - dim - 1;
-    /* make the index tensor */
-    index->SetAscendingOrder(dim);
-
     if (a->devID >= 0) {
+        /* make the index tensor */
+        index->SetAscendingOrder(dim);
 #ifdef USE_CUDA
         _CudaSortBig(a, b, index, index, dim);
 #else
         ShowNTErrors("Plesae specify USE_CUDA and recompile the code!");
 #endif
     }
+    else if (a->dataType == X_FLOAT) {
+        /* key-value radix sort with rows processed in parallel */
+        _RadixSort(a, b, index, dim, globalPRunner);
+    }
     else {
-        int stride = 1;
-        int strideNum = a->dimSizeRDI[dimRDI];
-        for (int i = 0; i < dimRDI; i++)
-            stride *= a->dimSizeRDI[i];
-
-        int blockNum = 1;
-        for (int i = dimRDI + 1; i < a->order; i++)
-            blockNum *= a->dimSizeRDI[i];
-        int blockSize = stride * strideNum;
-
-		_CopyValues(a, b);
-        for (int k = 0; k < blockNum; k++) {
-        for (int i = 0; i < stride; i++) {
-                void * dataB = (char*)b->data + (k * blockSize + i) * b->unitSize;
-                void * indexData = (char*)index->data + (k * blockSize + i) * sizeof(int);
-
-                /* we sort the data array along "dim" */
-                if (a->dataType == X_FLOAT)
-                    XQSort(dataB, indexData, strideNum, a->unitSize, stride, CompXFloat);
-                else {
-                    ShowNTErrors("TODO!");
-                }
-            }
-        }
+        ShowNTErrors("TODO!");
     }
 }
 
@@ -23,6 +23,7 @@
 #include "../../XName.h"
 #include "TopK.h"
 #include "TopK.cuh"
+#include "RadixSort.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -60,6 +61,10 @@ void _TopK(const XTensor * a, XTensor * b, XTensor * index, int dim, int k)
         ShowNTErrors("Plesae specify USE_CUDA and recompile the code!");
 #endif
     }
+    else if (a->dataType == X_FLOAT) {
+        /* radix selection with rows processed in parallel */
+        _RadixTopK(a, b, index, dim, k, globalPRunner);
+    }
     else {
         CheckNTErrors((a->dataType == DEFAULT_DTYPE), "TODO!");
 
@@ -51,24 +51,26 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
     CheckNTErrors(jobNum != 0, "TODO!");
 
     /* argument list of the jobs */
-    XList * jobArgList = new XList(4);
+    XSmallList<void*, XLIST_INLINE_NUM> jobArgList;
 
     va_list ap;
     va_start(ap, argNum);
     for (int i = 0; i < argNum; i++) {
         void * p = va_arg(ap, void*);
-        jobArgList->Add(p);
+        jobArgList.Add(p);
     }
     va_end(ap);
 
-    /* prepare the neccesary argument list for parallel processing */
-    XList * jobs = new XList(jobNum);
-    XList * args = new XList(jobNum);
+    /* prepare the neccesary argument list for parallel processing. The
+       lists are kept in place (i.e., no allocation) for a few jobs */
+    XList jobs(jobNum);
+    XList args(jobNum);
+    XList * blockArgs = new XList[jobNum];
 
-    int * indexList = new int[jobNum * 4 * 4];
+    XSmallList<int, XLIST_INLINE_NUM * 4 * 4> indexList(jobNum * 4 * 4);
 
     /* segment the matrix into blocks */
-    int nblock = SegmentTensor2D(rowNum, colNum, jobNum, indexList);
+    int nblock = SegmentTensor2D(rowNum, colNum, jobNum, indexList.items);
 
     /*
     assign jobs
@@ -77,40 +79,124 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
     2. other arguments
     */
     for (int i = 0; i < jobNum; i++) {
-        XList * blockArgs = new XList(argNum + 4);
-        int * blockIndex = indexList + i * 4;
+        int * blockIndex = indexList.items + i * 4;
 
-        blockArgs->Add(blockIndex);
-        blockArgs->Add(blockIndex + 1);
-        blockArgs->Add(blockIndex + 2);
-        blockArgs->Add(blockIndex + 3);
+        blockArgs[i].Reserve(argNum + 4);
+        blockArgs[i].Add(blockIndex);
+        blockArgs[i].Add(blockIndex + 1);
+        blockArgs[i].Add(blockIndex + 2);
+        blockArgs[i].Add(blockIndex + 3);
 
         for (int j = 0; j < argNum; j++)
-            blockArgs->Add(jobArgList->GetItem(j));
+            blockArgs[i].Add(jobArgList[j]);
 
-        args->Add(blockArgs);
-        jobs->Add((void*)job);
+        args.Add(blockArgs + i);
+        jobs.Add((void*)job);
     }
 
-    args->count = nblock;
-    jobs->count = nblock;
+    args.count = nblock;
+    jobs.count = nblock;
 
     /* single job */
     if (jobNum == 1)
-        ((TFunction)job)((XList*)args->GetItem(0));
+        ((TFunction)job)(blockArgs);
     /* multiple jobs */
     else
-        parallelRunner->Run(jobs, args);
+        parallelRunner->Run(&jobs, &args);
 
-    /* free the memory */
-    delete[] indexList;
-    for (int i = 0; i < args->count; i++) {
-        XList * blockArgs = (XList*)args->GetItem(i);
-        delete blockArgs;
+    delete[] blockArgs;
+}
+
+/*
+segment a list of independent items (e.g., rows of a matrix) into
+contiguous ranges and run jobs in parallel. Each job receives the
+range [beg, end) as its first two arguments.
+>> parallelRunner - parallel runner
+>> job - the function to run
+>> opNum - number of operations
+>> itemNum - number of items
+>> argNum - number of arguments of the jobs
+>> ... - arguments of the jobs
+*/
+void RunParallel1D(XPRunner * parallelRunner, void * job,
+                   int opNum, int itemNum, int argNum, ...)
+{
+    if (itemNum == 0)
+        return;
+
+    int jobNum = 1;
+
+    if (parallelRunner != NULL && parallelRunner->method == PRUNNER_MULTIPLE) {
+        jobNum = MIN(opNum / parallelRunner->minimumOPNum, parallelRunner->threadNum);
+        jobNum = MAX(MIN(jobNum, itemNum), 1);
+    }
+
+    CheckNTErrors(jobNum > 0, "Illegal job number!");
+
+    /* argument list of the jobs */
+    XSmallList<void*, XLIST_INLINE_NUM> jobArgList;
+
+    va_list ap;
+    va_start(ap, argNum);
+    for (int i = 0; i < argNum; i++) {
+        void * p = va_arg(ap, void*);
+        jobArgList.Add(p);
+    }
+    va_end(ap);
+
+    /* a single job runs with the lists on the stack (no allocation) */
+    if (jobNum == 1) {
+        int range[2] = {0, itemNum};
+        XList rangeArgs(argNum + 2);
+        rangeArgs.Add(range);
+        rangeArgs.Add(range + 1);
+        for (int j = 0; j < argNum; j++)
+            rangeArgs.Add(jobArgList[j]);
+
+        ((TFunction)job)(&rangeArgs);
+        return;
     }
-    delete args;
-    delete jobs;
-    delete jobArgList;
+
+    XList jobs(jobNum);
+    XList args(jobNum);
+    XList * rangeArgs = new XList[jobNum];
+
+    XSmallList<int, XLIST_INLINE_NUM * 2> indexList(jobNum * 2);
+    int segSize = (itemNum + jobNum - 1) / jobNum;
+
+    /*
+    assign jobs
+    argument rules:
+    1. range of the items
+    2. other arguments
+    */
+    for (int i = 0; i < jobNum; i++) {
+        int * range = indexList.items + i * 2;
+        range[0] = i * segSize;
+        range[1] = MIN((i + 1) * segSize, itemNum);
+
+        if (range[0] >= range[1])
+            break;
+
+        rangeArgs[i].Reserve(argNum + 2);
+        rangeArgs[i].Add(range);
+        rangeArgs[i].Add(range + 1);
+
+        for (int j = 0; j < argNum; j++)
+            rangeArgs[i].Add(jobArgList[j]);
+
+        args.Add(rangeArgs + i);
+        jobs.Add((void*)job);
+    }
+
+    /* single job */
+    if (args.count == 1)
+        ((TFunction)job)(rangeArgs);
+    /* multiple jobs */
+    else
+        parallelRunner->Run(&jobs, &args);
+
+    delete[] rangeArgs;
 }
 
 /*
@@ -0,0 +1,548 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * Element-wise kernels (on CPUs) that are specialized at compile time.
+ * A kernel is a template of
+ *   1) the type of the items (float, double, float16 and int8). Each
+ *      type has a type of computation, e.g., float16 and int8 items are
+ *      loaded into floats and stored back after the computation;
+ *   2) the operation (sum, sub, multiply and div);
+ *   3) the layout. A tensor of any order is seen as (blockNum, blockSize,
+ *      stride) w.r.t. the dimension of broadcasting, so the loop nest
+ *      is one of the three cases: flat (no broadcasting), row (the
+ *      broadcast vector spans the last dimension, stride = 1) and column
+ *      (stride > 1);
+ *   4) whether the second operand is scaled and whether the result is
+ *      accumulated on c.
+ * As everything but the sizes is known to the compiler, the inner loops
+ * have no branches and can be vectorized. The functions on XTensors
+ * pick a kernel according to the data type, the layout and the
+ * coefficients.
+ *
+ */
+
+#ifndef __XTYPEDKERNEL_H__
+#define __XTYPEDKERNEL_H__
+
+#include <string.h>
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* a float16 item (IEEE 754 half precision) */
+struct XFloat16
+{
+    unsigned short bits;
+};
+
+/* float -> float16 (rounded to the nearest even) */
+inline unsigned short XFloatToHalf(float f)
+{
+    unsigned int x;
+    memcpy(&x, &f, sizeof(float));
+
+    unsigned int sign = (x >> 16) & 0x8000;
+    unsigned int mant = x & 0x7fffff;
+    int fexp = (x >> 23) & 0xff;
+    int exp = fexp - 127 + 15;
+
+    /* inf and nan */
+    if(fexp == 0xff)
+        return (unsigned short)(sign | 0x7c00 | (mant != 0 ? 0x200 : 0));
+
+    /* overflow */
+    if(exp >= 31)
+        return (unsigned short)(sign | 0x7c00);
+
+    /* subnormal numbers (or zero) */
+    if(exp <= 0){
+        if(exp < -10)
+            return (unsigned short)sign;
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        unsigned int h = mant >> shift;
+        unsigned int rest = mant & ((1 << shift) - 1);
+        unsigned int half = 1 << (shift - 1);
+        if(rest > half || (rest == half && (h & 1)))
+            h++;
+        return (unsigned short)(sign | h);
+    }
+
+    /* a carry of the rounding goes to the exponent */
+    unsigned int h = sign | (exp << 10) | (mant >> 13);
+    unsigned int rest = mant & 0x1fff;
+    if(rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        h++;
+    return (unsigned short)h;
+}
+
+/* float16 -> float */
+inline float XHalfToFloat(unsigned short h)
+{
+    unsigned int sign = (h & 0x8000) << 16;
+    unsigned int exp = (h >> 10) & 0x1f;
+    unsigned int mant = h & 0x3ff;
+    unsigned int x;
+
+    if(exp == 0){
+        if(mant == 0)
+            x = sign;
+        else{
+            /* subnormal numbers are normalized in float */
+            exp = 113;
+            while(!(mant & 0x400)){
+                mant <<= 1;
+                exp--;
+            }
+            x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+    }
+    else if(exp == 31)
+        x = sign | 0x7f800000 | (mant << 13);
+    else
+        x = sign | ((exp + 112) << 23) | (mant << 13);
+
+    float f;
+    memcpy(&f, &x, sizeof(float));
+    return f;
+}
+
+/*
+type of computation for the items of type T, and the load/store
+between the two types
+*/
+template<typename T>
+struct XElement
+{
+    typedef T Compute;
+    static inline Compute Load(T v) { return v; }
+    static inline T Store(Compute v) { return v; }
+};
+
+template<>
+struct XElement<XFloat16>
+{
+    typedef float Compute;
+    static inline float Load(XFloat16 v) { return XHalfToFloat(v.bits); }
+    static inline XFloat16 Store(float v) { XFloat16 h; h.bits = XFloatToHalf(v); return h; }
+};
+
+/* int8 items are rounded to the nearest integer and saturated */
+template<>
+struct XElement<signed char>
+{
+    typedef float Compute;
+    static inline float Load(signed char v) { return (float)v; }
+    static inline signed char Store(float v)
+    {
+        if(v <= -128.0F)
+            return -128;
+        if(v >= 127.0F)
+            return 127;
+        return (signed char)(v >= 0 ? v + 0.5F : v - 0.5F);
+    }
+};
+
+/* the operations of two items */
+struct XOpSum { template<typename C> static inline C Do(C a, C b) { return a + b; } };
+struct XOpSub { template<typename C> static inline C Do(C a, C b) { return a - b; } };
+struct XOpMul { template<typename C> static inline C Do(C a, C b) { return a * b; } };
+struct XOpDiv { template<typename C> static inline C Do(C a, C b) { return a / b; } };
+
+/* layouts of broadcasting */
+enum XKERNEL_LAYOUT {XKL_FLAT, XKL_ROW, XKL_COL};
+
+/*
+c = OP(a, b * \beta) + \alpha * c on the items of a row
+>> a - items of a
+>> b - items of b
+>> c - items of c (it can be a)
+>> num - number of the items
+>> beta - the scaling factor of b (used if SCALED)
+>> alpha - the coefficient of c (used if ACCUMULATED)
+*/
+template<typename T, class OP, bool SCALED, bool ACCUMULATED>
+inline void _KernelBinaryRow(const T * a, const T * b, T * c, int num,
+                             typename XElement<T>::Compute beta,
+                             typename XElement<T>::Compute alpha)
+{
+    typedef XElement<T> E;
+    typedef typename E::Compute C;
+    int i = 0;
+
+    /* unrolling */
+    for(; i + 4 <= num; i += 4){
+        C v0 = OP::Do(E::Load(a[i]),     SCALED ? E::Load(b[i]) * beta     : E::Load(b[i]));
+        C v1 = OP::Do(E::Load(a[i + 1]), SCALED ? E::Load(b[i + 1]) * beta : E::Load(b[i + 1]));
+        C v2 = OP::Do(E::Load(a[i + 2]), SCALED ? E::Load(b[i + 2]) * beta : E::Load(b[i + 2]));
+        C v3 = OP::Do(E::Load(a[i + 3]), SCALED ? E::Load(b[i + 3]) * beta : E::Load(b[i + 3]));
+        if(ACCUMULATED){
+            v0 = v0 + alpha * E::Load(c[i]);
+            v1 = v1 + alpha * E::Load(c[i + 1]);
+            v2 = v2 + alpha * E::Load(c[i + 2]);
+            v3 = v3 + alpha * E::Load(c[i + 3]);
+        }
+        c[i] = E::Store(v0);
+        c[i + 1] = E::Store(v1);
+        c[i + 2] = E::Store(v2);
+        c[i + 3] = E::Store(v3);
+    }
+
+    for(; i < num; i++){
+        C v = OP::Do(E::Load(a[i]), SCALED ? E::Load(b[i]) * beta : E::Load(b[i]));
+        if(ACCUMULATED)
+            v = v + alpha * E::Load(c[i]);
+        c[i] = E::Store(v);
+    }
+}
+
+/*
+c = OP(a, bv) + \alpha * c on the items of a row where bv is a scalar
+>> a - items of a
+>> bv - the scalar (scaled already)
+>> c - items of c (it can be a)
+>> num - number of the items
+>> alpha - the coefficient of c (used if ACCUMULATED)
+*/
+template<typename T, class OP, bool ACCUMULATED>
+inline void _KernelBinaryScalar(const T * a, typename XElement<T>::Compute bv, T * c, int num,
+                                typename XElement<T>::Compute alpha)
+{
+    typedef XElement<T> E;
+    typedef typename E::Compute C;
+    int i = 0;
+
+    /* unrolling */
+    for(; i + 4 <= num; i += 4){
+        C v0 = OP::Do(E::Load(a[i]), bv);
+        C v1 = OP::Do(E::Load(a[i + 1]), bv);
+        C v2 = OP::Do(E::Load(a[i + 2]), bv);
+        C v3 = OP::Do(E::Load(a[i + 3]), bv);
+        if(ACCUMULATED){
+            v0 = v0 + alpha * E::Load(c[i]);
+            v1 = v1 + alpha * E::Load(c[i + 1]);
+            v2 = v2 + alpha * E::Load(c[i + 2]);
+            v3 = v3 + alpha * E::Load(c[i + 3]);
+        }
+        c[i] = E::Store(v0);
+        c[i + 1] = E::Store(v1);
+        c[i + 2] = E::Store(v2);
+        c[i + 3] = E::Store(v3);
+    }
+
+    for(; i < num; i++){
+        C v = OP::Do(E::Load(a[i]), bv);
+        if(ACCUMULATED)
+            v = v + alpha * E::Load(c[i]);
+        c[i] = E::Store(v);
+    }
+}
+
+/*
+c = OP(a, b * \beta) + \alpha * c where b is broadcast along a dimension of a
+>> a - items of a (blockNum * blockSize * stride)
+>> b - items of b (blockSize, or blockNum * blockSize * stride for XKL_FLAT)
+>> c - items of c
+>> blockNum - number of the blocks
+>> blockSize - size of the dimension of broadcasting
+>> stride - number of the items after the dimension
+>> beta - the scaling factor of b
+>> alpha - the coefficient of c
+*/
+template<typename T, class OP, int LAYOUT, bool SCALED, bool ACCUMULATED>
+void _KernelBinaryDim(const T * a, const T * b, T * c, int blockNum, int blockSize, int stride,
+                      typename XElement<T>::Compute beta, typename XElement<T>::Compute alpha)
+{
+    typedef XElement<T> E;
+
+    if(LAYOUT == XKL_FLAT){
+        _KernelBinaryRow<T, OP, SCALED, ACCUMULATED>(a, b, c, blockNum * blockSize * stride, beta, alpha);
+    }
+    else if(LAYOUT == XKL_ROW){
+        for(int k = 0; k < blockNum; k++){
+            int offset = k * blockSize;
+            _KernelBinaryRow<T, OP, SCALED, ACCUMULATED>(a + offset, b, c + offset, blockSize, beta, alpha);
+        }
+    }
+    else{
+        for(int k = 0; k < blockNum; k++){
+            for(int j = 0; j < blockSize; j++){
+                int offset = (k * blockSize + j) * stride;
+                typename E::Compute bv = E::Load(b[j]);
+                if(SCALED)
+                    bv = bv * beta;
+                _KernelBinaryScalar<T, OP, ACCUMULATED>(a + offset, bv, c + offset, stride, alpha);
+            }
+        }
+    }
+}
+
+/* pick the kernel for the coefficients (the type and the layout are known) */
+template<typename T, class OP, int LAYOUT>
+void _KernelBinaryDimCoef(const T * a, const T * b, T * c, int blockNum, int blockSize, int stride,
+                          DTYPE beta, DTYPE alpha)
+{
+    typedef typename XElement<T>::Compute C;
+    bool scaled = (beta != 1.0F);
+    bool accumulated = (alpha != 0.0F);
+
+    if(!scaled && !accumulated)
+        _KernelBinaryDim<T, OP, LAYOUT, false, false>(a, b, c, blockNum, blockSize, stride, (C)beta, (C)alpha);
+    else if(scaled && !accumulated)
+        _KernelBinaryDim<T, OP, LAYOUT, true, false>(a, b, c, blockNum, blockSize, stride, (C)beta, (C)alpha);
+    else if(!scaled && accumulated)
+        _KernelBinaryDim<T, OP, LAYOUT, false, true>(a, b, c, blockNum, blockSize, stride, (C)beta, (C)alpha);
+    else
+        _KernelBinaryDim<T, OP, LAYOUT, true, true>(a, b, c, blockNum, blockSize, stride, (C)beta, (C)alpha);
+}
+
+/* pick the kernel for the layout */
+template<typename T, class OP>
+void _KernelBinaryLayout(const T * a, const T * b, T * c, int blockNum, int blockSize, int stride,
+                         bool broadcast, DTYPE beta, DTYPE alpha)
+{
+    if(!broadcast)
+        _KernelBinaryDimCoef<T, OP, XKL_FLAT>(a, b, c, blockNum, blockSize, stride, beta, alpha);
+    else if(stride == 1)
+        _KernelBinaryDimCoef<T, OP, XKL_ROW>(a, b, c, blockNum, blockSize, stride, beta, alpha);
+    else
+        _KernelBinaryDimCoef<T, OP, XKL_COL>(a, b, c, blockNum, blockSize, stride, beta, alpha);
+}
+
+/*
+c = OP(a, b * \beta) + \alpha * c on dense tensors (on CPUs)
+>> a - a tensor
+>> b - another tensor. It is of the same size as a, or its size is
+       equal to the n-th dimension of a (broadcasting)
+>> c - the result tensor (it can be a)
+>> n - the dimension of broadcasting (-1 means no broadcasting)
+>> beta - the scaling factor of b
+>> alpha - the coefficient of c
+*/
+template<class OP>
+void _KernelBinary(const XTensor * a, const XTensor * b, XTensor * c, int n, DTYPE beta, DTYPE alpha)
+{
+    CheckNTErrors(a->devID < 0 && b->devID < 0 && c->devID < 0, "The kernel must run on CPUs!");
+    CheckNTErrors(!a->isSparse && !b->isSparse && !c->isSparse, "Dense tensors are required!");
+    CheckNTErrors(a->dataType == b->dataType && a->dataType == c->dataType,
+                  "Unmatched data types!");
+    CheckNTErrors(a->unitNum == c->unitNum, "Unmatched tensors!");
+
+    int blockNum = 1;
+    int blockSize = a->unitNum;
+    int stride = 1;
+    bool broadcast = (n >= 0);
+
+    if(broadcast){
+        CheckNTErrors(a->dimSize[n] == b->unitNum, "Wrong tensor size!");
+        blockSize = a->dimSize[n];
+        for(int i = a->order - 1; i >= 0; i--){
+            if(i > n)
+                stride *= a->dimSize[i];
+            else if(i < n)
+                blockNum *= a->dimSize[i];
+        }
+    }
+    else
+        CheckNTErrors(a->unitNum == b->unitNum, "Unmatched tensors!");
+
+    if(a->dataType == X_FLOAT)
+        _KernelBinaryLayout<float, OP>((float*)a->data, (float*)b->data, (float*)c->data,
+                                       blockNum, blockSize, stride, broadcast, beta, alpha);
+    else if(a->dataType == X_DOUBLE)
+        _KernelBinaryLayout<double, OP>((double*)a->data, (double*)b->data, (double*)c->data,
+                                        blockNum, blockSize, stride, broadcast, beta, alpha);
+    else if(a->dataType == X_FLOAT16)
+        _KernelBinaryLayout<XFloat16, OP>((XFloat16*)a->data, (XFloat16*)b->data, (XFloat16*)c->data,
+                                          blockNum, blockSize, stride, broadcast, beta, alpha);
+    else if(a->dataType == X_INT8)
+        _KernelBinaryLayout<signed char, OP>((signed char*)a->data, (signed char*)b->data, (signed char*)c->data,
+                                             blockNum, blockSize, stride, broadcast, beta, alpha);
+    else
+        ShowNTErrors("Unsupported data type!");
+}
+
+/*
+c = OP(a, b) + \alpha * c where a, b and c have different sizes on
+the leading dimension (the items of the shorter ones are used cyclically)
+*/
+template<typename T, class OP, bool ACCUMULATED>
+void _KernelBinaryCyclic(const T * a, const T * b, T * c, int blockNum, int stride,
+                         int dimA, int dimB, int dimC, typename XElement<T>::Compute alpha)
+{
+    for(int k = 0; k < blockNum; k++){
+        for(int ci = 0, ai = 0, bi = 0; ci < dimC; ci++, ai++, bi++){
+            if(ai >= dimA)
+                ai = 0;
+            if(bi >= dimB)
+                bi = 0;
+            _KernelBinaryRow<T, OP, false, ACCUMULATED>(a + (k * dimA + ai) * stride,
+                                                        b + (k * dimB + bi) * stride,
+                                                        c + (k * dimC + ci) * stride,
+                                                        stride, 1, alpha);
+        }
+    }
+}
+
+/* pick the kernel for the coefficient of c */
+template<typename T, class OP>
+void _KernelBinaryCyclicCoef(const T * a, const T * b, T * c, int blockNum, int stride,
+                             int dimA, int dimB, int dimC, DTYPE alpha)
+{
+    typedef typename XElement<T>::Compute C;
+    if(alpha == 0.0F)
+        _KernelBinaryCyclic<T, OP, false>(a, b, c, blockNum, stride, dimA, dimB, dimC, (C)alpha);
+    else
+        _KernelBinaryCyclic<T, OP, true>(a, b, c, blockNum, stride, dimA, dimB, dimC, (C)alpha);
+}
+
+/*
+c = OP(a, b) + \alpha * c on dense tensors (on CPUs) where the tensors
+can have different sizes on the leading dimension
+>> a - a tensor
+>> b - another tensor
+>> c - the result tensor
+>> leadingDim - the dimension along which we perform broadcasting
+>> alpha - the coefficient of c
+*/
+template<class OP>
+void _KernelBinaryLeading(const XTensor * a, const XTensor * b, XTensor * c, int leadingDim, DTYPE alpha)
+{
+    CheckNTErrors(a->devID < 0 && b->devID < 0 && c->devID < 0, "The kernel must run on CPUs!");
+    CheckNTErrors(!a->isSparse && !b->isSparse && !c->isSparse, "Dense tensors are required!");
+    CheckNTErrors(a->dataType == b->dataType && a->dataType == c->dataType,
+                  "Unmatched data types!");
+
+    if(a->unitNum == c->unitNum && b->unitNum == c->unitNum){
+        _KernelBinary<OP>(a, b, c, -1, 1.0F, alpha);
+        return;
+    }
+
+    int stride = 1;
+    for(int i = leadingDim + 1; i < a->order; i++)
+        stride *= a->dimSize[i];
+
+    int dimA = a->dimSize[leadingDim];
+    int dimB = b->dimSize[leadingDim];
+    int dimC = c->dimSize[leadingDim];
+    int blockNum = a->unitNum / (stride * dimA);
+
+    if(a->dataType == X_FLOAT)
+        _KernelBinaryCyclicCoef<float, OP>((float*)a->data, (float*)b->data, (float*)c->data,
+                                           blockNum, stride, dimA, dimB, dimC, alpha);
+    else if(a->dataType == X_DOUBLE)
+        _KernelBinaryCyclicCoef<double, OP>((double*)a->data, (double*)b->data, (double*)c->data,
+                                            blockNum, stride, dimA, dimB, dimC, alpha);
+    else if(a->dataType == X_FLOAT16)
+        _KernelBinaryCyclicCoef<XFloat16, OP>((XFloat16*)a->data, (XFloat16*)b->data, (XFloat16*)c->data,
+                                              blockNum, stride, dimA, dimB, dimC, alpha);
+    else if(a->dataType == X_INT8)
+        _KernelBinaryCyclicCoef<signed char, OP>((signed char*)a->data, (signed char*)b->data, (signed char*)c->data,
+                                                 blockNum, stride, dimA, dimB, dimC, alpha);
+    else
+        ShowNTErrors("Unsupported data type!");
+}
+
+/* b = a * scale + shift on the items */
+template<typename T>
+void _KernelScaleAndShift(const T * a, T * b, int num, DTYPE scale, DTYPE shift)
+{
+    typedef XElement<T> E;
+    typename E::Compute s = (typename E::Compute)scale;
+    typename E::Compute t = (typename E::Compute)shift;
+    for(int i = 0; i < num; i++)
+        b[i] = E::Store(E::Load(a[i]) * s + t);
+}
+
+/*
+b = a * scale + shift on dense tensors (on CPUs)
+>> a - the input tensor
+>> b - the output tensor
+>> scale - the scaler factor
+>> shift - the shift factor
+*/
+inline void _KernelScaleAndShift(const XTensor * a, XTensor * b, DTYPE scale, DTYPE shift)
+{
+    CheckNTErrors(a->dataType == b->dataType, "Unmatched data types!");
+
+    if(a->dataType == X_FLOAT)
+        _KernelScaleAndShift<float>((float*)a->data, (float*)b->data, b->unitNum, scale, shift);
+    else if(a->dataType == X_DOUBLE)
+        _KernelScaleAndShift<double>((double*)a->data, (double*)b->data, b->unitNum, scale, shift);
+    else if(a->dataType == X_FLOAT16)
+        _KernelScaleAndShift<XFloat16>((XFloat16*)a->data, (XFloat16*)b->data, b->unitNum, scale, shift);
+    else if(a->dataType == X_INT8)
+        _KernelScaleAndShift<signed char>((signed char*)a->data, (signed char*)b->data, b->unitNum, scale, shift);
+    else
+        ShowNTErrors("Unsupported data type!");
+}
+
+/* t = (T)s on the items */
+template<typename S, typename T>
+void _KernelConvert(const S * s, T * t, int num)
+{
+    for(int i = 0; i < num; i++)
+        t[i] = XElement<T>::Store((typename XElement<T>::Compute)XElement<S>::Load(s[i]));
+}
+
+/* convert the items of type S into the data type of the target */
+template<typename S>
+void _KernelConvertFrom(const S * s, void * t, TENSOR_DATA_TYPE typeT, int num)
+{
+    if(typeT == X_FLOAT)
+        _KernelConvert<S, float>(s, (float*)t, num);
+    else if(typeT == X_DOUBLE)
+        _KernelConvert<S, double>(s, (double*)t, num);
+    else if(typeT == X_FLOAT16)
+        _KernelConvert<S, XFloat16>(s, (XFloat16*)t, num);
+    else if(typeT == X_INT8)
+        _KernelConvert<S, signed char>(s, (signed char*)t, num);
+    else if(typeT == X_INT)
+        _KernelConvert<S, int>(s, (int*)t, num);
+    else
+        ShowNTErrors("Unsupported data types for conversion!");
+}
+
+/*
+data type conversion of dense arrays (on CPUs)
+>> s - source data array
+>> typeS - source data type
+>> t - target data array
+>> typeT - target data type
+>> num - number of the items
+*/
+inline void _KernelConvert(const void * s, TENSOR_DATA_TYPE typeS, void * t, TENSOR_DATA_TYPE typeT, int num)
+{
+    if(typeS == X_FLOAT)
+        _KernelConvertFrom<float>((const float*)s, t, typeT, num);
+    else if(typeS == X_DOUBLE)
+        _KernelConvertFrom<double>((const double*)s, t, typeT, num);
+    else if(typeS == X_FLOAT16)
+        _KernelConvertFrom<XFloat16>((const XFloat16*)s, t, typeT, num);
+    else if(typeS == X_INT8)
+        _KernelConvertFrom<signed char>((const signed char*)s, t, typeT, num);
+    else if(typeS == X_INT)
+        _KernelConvertFrom<int>((const int*)s, t, typeT, num);
+    else
+        ShowNTErrors("Unsupported data types for conversion!");
+}
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __XTYPEDKERNEL_H__
@@ -172,14 +172,17 @@ See more details in LogSoftmaxBackward(...)
 >> dedx - dE/dx
 >> lossName - type of loss function, e.g., cross entropy
 >> leadDim - leading dimension (along which we perform reduction)
+>> beta - the coefficient of dedx. dE/dx is accumulated into dedx if 
+          beta != 0 (only for NOLOSS), i.e., dedx = dE/dx + dedx * \beta
 */
 void _SoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x, 
                       XTensor * dedy, XTensor * dedx, 
                       XTensor * padding, int leadDim,
-                      LOSS_FUNCTION_NAME lossName)
+                      LOSS_FUNCTION_NAME lossName, DTYPE beta)
 {
     CheckNTErrors(dedx->isSparse == false, "The gradient tensor must be dense!");
     CheckNTErrors(gold != NULL || lossName == NOLOSS, "Gold standard is required for computing loss!");
+    CheckNTErrors(beta == 0 || lossName == NOLOSS, "TODO!");
 
     if(leadDim < 0)
         leadDim = y->order - 1;
@@ -188,7 +191,7 @@ void _SoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x,
 
 #ifdef USE_CUDA
     if(y->devID >= 0){
-        _CudaSoftmaxBackward(gold, y, x, dedy, dedx, padding, leadDim, lossName);
+        _CudaSoftmaxBackward(gold, y, x, dedy, dedx, padding, leadDim, lossName, beta);
         return;
     }
 #endif
@@ -305,13 +308,20 @@ void _SoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x,
                 int nCols = stride;
                 for(int k = 0; k < stride; k++){
                     /* \beta = \sum_i (dE/dy_i * y_i) */
-                    DTYPE beta = 0;
+                    DTYPE sum = 0;
                     for(int i = 0; i < dimensionSize; i++)
-                        beta += yp[i * nCols + k] * op[i * nCols + k];
+                        sum += yp[i * nCols + k] * op[i * nCols + k];
 
                     /* dE/ds_j = y_j * (dE/dy_j - \beta) */
-                    for(int j = 0; j < dimensionSize; j++)
-                        sp[j * nCols + k] = op[j * nCols + k] * (yp[j * nCols + k] - beta);
+                    if(beta == 0){
+                        for(int j = 0; j < dimensionSize; j++)
+                            sp[j * nCols + k] = op[j * nCols + k] * (yp[j * nCols + k] - sum);
+                    }
+                    else{
+                        for(int j = 0; j < dimensionSize; j++)
+                            sp[j * nCols + k] = op[j * nCols + k] * (yp[j * nCols + k] - sum) + 
+                                                sp[j * nCols + k] * beta;
+                    }
                 }
             }
         }
@@ -307,11 +307,12 @@ See more details in SoftmaxBackward
 >> dedx - dE/dx
 >> lossName - type of loss function, e.g., cross entropy
 >> leadDim - leading dimension (along which we perform reduction)
+>> beta - the coefficient of dedx, i.e., dedx = dE/dx + dedx * \beta (only for NOLOSS)
 */
 void _CudaSoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x, 
                           XTensor * dedy, XTensor * dedx,
                           XTensor * padding, int leadDim,
-                          LOSS_FUNCTION_NAME lossName)
+                          LOSS_FUNCTION_NAME lossName, DTYPE beta)
 {
     int n = leadDim < 0 ? y->order - 1 : leadDim;
 
@@ -383,44 +384,44 @@ void _CudaSoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x,
             XTensor * ytmp = NewTensor(y, false);
 
             /* make a matrix to keep \beta */
-            XTensor * beta = new XTensor(y->order - 1, dimSize, y->dataType, y->denseRatio, y->devID, mem);
+            XTensor * sum = new XTensor(y->order - 1, dimSize, y->dataType, y->denseRatio, y->devID, mem);
 
             if(mem != NULL){
                 ytmp->data = mem->AllocBuf(mem->devID, y->unitNum * y->unitSize);
-                beta->data = mem->AllocBuf(mem->devID, beta->unitNum * beta->unitSize);
+                sum->data = mem->AllocBuf(mem->devID, sum->unitNum * sum->unitSize);
             }
             else{
                 ytmp->data = XMemAlloc(y->devID, y->unitNum * y->unitSize);
-                beta->data = XMemAlloc(y->devID, beta->unitNum * beta->unitSize);
+                sum->data = XMemAlloc(y->devID, sum->unitNum * sum->unitSize);
             }
 
             /* \beta = \sum_i (dE/dy_i * y_i) */
             _Multiply(dedy, y, ytmp, 0, 0);
-            _ReduceSum(ytmp, beta, leadDim);
+            _ReduceSum(ytmp, sum, leadDim);
 
             /* ytmp = dE/dy_j - \beta */
-            _Unsqueeze(beta, ytmp, leadDim, y->dimSize[leadDim]);
+            _Unsqueeze(sum, ytmp, leadDim, y->dimSize[leadDim]);
             _Sum(dedy, ytmp, ytmp, -1.0F);
 
             /* dE/ds_j = y_j * ytmp = y_j * (dE/dy_j - \beta) */
-            _Multiply(y, ytmp, dedx, 0, 0);
+            _Multiply(y, ytmp, dedx, beta, 0);
 
 
             if(mem != NULL){
                 mem->ReleaseBuf(mem->devID, y->unitNum * y->unitSize);
-                mem->ReleaseBuf(mem->devID, beta->unitNum * beta->unitSize);
+                mem->ReleaseBuf(mem->devID, sum->unitNum * sum->unitSize);
             }
             else{
                 XMemFree(y->devID, ytmp->data);
-                XMemFree(y->devID, beta->data);
+                XMemFree(y->devID, sum->data);
             }
 
             ytmp->data = NULL;
-            beta->data = NULL;
+            sum->data = NULL;
 
             delete[] dimSize;
             delete ytmp;
-            delete beta;
+            delete sum;
         }
         else{
             ShowNTErrors("TODO!");
@@ -39,7 +39,7 @@ void _CudaSoftmaxSumMax(const XTensor * x, XTensor * y, int leadDim, XTensor * s
 void _CudaSoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x,
                           XTensor * dedy, XTensor * dedx, 
                           XTensor * padding, int leadDim, 
-                          LOSS_FUNCTION_NAME lossName);
+                          LOSS_FUNCTION_NAME lossName, DTYPE beta = 0);
 
 #endif // USE_CUDA
 
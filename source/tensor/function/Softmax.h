@@ -33,11 +33,11 @@ void _Softmax(const XTensor * x, XTensor * y, int leadDim);
 /* softmax y = e^x / \sum_{i} e^{x_i} (return an XTensor structure) */
 XTensor Softmax(const XTensor &x, int leadDim);
 
-/* de/dx */
+/* de/dx (it is accumulated into dedx if beta != 0, i.e., dedx = de/dx + dedx * \beta) */
 void _SoftmaxBackward(XTensor * gold, XTensor * y, XTensor * x, 
                       XTensor * dedy, XTensor * dedx, 
                       XTensor * padding, int leadDim,
-                      LOSS_FUNCTION_NAME lossName);
+                      LOSS_FUNCTION_NAME lossName, DTYPE beta = 0);
 
 } // namespace nts(NiuTrans.Tensor)
 
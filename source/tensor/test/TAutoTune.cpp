@@ -0,0 +1,201 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include "../XTensor.h"
+#include "../XUtility.h"
+#include "../core/arithmetic/MatrixMulBatchedStrided.h"
+#include "../core/arithmetic/MatrixMulTuned.h"
+#include "TAutoTune.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* case 1: the features of the CPU are consistent */
+bool TestAutoTuneCase1()
+{
+    const XCPUFeatures & f = GetCPUFeatures();
+    XCPU_ISA isa = GetCPUISA();
+
+    bool ok = f.isDetected;
+    ok = ok && (!f.hasAVX2 || f.hasAVX);
+    ok = ok && (!f.hasAVX512VNNI || f.hasAVX512F);
+    ok = ok && (isa < ISA_AVX512 || f.hasAVX512F);
+    ok = ok && (isa < ISA_AVX2 || f.hasAVX2);
+    ok = ok && GetBMMISA() <= isa;
+
+    return ok;
+}
+
+/* case 2: the settings are kept in the cache and the file */
+bool TestAutoTuneCase2()
+{
+    const char * fn = "autotune.test.tmp";
+    remove(fn);
+
+    XAutoTuner tuner;
+    tuner.Enable(fn);
+
+    bool ok = tuner.entryNum == 0;
+
+    /* enough settings for the table to grow */
+    for (int i = 0; i < 300; i++) {
+        int dims[3] = {i, i * 2, 7};
+        XTuneKey key;
+        XAutoTuner::MakeKey(key, "test", 3, dims);
+
+        XTuneChoice choice;
+        choice.kernel = i % 3;
+        choice.threadNum = i;
+        choice.tileRow = 16;
+        choice.tileCol = 128;
+        choice.time = 0.5;
+        tuner.Add(key, choice);
+    }
+
+    ok = ok && tuner.entryNum == 300;
+
+    XAutoTuner loaded;
+    loaded.Enable(fn);
+    ok = ok && loaded.entryNum == 300;
+
+    for (int i = 0; i < 300 && ok; i++) {
+        int dims[3] = {i, i * 2, 7};
+        XTuneKey key;
+        XAutoTuner::MakeKey(key, "test", 3, dims);
+
+        XTuneChoice choice;
+        ok = loaded.Find(key, choice) && choice.kernel == i % 3 && choice.threadNum == i &&
+             choice.tileRow == 16 && choice.tileCol == 128;
+    }
+
+    int dims[3] = {1, 2, 8};
+    XTuneKey key;
+    XTuneChoice choice;
+    XAutoTuner::MakeKey(key, "test", 3, dims);
+    ok = ok && !loaded.Find(key, choice);
+
+    remove(fn);
+
+    return ok;
+}
+
+/* case 3: the tuned multiplication is the same as the default one */
+bool TestAutoTuneCase3()
+{
+    int count = 3;
+    int n = 37;
+    int k = 50;
+    int m = 300;
+
+    DTYPE * a = new DTYPE[count * n * k];
+    DTYPE * b = new DTYPE[count * m * k];
+    DTYPE * c1 = new DTYPE[count * n * m];
+    DTYPE * c2 = new DTYPE[count * n * m];
+
+    for (int i = 0; i < count * n * k; i++)
+        a[i] = (DTYPE)((i * 7) % 13 - 6) / 6.0F;
+    for (int i = 0; i < count * m * k; i++)
+        b[i] = (DTYPE)((i * 5) % 11 - 5) / 5.0F;
+    for (int i = 0; i < count * n * m; i++)
+        c1[i] = c2[i] = (DTYPE)(i % 7);
+
+    XPRunner runner;
+    runner.Init(2);
+
+    bool ok = true;
+
+    /* a * trans(b) with a shared b, and a * b */
+    for (int t = 0; t < 2 && ok; t++) {
+        MATRIX_TRANS_TYPE transB = t == 0 ? X_TRANS : X_NOTRANS;
+        int nb = t == 0 ? m : k;
+        int mb = t == 0 ? k : m;
+        int strideB = t == 0 ? 0 : m * k;
+
+        _MatrixMulBatchedStridedCPU(a, X_NOTRANS, n, k, n * k, b, transB, nb, mb, strideB,
+                                    c1, n, m, n * m, count, 0.5F, 2.0F, &runner);
+
+        GTuner.Enable(NULL);
+        _MatrixMulTunedCPU(a, X_NOTRANS, n, k, n * k, b, transB, nb, mb, strideB,
+                           c2, n, m, n * m, count, 0.5F, 2.0F, &runner);
+        bool tuned = GTuner.entryNum > 0;
+        GTuner.Disable();
+        GTuner.Clear();
+
+        ok = tuned;
+        for (int i = 0; i < count * n * m && ok; i++)
+            ok = fabs(c1[i] - c2[i]) < 1e-3F * MAX(1.0F, fabs(c1[i]));
+    }
+
+    delete[] a;
+    delete[] b;
+    delete[] c1;
+    delete[] c2;
+
+    return ok;
+}
+
+/* test for the CPU dispatch and the kernel tuner */
+bool TestAutoTune()
+{
+    XPRINT(0, stdout, "[Test] CPU dispatch and kernel tuner ... Began\n");
+    bool returnFlag = true;
+    bool caseFlag = true;
+
+    double startT = GetClock();
+
+    /* case 1 test */
+    caseFlag = TestAutoTuneCase1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestAutoTuneCase2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestAutoTuneCase3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    double endT = GetClock();
+
+    XPRINT1(0, stdout, "[Test] Finished (took %.3lfms)\n\n", endT - startT);
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,886 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../XTensor.h"
+#include "../XUtility.h"
+#include "../XCPU.h"
+#include "../XAutoTune.h"
+#include "../XBLAS.h"
+#include "../core/CHeader.h"
+#include "../function/FHeader.h"
+#include "TBenchmark.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* constructor */
+XBench::XBench()
+{
+    results = new XBenchResult[MAX_BENCH_NUM];
+    resultNum = 0;
+    minTime = 200.0;
+    filter = NULL;
+    runner = NULL;
+}
+
+/* de-constructor */
+XBench::~XBench()
+{
+    delete[] results;
+}
+
+/*
+check whether a benchmark is to run
+>> name - name of the benchmark
+*/
+bool XBench::IsSelected(const char * name)
+{
+    return filter == NULL || *filter == 0 || strstr(name, filter) != NULL;
+}
+
+/* compare two times (for sorting) */
+int _CompareBenchTime(const void * a, const void * b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*
+run a benchmark. The function runs once for warm-up, and then again and
+again until it takes "minTime" ms (and at least three times).
+>> name - name of the benchmark
+>> func - the function
+>> arg - the argument of the function
+>> work - amount of the work of a run (e.g., GFLOP), 0 if it is unknown
+>> unit - unit of the rate (e.g., GFLOPS)
+<< return - the median time of a run (in ms)
+*/
+double XBench::Run(const char * name, XBenchFunc func, void * arg, double work, const char * unit)
+{
+    if (!IsSelected(name))
+        return 0;
+
+    func(arg);
+
+    double * samples = new double[MAX_BENCH_SAMPLE_NUM];
+    int num = 0;
+    double total = 0;
+
+    while (num < MAX_BENCH_SAMPLE_NUM && (num < 3 || total < minTime)) {
+        double startT = GetClock();
+        func(arg);
+        samples[num] = GetClock() - startT;
+        total += samples[num];
+        num++;
+    }
+
+    qsort(samples, num, sizeof(double), _CompareBenchTime);
+    double ms = samples[num / 2];
+    delete[] samples;
+
+    Add(name, ms, work > 0 && ms > 0 ? work / (ms / 1000) : 0, unit, num);
+
+    return ms;
+}
+
+/*
+add a result that is measured elsewhere
+>> name - name of the benchmark
+>> ms - time of a run
+>> rate - rate of the work
+>> unit - unit of the rate
+>> runNum - number of the runs
+*/
+void XBench::Add(const char * name, double ms, double rate, const char * unit, int runNum)
+{
+    CheckNTErrors(resultNum < MAX_BENCH_NUM, "Too many benchmarks!");
+
+    XBenchResult &r = results[resultNum++];
+    memset(&r, 0, sizeof(r));
+    strncpy(r.name, name, MAX_BENCH_NAME_LENGTH - 1);
+    strncpy(r.unit, unit, sizeof(r.unit) - 1);
+    r.ms = ms;
+    r.rate = rate;
+    r.runNum = runNum;
+
+    XPRINT5(0, stderr, "[BENCH] %-40s %12.4f ms %10.2f %s (%d runs)\n", r.name, r.ms, r.rate, r.unit, r.runNum);
+}
+
+/*
+find a result
+>> name - name of the benchmark
+*/
+const XBenchResult * XBench::Find(const char * name) const
+{
+    for (int i = 0; i < resultNum; i++) {
+        if (!strcmp(results[i].name, name))
+            return results + i;
+    }
+    return NULL;
+}
+
+/* show the results */
+void XBench::Show(FILE * file)
+{
+    fprintf(file, "%-40s %12s %12s\n", "benchmark", "ms", "rate");
+    for (int i = 0; i < resultNum; i++)
+        fprintf(file, "%-40s %12.4f %12.2f %s\n", results[i].name, results[i].ms, results[i].rate, results[i].unit);
+}
+
+/*
+save the results as JSON. Each result is in a line so that the file
+is easy to diff and to read back.
+>> fn - the file
+*/
+void XBench::Save(const char * fn)
+{
+    FILE * file = fopen(fn, "wb");
+    CheckNTErrors(file != NULL, "Cannot open the file for the benchmark results!");
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"isa\": \"%s\",\n", GetISAName(GetCPUISA()));
+    fprintf(file, "  \"threads\": %d,\n", runner != NULL ? runner->threadNum : 1);
+    fprintf(file, "  \"results\": [\n");
+    for (int i = 0; i < resultNum; i++) {
+        XBenchResult &r = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"ms\": %.6f, \"rate\": %.4f, \"unit\": \"%s\", \"runs\": %d}%s\n",
+                r.name, r.ms, r.rate, r.unit, r.runNum, i < resultNum - 1 ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    fclose(file);
+}
+
+/*
+read the value of a field in a line of JSON
+>> line - the line
+>> field - name of the field
+<< return - the beginning of the value (NULL if it is not there)
+*/
+const char * _FindBenchField(const char * line, const char * field)
+{
+    char key[64];
+    sprintf(key, "\"%s\":", field);
+
+    const char * p = strstr(line, key);
+    if (p == NULL)
+        return NULL;
+
+    p += strlen(key);
+    while (*p == ' ')
+        p++;
+
+    return p;
+}
+
+/*
+load the results from a JSON file (that is saved by XBench::Save)
+>> fn - the file
+<< return - succeeded or not
+*/
+bool XBench::Load(const char * fn)
+{
+    FILE * file = fopen(fn, "rb");
+    if (file == NULL)
+        return false;
+
+    char line[1024];
+    resultNum = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        const char * name = _FindBenchField(line, "name");
+        const char * ms = _FindBenchField(line, "ms");
+        if (name == NULL || ms == NULL || *name != '"')
+            continue;
+
+        CheckNTErrors(resultNum < MAX_BENCH_NUM, "Too many benchmarks!");
+
+        XBenchResult &r = results[resultNum++];
+        memset(&r, 0, sizeof(r));
+
+        name++;
+        int len = 0;
+        while (name[len] != '"' && name[len] != 0 && len < MAX_BENCH_NAME_LENGTH - 1) {
+            r.name[len] = name[len];
+            len++;
+        }
+
+        r.ms = atof(ms);
+
+        const char * rate = _FindBenchField(line, "rate");
+        if (rate != NULL)
+            r.rate = atof(rate);
+
+        const char * unit = _FindBenchField(line, "unit");
+        if (unit != NULL && *unit == '"')
+            sscanf(unit + 1, "%15[^\"]", r.unit);
+
+        const char * runs = _FindBenchField(line, "runs");
+        if (runs != NULL)
+            r.runNum = atoi(runs);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+/*
+compare the results with a baseline. A benchmark regresses if it is
+slower than the baseline by more than the threshold.
+>> baseline - the baseline
+>> threshold - the threshold, e.g., 0.1 means 10% slower
+>> file - where we show the comparison
+<< return - number of the benchmarks that regress
+*/
+int XBench::Compare(const XBench &baseline, double threshold, FILE * file)
+{
+    int regressed = 0;
+    int improved = 0;
+    int missing = 0;
+
+    fprintf(file, "%-40s %12s %12s %9s\n", "benchmark", "baseline(ms)", "current(ms)", "change");
+
+    for (int i = 0; i < resultNum; i++) {
+        const XBenchResult &r = results[i];
+        const XBenchResult * b = baseline.Find(r.name);
+
+        if (b == NULL || b->ms <= 0) {
+            fprintf(file, "%-40s %12s %12.4f %9s\n", r.name, "-", r.ms, "new");
+            continue;
+        }
+
+        double change = r.ms / b->ms - 1.0;
+        const char * flag = "";
+
+        if (change > threshold) {
+            flag = "  REGRESSION";
+            regressed++;
+        }
+        else if (change < -threshold) {
+            flag = "  improved";
+            improved++;
+        }
+
+        fprintf(file, "%-40s %12.4f %12.4f %+8.1f%%%s\n", r.name, b->ms, r.ms, change * 100, flag);
+    }
+
+    for (int i = 0; i < baseline.resultNum; i++) {
+        if (Find(baseline.results[i].name) == NULL)
+            missing++;
+    }
+
+    fprintf(file, "%d regressed, %d improved (threshold %.1f%%), %d of the baseline not run\n",
+            regressed, improved, threshold * 100, missing);
+
+    return regressed;
+}
+
+/* arguments of the operator benchmarks */
+struct BenchOpArg
+{
+    XTensor * a;
+    XTensor * b;
+    XTensor * c;
+    XTensor * d;
+    MATRIX_TRANS_TYPE transA;
+    MATRIX_TRANS_TYPE transB;
+    int dim;
+    int num;
+    XPRunner * runner;
+    XMem * mem;
+};
+
+void _BenchGEMM(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _MatrixMul2D(p->a, p->transA, p->b, p->transB, p->c, 1.0F, 0, p->runner);
+}
+
+void _BenchBatchedGEMM(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _MatrixMulBatched(p->a, p->transA, p->b, p->transB, p->c, 1.0F, 0, p->runner);
+}
+
+void _BenchSum(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Sum(p->a, p->b, p->c);
+}
+
+void _BenchMultiply(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Multiply(p->a, p->b, p->c);
+}
+
+void _BenchScaleAndShift(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _ScaleAndShift(p->a, p->c, 2.0F, 1.0F);
+}
+
+void _BenchRectify(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Rectify(p->a, p->c);
+}
+
+void _BenchReduceSum(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _ReduceSum(p->a, p->c, p->dim);
+}
+
+void _BenchReduceMax(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _ReduceMax(p->a, p->c, p->dim);
+}
+
+void _BenchSoftmax(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Softmax(p->a, p->c, p->dim);
+}
+
+void _BenchLogSoftmax(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _LogSoftmax(p->a, p->c, p->dim);
+}
+
+void _BenchTopK(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _TopK(p->a, p->c, p->d, p->dim, p->num);
+}
+
+void _BenchSplit(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Split(p->a, p->c, p->dim, p->num);
+}
+
+void _BenchMerge(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _Merge(p->c, p->a, p->dim, 0);
+}
+
+/* copy the whole data with memcpy (as "copy" in the STREAM benchmark) */
+void _BenchStreamCopy(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    memcpy(p->c->data, p->a->data, p->a->unitNum * p->a->unitSize);
+}
+
+/* copy the blocks (of "dim" bytes) to the positions in "d" */
+void _BenchCopyBlocks(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    _CopyBlocksCPU(p->a->data, p->dim, NULL, p->num, p->c->data, (int*)p->d->data, p->runner);
+}
+
+/* allocate and release pieces of memory of various sizes in the order of a stack */
+void _BenchXMem(void * arg)
+{
+    BenchOpArg * p = (BenchOpArg*)arg;
+    void * pieces[64];
+    MTYPE sizes[64];
+
+    for (int r = 0; r < p->num; r++) {
+        for (int i = 0; i < 64; i++) {
+            sizes[i] = (MTYPE)(((i * 7919 + r * 31) % 64) + 1) * 256;
+            pieces[i] = p->mem->AllocStandard(-1, sizes[i]);
+        }
+        for (int i = 63; i >= 0; i--)
+            p->mem->ReleaseStandard(-1, pieces[i], sizes[i]);
+    }
+}
+
+/* arguments of the benchmark of building networks */
+struct BenchGraphArg
+{
+    XTensor * input;
+    XTensor * wq;
+    XTensor * wk;
+    XTensor * wv;
+    XTensor * wa;
+    XTensor * w1;
+    XTensor * b1;
+    XTensor * w2;
+    XTensor * b2;
+    int nhead;
+};
+
+/* build (and then free) the network of a Transformer layer as the Transformer 
+   sample does. The tensors are tiny so that the time is mostly spent in 
+   creating the nodes and the edges of the network */
+void _BenchGraph(void * arg)
+{
+    BenchGraphArg * p = (BenchGraphArg*)arg;
+    XTensor &input = *p->input;
+    int d = input.GetDim(-1);
+
+    XTensor k2, q2, v2;
+    XTensor dot, att, res;
+    XTensor mean, variance, x;
+    XTensor fnn;
+
+    k2 = MMul(input, *p->wk);
+    q2 = MMul(input, *p->wq);
+    v2 = MMul(input, *p->wv);
+
+    dot = BMMul(Split(q2, q2.order - 1, p->nhead), X_NOTRANS, 
+                Split(k2, k2.order - 1, p->nhead), X_TRANS);
+    dot = Linear(dot, 1.0F/(float)sqrt((float)d/p->nhead));
+    att = BMMul(Softmax(dot, -1), Split(v2, v2.order - 1, p->nhead));
+    att = MMul(Merge(att, att.order - 1), *p->wa);
+    res = Sum(att, input);
+
+    mean = ReduceMean(res, res.order - 1);
+    variance = ReduceVariance(res, res.order - 1, mean);
+    x = (res - Unsqueeze(mean, res.order - 1, d)) / 
+        Unsqueeze(Power(variance, 0.5F), res.order - 1, d);
+
+    fnn = MulAndShift(Rectify(MulAndShift(x, *p->w1, *p->b1)), *p->w2, *p->b2);
+    res = Sum(fnn, x);
+}
+
+/* name of the transposition modes */
+const char * _BenchTransName(MATRIX_TRANS_TYPE transA, MATRIX_TRANS_TYPE transB)
+{
+    if (transA == X_NOTRANS)
+        return transB == X_NOTRANS ? "nn" : "nt";
+    else
+        return transB == X_NOTRANS ? "tn" : "tt";
+}
+
+/* benchmarks of matrix multiplication */
+void _BenchmarkGEMM(XBench &bench, bool isQuick)
+{
+    /* rows of c, columns of c, inner size */
+    int quickShapes[][3] = {{64, 64, 64}, {256, 256, 256}, {256, 512, 512}};
+    int fullShapes[][3] = {{64, 64, 64}, {128, 128, 128}, {256, 256, 256}, {512, 512, 512},
+                           {256, 512, 512}, {256, 2048, 512}, {256, 512, 2048}, {64, 10000, 512}};
+    int (*shapes)[3] = isQuick ? quickShapes : fullShapes;
+    int shapeNum = isQuick ? 3 : 8;
+
+    char name[MAX_BENCH_NAME_LENGTH];
+
+    for (int s = 0; s < shapeNum; s++) {
+        int n = shapes[s][0];
+        int m = shapes[s][1];
+        int k = shapes[s][2];
+
+        for (int t = 0; t < 4; t++) {
+            MATRIX_TRANS_TYPE transA = t / 2 ? X_TRANS : X_NOTRANS;
+            MATRIX_TRANS_TYPE transB = t % 2 ? X_TRANS : X_NOTRANS;
+
+            sprintf(name, "gemm.%s.%dx%dx%d", _BenchTransName(transA, transB), n, m, k);
+            if (!bench.IsSelected(name))
+                continue;
+
+            BenchOpArg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.a = transA == X_TRANS ? NewTensor2D(k, n) : NewTensor2D(n, k);
+            arg.b = transB == X_TRANS ? NewTensor2D(m, k) : NewTensor2D(k, m);
+            arg.c = NewTensor2D(n, m);
+            arg.transA = transA;
+            arg.transB = transB;
+            arg.runner = bench.runner;
+            arg.a->SetDataRand(-1.0F, 1.0F);
+            arg.b->SetDataRand(-1.0F, 1.0F);
+
+            bench.Run(name, _BenchGEMM, &arg, 2.0 * n * m * k / 1e9, "GFLOPS");
+
+            delete arg.a;
+            delete arg.b;
+            delete arg.c;
+        }
+    }
+
+    /* heads, rows, columns and inner size of the attention in transformers */
+    int batchShapes[][4] = {{8, 64, 64, 64}, {8, 128, 128, 64}, {8, 128, 64, 128}, {32, 32, 32, 32}};
+    int batchShapeNum = isQuick ? 2 : 4;
+
+    for (int s = 0; s < batchShapeNum; s++) {
+        int h = batchShapes[s][0];
+        int n = batchShapes[s][1];
+        int m = batchShapes[s][2];
+        int k = batchShapes[s][3];
+
+        for (int t = 0; t < 2; t++) {
+            MATRIX_TRANS_TYPE transB = t ? X_TRANS : X_NOTRANS;
+
+            sprintf(name, "bmm.%s.%dx%dx%dx%d", _BenchTransName(X_NOTRANS, transB), h, n, m, k);
+            if (!bench.IsSelected(name))
+                continue;
+
+            BenchOpArg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.a = NewTensor3D(h, n, k);
+            arg.b = transB == X_TRANS ? NewTensor3D(h, m, k) : NewTensor3D(h, k, m);
+            arg.c = NewTensor3D(h, n, m);
+            arg.transA = X_NOTRANS;
+            arg.transB = transB;
+            arg.runner = bench.runner;
+            arg.a->SetDataRand(-1.0F, 1.0F);
+            arg.b->SetDataRand(-1.0F, 1.0F);
+
+            bench.Run(name, _BenchBatchedGEMM, &arg, 2.0 * h * n * m * k / 1e9, "GFLOPS");
+
+            delete arg.a;
+            delete arg.b;
+            delete arg.c;
+        }
+    }
+
+    /* dense * block-sparse multiplication on the shapes of the FNN weights. The
+       rate is of the dense multiplication, so it compares with the dense baselines
+       bsgemm.dense.* that run the same shapes through the tuned kernels (what the
+       transformer runs with -autotune) and through BLAS (in the builds with BLAS) */
+    int sparseShapes[][3] = {{256, 2048, 512}, {256, 512, 2048}};
+    int blockSizes[][2] = {{1, 16}, {4, 4}};
+    int sparsities[] = {70, 80, 90};
+    int sparseShapeNum = isQuick ? 1 : 2;
+
+    for (int s = 0; s < sparseShapeNum; s++) {
+        int n = sparseShapes[s][0];
+        int m = sparseShapes[s][1];
+        int k = sparseShapes[s][2];
+
+        for (int d = 0; d < 2; d++) {
+            sprintf(name, "bsgemm.dense.%s.%dx%dx%d", d == 0 ? "tuned" : "blas", n, m, k);
+            if (!bench.IsSelected(name))
+                continue;
+#ifndef USE_BLAS
+            if (d == 1)
+                continue;
+#endif
+
+            BenchOpArg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.a = NewTensor2D(n, k);
+            arg.b = NewTensor2D(k, m);
+            arg.c = NewTensor2D(n, m);
+            arg.transA = X_NOTRANS;
+            arg.transB = X_NOTRANS;
+            arg.runner = bench.runner;
+            arg.a->SetDataRand(-1.0F, 1.0F);
+            arg.b->SetDataRand(-1.0F, 1.0F);
+
+            /* _MatrixMul2D takes the tuned path if the tuner is on and the BLAS path
+               if useBLAS is set. The first (untimed) run tunes the shape */
+            bool wasTuned = GTuner.isEnabled;
+            bool wasBLAS = useBLAS;
+            if (d == 0 && !wasTuned)
+                GTuner.Enable(NULL);
+            else {
+#ifdef USE_BLAS
+                if (XBLAS_SGEMM == NULL)
+                    LoadBLAS(NULL);
+#endif
+                GTuner.Disable();
+                useBLAS = true;
+            }
+
+            bench.Run(name, _BenchGEMM, &arg, 2.0 * n * m * k / 1e9, "GFLOPS");
+
+            GTuner.isEnabled = wasTuned;
+            useBLAS = wasBLAS;
+
+            delete arg.a;
+            delete arg.b;
+            delete arg.c;
+        }
+
+        for (int b = 0; b < 2; b++) {
+            for (int p = 0; p < 3; p++) {
+                sprintf(name, "bsgemm.%dx%d.s%d.%dx%dx%d", blockSizes[b][0], blockSizes[b][1],
+                        sparsities[p], n, m, k);
+                if (!bench.IsSelected(name))
+                    continue;
+
+                BenchOpArg arg;
+                memset(&arg, 0, sizeof(arg));
+                arg.a = NewTensor2D(n, k);
+                arg.b = NewTensor2D(k, m);
+                arg.c = NewTensor2D(n, m);
+                arg.transA = X_NOTRANS;
+                arg.transB = X_NOTRANS;
+                arg.runner = bench.runner;
+                arg.a->SetDataRand(-1.0F, 1.0F);
+                arg.b->SetDataRand(-1.0F, 1.0F);
+
+                _PruneBlocks(arg.b, blockSizes[b][0], blockSizes[b][1], sparsities[p] / 100.0F);
+
+                bench.Run(name, _BenchGEMM, &arg, 2.0 * n * m * k / 1e9, "GFLOPS");
+
+                delete arg.a;
+                delete arg.b;
+                delete arg.c;
+            }
+        }
+    }
+}
+
+/* benchmarks of element-wise operations, reductions and (log-)softmax */
+void _BenchmarkElementwise(XBench &bench, bool isQuick)
+{
+    int sizes[3] = {1 << 12, 1 << 16, 1 << 20};
+    int sizeNum = isQuick ? 2 : 3;
+    char name[MAX_BENCH_NAME_LENGTH];
+
+    for (int s = 0; s < sizeNum; s++) {
+        int size = sizes[s];
+
+        BenchOpArg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.a = NewTensor1D(size);
+        arg.b = NewTensor1D(size);
+        arg.c = NewTensor1D(size);
+        arg.a->SetDataRand(-1.0F, 1.0F);
+        arg.b->SetDataRand(-1.0F, 1.0F);
+
+        double gb = (double)size * sizeof(DTYPE) / 1e9;
+
+        sprintf(name, "sum.%d", size);
+        bench.Run(name, _BenchSum, &arg, 3 * gb, "GB/s");
+
+        sprintf(name, "multiply.%d", size);
+        bench.Run(name, _BenchMultiply, &arg, 3 * gb, "GB/s");
+
+        sprintf(name, "scaleandshift.%d", size);
+        bench.Run(name, _BenchScaleAndShift, &arg, 2 * gb, "GB/s");
+
+        sprintf(name, "rectify.%d", size);
+        bench.Run(name, _BenchRectify, &arg, 2 * gb, "GB/s");
+
+        delete arg.a;
+        delete arg.b;
+        delete arg.c;
+    }
+
+    /* rows and columns, e.g., (tokens, hidden size) and (tokens, vocabulary size) */
+    int shapes[][2] = {{256, 512}, {64, 8000}, {64, 32000}};
+    int shapeNum = isQuick ? 2 : 3;
+
+    for (int s = 0; s < shapeNum; s++) {
+        int n = shapes[s][0];
+        int m = shapes[s][1];
+        double gb = (double)n * m * sizeof(DTYPE) / 1e9;
+
+        BenchOpArg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.a = NewTensor2D(n, m);
+        arg.a->SetDataRand(-3.0F, 3.0F);
+
+        for (int dim = 0; dim < 2; dim++) {
+            arg.c = NewTensor1D(dim == 0 ? m : n);
+            arg.dim = dim;
+
+            sprintf(name, "reducesum.%dx%d.d%d", n, m, dim);
+            bench.Run(name, _BenchReduceSum, &arg, gb, "GB/s");
+
+            sprintf(name, "reducemax.%dx%d.d%d", n, m, dim);
+            bench.Run(name, _BenchReduceMax, &arg, gb, "GB/s");
+
+            delete arg.c;
+        }
+
+        arg.c = NewTensor2D(n, m);
+        arg.dim = 1;
+
+        sprintf(name, "softmax.%dx%d", n, m);
+        bench.Run(name, _BenchSoftmax, &arg, 2 * gb, "GB/s");
+
+        sprintf(name, "logsoftmax.%dx%d", n, m);
+        bench.Run(name, _BenchLogSoftmax, &arg, 2 * gb, "GB/s");
+
+        delete arg.a;
+        delete arg.c;
+    }
+}
+
+/* benchmarks of TopK, Merge/Split and the memory pool */
+void _BenchmarkOthers(XBench &bench, bool isQuick)
+{
+    char name[MAX_BENCH_NAME_LENGTH];
+
+    /* top-k over the vocabulary (e.g., in beam search) */
+    int vocabSizes[2] = {8000, 32000};
+    int ks[2] = {4, 32};
+
+    for (int v = 0; v < (isQuick ? 1 : 2); v++) {
+        for (int j = 0; j < 2; j++) {
+            int rowNum = 64;
+            int k = ks[j];
+
+            BenchOpArg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.a = NewTensor2D(rowNum, vocabSizes[v]);
+            arg.c = NewTensor2D(rowNum, k);
+            arg.d = NewTensor2D(rowNum, k, X_INT);
+            arg.dim = 1;
+            arg.num = k;
+            arg.a->SetDataRand(-3.0F, 3.0F);
+
+            sprintf(name, "topk.%dx%d.k%d", rowNum, vocabSizes[v], k);
+            bench.Run(name, _BenchTopK, &arg, (double)rowNum * vocabSizes[v] * sizeof(DTYPE) / 1e9, "GB/s");
+
+            delete arg.a;
+            delete arg.c;
+            delete arg.d;
+        }
+    }
+
+    /* splitting the hidden states into heads and merging them back */
+    int shapes[][4] = {{16, 32, 512, 8}, {32, 64, 512, 8}, {32, 64, 1024, 16}};
+
+    for (int s = 0; s < (isQuick ? 2 : 3); s++) {
+        int batch = shapes[s][0];
+        int len = shapes[s][1];
+        int d = shapes[s][2];
+        int h = shapes[s][3];
+        double gb = 2.0 * batch * len * d * sizeof(DTYPE) / 1e9;
+
+        BenchOpArg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.a = NewTensor3D(batch, len, d);
+        arg.c = NewTensor4D(h, batch, len, d / h);
+        arg.dim = 2;
+        arg.num = h;
+        arg.a->SetDataRand(-1.0F, 1.0F);
+
+        sprintf(name, "split.%dx%dx%d.h%d", batch, len, d, h);
+        bench.Run(name, _BenchSplit, &arg, gb, "GB/s");
+
+        arg.dim = 3;
+        sprintf(name, "merge.%dx%dx%d.h%d", batch, len, d, h);
+        bench.Run(name, _BenchMerge, &arg, gb, "GB/s");
+
+        delete arg.a;
+        delete arg.c;
+    }
+
+    /* block copy against the memory bandwidth (STREAM copy). The blocks are
+       placed as in merging heads, i.e., no two blocks are next to each other
+       in the target */
+    int copySizes[] = {8, 32};
+    int copyBlocks[] = {64, 256, 4096, 1024 * 64};
+
+    for (int s = 0; s < (isQuick ? 1 : 2); s++) {
+        int size = copySizes[s] * 1024 * 1024;
+        double gb = 2.0 * size / 1e9;
+
+        BenchOpArg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.a = NewTensor1D(size / sizeof(DTYPE));
+        arg.c = NewTensor1D(size / sizeof(DTYPE));
+        arg.runner = bench.runner;
+        arg.a->SetDataRand(-1.0F, 1.0F);
+        arg.c->SetZeroAll();
+
+        sprintf(name, "copy.stream.%dMB", copySizes[s]);
+        bench.Run(name, _BenchStreamCopy, &arg, gb, "GB/s");
+
+        for (int b = 0; b < 4; b++) {
+            int blockNum = size / copyBlocks[b];
+            int headNum = MIN(8, blockNum);
+            arg.dim = copyBlocks[b];
+            arg.num = blockNum;
+            arg.d = NewTensor1D(blockNum, X_INT);
+
+            int * index = (int*)arg.d->data;
+            for (int i = 0; i < blockNum; i++)
+                index[i] = (i % headNum) * (blockNum / headNum) + i / headNum;
+
+            sprintf(name, "copy.blocks.%dMB.b%d", copySizes[s], copyBlocks[b]);
+            bench.Run(name, _BenchCopyBlocks, &arg, gb, "GB/s");
+
+            delete arg.d;
+        }
+
+        delete arg.a;
+        delete arg.c;
+    }
+
+    /* building the network of a Transformer layer (on tiny tensors) */
+    sprintf(name, "graph.t2t.layer");
+    if (bench.IsSelected(name)) {
+        int d = 8;
+        int hSize = 16;
+
+        BenchGraphArg arg;
+        arg.input = NewTensor3D(2, 4, d);
+        arg.wq = NewTensor2D(d, d);
+        arg.wk = NewTensor2D(d, d);
+        arg.wv = NewTensor2D(d, d);
+        arg.wa = NewTensor2D(d, d);
+        arg.w1 = NewTensor2D(d, hSize);
+        arg.b1 = NewTensor1D(hSize);
+        arg.w2 = NewTensor2D(hSize, d);
+        arg.b2 = NewTensor1D(d);
+        arg.nhead = 2;
+
+        XTensor * ts[] = {arg.input, arg.wq, arg.wk, arg.wv, arg.wa, arg.w1, arg.b1, arg.w2, arg.b2};
+        int tNum = sizeof(ts) / sizeof(ts[0]);
+        for (int i = 0; i < tNum; i++)
+            ts[i]->SetDataRand(-1.0F, 1.0F);
+
+        bench.Run(name, _BenchGraph, &arg);
+
+        for (int i = 0; i < tNum; i++)
+            delete ts[i];
+    }
+
+    /* the memory pool */
+    sprintf(name, "xmem.allocfree.64x100");
+    if (bench.IsSelected(name)) {
+        XMem mem;
+        mem.Initialize(-1, FREE_ON_THE_FLY, MILLION * 16, 16, 0);
+        mem.SetIndex(100000);
+
+        BenchOpArg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.mem = &mem;
+        arg.num = 100;
+
+        bench.Run(name, _BenchXMem, &arg);
+    }
+}
+
+/*
+benchmarks of the core operators over a sweep of shapes
+>> bench - where we keep the results
+>> isQuick - indicates whether we run the small shapes only
+*/
+void BenchmarkOperators(XBench &bench, bool isQuick)
+{
+    _BenchmarkGEMM(bench, isQuick);
+    _BenchmarkElementwise(bench, isQuick);
+    _BenchmarkOthers(bench, isQuick);
+}
+
+} // namespace nts(NiuTrans.Tensor)
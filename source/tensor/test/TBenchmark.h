@@ -0,0 +1,117 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * Speed benchmarks. A benchmark runs a function until it has taken long
+ * enough and keeps the median time of a run, together with a rate (GFLOPS or
+ * GB/s) if the amount of work is known. The results are written as JSON
+ * (one result per line) and can be compared with a saved baseline to find
+ * the benchmarks that become slower.
+ */
+
+#ifndef __TBENCHMARK_H__
+#define __TBENCHMARK_H__
+
+#include <stdio.h>
+#include "../XGlobal.h"
+#include "../XPRunner.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+#define MAX_BENCH_NAME_LENGTH 128
+#define MAX_BENCH_NUM 1024
+#define MAX_BENCH_SAMPLE_NUM 1000
+
+/* a function to benchmark */
+typedef void (*XBenchFunc)(void * arg);
+
+/* result of a benchmark */
+struct XBenchResult
+{
+    /* name of the benchmark */
+    char name[MAX_BENCH_NAME_LENGTH];
+
+    /* time of a run (median, in ms) */
+    double ms;
+
+    /* rate of the work (0 if it is unknown) */
+    double rate;
+
+    /* unit of the rate, e.g., "GFLOPS" */
+    char unit[16];
+
+    /* number of the runs */
+    int runNum;
+};
+
+/* a set of benchmarks */
+class XBench
+{
+public:
+    /* the results */
+    XBenchResult * results;
+
+    /* number of the results */
+    int resultNum;
+
+    /* the minimum time (in ms) to run a benchmark */
+    double minTime;
+
+    /* the benchmarks whose names do not contain it are skipped (NULL means all) */
+    const char * filter;
+
+    /* the runner for the operations that run in parallel */
+    XPRunner * runner;
+
+public:
+    /* constructor */
+    XBench();
+
+    /* de-constructor */
+    ~XBench();
+
+    /* check whether a benchmark is to run */
+    bool IsSelected(const char * name);
+
+    /* run a benchmark */
+    double Run(const char * name, XBenchFunc func, void * arg, double work = 0, const char * unit = "");
+
+    /* add a result that is measured elsewhere */
+    void Add(const char * name, double ms, double rate = 0, const char * unit = "", int runNum = 1);
+
+    /* find a result */
+    const XBenchResult * Find(const char * name) const;
+
+    /* show the results */
+    void Show(FILE * file);
+
+    /* save the results as JSON */
+    void Save(const char * fn);
+
+    /* load the results from a JSON file */
+    bool Load(const char * fn);
+
+    /* compare the results with a baseline */
+    int Compare(const XBench &baseline, double threshold, FILE * file);
+};
+
+/* benchmarks of the core operators */
+void BenchmarkOperators(XBench &bench, bool isQuick);
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __TBENCHMARK_H__
@@ -232,12 +232,12 @@ bool TestConvertDataType3()
     /* initialize variables */
     a->SetData(data1, unitNum1);
 
-    /* call ConvertDataType function (We have not implemented this yet...)  */
-    //_ConvertDataType(a, b);
-    //_ConvertDataType(b, c);
+    /* call ConvertDataType function */
+    _ConvertDataType(a, b);
+    _ConvertDataType(b, c);
     
     /* check results */
-    //cpuTest = a->CheckData(data1, unitNum1, 1e-4F);
+    cpuTest = c->CheckData(data1, unitNum1, 1e-4F);
 
 #ifdef USE_CUDA
     /* GPU test */
@@ -290,6 +290,61 @@ bool TestConvertDataType3()
 #endif // USE_CUDA
 }
 
+/*
+case 4: test ConvertDataType function.
+In this case, the float data type is converted to int8 (rounded and
+saturated) and double data types, and back to float.
+*/
+bool TestConvertDataType4()
+{
+    /* a tensor of size (2, 4) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 2;
+    dimSize[1] = 4;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE aData[2][4] = { {1.4F, -2.6F, 0.5F, 300.0F},
+                          {-0.25F, 127.0F, -200.0F, 6.0F} };
+    DTYPE answer[2][4] = { {1.0F, -3.0F, 1.0F, 127.0F},
+                           {0.0F, 127.0F, -128.0F, 6.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(order, dimSize, X_FLOAT, 1.0F, -1);
+    XTensor * b = NewTensor(order, dimSize, X_INT8, 1.0F, -1);
+    XTensor * c = NewTensor(order, dimSize, X_FLOAT, 1.0F, -1);
+    XTensor * d = NewTensor(order, dimSize, X_DOUBLE, 1.0F, -1);
+    XTensor * e = NewTensor(order, dimSize, X_FLOAT, 1.0F, -1);
+
+    /* initialize variables */
+    a->SetData(aData, unitNum);
+
+    /* call ConvertDataType function */
+    _ConvertDataType(a, b);
+    _ConvertDataType(b, c);
+    _ConvertDataType(a, d);
+    _ConvertDataType(d, e);
+
+    /* check results */
+    cpuTest = c->CheckData(answer, unitNum) && e->CheckData(aData, unitNum);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+    delete d;
+    delete e;
+    delete[] dimSize;
+
+    return cpuTest;
+}
+
 /* other cases */
 /*
 TODO!!
@@ -331,6 +386,16 @@ bool TestConvertDataType()
 	else
 		XPRINT(0, stdout, ">> case 3 passed!\n");
 
+    /* case 4 test */
+	caseFlag = TestConvertDataType4();
+
+	if (!caseFlag) {
+		returnFlag = false;
+		XPRINT(0, stdout, ">> case 4 failed!\n");
+	}
+	else
+		XPRINT(0, stdout, ">> case 4 passed!\n");
+
 	/* other cases test */
 	/*
 	TODO!!
@@ -0,0 +1,202 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "../XUtility.h"
+#include "../XPRunner.h"
+#include "../core/shape/Merge.h"
+#include "../core/shape/Split.h"
+#include "TCopyBlocks.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* 
+copy the blocks one by one (the reference)
+>> sourceBlocks - source positions of the copy (NULL means block i is at position i)
+*/
+void _CopyBlocksOneByOne(char * source, int blockSize, int * sourceBlocks, int blockNum, char * target, int * targetBlocks)
+{
+    for (int i = 0; i < blockNum; i++) {
+        int s = sourceBlocks == NULL ? i : sourceBlocks[i];
+        memcpy(target + (MTYPE)targetBlocks[i] * blockSize, source + (MTYPE)s * blockSize, blockSize);
+    }
+}
+
+/* 
+check a copy against the reference
+>> blockSize - size of block (in bytes)
+>> blockNum - number of blocks
+>> runLength - number of blocks in a run (the runs are copied in a reverse order)
+>> isSelected - indicates whether the source positions are given
+>> runner - parallel processing module
+*/
+bool _CheckCopyBlocks(int blockSize, int blockNum, int runLength, bool isSelected, XPRunner * runner)
+{
+    CheckNTErrors(blockNum % runLength == 0, "The blocks cannot be split into runs!");
+
+    MTYPE size = (MTYPE)blockSize * blockNum;
+    char * source = new char[size];
+    char * target = new char[size];
+    char * answer = new char[size];
+    int * sourceBlocks = new int[blockNum];
+    int * targetBlocks = new int[blockNum];
+
+    for (MTYPE i = 0; i < size; i++)
+        source[i] = (char)(i * 131 + 7);
+
+    /* runs of blocks in a reverse order, and each run is kept in the order */
+    int runNum = blockNum / runLength;
+    for (int i = 0; i < blockNum; i++) {
+        int run = i / runLength;
+        targetBlocks[i] = (runNum - 1 - run) * runLength + i % runLength;
+        sourceBlocks[i] = (targetBlocks[i] + runLength) % blockNum;
+    }
+
+    memset(target, 0, size);
+    memset(answer, 0, size);
+
+    _CopyBlocksOneByOne(source, blockSize, isSelected ? sourceBlocks : NULL, blockNum, answer, targetBlocks);
+    _CopyBlocksCPU(source, blockSize, isSelected ? sourceBlocks : NULL, blockNum, target, targetBlocks, runner);
+
+    bool ok = memcmp(target, answer, size) == 0;
+
+    delete[] source;
+    delete[] target;
+    delete[] answer;
+    delete[] sourceBlocks;
+    delete[] targetBlocks;
+
+    return ok;
+}
+
+/* case 1: small copies of blocks (in one thread) */
+bool TestCopyBlocksCase1()
+{
+    bool ok = true;
+
+    ok = ok && _CheckCopyBlocks(sizeof(int), 100, 1, false, NULL);
+    ok = ok && _CheckCopyBlocks(sizeof(int), 100, 10, false, NULL);
+    ok = ok && _CheckCopyBlocks(12, 36, 4, true, NULL);
+    ok = ok && _CheckCopyBlocks(256, 64, 8, false, NULL);
+    ok = ok && _CheckCopyBlocks(256, 64, 1, true, NULL);
+
+    return ok;
+}
+
+/* case 2: large copies in parallel, including the copies with non-temporal stores */
+bool TestCopyBlocksCase2()
+{
+    XPRunner runner;
+    runner.Init(4);
+
+    bool ok = true;
+
+    /* blocks that are smaller than a chunk */
+    ok = ok && _CheckCopyBlocks(sizeof(int), 1024 * 256, 16, false, &runner);
+    ok = ok && _CheckCopyBlocks(100, 1024 * 8, 4, true, &runner);
+
+    /* blocks that are larger than a chunk (and runs of non-temporal stores) */
+    ok = ok && _CheckCopyBlocks(COPY_CHUNK_SIZE * 3 + 20, 1024, 4, false, &runner);
+    ok = ok && _CheckCopyBlocks(MIN_STREAM_COPY_SIZE / 4 + 8, 6, 2, false, &runner);
+    ok = ok && _CheckCopyBlocks(MIN_STREAM_COPY_SIZE / 16 + 4, 20, 1, true, &runner);
+
+    return ok;
+}
+
+/* case 3: merge and split on top of the block copy (with the global runner) */
+bool TestCopyBlocksCase3()
+{
+    XPRunner runner;
+    runner.Init(4);
+
+    XPRunner * backup = globalPRunner;
+    globalPRunner = &runner;
+
+    XTensor * s = NewTensor3D(8, 64, 512);
+    XTensor * t = NewTensor4D(8, 8, 64, 64);
+    XTensor * r = NewTensor3D(8, 64, 512);
+
+    s->SetDataRand(-1.0F, 1.0F);
+
+    _Split(s, t, 2, 8);
+    _Merge(t, r, 3, 0);
+
+    bool ok = r->CheckData(s->data, s->unitNum);
+
+    /* the same with copies in one thread */
+    globalPRunner = NULL;
+
+    XTensor * t2 = NewTensor4D(8, 8, 64, 64);
+    _Split(s, t2, 2, 8);
+    ok = ok && t2->CheckData(t->data, t->unitNum);
+
+    globalPRunner = backup;
+
+    delete s;
+    delete t;
+    delete r;
+    delete t2;
+
+    return ok;
+}
+
+/* test for CopyBlocks Function */
+bool TestCopyBlocks()
+{
+    XPRINT(0, stdout, "[TEST CopyBlocks] copy blocks in runs with multi-threading \n");
+    bool returnFlag = true;
+    bool caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestCopyBlocksCase1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestCopyBlocksCase2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestCopyBlocksCase3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,31 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TCOPYBLOCKS_H__
+#define __TCOPYBLOCKS_H__
+
+#include "../core/movement/CopyBlocks.h"
+#include "../core/movement/CopyBlocksOnSite.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* test for CopyBlocks Function */
+extern "C"
+bool TestCopyBlocks();
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __TCOPYBLOCKS_H__
@@ -0,0 +1,221 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TGatherByIndex.h"
+#include "../core/arithmetic/Multiply.h"
+#include "../core/reduce/ReduceSum.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* 
+case 1: gather one entry of each row by index
+In this case, (2, 2, 4) -> (2, 2). Row (1, 0) has a negative index 
+and row (1, 1) is masked, so both of them are 0.
+*/
+bool TestGatherByIndex1()
+{
+    /* a input tensor of size (2, 2, 4) */
+    int sOrder = 3;
+    int sDimSize[3] = {2, 2, 4};
+    int sUnitNum = 16;
+
+    /* index and output tensors of size (2, 2) */
+    int tOrder = 2;
+    int tDimSize[2] = {2, 2};
+    int tUnitNum = 4;
+
+    DTYPE sData[2][2][4] = { { {0.0F, -1.0F, 2.0F, 3.0F},
+                               {2.0F, 1.0F, 3.0F, -2.0F} },
+                             { {1.0F, 2.0F, 4.0F, 5.0F},
+                               {3.0F, 1.0F, 2.0F, 0.5F} } };
+    int indexData[2][2] = { {3, 0}, {-1, 2} };
+    DTYPE maskData[2][2] = { {1.0F, 1.0F}, {1.0F, 0.0F} };
+    DTYPE answer[2][2] = { {3.0F, 2.0F}, {0.0F, 0.0F} };
+    DTYPE answer2[2][2] = { {3.0F, 2.0F}, {0.0F, 2.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s = NewTensor(sOrder, sDimSize);
+    XTensor * t = NewTensor(tOrder, tDimSize);
+    XTensor * index = NewTensor(tOrder, tDimSize, X_INT);
+    XTensor * mask = NewTensor(tOrder, tDimSize);
+    XTensor tUser;
+
+    /* initialize variables */
+    s->SetData(sData, sUnitNum);
+    index->SetData(indexData, tUnitNum);
+    mask->SetData(maskData, tUnitNum);
+    t->SetZeroAll();
+
+    /* call GatherByIndex function */
+    _GatherByIndex(s, t, index, mask);
+    tUser = GatherByIndex(*s, *index);
+
+    /* check results */
+    cpuTest = t->CheckData(answer, tUnitNum) && tUser.CheckData(answer2, tUnitNum) &&
+              tUser.order == tOrder;
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensors */
+    XTensor * sGPU = NewTensor(sOrder, sDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * tGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * indexGPU = NewTensor(tOrder, tDimSize, X_INT, 1.0F, 0);
+    XTensor * maskGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+    XTensor tUserGPU;
+
+    /* initialize variables */
+    sGPU->SetData(sData, sUnitNum);
+    indexGPU->SetData(indexData, tUnitNum);
+    maskGPU->SetData(maskData, tUnitNum);
+    tGPU->SetZeroAll();
+
+    /* call GatherByIndex function */
+    _GatherByIndex(sGPU, tGPU, indexGPU, maskGPU);
+    tUserGPU = GatherByIndex(*sGPU, *indexGPU);
+
+    /* check results */
+    gpuTest = tGPU->CheckData(answer, tUnitNum) && tUserGPU.CheckData(answer2, tUnitNum);
+
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete index;
+    delete mask;
+    delete sGPU;
+    delete tGPU;
+    delete indexGPU;
+    delete maskGPU;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete index;
+    delete mask;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
+/* 
+case 2: gather by index vs. the product with the one-hot tensor
+In this case, we score the rows of a (3, 5, 1000) tensor, and the 
+result must be the same as that of multiplying the tensor by the 
+one-hot tensor of the index and summing up each row.
+*/
+bool TestGatherByIndex2()
+{
+    int sDimSize[3] = {3, 5, 1000};
+    int tDimSize[2] = {3, 5};
+    int rowNum = 15;
+
+    /* create tensors */
+    XTensor * s = NewTensor(3, sDimSize);
+    XTensor * index = NewTensor(2, tDimSize, X_INT);
+    XTensor * onehot = NewTensor(3, sDimSize);
+    XTensor * product = NewTensor(3, sDimSize);
+    XTensor * answer = NewTensor(2, tDimSize);
+    XTensor * t = NewTensor(2, tDimSize);
+
+    /* initialize variables */
+    s->SetDataRand(-5.0F, 5.0F);
+
+    int * ids = new int[rowNum];
+    MTYPE * offsets = new MTYPE[rowNum];
+    for (int i = 0; i < rowNum; i++) {
+        ids[i] = (i * 397 + 11) % sDimSize[2];
+        offsets[i] = (MTYPE)i * sDimSize[2] + ids[i];
+    }
+    index->SetData(ids, rowNum);
+
+    /* the dense way */
+    onehot->SetZeroAll();
+    onehot->SetDataBatched(offsets, 1.0F, rowNum);
+    _Multiply(s, onehot, product);
+    _ReduceSum(product, answer, 2);
+
+    /* the index-based way */
+    _GatherByIndex(s, t, index);
+
+    /* check results */
+    bool cpuTest = t->CheckData(answer->data, rowNum, 1e-4F);
+
+    /* destroy variables */
+    delete s;
+    delete index;
+    delete onehot;
+    delete product;
+    delete answer;
+    delete t;
+    delete[] ids;
+    delete[] offsets;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for GatherByIndex Function */
+bool TestGatherByIndex()
+{
+    XPRINT(0, stdout, "[TEST GatherByIndex] gather one entry of each row by index \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestGatherByIndex1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestGatherByIndex2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -19,6 +19,7 @@
 * $Created by: Xu Chen (email: hello_master1954@163.com) 2018-06-15
 */
 
+#include <math.h>
 #include "../XTensor.h"
 #include "TMatrixMulBatched.h"
 
@@ -258,6 +259,100 @@ bool TestMatrixMulBatched2()
 #endif // USE_CUDA
 }
 
+/*
+case 3: strided batched matrix multiplication where b is shared by all the matrices of a.
+In this case, a=(2, 2, 3), b=(2, 3) is shared -> c=(2, 2, 2), transposedA=X_NOTRANS, transposedB=X_TRANS.
+*/
+bool TestMatrixMulBatched3()
+{
+    DTYPE aData[2][2][3] = { { {1.0F, 2.0F, 3.0F},
+                               {-4.0F, 5.0F, 6.0F} },
+                             { {0.0F, 1.0F, 0.0F},
+                               {1.0F, 0.0F, -1.0F} } };
+    DTYPE bData[2][3] = { {0.0F, 1.0F, 2.0F},
+                          {-1.0F, 2.0F, 1.0F} };
+    DTYPE answer[2][2][2] = { { {8.0F, 6.0F},
+                                {17.0F, 20.0F} },
+                              { {1.0F, 2.0F},
+                                {-2.0F, -2.0F} } };
+
+    /* the result is initialized with something that should be overwritten (beta = 0) */
+    DTYPE cData[2][2][2];
+    for (int i = 0; i < 8; i++)
+        ((DTYPE*)cData)[i] = 100.0F;
+
+    /* call _MatrixMulBatchedStridedCPU function */
+    _MatrixMulBatchedStridedCPU((DTYPE*)aData, X_NOTRANS, 2, 3, 6,
+                                (DTYPE*)bData, X_TRANS, 2, 3, 0,
+                                (DTYPE*)cData, 2, 2, 4, 2);
+
+    /* check results */
+    bool cpuTest = true;
+    for (int i = 0; i < 8; i++) {
+        if (fabs(((DTYPE*)cData)[i] - ((DTYPE*)answer)[i]) > 1e-4F)
+            cpuTest = false;
+    }
+
+    return cpuTest;
+}
+
+/*
+case 4: strided batched matrix multiplication of matrices that span several blocks.
+In this case, a=(3, 5, 37), b=(3, 300, 5) -> c=(3, 37, 300), transposedA=X_TRANS, transposedB=X_TRANS,
+alpha=0.5 and beta=2. The answer is computed element by element.
+*/
+bool TestMatrixMulBatched4()
+{
+    int count = 3;
+    int n = 37;
+    int m = 300;
+    int k = 5;
+
+    DTYPE * a = new DTYPE[count * k * n];
+    DTYPE * b = new DTYPE[count * m * k];
+    DTYPE * c = new DTYPE[count * n * m];
+    DTYPE * answer = new DTYPE[count * n * m];
+
+    for (int i = 0; i < count * k * n; i++)
+        a[i] = (DTYPE)(i % 7) - 3.0F;
+    for (int i = 0; i < count * m * k; i++)
+        b[i] = (DTYPE)(i % 5) * 0.5F - 1.0F;
+    for (int i = 0; i < count * n * m; i++)
+        c[i] = (DTYPE)(i % 3);
+
+    for (int id = 0; id < count; id++) {
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) {
+                DTYPE sum = 0;
+                for (int p = 0; p < k; p++)
+                    sum += a[id * k * n + p * n + i] * b[id * m * k + j * k + p];
+                int offset = id * n * m + i * m + j;
+                answer[offset] = sum * 0.5F + c[offset] * 2.0F;
+            }
+        }
+    }
+
+    /* call _MatrixMulBatchedStridedCPU function */
+    _MatrixMulBatchedStridedCPU(a, X_TRANS, k, n, k * n,
+                                b, X_TRANS, m, k, m * k,
+                                c, n, m, n * m, count, 0.5F, 2.0F);
+
+    /* check results */
+    bool cpuTest = true;
+    for (int i = 0; i < count * n * m; i++) {
+        if (fabs(c[i] - answer[i]) > 1e-3F)
+            cpuTest = false;
+    }
+
+    /* destroy variables */
+    delete[] a;
+    delete[] b;
+    delete[] c;
+    delete[] answer;
+
+    return cpuTest;
+}
+
 /* other cases */
 /*
     TODO!!
@@ -289,6 +384,26 @@ bool TestMatrixMulBatched()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestMatrixMulBatched3();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* case 4 test */
+    caseFlag = TestMatrixMulBatched4();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 4 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 4 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
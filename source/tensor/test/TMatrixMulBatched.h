@@ -23,6 +23,7 @@
 #define __TEST_MATRIXMULBATCHED_H__
 
 #include "../core/arithmetic/MatrixMulBatched.h"
+#include "../core/arithmetic/MatrixMulBatchedStrided.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
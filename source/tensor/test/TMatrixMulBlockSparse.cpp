@@ -0,0 +1,206 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "TMatrixMulBlockSparse.h"
+#include "../XTensor.h"
+#include "../core/CHeader.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* 
+case 1: magnitude pruning of 1 * 4 blocks and the block-sparse multiplication
+c = a * b
+In this case, (2, 4) * (4, 8) -> (2, 8). Half of the blocks of b are pruned.
+*/
+bool TestMatrixMulBlockSparse1()
+{
+    /* a tensor of size (2, 4) */
+    int aOrder = 2;
+    int aDimSize[2] = {2, 4};
+    int aUnitNum = 8;
+
+    /* a tensor of size (4, 8) */
+    int bOrder = 2;
+    int bDimSize[2] = {4, 8};
+    int bUnitNum = 32;
+
+    /* a tensor of size (2, 8) */
+    int cOrder = 2;
+    int cDimSize[2] = {2, 8};
+    int cUnitNum = 16;
+
+    DTYPE aData[2][4] = { {1.0F, 2.0F, 3.0F, 4.0F},
+                          {-1.0F, 0.0F, 1.0F, 2.0F} };
+    DTYPE bData[4][8] = { {1.0F, 1.0F, 1.0F, 1.0F, -5.0F, -5.0F, -5.0F, -5.0F},
+                          {3.0F, 3.0F, 3.0F, 3.0F, 0.5F, 0.5F, 0.5F, 0.5F},
+                          {-2.0F, -2.0F, -2.0F, -2.0F, 4.0F, 4.0F, 4.0F, 4.0F},
+                          {0.1F, 0.1F, 0.1F, 0.1F, 6.0F, 6.0F, 6.0F, 6.0F} };
+    DTYPE bAnswer[4][8] = { {0.0F, 0.0F, 0.0F, 0.0F, -5.0F, -5.0F, -5.0F, -5.0F},
+                            {3.0F, 3.0F, 3.0F, 3.0F, 0.0F, 0.0F, 0.0F, 0.0F},
+                            {0.0F, 0.0F, 0.0F, 0.0F, 4.0F, 4.0F, 4.0F, 4.0F},
+                            {0.0F, 0.0F, 0.0F, 0.0F, 6.0F, 6.0F, 6.0F, 6.0F} };
+    DTYPE answer[2][8] = { {6.0F, 6.0F, 6.0F, 6.0F, 31.0F, 31.0F, 31.0F, 31.0F},
+                           {0.0F, 0.0F, 0.0F, 0.0F, 21.0F, 21.0F, 21.0F, 21.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(aOrder, aDimSize);
+    XTensor * b = NewTensor(bOrder, bDimSize);
+    XTensor * c = NewTensor(cOrder, cDimSize);
+    XTensor cUser;
+
+    /* initialize variables */
+    a->SetData(aData, aUnitNum);
+    b->SetData(bData, bUnitNum);
+    c->SetZeroAll();
+
+    /* prune the blocks and index the rest */
+    _PruneBlocks(b, 1, 4, 0.5F);
+
+    XBlockSparse * index = b->blockSparse;
+    cpuTest = b->CheckData(bAnswer, bUnitNum) && index != NULL && index->blockNum == 4 &&
+              index->colOffsets[0] == 0 && index->colOffsets[1] == 1 && index->colOffsets[2] == 4 &&
+              index->blockRows[0] == 1 && index->blockRows[1] == 0 &&
+              index->blockRows[2] == 2 && index->blockRows[3] == 3 &&
+              index->GetSparsity() == 0.5F;
+
+    /* call the block-sparse kernel (through MatrixMul) */
+    _MatrixMul(a, X_NOTRANS, b, X_NOTRANS, c);
+    cUser = MatrixMul(*a, X_NOTRANS, *b, X_NOTRANS);
+
+    /* check results */
+    cpuTest = cpuTest && c->CheckData(answer, cUnitNum) && cUser.CheckData(answer, cUnitNum);
+
+    /* the index is removed with the data array */
+    b->SetBlockSparse(0, 0);
+    cpuTest = cpuTest && b->blockSparse == NULL;
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+
+    return cpuTest;
+}
+
+/* 
+case 2: 4 * 4 blocks, a higher-order input and c = a * b * alpha + c * beta
+In this case, (2, 6, 16) * (16, 32) -> (2, 6, 32) at a sparsity of 0.75. The
+result is compared with the dense multiplication of the pruned matrix.
+*/
+bool TestMatrixMulBlockSparse2()
+{
+    /* a tensor of size (2, 6, 16) */
+    int aOrder = 3;
+    int aDimSize[3] = {2, 6, 16};
+
+    /* a tensor of size (16, 32) */
+    int bOrder = 2;
+    int bDimSize[2] = {16, 32};
+
+    /* a tensor of size (2, 6, 32) */
+    int cOrder = 3;
+    int cDimSize[3] = {2, 6, 32};
+    int cUnitNum = 384;
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(aOrder, aDimSize);
+    XTensor * b = NewTensor(bOrder, bDimSize);
+    XTensor * bDense = NewTensor(bOrder, bDimSize);
+    XTensor * c = NewTensor(cOrder, cDimSize);
+    XTensor * cDense = NewTensor(cOrder, cDimSize);
+
+    /* initialize variables */
+    a->SetDataRand(-1.0F, 1.0F);
+    b->SetDataRand(-1.0F, 1.0F);
+    c->SetDataRand(-1.0F, 1.0F);
+    _CopyValues(c, cDense);
+
+    _PruneBlocks(b, 4, 4, 0.75F);
+    _CopyValues(b, bDense);
+
+    cpuTest = b->blockSparse != NULL && bDense->blockSparse == NULL && b->blockSparse->blockNum == 8;
+
+    /* call the block-sparse kernel and the dense kernel */
+    _MatrixMul(a, X_NOTRANS, b, X_NOTRANS, c, 2.0F, 1.0F);
+    _MatrixMul(a, X_NOTRANS, bDense, X_NOTRANS, cDense, 2.0F, 1.0F);
+
+    /* check results */
+    cpuTest = cpuTest && c->CheckData(cDense->data, cUnitNum, 1e-4F);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete bDense;
+    delete c;
+    delete cDense;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for block-sparse matrix multiplication and pruning */
+bool TestMatrixMulBlockSparse()
+{
+    XPRINT(0, stdout, "[TEST MatrixMulBlockSparse] dense * block-sparse matrix multiplication \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestMatrixMulBlockSparse1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestMatrixMulBlockSparse2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
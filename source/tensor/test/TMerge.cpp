@@ -473,6 +473,98 @@ bool TestMerge4()
 #endif // USE_CUDA
 }
 
+/* 
+case 5: transform a tensor by merging it along with a dimension, and
+accumulate the result into the target (i.e., t = merge(s) + t * beta).
+In this case, (2, 2, 3) -> (2, 6), whereToMerge=2, leadingDim=0, beta=2.
+*/
+bool TestMerge5()
+{
+    /* a source tensor of size (2, 2, 3) */
+    int sOrder = 3;
+    int * sDimSize = new int[sOrder];
+    sDimSize[0] = 2;
+    sDimSize[1] = 2;
+    sDimSize[2] = 3;
+
+    int sUnitNum = 1;
+    for (int i = 0; i < sOrder; i++)
+        sUnitNum *= sDimSize[i];
+
+    /* a target tensor of size (2, 6) */
+    int tOrder = 2;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 2;
+    tDimSize[1] = 6;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData[2][2][3] = { { {0.0F, 1.0F, 2.0F},
+                               {4.0F, 5.0F, 6.0F} },
+                             { {-1.0F, 2.0F, 3.0F},
+                               {-4.0F, -5.0F, -6.0F} } };
+    DTYPE tData[2][6] = { {1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F},
+                          {0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F} };
+    DTYPE answer[2][6] = { {2.0F, 3.0F, 4.0F, 1.0F, 4.0F, 5.0F},
+                           {4.0F, 7.0F, 10.0F, 2.0F, 3.0F, 4.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s = NewTensor(sOrder, sDimSize);
+    XTensor * t = NewTensor(tOrder, tDimSize);
+
+    /* initialize variables */
+    s->SetData(sData, sUnitNum);
+    t->SetData(tData, tUnitNum);
+
+    /* call Merge function */
+    _Merge(s, t, 2, 0, 2.0F);
+
+    /* check results */
+    cpuTest = t->CheckData(answer, tUnitNum);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensor */
+    XTensor * sGPU = NewTensor(sOrder, sDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * tGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+
+    /* Initialize variables */
+    sGPU->SetData(sData, sUnitNum);
+    tGPU->SetData(tData, tUnitNum);
+
+    /* call Merge function */
+    _Merge(sGPU, tGPU, 2, 0, 2.0F);
+
+    /* check results */
+    gpuTest = tGPU->CheckData(answer, tUnitNum);
+
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete sGPU;
+    delete tGPU;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
     TODO!!
@@ -521,6 +613,16 @@ bool TestMerge()
     else
         XPRINT(0, stdout, ">> case 4 passed!\n");
 
+    /* case 5 test */
+    caseFlag = TestMerge5();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 5 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 5 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
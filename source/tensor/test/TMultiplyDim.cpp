@@ -21,6 +21,7 @@
 
 #include "TMultiplyDim.h"
 #include "../core/arithmetic/MultiplyDim.h"
+#include "../core/getandset/ConvertDataType.h"
 #include "../XTensor.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
@@ -248,6 +249,89 @@ bool TestMultiplyDim2()
 #endif // USE_CUDA
 }
 
+/*
+case 3: tensor multiplication c = a * b + \alpha * c in float16
+where the size of b is equal to the n-th dimension of a,
+i.e., a is multiplied with b by broadcasting
+In this case, (2, 4) * (2) = (2, 4), n = 0 and (2, 4) * (4) = (2, 4), n = 1.
+*/
+bool TestMultiplyDim3()
+{
+    /* a tensor of size (2, 4) */
+    int aOrder = 2;
+    int * aDimSize = new int[aOrder];
+    aDimSize[0] = 2;
+    aDimSize[1] = 4;
+
+    int aUnitNum = 1;
+    for (int i = 0; i < aOrder; i++)
+        aUnitNum *= aDimSize[i];
+
+    /* a tensor of size (2) */
+    int bOrder = 1;
+    int * bDimSize = new int[bOrder];
+    bDimSize[0] = 2;
+
+    /* a tensor of size (4) */
+    int dOrder = 1;
+    int * dDimSize = new int[dOrder];
+    dDimSize[0] = 4;
+
+    DTYPE aData[2][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 6.0F, 7.0F} };
+    DTYPE bData[2] = {1.0F, -1.0F};
+    DTYPE dData[4] = {-1.0F, 1.0F, 0.5F, 2.0F};
+    DTYPE answer1[2][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                            {-4.0F, -5.0F, -6.0F, -7.0F} };
+    DTYPE answer2[2][4] = { {-0.0F, 1.0F, 1.0F, 6.0F},
+                            {-4.0F, 5.0F, 3.0F, 14.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(aOrder, aDimSize);
+    XTensor * b = NewTensor(bOrder, bDimSize);
+    XTensor * d = NewTensor(dOrder, dDimSize);
+    XTensor * c = NewTensor(aOrder, aDimSize);
+    XTensor * aHalf = NewTensor(aOrder, aDimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * bHalf = NewTensor(bOrder, bDimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * dHalf = NewTensor(dOrder, dDimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * cHalf = NewTensor(aOrder, aDimSize, X_FLOAT16, 1.0F, -1);
+
+    /* initialize variables */
+    a->SetData(aData, aUnitNum);
+    b->SetData(bData, 2);
+    d->SetData(dData, 4);
+    _ConvertDataType(a, aHalf);
+    _ConvertDataType(b, bHalf);
+    _ConvertDataType(d, dHalf);
+
+    /* call MultiplyDim function */
+    _MultiplyDim(aHalf, bHalf, cHalf, 0);
+    _ConvertDataType(cHalf, c);
+    cpuTest = c->CheckData(answer1, aUnitNum);
+
+    _MultiplyDim(aHalf, dHalf, cHalf, 1);
+    _ConvertDataType(cHalf, c);
+    cpuTest = cpuTest && c->CheckData(answer2, aUnitNum);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete d;
+    delete c;
+    delete aHalf;
+    delete bHalf;
+    delete dHalf;
+    delete cHalf;
+    delete[] aDimSize;
+    delete[] bDimSize;
+    delete[] dDimSize;
+
+    return cpuTest;
+}
+
 /* test for MultiplyDim Function */
 bool TestMultiplyDim()
 {
@@ -272,6 +356,15 @@ bool TestMultiplyDim()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestMultiplyDim3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
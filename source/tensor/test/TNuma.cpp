@@ -0,0 +1,345 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../XTensor.h"
+#include "../XUtility.h"
+#include "../XPRunner.h"
+#include "../core/arithmetic/MatrixMul2D.h"
+#include "../core/utilities/XMatrixSegment.h"
+#include "TNuma.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* case 1: parse cpu lists */
+bool TestNumaCase1()
+{
+    int cpus[16];
+    int answer[7] = {0, 1, 2, 3, 8, 10, 11};
+
+    int num = XNumaManager::ParseCPUList("0-3,8,10-11\n", cpus, 16);
+    bool ok = num == 7;
+    for (int i = 0; i < num && ok; i++)
+        ok = cpus[i] == answer[i];
+
+    /* the list is cut at the end of the buffer */
+    num = XNumaManager::ParseCPUList("0-31", cpus, 16);
+    ok = ok && num == 16 && cpus[15] == 15;
+
+    num = XNumaManager::ParseCPUList("", cpus, 16);
+    ok = ok && num == 0;
+
+    return ok;
+}
+
+/* case 2: topology and memory pools of the nodes */
+bool TestNumaCase2()
+{
+    GNuma.Init();
+
+    bool ok = GNuma.nodeNum > 0 && GNuma.cpuNum > 0;
+
+    for (int i = 0; i < GNuma.cpuNum && ok; i++)
+        ok = GNuma.cpuNodes[i] >= 0 && GNuma.cpuNodes[i] < GNuma.nodeNum;
+
+    /* threads are placed node by node */
+    for (int i = 1; i < GNuma.cpuNum && ok; i++)
+        ok = GNuma.GetThreadNode(i) >= GNuma.GetThreadNode(i - 1);
+
+    for (int node = 0; node < GNuma.nodeNum && ok; node++) {
+        XMem * mem = GNuma.GetMem(node);
+        ok = mem != NULL && mem->numaNode == node && GNuma.GetMem(node) == mem;
+
+        int * p = (int*)mem->AllocStandard(-1, sizeof(int) * 1000);
+        for (int i = 0; i < 1000; i++)
+            p[i] = i;
+        for (int i = 0; i < 1000 && ok; i++)
+            ok = p[i] == i;
+        mem->ReleaseStandard(-1, p, sizeof(int) * 1000);
+    }
+
+    return ok;
+}
+
+/* record the thread of a job */
+void _NumaRecordThread(XList * args)
+{
+#ifdef USE_PTHREAD
+    THREAD_HANDLE * hnd = (THREAD_HANDLE*)args->GetItem(0);
+    *hnd = pthread_self();
+#endif
+}
+
+/* case 3: a pinned runner places job i on thread i, and the blocks of
+   a spread pool are zeroed by the threads */
+bool TestNumaCase3()
+{
+    bool ok = true;
+    int threadNum = 4;
+
+    XPRunner runner;
+    runner.Init(threadNum);
+    runner.PinThreads();
+
+#ifdef USE_PTHREAD
+    THREAD_HANDLE hnds[4];
+
+    for (int round = 0; round < 5 && ok; round++) {
+        XList jobs(threadNum);
+        XList args(threadNum);
+        XList jobArgs[4];
+
+        for (int i = 0; i < threadNum; i++) {
+            jobArgs[i].Add(hnds + i);
+            jobs.Add((void*)_NumaRecordThread);
+            args.Add(jobArgs + i);
+        }
+
+        runner.Run(&jobs, &args);
+
+        for (int i = 0; i < threadNum && ok; i++)
+            ok = pthread_equal(hnds[i], runner.threads[i].hnd) != 0;
+    }
+#endif
+
+    XPRunner * backup = globalPRunner;
+    globalPRunner = &runner;
+
+    XMem mem;
+    mem.SetNumaNode(NUMA_NODE_SPREAD);
+    mem.Initialize(-1, FREE_ON_THE_FLY, 1 << 20, 4, 0);
+
+    char * p = (char*)mem.AllocStandard(-1, 1 << 19);
+    for (int i = 0; i < (1 << 19) && ok; i++)
+        ok = p[i] == 0;
+    mem.ReleaseStandard(-1, p, 1 << 19);
+
+    globalPRunner = backup;
+
+    return ok;
+}
+
+/* case 4: the global runner of the samples (e.g., "-nthread 2 -numa")
+   is pinned and the blocks of a spread pool are zeroed by its threads.
+   Nothing is created for a single thread or if there is a runner. */
+bool TestNumaCase4()
+{
+    XPRunner * backup = globalPRunner;
+    globalPRunner = NULL;
+
+    bool ok = !InitGlobalPRunner(1, true) && globalPRunner == NULL;
+
+    ok = ok && InitGlobalPRunner(2, true);
+    ok = ok && globalPRunner != NULL && globalPRunner->threadNum == 2 && globalPRunner->isPinned;
+    ok = ok && !InitGlobalPRunner(4, true) && globalPRunner->threadNum == 2;
+
+    if (ok) {
+        XMem mem;
+        mem.SetNumaNode(NUMA_NODE_SPREAD);
+        mem.Initialize(-1, FREE_ON_THE_FLY, 1 << 20, 4, 0);
+
+        char * p = (char*)mem.AllocStandard(-1, 1 << 19);
+        for (int i = 0; i < (1 << 19) && ok; i++)
+            ok = p[i] == 0;
+        mem.ReleaseStandard(-1, p, 1 << 19);
+    }
+
+    FreeGlobalPRunner();
+    ok = ok && globalPRunner == NULL;
+
+    globalPRunner = backup;
+
+    return ok;
+}
+
+/* test for NUMA placement */
+bool TestNuma()
+{
+    XPRINT(0, stdout, "[Test] NUMA placement ... Began\n");
+    bool returnFlag = true;
+    bool caseFlag = true;
+
+    double startT = GetClock();
+
+    /* case 1 test */
+    caseFlag = TestNumaCase1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestNumaCase2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestNumaCase3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* case 4 test */
+    caseFlag = TestNumaCase4();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 4 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 4 passed!\n");
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    double endT = GetClock();
+
+    XPRINT1(0, stdout, "[Test] Finished (took %.3lfms)\n\n", endT - startT);
+
+    return returnFlag;
+}
+
+/* a = b + c * s for a segment (in a thread) */
+void _NumaTriad(XList * args)
+{
+    int beg = *(int*)args->GetItem(0);
+    int end = *(int*)args->GetItem(1);
+    float * a = (float*)args->GetItem(2);
+    float * b = (float*)args->GetItem(3);
+    float * c = (float*)args->GetItem(4);
+
+    for (int i = beg; i < end; i++)
+        a[i] = b[i] + c[i] * 3.0F;
+}
+
+/*
+run the benchmark with a given runner and placement
+>> runner - the runner
+>> isSpread - indicates whether the memory is placed over the threads of the runner
+>> itemNum - size of the vectors of the triad
+>> matrixSize - size of the matrices
+>> bandwidth - memory bandwidth (GB/s)
+>> gflops - speed of the matrix multiplication
+*/
+void _BenchmarkNumaRun(XPRunner * runner, bool isSpread, int itemNum, int matrixSize,
+                       double &bandwidth, double &gflops)
+{
+    int round = 10;
+    MTYPE size = sizeof(float) * itemNum;
+
+    float * a = (float*)malloc(size);
+    float * b = (float*)malloc(size);
+    float * c = (float*)malloc(size);
+
+    if (isSpread) {
+        GNuma.TouchSpread(a, size, runner);
+        GNuma.TouchSpread(b, size, runner);
+        GNuma.TouchSpread(c, size, runner);
+    }
+    else {
+        memset(a, 0, size);
+        memset(b, 0, size);
+        memset(c, 0, size);
+    }
+
+    double startT = GetClock();
+    for (int r = 0; r < round; r++)
+        RunParallel1D(runner, (void*)_NumaTriad, itemNum, itemNum, 3, a, b, c);
+    double elapsed = (GetClock() - startT) / 1000;
+    bandwidth = (double)round * size * 3 / elapsed / 1e9;
+
+    free(a);
+    free(b);
+    free(c);
+
+    /* matrix multiplication with the blocks of a pool */
+    XMem mem;
+    mem.SetNumaNode(isSpread ? NUMA_NODE_SPREAD : NUMA_NODE_NONE);
+    mem.Initialize(-1, FREE_ON_THE_FLY, sizeof(DTYPE) * matrixSize * matrixSize * 4, 4, 0);
+
+    XPRunner * backup = globalPRunner;
+    globalPRunner = runner;
+
+    XTensor * x = NewTensor2D(matrixSize, matrixSize, X_FLOAT, -1, &mem);
+    XTensor * y = NewTensor2D(matrixSize, matrixSize, X_FLOAT, -1, &mem);
+    XTensor * z = NewTensor2D(matrixSize, matrixSize, X_FLOAT, -1, &mem);
+    x->SetDataRand(-1.0F, 1.0F);
+    y->SetDataRand(-1.0F, 1.0F);
+
+    round = 3;
+    startT = GetClock();
+    for (int r = 0; r < round; r++)
+        _MatrixMul2D(x, X_NOTRANS, y, X_NOTRANS, z, 1.0F, 0, runner);
+    elapsed = (GetClock() - startT) / 1000;
+    gflops = 2.0 * round * matrixSize * matrixSize * matrixSize / elapsed / 1e9;
+
+    delete x;
+    delete y;
+    delete z;
+
+    globalPRunner = backup;
+}
+
+/*
+benchmark of memory bandwidth (a triad over three vectors) and matrix
+multiplication without NUMA placement (free threads and memory that
+is touched by the main thread) and with it (pinned threads and memory
+that is touched by the threads that use it)
+>> threadNum - number of threads
+*/
+void BenchmarkNuma(int threadNum)
+{
+    int itemNum = 1 << 24;
+    int matrixSize = 512;
+
+    threadNum = MIN(MAX(threadNum, 1), MAX_THREAD_NUM);
+
+    GNuma.Show(stdout);
+
+    double bandwidth = 0;
+    double gflops = 0;
+
+    XPRINT1(0, stdout, "[BENCHMARK NUMA] %d threads\n", threadNum);
+    XPRINT(0, stdout, "    placement   triad(GB/s)   matmul(GFLOPS)\n");
+
+    {
+        XPRunner runner;
+        runner.Init(threadNum);
+        _BenchmarkNumaRun(&runner, false, itemNum, matrixSize, bandwidth, gflops);
+        XPRINT2(0, stdout, "         none %13.2f %16.2f\n", bandwidth, gflops);
+    }
+
+    {
+        XPRunner runner;
+        runner.Init(threadNum);
+        runner.PinThreads();
+        _BenchmarkNumaRun(&runner, true, itemNum, matrixSize, bandwidth, gflops);
+        XPRINT2(0, stdout, "pinned+spread %13.2f %16.2f\n", bandwidth, gflops);
+    }
+}
+
+} // namespace nts(NiuTrans.Tensor)
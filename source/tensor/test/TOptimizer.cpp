@@ -0,0 +1,137 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TOptimizer.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: the gradient of an embedding matrix (with row-sparse gradients) is 
+thrown away by ClearGrad. The next update should then leave the matrix 
+unchanged, though the moments of adam are non-zero for the rows used before.
+*/
+bool TestOptimizer1()
+{
+    /* an embedding matrix of size (4, 3) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 4;
+    dimSize[1] = 3;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE embData[4][3] = { {0.0F, 1.0F, 2.0F},
+                            {3.0F, 4.0F, 5.0F},
+                            {6.0F, 7.0F, 8.0F},
+                            {9.0F, 10.0F, 11.0F} };
+    DTYPE gradData[4][3] = { {0.0F, 0.0F, 0.0F},
+                             {1.0F, -1.0F, 2.0F},
+                             {0.0F, 0.0F, 0.0F},
+                             {-2.0F, 1.0F, 1.0F} };
+    DTYPE zeroData[4][3] = { {0.0F, 0.0F, 0.0F},
+                             {0.0F, 0.0F, 0.0F},
+                             {0.0F, 0.0F, 0.0F},
+                             {0.0F, 0.0F, 0.0F} };
+    int index[2] = {1, 3};
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * emb = NewTensor(order, dimSize);
+    emb->SetData(embData, unitNum);
+    emb->SetVarFlag();
+    emb->SetSparseGradFlag();
+
+    XList params(1);
+    params.Add(emb);
+
+    XOptimizer optimizer;
+    optimizer.SetAdam();
+    optimizer.Init(params);
+
+    /* one step with the gradient of rows 1 and 3 */
+    emb->grad->SetData(gradData, unitNum);
+    emb->gradRows->Add(index, 2);
+    optimizer.Update(0.1F);
+
+    cpuTest = emb->gradRows->count == 0 && emb->grad->CheckData(zeroData, unitNum, 1e-4F);
+
+    /* the gradient of the next step is thrown away */
+    DTYPE * updated = new DTYPE[unitNum];
+    memcpy(updated, emb->data, sizeof(DTYPE) * unitNum);
+
+    emb->grad->SetData(gradData, unitNum);
+    emb->gradRows->Add(index, 2);
+    optimizer.ClearGrad();
+
+    cpuTest = cpuTest && emb->gradRows->count == 0 && 
+              emb->grad->CheckData(zeroData, unitNum, 1e-4F);
+
+    /* no gradient, no update */
+    optimizer.Update(0.1F);
+
+    /* check results */
+    cpuTest = cpuTest && emb->CheckData(updated, unitNum, 1e-6F);
+
+    /* destroy variables */
+    delete emb;
+    delete[] updated;
+    delete[] dimSize;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for XOptimizer */
+bool TestOptimizer()
+{
+    XPRINT(0, stdout, "[TEST Optimizer] update of the parameters \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestOptimizer1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
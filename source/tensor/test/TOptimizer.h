@@ -0,0 +1,30 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TOPTIMIZER_H__
+#define __TOPTIMIZER_H__
+
+#include "../../network/XOptimizer.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* test for XOptimizer */
+extern "C"
+bool TestOptimizer();
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __TOPTIMIZER_H__
@@ -0,0 +1,237 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../XUtility.h"
+#include "../XPRunner.h"
+#include "TQueue.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* case 1: order, capacity and batches of a ring queue in a single thread */
+bool TestQueueCase1()
+{
+    XRingQueue queue(6);
+    bool ok = queue.GetSize() == 8 && queue.IsEmpty();
+
+    long long items[16];
+    void * got[16];
+
+    for (int i = 0; i < 8; i++)
+        ok = ok && queue.TryEnqueue(items + i);
+
+    /* the queue is full */
+    ok = ok && !queue.TryEnqueue(items + 8) && queue.GetItemNum() == 8;
+
+    for (int i = 0; i < 3 && ok; i++)
+        ok = queue.TryDequeue(got) && got[0] == items + i;
+
+    /* a batch is cut at the free cells */
+    void * batch[5] = {items + 8, items + 9, items + 10, items + 11, items + 12};
+    ok = ok && queue.TryEnqueueBatch(batch, 5) == 3;
+
+    ok = ok && queue.TryDequeueBatch(got, 16) == 8;
+    for (int i = 0; i < 8 && ok; i++)
+        ok = got[i] == items + 3 + i;
+
+    ok = ok && queue.IsEmpty() && !queue.TryDequeue(got);
+    ok = ok && queue.TryDequeueBatch(got, 4) == 0;
+
+    return ok;
+}
+
+/* produce the numbers in [beg, end) (in a thread) */
+void _QueueProduce(XList * args)
+{
+    XRingQueue * queue = (XRingQueue*)args->GetItem(0);
+    int beg = *(int*)args->GetItem(1);
+    int end = *(int*)args->GetItem(2);
+    int batchSize = *(int*)args->GetItem(3);
+
+    void * batch[16];
+
+    for (int i = beg; i < end;) {
+        int num = MIN(batchSize, end - i);
+        for (int j = 0; j < num; j++)
+            batch[j] = (void*)(long long)(i + j + 1);
+        queue->EnqueueBatch(batch, num);
+        i += num;
+    }
+}
+
+/* consume a number of items and sum them up (in a thread) */
+void _QueueConsume(XList * args)
+{
+    XRingQueue * queue = (XRingQueue*)args->GetItem(0);
+    int itemNum = *(int*)args->GetItem(1);
+    long long * sum = (long long*)args->GetItem(2);
+    int batchSize = *(int*)args->GetItem(3);
+
+    void * batch[16];
+
+    for (int i = 0; i < itemNum;) {
+        int num = 1;
+        if (batchSize > 1)
+            num = queue->DequeueBatch(batch, MIN(batchSize, itemNum - i));
+        else
+            batch[0] = queue->Dequeue();
+        for (int j = 0; j < num; j++)
+            *sum += (long long)batch[j];
+        i += num;
+    }
+}
+
+/* case 2: two producers and two consumers on a small queue, so that
+   the threads are parked and woken up many times */
+bool TestQueueCase2()
+{
+    int threadNum = 4;
+    int itemNum = 20000;
+    int half = itemNum / 2;
+    int batchSizes[2] = {1, 7};
+
+    XPRunner runner;
+    runner.Init(threadNum);
+
+    XRingQueue queue(16);
+
+    int zero = 0;
+    long long sums[2] = {0, 0};
+
+    XList jobs(threadNum);
+    XList args(threadNum);
+    XList jobArgs[4];
+
+    jobArgs[0].Add(&queue);
+    jobArgs[0].Add(&zero);
+    jobArgs[0].Add(&half);
+    jobArgs[0].Add(batchSizes);
+
+    jobArgs[1].Add(&queue);
+    jobArgs[1].Add(&half);
+    jobArgs[1].Add(&itemNum);
+    jobArgs[1].Add(batchSizes + 1);
+
+    for (int i = 0; i < 2; i++) {
+        jobArgs[2 + i].Add(&queue);
+        jobArgs[2 + i].Add(&half);
+        jobArgs[2 + i].Add(sums + i);
+        jobArgs[2 + i].Add(batchSizes + i);
+    }
+
+    jobs.Add((void*)_QueueProduce);
+    jobs.Add((void*)_QueueProduce);
+    jobs.Add((void*)_QueueConsume);
+    jobs.Add((void*)_QueueConsume);
+
+    for (int i = 0; i < threadNum; i++)
+        args.Add(jobArgs + i);
+
+    runner.Run(&jobs, &args);
+
+    long long answer = (long long)itemNum * (itemNum + 1) / 2;
+
+    return sums[0] + sums[1] == answer && queue.IsEmpty();
+}
+
+/* add a number to a counter (as a job) */
+void _QueueAddJob(XList * args)
+{
+    long long * counter = (long long*)args->GetItem(0);
+    int * n = (int*)args->GetItem(1);
+    ATOMIC_ADD(*counter, *n);
+}
+
+/* case 3: a job queue with a pool of consumers */
+bool TestQueueCase3()
+{
+    int jobNum = 1000;
+    long long counter = 0;
+    int * values = new int[jobNum];
+
+    XQueue queue(64);
+    queue.RunJobConsumer(-1, 3);
+
+    XList jobArgs(2);
+    for (int i = 0; i < jobNum; i++) {
+        values[i] = i;
+        jobArgs.Clear();
+        jobArgs.Add(&counter);
+        jobArgs.Add(values + i);
+        queue.EnqueueJob((void*)_QueueAddJob, &jobArgs);
+    }
+
+    queue.WaitForEmptyJobQueue();
+    bool ok = ATOMIC_LOAD(counter) == (long long)jobNum * (jobNum - 1) / 2;
+
+    queue.StopJobConsumer();
+    ok = ok && queue.IsEmpty();
+
+    delete[] values;
+
+    return ok;
+}
+
+/* test for XQueue */
+bool TestQueue()
+{
+    XPRINT(0, stdout, "[Test] XQueue ... Began\n");
+    bool returnFlag = true;
+    bool caseFlag = true;
+
+    double startT = GetClock();
+
+    /* case 1 test */
+    caseFlag = TestQueueCase1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestQueueCase2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestQueueCase3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    double endT = GetClock();
+
+    XPRINT1(0, stdout, "[Test] Finished (took %.3lfms)\n\n", endT - startT);
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
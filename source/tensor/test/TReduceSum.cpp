@@ -607,6 +607,93 @@ bool TestReduceSum6()
 }
 
 
+/* 
+case 7: test ReduceSum function.
+Sum the items along a dimension of the tensor and accumulate
+the result into the output (i.e., output = sum + output * beta).
+In this case, (2, 4) -> (4), dim = 0, beta = 1
+*/
+bool TestReduceSum7()
+{
+    /* a tensor of size (2, 4) */
+    int sOrder = 2;
+    int * sDimSize = new int[sOrder];
+    sDimSize[0] = 2;
+    sDimSize[1] = 4;
+
+    int sUnitNum = 1;
+    for (int i = 0; i < sOrder; i++)
+        sUnitNum *= sDimSize[i];
+
+    /* a tensor of size (4) */
+    int tOrder = 1;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 4;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData[2][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 6.0F, 7.0F} };
+    DTYPE tData[4] = {1.0F, -1.0F, 0.5F, 0.0F};
+    DTYPE answer[4] = {5.0F, 5.0F, 8.5F, 10.0F};
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s = NewTensor(sOrder, sDimSize);
+    XTensor * t = NewTensor(tOrder, tDimSize);
+
+    /* initialize variables */
+    s->SetData(sData, sUnitNum);
+    t->SetData(tData, tUnitNum);
+
+    /* call ReduceSum function */
+    _ReduceSum(s, t, 0, NULL, 1.0F, false, 1.0F);
+
+    /* check results */
+    cpuTest = t->CheckData(answer, tUnitNum);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensors */
+    XTensor * sGPU = NewTensor(sOrder, sDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * tGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+
+    /* initialize variables */
+    sGPU->SetData(sData, sUnitNum);
+    tGPU->SetData(tData, tUnitNum);
+
+    /* call ReduceSum function */
+    _ReduceSum(sGPU, tGPU, 0, NULL, 1.0F, false, 1.0F);
+
+    /* check results */
+    gpuTest = tGPU->CheckData(answer, tUnitNum);
+
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete sGPU;
+    delete tGPU;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
 TODO!!
@@ -672,6 +759,16 @@ bool TestReduceSum()
     else
         XPRINT(0, stdout, ">> case 6 passed!\n");
 
+    /* case 7 test */
+    caseFlag = TestReduceSum7();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 7 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 7 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
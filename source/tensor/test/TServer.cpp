@@ -0,0 +1,245 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TServer.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace transformer;
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+#ifndef WIN32
+
+/* a thread that runs the server */
+void * TestServerThread(void * arg)
+{
+    T2TServer * server = (T2TServer*)arg;
+    server->Run(server->model);
+    return NULL;
+}
+
+/* check whether a response is a list of scores */
+bool TestServerIsScored(const char * result)
+{
+    return result != NULL && strncmp(result, "ERROR", 5) && strstr(result, "|||") != NULL;
+}
+
+/* 
+send the lines through a new connection and collect the responses, i.e., 
+results[i] is the response of the line i (NULL if there is none)
+*/
+void TestServerSend(sockaddr_un * addr, char ** lines, int lineNum, char ** results)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    CheckNTErrors(connect(fd, (sockaddr*)addr, sizeof(*addr)) == 0, "Cannot connect to the server!");
+
+    for(int i = 0; i < lineNum; i++){
+        results[i] = NULL;
+        send(fd, lines[i], strlen(lines[i]), MSG_NOSIGNAL);
+    }
+    shutdown(fd, SHUT_WR);
+
+    int bufSize = 1024 * 64;
+    int bufNum = 0;
+    char * buf = new char[bufSize];
+    int n = 0;
+    while(bufNum < bufSize - 1 && (n = (int)recv(fd, buf + bufNum, bufSize - 1 - bufNum, 0)) > 0)
+        bufNum += n;
+    buf[bufNum] = 0;
+    close(fd);
+
+    /* each response is "id ||| ..." */
+    for(char * line = strtok(buf, "\n"); line != NULL; line = strtok(NULL, "\n")){
+        int id = atoi(line);
+        char * result = strstr(line, "||| ");
+        if(id < 0 || id >= lineNum || result == NULL)
+            continue;
+        results[id] = new char[strlen(result + 4) + 1];
+        strcpy(results[id], result + 4);
+    }
+
+    delete[] buf;
+}
+
+/* 
+case 1: the server runs on a small language model (with random parameters)
+and the client sends good requests, requests with out-of-vocabulary words,
+too long requests and ids that wrap around in int. The bad requests must be 
+answered with errors and the server must keep answering the others (on the 
+same connection and on a new one). "#shutdown" is an ill-formed request unless 
+the server allows it. At last the server stops with a connection open, which 
+must be closed before the server returns.
+*/
+bool TestServer1()
+{
+    char socketFN[64];
+    sprintf(socketFN, "/tmp/nts.test.server.%d.sock", (int)getpid());
+
+    const char * args[] = {"-lm", "-vsize", "300", "-vsizetgt", "300", "-nlayer", "2", 
+                           "-d", "64", "-hsize", "128", "-nhead", "4", "-maxlen", "32",
+                           "-socket", socketFN, "-statfreq", "0"};
+    int argNum = sizeof(args) / sizeof(char*);
+
+    T2TModel * model = new T2TModel();
+    model->InitModel(argNum, (char**)args);
+
+    T2TServer server;
+    server.Init(argNum, (char**)args);
+    server.model = model;
+
+    pthread_t hnd;
+    pthread_create(&hnd, NULL, TestServerThread, &server);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketFN, sizeof(addr.sun_path) - 1);
+
+    /* wait until the server is listening */
+    bool isReady = false;
+    for(int i = 0; i < 1000 && !isReady; i++){
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        isReady = connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+        close(fd);
+        if(!isReady)
+            usleep(10000);
+    }
+    CheckNTErrors(isReady, "Cannot connect to the server!");
+
+    int maxLen = model->encoder->embedder.maxLength;
+
+    /* a good request, a request with an out-of-vocabulary word, a too long
+       request, a request with an id out of the range of int (which is -1
+       if it wraps around), a "#shutdown" that is not allowed and a good 
+       request again */
+    int lineNum = 6;
+    char ** lines = new char*[lineNum];
+    char ** results = new char*[lineNum];
+    for(int i = 0; i < lineNum; i++)
+        lines[i] = new char[2 * (maxLen + 2) + 32];
+    sprintf(lines[0], "1 2 3\n");
+    sprintf(lines[1], "1 300 3\n");
+    int len = 0;
+    for(int i = 0; i <= maxLen; i++)
+        len += sprintf(lines[2] + len, "1 ");
+    sprintf(lines[2] + len, "\n");
+    sprintf(lines[3], "1 4294967295 3\n");
+    sprintf(lines[4], "#shutdown\n");
+    sprintf(lines[5], "4 5 6\n");
+
+    TestServerSend(&addr, lines, lineNum, results);
+
+    bool cpuTest = TestServerIsScored(results[0]) && TestServerIsScored(results[5]);
+    for(int i = 1; i < 5; i++)
+        cpuTest = cpuTest && results[i] != NULL && !TestServerIsScored(results[i]);
+
+    /* the server still answers a new connection */
+    for(int i = 0; i < lineNum; i++)
+        delete[] results[i];
+    TestServerSend(&addr, lines + 5, 1, results);
+
+    cpuTest = cpuTest && TestServerIsScored(results[0]);
+    delete[] results[0];
+
+    /* a connection that is still open when the server stops (its reader waits for more requests) */
+    int idle = socket(AF_UNIX, SOCK_STREAM, 0);
+    CheckNTErrors(connect(idle, (sockaddr*)&addr, sizeof(addr)) == 0, "Cannot connect to the server!");
+    send(idle, lines[5], strlen(lines[5]), MSG_NOSIGNAL);
+    char buf[1024];
+    int bufNum = 0;
+    while(bufNum < (int)sizeof(buf) - 1 && (bufNum == 0 || buf[bufNum - 1] != '\n')){
+        int n = (int)recv(idle, buf + bufNum, sizeof(buf) - 1 - bufNum, 0);
+        if(n <= 0)
+            break;
+        bufNum += n;
+    }
+    buf[bufNum] = 0;
+    cpuTest = cpuTest && TestServerIsScored(buf);
+
+    /* stop the server. The reader of the new connection starts after this,
+       so it sees the flag */
+    server.allowShutdown = true;
+    TestServerSend(&addr, lines + 4, 1, results);
+    delete[] results[0];
+    pthread_join(hnd, NULL);
+
+    /* the server has closed the idle connection before it stopped */
+    cpuTest = cpuTest && recv(idle, buf, sizeof(buf), 0) == 0;
+    close(idle);
+
+    /* destroy variables */
+    for(int i = 0; i < lineNum; i++)
+        delete[] lines[i];
+    delete[] lines;
+    delete[] results;
+    delete model;
+
+    return cpuTest;
+}
+
+#else
+
+/* the server is not supported on Windows */
+bool TestServer1()
+{
+    return true;
+}
+
+#endif
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for the scoring server */
+bool TestServer()
+{
+    XPRINT(0, stdout, "[TEST Server] scoring server of the transformer \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestServer1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
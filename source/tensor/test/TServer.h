@@ -0,0 +1,30 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2018, Natural Language Processing Lab, Northestern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TSERVER_H__
+#define __TSERVER_H__
+
+#include "../../sample/transformer/T2TServer.h"
+
+namespace nts{ // namespace nts(NiuTrans.Tensor)
+
+/* test for the scoring server of the transformer sample */
+extern "C"
+bool TestServer();
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __TSERVER_H__
@@ -207,6 +207,100 @@ bool TestSoftmax2()
 #endif // USE_CUDA
 }
 
+/* 
+case 3: test SoftmaxBackward function.
+SoftmaxBackward function: dE/dx_j = y_j * (dE/dy_j - \sum_i (dE/dy_i * y_i))
+In this case, LossName=NOLOSS, and dE/dx is accumulated into 
+the gradient (beta = 1).
+*/
+bool TestSoftmax3()
+{
+    /* a input tensor of size (1, 3) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 1;
+    dimSize[1] = 3;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE xData[1][3] = { {0.0F, 1.0F, 2.0F} };
+    DTYPE dedyData[1][3] = { {1.0F, 0.0F, 0.0F} };
+    DTYPE dedxData[1][3] = { {1.0F, 1.0F, 1.0F} };
+    DTYPE dedxAnswer[1][3] = { {1.0819F, 0.9780F, 0.9401F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensor(order, dimSize);
+    XTensor * y = NewTensor(order, dimSize);
+    XTensor * dedy = NewTensor(order, dimSize);
+    XTensor * dedx = NewTensor(order, dimSize);
+
+    /* initialize variables */
+    x->SetData(xData, unitNum);
+    dedy->SetData(dedyData, unitNum);
+    dedx->SetData(dedxData, unitNum);
+
+    /* call Softmax function */
+    _Softmax(x, y, 1);
+
+    /* call SoftmaxBackward function */
+    _SoftmaxBackward(NULL, y, x, dedy, dedx, NULL, 1, NOLOSS, 1.0F);
+
+    /* check result */
+    cpuTest = dedx->CheckData(dedxAnswer, unitNum, 1e-4F);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensors */
+    XTensor * xGPU = NewTensor(order, dimSize, X_FLOAT, 1.0F, 0);
+    XTensor * yGPU = NewTensor(order, dimSize, X_FLOAT, 1.0F, 0);
+    XTensor * dedyGPU = NewTensor(order, dimSize, X_FLOAT, 1.0F, 0);
+    XTensor * dedxGPU = NewTensor(order, dimSize, X_FLOAT, 1.0F, 0);
+
+    /* initialize variables */
+    xGPU->SetData(xData, unitNum);
+    dedyGPU->SetData(dedyData, unitNum);
+    dedxGPU->SetData(dedxData, unitNum);
+
+    /* call Softmax function */
+    _Softmax(xGPU, yGPU, 1);
+
+    /* call SoftmaxBackward function */
+    _SoftmaxBackward(NULL, yGPU, xGPU, dedyGPU, dedxGPU, NULL, 1, NOLOSS, 1.0F);
+
+    /* check result */
+    gpuTest = dedxGPU->CheckData(dedxAnswer, unitNum, 1e-4F);
+
+    /* destroy variables */
+    delete x;
+    delete y;
+    delete dedy;
+    delete dedx;
+    delete xGPU;
+    delete yGPU;
+    delete dedyGPU;
+    delete dedxGPU;
+    delete[] dimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete x;
+    delete y;
+    delete dedy;
+    delete dedx;
+    delete[] dimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
     TODO!!
@@ -238,6 +332,16 @@ bool TestSoftmax()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestSoftmax3();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
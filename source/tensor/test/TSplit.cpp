@@ -363,6 +363,105 @@ bool TestSplit3()
 #endif // USE_CUDA
 }
 
+/* 
+case 4: transform a tensor by splitting it, and accumulate the result 
+into the target (i.e., t = split(s) + t * beta).
+In this case, (3, 4) -> (2, 3, 2), whereToSplit=1, splitNum=2, beta=1.
+*/
+bool TestSplit4()
+{
+    /* a source tensor of size (3, 4) */
+    int sOrder = 2;
+    int * sDimSize = new int[sOrder];
+    sDimSize[0] = 3;
+    sDimSize[1] = 4;
+
+    int sUnitNum = 1;
+    for (int i = 0; i < sOrder; i++)
+        sUnitNum *= sDimSize[i];
+
+    /* a target tensor of size (2, 3, 2) */
+    int tOrder = 3;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 2;
+    tDimSize[1] = 3;
+    tDimSize[2] = 2;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData[3][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 0.5F, 1.5F},
+                          {2.5F, 3.5F, 4.5F, 5.5F} };
+    DTYPE tData[2][3][2] = { { {1.0F, 1.0F},
+                               {1.0F, 1.0F},
+                               {1.0F, 1.0F} },
+                             { {0.0F, 1.0F},
+                               {2.0F, 3.0F},
+                               {4.0F, 5.0F} } };
+    DTYPE answer[2][3][2] = { { {1.0F, 2.0F},
+                                {5.0F, 6.0F},
+                                {3.5F, 4.5F} },
+                              { {2.0F, 4.0F},
+                                {2.5F, 4.5F},
+                                {8.5F, 10.5F} } };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s = NewTensor(sOrder, sDimSize);
+    XTensor * t = NewTensor(tOrder, tDimSize);
+
+    /* initialize variables */
+    s->SetData(sData, sUnitNum);
+    t->SetData(tData, tUnitNum);
+
+    /* call Split function */
+    _Split(s, t, 1, 2, 1.0F);
+
+    /* check results */
+    cpuTest = t->CheckData(answer, tUnitNum);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensor */
+    XTensor * sGPU = NewTensor(sOrder, sDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * tGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+
+    /* Initialize variables */
+    sGPU->SetData(sData, sUnitNum);
+    tGPU->SetData(tData, tUnitNum);
+
+    /* call Split function */
+    _Split(sGPU, tGPU, 1, 2, 1.0F);
+
+    /* check results */
+    gpuTest = tGPU->CheckData(answer, tUnitNum);
+
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete sGPU;
+    delete tGPU;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
 TODO!!
@@ -404,6 +503,16 @@ bool TestSplit()
     else
         XPRINT(0, stdout, ">> case 3 passed!\n");
 
+    /* case 4 test */
+    caseFlag = TestSplit4();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 4 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 4 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
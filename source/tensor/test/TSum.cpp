@@ -20,6 +20,7 @@
  */
 
 #include "TSum.h"
+#include "../core/getandset/ConvertDataType.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -214,6 +215,73 @@ bool TestSum2()
 #endif // USE_CUDA
 }
 
+/* case 3: tensor summation c = a + b * \beta in float16 and double */
+bool TestSum3()
+{
+    /* a tensor of size (2, 4) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 2;
+    dimSize[1] = 4;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE aData[2][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 6.0F, 7.0F} };
+    DTYPE bData[2][4] = { {1.0F, -1.0F, -3.0F, -5.0F}, 
+                          {-7.0F, -9.0F, -11.0F, -13.0F} };
+    DTYPE answer[2][4] = { {0.5F, 0.5F, 0.5F, 0.5F},
+                           {0.5F, 0.5F, 0.5F, 0.5F} };
+    float beta = 0.5F;
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(order, dimSize);
+    XTensor * b = NewTensor(order, dimSize);
+    XTensor * c = NewTensor(order, dimSize);
+    XTensor * aHalf = NewTensor(order, dimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * bHalf = NewTensor(order, dimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * cHalf = NewTensor(order, dimSize, X_FLOAT16, 1.0F, -1);
+    XTensor * aDouble = NewTensor(order, dimSize, X_DOUBLE, 1.0F, -1);
+    XTensor * bDouble = NewTensor(order, dimSize, X_DOUBLE, 1.0F, -1);
+
+    /* initialize variables */
+    a->SetData(aData, unitNum);
+    b->SetData(bData, unitNum);
+    _ConvertDataType(a, aHalf);
+    _ConvertDataType(b, bHalf);
+    _ConvertDataType(a, aDouble);
+    _ConvertDataType(b, bDouble);
+
+    /* call Sum function */
+    _Sum(aHalf, bHalf, cHalf, beta);
+    _SumMe(aDouble, bDouble, beta);
+
+    /* check results */
+    _ConvertDataType(cHalf, c);
+    cpuTest = c->CheckData(answer, unitNum);
+
+    _ConvertDataType(aDouble, c);
+    cpuTest = cpuTest && c->CheckData(answer, unitNum);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+    delete aHalf;
+    delete bHalf;
+    delete cHalf;
+    delete aDouble;
+    delete bDouble;
+    delete[] dimSize;
+
+    return cpuTest;
+}
+
 /* other cases */
 /*
     TODO!!
@@ -243,6 +311,15 @@ bool TestSum()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestSum3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
     /* other cases test */
     /*
         TODO!!
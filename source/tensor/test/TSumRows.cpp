@@ -0,0 +1,197 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northestern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Test for the summation (and set) over a subset of rows.
+*/
+
+#include "TSumRows.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: summation over the given rows
+c[r] = a[r] + b[r] * \beta for every row r in rows.
+The row set is built with duplicated indices.
+*/
+bool TestSumRows1()
+{
+    /* a tensor of size (4, 3) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 4;
+    dimSize[1] = 3;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE aData[4][3] = { {0.0F, 1.0F, 2.0F},
+                          {3.0F, 4.0F, 5.0F},
+                          {6.0F, 7.0F, 8.0F},
+                          {9.0F, 10.0F, 11.0F} };
+    DTYPE bData[4][3] = { {1.0F, 1.0F, 1.0F},
+                          {2.0F, 2.0F, 2.0F},
+                          {3.0F, 3.0F, 3.0F},
+                          {4.0F, 4.0F, 4.0F} };
+    DTYPE answer[4][3] = { {0.0F, 1.0F, 2.0F},
+                           {2.0F, 3.0F, 4.0F},
+                           {6.0F, 7.0F, 8.0F},
+                           {7.0F, 8.0F, 9.0F} };
+    int index[4] = {3, 1, 3, 1};
+    DTYPE beta = -0.5F;
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(order, dimSize);
+    XTensor * b = NewTensor(order, dimSize);
+    XTensor * c = NewTensor(order, dimSize);
+    XTensor * aMe = NewTensor(order, dimSize);
+    XSparseRows rows(dimSize[0]);
+
+    /* initialize variables */
+    a->SetData(aData, unitNum);
+    b->SetData(bData, unitNum);
+    c->SetData(aData, unitNum);
+    aMe->SetData(aData, unitNum);
+    rows.Add(index, 4);
+
+    /* call SumRows function */
+    _SumRows(a, b, c, &rows, beta);
+    _SumRowsMe(aMe, b, &rows, beta);
+
+    /* check results */
+    cpuTest = rows.count == 2 && 
+              c->CheckData(answer, unitNum, 1e-4F) && 
+              aMe->CheckData(answer, unitNum, 1e-4F);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+    delete aMe;
+    delete[] dimSize;
+
+    return cpuTest;
+}
+
+/*
+case 2: set the given rows to a fixed value, and reuse the
+row set after it is cleared.
+*/
+bool TestSumRows2()
+{
+    /* a tensor of size (3, 2) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 3;
+    dimSize[1] = 2;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE aData[3][2] = { {1.0F, 2.0F},
+                          {3.0F, 4.0F},
+                          {5.0F, 6.0F} };
+    DTYPE answer1[3][2] = { {1.0F, 2.0F},
+                            {0.0F, 0.0F},
+                            {5.0F, 6.0F} };
+    DTYPE answer2[3][2] = { {0.0F, 0.0F},
+                            {0.0F, 0.0F},
+                            {5.0F, 6.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * a = NewTensor(order, dimSize);
+    XSparseRows rows(dimSize[0]);
+
+    /* initialize variables */
+    a->SetData(aData, unitNum);
+
+    /* call SetDataRows function */
+    rows.Add(1);
+    _SetDataRows(a, &rows, 0);
+    cpuTest = a->CheckData(answer1, unitNum, 1e-4F);
+
+    rows.Clear();
+    cpuTest = cpuTest && rows.count == 0 && !rows.marks[1];
+
+    rows.Add(0);
+    rows.Add(0);
+    _SetDataRows(a, &rows, 0);
+
+    /* check results */
+    cpuTest = cpuTest && rows.count == 1 && a->CheckData(answer2, unitNum, 1e-4F);
+
+    /* destroy variables */
+    delete a;
+    delete[] dimSize;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for SumRows Function */
+bool TestSumRows()
+{
+    XPRINT(0, stdout, "[TEST SumRows] summation over a subset of rows \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestSumRows1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestSumRows2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -305,6 +305,122 @@ bool TestTopK2()
 #endif // USE_CUDA
 }
 
+/*
+get the top-k items of a strided row by scanning it k times
+(the reference for the following cases). Ties go to the smaller index.
+*/
+void TopKReference(const DTYPE * data, int num, int stride, int k, DTYPE * value, int * index)
+{
+    bool * taken = new bool[num];
+    memset(taken, 0, sizeof(bool) * num);
+
+    for (int j = 0; j < k && j < num; j++) {
+        int best = -1;
+        for (int i = 0; i < num; i++) {
+            if (!taken[i] && (best < 0 || data[i * stride] > data[best * stride]))
+                best = i;
+        }
+        taken[best] = true;
+        value[j] = data[best * stride];
+        index[j] = best;
+    }
+
+    delete[] taken;
+}
+
+/*
+check the top-k items of a tensor against the reference
+>> a - the input tensor
+>> b - the top-k values
+>> index - the top-k indices
+>> dim - the dimension along which we select
+>> k - number of the items to select
+*/
+bool CheckTopK(XTensor * a, XTensor * b, XTensor * index, int dim, int k)
+{
+    int dimRDI = a->order - dim - 1;
+    int stride = 1;
+    int num = a->dimSizeRDI[dimRDI];
+    for (int i = 0; i < dimRDI; i++)
+        stride *= a->dimSizeRDI[i];
+    int rowNum = a->unitNum / num;
+
+    DTYPE * value = new DTYPE[k];
+    int * ids = new int[k];
+    bool right = true;
+
+    for (int r = 0; r < rowNum && right; r++) {
+        int h = r / stride;
+        int i = r % stride;
+        DTYPE * dataA = (DTYPE*)a->data + h * stride * num + i;
+        DTYPE * dataB = (DTYPE*)b->data + h * stride * k + i;
+        int * indexData = (int*)index->data + h * stride * k + i;
+
+        TopKReference(dataA, num, stride, k, value, ids);
+
+        for (int j = 0; j < k; j++) {
+            if (dataB[j * stride] != value[j] || indexData[j * stride] != ids[j]) {
+                right = false;
+                break;
+            }
+        }
+    }
+
+    delete[] value;
+    delete[] ids;
+
+    return right;
+}
+
+/*
+case 3: get the top-k items of vocabulary-sized rows.
+In this case, (4, 30000) -> (4, k), dim = 1, k = 1, 10, 100 and
+(3000, 5) -> (k, 5), dim = 0, k = 20. The values are rounded to 0.1 so
+that there are many ties.
+*/
+bool TestTopK3()
+{
+    int rowNum = 4;
+    int colNum = 30000;
+    int ks[3] = {1, 10, 100};
+    bool cpuTest = true;
+
+    XTensor * s = NewTensor2D(rowNum, colNum);
+    s->SetDataRand(-10.0F, 10.0F);
+    for (int i = 0; i < s->unitNum; i++) {
+        DTYPE * p = (DTYPE*)s->data + i;
+        *p = (DTYPE)((int)(*p * 10)) / 10;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        XTensor * t = NewTensor2D(rowNum, ks[i]);
+        XTensor * index = NewTensor2D(rowNum, ks[i], X_INT);
+
+        _TopK(s, t, index, 1, ks[i]);
+        cpuTest = CheckTopK(s, t, index, 1, ks[i]) && cpuTest;
+
+        delete t;
+        delete index;
+    }
+
+    /* select along a dimension that is not the last one */
+    XTensor * s2 = NewTensor2D(3000, 5);
+    XTensor * t2 = NewTensor2D(20, 5);
+    XTensor * index2 = NewTensor2D(20, 5, X_INT);
+    s2->SetDataRand(-1.0F, 1.0F);
+
+    _TopK(s2, t2, index2, 0, 20);
+    cpuTest = CheckTopK(s2, t2, index2, 0, 20) && cpuTest;
+
+    /* destroy variables */
+    delete s;
+    delete s2;
+    delete t2;
+    delete index2;
+
+    return cpuTest;
+}
+
 /* other cases */
 /*
 TODO!!
@@ -334,6 +450,15 @@ bool TestTopK()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestTopK3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
@@ -350,4 +475,84 @@ bool TestTopK()
     return returnFlag;
     }
 
+/*
+top-k of a row with a heap (the old CPU implementation of _TopK).
+It is the baseline of the benchmark.
+*/
+void TopKByHeap(const DTYPE * data, int num, int k, XHeap<MIN_HEAP, DTYPE> &heap,
+                DTYPE * value, int * index)
+{
+    heap.Clear(DTYPE_MIN);
+
+    for (int j = 0; j < num; j++) {
+        if (heap.count < heap.size)
+            heap.Push(HeapNode<DTYPE>(j, data[j]));
+        else if (data[j] > heap.Top().value)
+            heap.ReplaceTop(HeapNode<DTYPE>(j, data[j]));
+    }
+
+    for (int j = k - 1; j >= 0; j--) {
+        HeapNode<DTYPE> node = heap.Pop();
+        value[j] = node.value;
+        index[j] = node.index;
+    }
+}
+
+/*
+benchmark of TopK over vocabulary-sized rows. For each row size and k,
+it reports the time (in ms per row) of the heap, the radix selection with
+a single job and the radix selection with a thread pool.
+>> threadNum - number of threads in the pool
+*/
+void BenchmarkTopK(int threadNum)
+{
+    int rowNum = 64;
+    int sizes[4] = {1000, 10000, 30000, 50000};
+    int ks[5] = {1, 4, 10, 50, 200};
+    int round = 10;
+
+    XPRunner runner;
+    runner.Init(MIN(threadNum, MAX_THREAD_NUM));
+
+    XPRINT1(0, stdout, "[BENCHMARK TopK] %d rows per run, times are in ms per row\n", rowNum);
+    XPRINT1(0, stdout, "    size      k       heap      radix   parallel(%d threads)\n", threadNum);
+
+    for (int i = 0; i < 4; i++) {
+        XTensor * s = NewTensor2D(rowNum, sizes[i]);
+        s->SetDataRandn(0, 3.0F);
+
+        for (int j = 0; j < 5; j++) {
+            int k = ks[j];
+            XTensor * t = NewTensor2D(rowNum, k);
+            XTensor * index = NewTensor2D(rowNum, k, X_INT);
+            XHeap<MIN_HEAP, DTYPE> heap(k);
+
+            double startT = GetClock();
+            for (int r = 0; r < round; r++) {
+                for (int row = 0; row < rowNum; row++)
+                    TopKByHeap((DTYPE*)s->data + row * sizes[i], sizes[i], k, heap,
+                               (DTYPE*)t->data + row * k, (int*)index->data + row * k);
+            }
+            double heapT = (GetClock() - startT) / (round * rowNum);
+
+            startT = GetClock();
+            for (int r = 0; r < round; r++)
+                _RadixTopK(s, t, index, 1, k);
+            double radixT = (GetClock() - startT) / (round * rowNum);
+
+            startT = GetClock();
+            for (int r = 0; r < round; r++)
+                _RadixTopK(s, t, index, 1, k, &runner);
+            double parallelT = (GetClock() - startT) / (round * rowNum);
+
+            XPRINT5(0, stdout, "%8d %6d %10.4f %10.4f %10.4f\n", sizes[i], k, heapT, radixT, parallelT);
+
+            delete t;
+            delete index;
+        }
+
+        delete s;
+    }
+}
+
 } // namespace nts(NiuTrans.Tensor)
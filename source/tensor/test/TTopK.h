@@ -23,6 +23,9 @@
 #define __TEST_TOPK_H__
 
 #include "../core/sort/TopK.h"
+#include "../core/sort/RadixSort.h"
+#include "../XHeap.h"
+#include "../XUtility.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -30,5 +33,8 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 extern "C"
 bool TestTopK();
 
+/* benchmark of TopK over vocabulary-sized rows */
+void BenchmarkTopK(int threadNum);
+
 } // namespace nts(NiuTrans.Tensor)
 #endif // __TEST_TOPK_H__
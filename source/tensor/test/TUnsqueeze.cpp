@@ -153,6 +153,100 @@ bool TestUnsqueeze1()
 #endif // USE_CUDA
 }
 
+/* 
+case 2: insert a dimension and accumulate the result into the target 
+(i.e., b = unsqueeze(a) + b * beta)
+In this case, (2, 3) -> (2, 2, 3), dim=1, dSize=2, beta=1
+*/
+bool TestUnsqueeze2()
+{
+    /* a source tensor of size (2, 3) */
+    int sOrder = 2;
+    int * sDimSize = new int[sOrder];
+    sDimSize[0] = 2;
+    sDimSize[1] = 3;
+
+    int sUnitNum = 1;
+    for (int i = 0; i < sOrder; i++)
+        sUnitNum *= sDimSize[i];
+
+    /* a target tensor of size (2, 2, 3) */
+    int tOrder = 3;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 2;
+    tDimSize[1] = 2;
+    tDimSize[2] = 3;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData[2][3] = { {0.0F, 1.0F, 2.0F},
+                          {3.0F, 4.0F, 5.0F} };
+    DTYPE tData[2][2][3] = { { {1.0F, 1.0F, 1.0F},
+                               {2.0F, 2.0F, 2.0F} },
+                             { {-1.0F, 0.0F, 1.0F},
+                               {0.5F, 0.5F, 0.5F} } };
+    DTYPE answer[2][2][3] = { { {1.0F, 2.0F, 3.0F},
+                                {2.0F, 3.0F, 4.0F} },
+                              { {2.0F, 4.0F, 6.0F},
+                                {3.5F, 4.5F, 5.5F} } };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s = NewTensor(sOrder, sDimSize);
+    XTensor * t = NewTensor(tOrder, tDimSize);
+
+    /* initialize variables */
+    s->SetData(sData, sUnitNum);
+    t->SetData(tData, tUnitNum);
+
+    /* call Unsqueeze function */
+    _Unsqueeze(s, t, 1, 2, 1.0F);
+
+    /* check results */
+    cpuTest = t->CheckData(answer, tUnitNum);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensor */
+    XTensor * sGPU = NewTensor(sOrder, sDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * tGPU = NewTensor(tOrder, tDimSize, X_FLOAT, 1.0F, 0);
+
+    /* Initialize variables */
+    sGPU->SetData(sData, sUnitNum);
+    tGPU->SetData(tData, tUnitNum);
+
+    /* call Unsqueeze function */
+    _Unsqueeze(sGPU, tGPU, 1, 2, 1.0F);
+
+    /* check results */
+    gpuTest = tGPU->CheckData(answer, tUnitNum);
+
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete sGPU;
+    delete tGPU;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete s;
+    delete t;
+    delete[] sDimSize;
+    delete[] tDimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
     TODO!!
@@ -174,6 +268,16 @@ bool TestUnsqueeze()
     else
         XPRINT(0, stdout, ">> case 1 passed!\n");
 
+    /* case 2 test */
+    caseFlag = TestUnsqueeze2();
+
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
@@ -0,0 +1,180 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TXLink.h"
+#include "../XTensor.h"
+#include "../XGraphArena.h"
+#include "../XName.h"
+#include "../core/CHeader.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* 
+case 1: an edge with many tails and parameters
+The tails and the parameters are kept in the edge itself if there are a few
+of them, and in the graph arena otherwise. Moving a node to another keeps
+the edges, and clearing the node gives the arrays back to the arena.
+*/
+bool TestXLink1()
+{
+    int tailNum = XLINK_INLINE_TAIL_NUM * 2 + 1;
+    int paramNum = XLINK_INLINE_PARAM_NUM * 2 + 1;
+    int blockNum = GGraphArena.blockNum;
+
+    bool cpuTest = true;
+
+    XTensor * tails = new XTensor[tailNum];
+    XTensor h;
+    XList list(tailNum);
+    for (int i = 0; i < tailNum; i++)
+        list.Add(tails + i);
+
+    XLink::MakeLink(&list, &h, MATH_SUM);
+    for (int i = 0; i < paramNum; i++)
+        XLink::AddParamToHeadInt(&h, i);
+
+    cpuTest = cpuTest && h.income.tailNum == tailNum && h.income.paramNum == paramNum;
+    cpuTest = cpuTest && h.income.tails != h.income.tailBuf && 
+              h.income.params != (void*)h.income.paramBuf;
+    cpuTest = cpuTest && GGraphArena.blockNum == blockNum + 2;
+
+    for (int i = 0; i < tailNum; i++)
+        cpuTest = cpuTest && h.income.tails[i] == tails + i && tails[i].outgo.tails[0] == &h;
+    for (int i = 0; i < paramNum; i++)
+        cpuTest = cpuTest && h.income.GetParamInt(i) == i;
+
+    /* a node with a few tails (kept in the edge) is moved to the node
+       with many tails (kept in the arena), and vice versa */
+    XTensor g;
+    XLink::MakeLink(tails, tails + 1, &g, MATH_SUM);
+    XLink::AddParamToHeadInt(&g, 7);
+
+    XLink::Swap(g.income, h.income);
+
+    cpuTest = cpuTest && g.income.tailNum == tailNum && h.income.tailNum == 2;
+    cpuTest = cpuTest && g.income.tails[tailNum - 1] == tails + tailNum - 1 && 
+              g.income.GetParamInt(paramNum - 1) == paramNum - 1;
+    cpuTest = cpuTest && h.income.tails == h.income.tailBuf && h.income.tails[1] == tails + 1 &&
+              h.income.GetParamInt(0) == 7;
+
+    XLink::Swap(g.income, h.income);
+
+    XTensor m;
+    XLink::Move(&h, &m);
+
+    cpuTest = cpuTest && m.income.tailNum == tailNum && h.income.tailNum == 0;
+    for (int i = 0; i < tailNum; i++)
+        cpuTest = cpuTest && m.income.tails[i] == tails + i && tails[i].outgo.tails[0] == &m;
+    for (int i = 0; i < paramNum; i++)
+        cpuTest = cpuTest && m.income.GetParamInt(i) == i;
+
+    XLink::ClearIncoming(&m);
+    XLink::ClearIncoming(&g);
+
+    cpuTest = cpuTest && m.income.tails == m.income.tailBuf && GGraphArena.blockNum == blockNum;
+
+    delete[] tails;
+
+    return cpuTest;
+}
+
+/* 
+case 2: a node that is used by many nodes
+The outgoing edge of the node grows into the graph arena, and goes back
+to the node when these nodes die. The arena is freed in one go when no
+array of it is in use.
+*/
+bool TestXLink2()
+{
+    int dimSize[2] = {2, 3};
+    DTYPE aData[2][3] = { {1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 6.0F} };
+    int num = XLINK_INLINE_TAIL_NUM * 4;
+    int blockNum = GGraphArena.blockNum;
+
+    bool cpuTest = true;
+
+    XTensor a(2, dimSize, X_FLOAT, 1.0F, -1, NULL);
+    a.SetData(aData, 6);
+
+    {
+        XTensor * results = new XTensor[num];
+        for (int i = 0; i < num; i++)
+            results[i] = ScaleAndShift(a, (DTYPE)i);
+
+        cpuTest = cpuTest && a.outgo.tailNum == num && a.outgo.tails != a.outgo.tailBuf;
+        for (int i = 0; i < num; i++)
+            cpuTest = cpuTest && a.outgo.tails[i] == results + i && results[i].income.tails[0] == &a;
+
+        delete[] results;
+    }
+
+    cpuTest = cpuTest && a.outgo.tailNum == 0 && a.outgo.tails == a.outgo.tailBuf;
+    cpuTest = cpuTest && GGraphArena.blockNum == blockNum;
+
+    if (blockNum == 0)
+        cpuTest = cpuTest && GGraphArena.Rewind() && GGraphArena.chunkNum == 0;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for XLink (edges of the network) */
+bool TestXLink()
+{
+    XPRINT(0, stdout, "[TEST XLink] edges of the network \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestXLink1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestXLink2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,252 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "TXOperator.h"
+#include "../XTensor.h"
+#include "../XName.h"
+#include "../core/CHeader.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* 
+case 1: the built-in operators
+Names, in-place capability and cost models are given by the registry, and
+an operator of the uniform form is run by its registered forward kernel.
+*/
+bool TestXOperator1()
+{
+    /* a tensor of size (2, 3) */
+    int aOrder = 2;
+    int aDimSize[2] = {2, 3};
+    int aUnitNum = 6;
+
+    /* a tensor of size (3, 4) */
+    int bOrder = 2;
+    int bDimSize[2] = {3, 4};
+    int bUnitNum = 12;
+
+    DTYPE aData[2][3] = { {1.0F, -2.0F, 3.0F},
+                          {-4.0F, 5.0F, -6.0F} };
+    DTYPE answer[2][3] = { {1.0F, 2.0F, 3.0F},
+                           {4.0F, 5.0F, 6.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    cpuTest = cpuTest && !strcmp(GetOPName(MATH_SUM), "M_SUM") && 
+              !strcmp(GetOPName(SHAPE_MERGE), "S_MERGE") && 
+              !strcmp(GetOPName(FUNC_SOFTMAX), "F_SOFTMAX") &&
+              !strcmp(GetOPName(0), "NULL");
+    cpuTest = cpuTest && GOPs.IsInPlace(MATH_EXP) && !GOPs.IsInPlace(MATH_MATRIXMUL);
+
+    /* create tensors */
+    XTensor * a = NewTensor(aOrder, aDimSize);
+    XTensor * b = NewTensor(bOrder, bDimSize);
+    XTensor * c = NewTensor(aOrder, aDimSize);
+    XTensor mUser;
+    XTensor cUser;
+
+    /* initialize variables */
+    a->SetData(aData, aUnitNum);
+    b->SetDataRand(-1.0F, 1.0F);
+
+    /* call the forward kernel of the operator */
+    const XTensor * inputs[1] = {a};
+    _RunOperator(MATH_ABSOLUTE, inputs, 1, c);
+    cUser = RunOperator(MATH_ABSOLUTE, inputs, 1);
+
+    cpuTest = cpuTest && c->CheckData(answer, aUnitNum) && cUser.CheckData(answer, aUnitNum) &&
+              cUser.income.typeID == MATH_ABSOLUTE && cUser.income.tails[0] == a;
+
+    /* the cost of (2, 3) * (3, 4) -> (2, 4) */
+    double flops = 0;
+    double bytes = 0;
+    mUser = MatrixMul(*a, X_NOTRANS, *b, X_NOTRANS);
+    cpuTest = cpuTest && GOPs.GetCost(&mUser, &flops, &bytes);
+    cpuTest = cpuTest && flops == 2.0 * 8 * 3 && bytes == (aUnitNum + bUnitNum + 8) * sizeof(DTYPE);
+
+    /* the cost of an element-wise operator */
+    cpuTest = cpuTest && GOPs.GetCost(&cUser, &flops, &bytes);
+    cpuTest = cpuTest && flops == aUnitNum && bytes == 2 * aUnitNum * sizeof(DTYPE);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensors */
+    XTensor * aGPU = NewTensor(aOrder, aDimSize, X_FLOAT, 1.0F, 0);
+    XTensor * cGPU = NewTensor(aOrder, aDimSize, X_FLOAT, 1.0F, 0);
+    XTensor cUserGPU;
+
+    /* initialize variables */
+    aGPU->SetData(aData, aUnitNum);
+
+    /* call the forward kernel of the operator */
+    const XTensor * inputsGPU[1] = {aGPU};
+    _RunOperator(MATH_ABSOLUTE, inputsGPU, 1, cGPU);
+    cUserGPU = RunOperator(MATH_ABSOLUTE, inputsGPU, 1);
+
+    /* check results */
+    gpuTest = cGPU->CheckData(answer, aUnitNum) && cUserGPU.CheckData(answer, aUnitNum);
+
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+    delete aGPU;
+    delete cGPU;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete a;
+    delete b;
+    delete c;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
+/* the number of calls of the gradient function of the custom operator */
+static int scaledSumGradNum = 0;
+
+/* forward kernel of a custom (fused) operator: c = (a + b) * params[0] */
+static
+void ForwardScaledSum(const XTensor ** inputs, int inputNum, XTensor * output,
+                      const DTYPE * params, int paramNum)
+{
+    _Sum(inputs[0], inputs[1], output);
+    _ScaleAndShiftMe(output, params[0]);
+}
+
+/* gradient function of the custom operator */
+static
+void GradScaledSum(XTensor * node, bool isEfficient)
+{
+    scaledSumGradNum++;
+}
+
+/* 
+case 2: a custom (fused) operator
+The operator is registered from outside the library, and is run, named,
+costed and differentiated through the registry.
+*/
+bool TestXOperator2()
+{
+    /* a tensor of size (2, 2) */
+    int order = 2;
+    int dimSize[2] = {2, 2};
+    int unitNum = 4;
+
+    DTYPE aData[2][2] = { {1.0F, 2.0F},
+                          {3.0F, 4.0F} };
+    DTYPE bData[2][2] = { {0.5F, -1.0F},
+                          {1.0F, 0.0F} };
+    DTYPE answer[2][2] = { {3.0F, 2.0F},
+                           {8.0F, 8.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    int id = GOPs.Register("F_SCALEDSUM", ForwardScaledSum, GradScaledSum, CostElementwise, true);
+
+    cpuTest = cpuTest && id > CUSTOM_BASE && !strcmp(GetOPName(id), "F_SCALEDSUM") &&
+              GOPs.IsInPlace(id) && GOPs.GetBackward(id) == GradScaledSum &&
+              GOPs.GetForward(id, -1, X_FLOAT) == ForwardScaledSum;
+
+    /* create tensors */
+    XTensor * a = NewTensor(order, dimSize);
+    XTensor * b = NewTensor(order, dimSize);
+    XTensor cUser;
+
+    /* initialize variables */
+    a->SetData(aData, unitNum);
+    b->SetData(bData, unitNum);
+
+    /* call the custom operator */
+    const XTensor * inputs[2] = {a, b};
+    DTYPE scale = 2.0F;
+    cUser = RunOperator(id, inputs, 2, &scale, 1);
+
+    cpuTest = cpuTest && cUser.CheckData(answer, unitNum) && cUser.income.typeID == id &&
+              cUser.income.tailNum == 2 && cUser.income.GetParam(0) == scale;
+
+    /* the metadata of the node */
+    double flops = 0;
+    double bytes = 0;
+    cpuTest = cpuTest && GOPs.GetCost(&cUser, &flops, &bytes);
+    cpuTest = cpuTest && flops == unitNum && bytes == 3 * unitNum * sizeof(DTYPE);
+
+    /* backward dispatch */
+    int gradNum = scaledSumGradNum;
+    GOPs.Backward(&cUser, false);
+    cpuTest = cpuTest && scaledSumGradNum == gradNum + 1;
+
+    /* destroy variables */
+    delete a;
+    delete b;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for XOperator (the registry of operators) */
+bool TestXOperator()
+{
+    XPRINT(0, stdout, "[TEST XOperator] the registry of operators \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestXOperator1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestXOperator2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
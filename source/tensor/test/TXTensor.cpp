@@ -0,0 +1,232 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northestern University. 
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include "TXTensor.h"
+#include "../core/CHeader.h"
+#include "../function/FHeader.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* 
+case 1: copy and move tensors
+A tensor is copied (with its data) only when we assign or construct it 
+from a tensor that is still alive. The result of an operation is moved, 
+i.e., we take its data array and its place in the network.
+*/
+bool TestXTensor1()
+{
+    int dimSize[2] = {2, 3};
+    DTYPE aData[2][3] = { {1.0F, 2.0F, 3.0F},
+                          {4.0F, 5.0F, 6.0F} };
+    DTYPE answer[2][3] = { {2.0F, 4.0F, 6.0F},
+                           {8.0F, 10.0F, 12.0F} };
+
+    bool cpuTest = true;
+
+    XTensor a(2, dimSize, X_FLOAT, 1.0F, -1, NULL);
+    XTensor b(2, dimSize, X_FLOAT, 1.0F, -1, NULL);
+    a.SetData(aData, 6);
+    b.SetData(aData, 6);
+
+    long long copyCount = tensorCopyCount;
+
+    /* move assignment */
+    XTensor c;
+    c = Sum(a, b);
+    cpuTest = cpuTest && c.CheckData(answer, 6) && tensorCopyCount == copyCount;
+
+    /* c takes the place of the result of Sum in the network */
+    cpuTest = cpuTest && c.income.tailNum == 2 && c.income.tails[0] == &a && c.income.tails[1] == &b;
+    cpuTest = cpuTest && a.outgo.tailNum == 1 && a.outgo.tails[0] == &c;
+
+    /* move assignment to a tensor that is the input of another one */
+    XTensor d;
+    d = Sum(c, c);
+    c = Sum(a, a);
+    cpuTest = cpuTest && c.CheckData(answer, 6) && tensorCopyCount == copyCount;
+    cpuTest = cpuTest && d.income.tailNum == 2 && d.income.tails[0] != &c && 
+              d.income.tails[0]->CheckData(answer, 6);
+
+    /* move construction */
+    void * dataBackup = d.data;
+    XTensor e((XTensor&&)d);
+    cpuTest = cpuTest && e.data == dataBackup && d.data == NULL && tensorCopyCount == copyCount;
+    cpuTest = cpuTest && e.income.tailNum == 2 && d.income.tailNum == 0 &&
+              e.income.tails[0]->outgo.tails[0] == &e;
+
+    /* copy construction and copy assignment */
+    XTensor f(c);
+    XTensor g;
+    g = f;
+    cpuTest = cpuTest && f.CheckData(answer, 6) && g.CheckData(answer, 6) && c.CheckData(answer, 6);
+    cpuTest = cpuTest && f.data != c.data && g.data != f.data && tensorCopyCount == copyCount + 2;
+
+    return cpuTest;
+}
+
+/* 
+case 2: copies in a Transformer layer
+We run a self-attention layer and a feed-forward layer (with residual 
+connections and layer normalization) in the way the Transformer sample 
+does, and count the tensors that are copied. There should be no copy.
+*/
+bool TestXTensor2()
+{
+    int batch = 2;
+    int len = 4;
+    int d = 8;
+    int hSize = 16;
+    int nhead = 2;
+
+    XTensor input;
+    XTensor wq, wk, wv, wa;
+    XTensor w1, b1, w2, b2;
+    XTensor lnw, lnb;
+
+    InitTensor3D(&input, batch, len, d);
+    InitTensor2D(&wq, d, d);
+    InitTensor2D(&wk, d, d);
+    InitTensor2D(&wv, d, d);
+    InitTensor2D(&wa, d, d);
+    InitTensor2D(&w1, d, hSize);
+    InitTensor1D(&b1, hSize);
+    InitTensor2D(&w2, hSize, d);
+    InitTensor1D(&b2, d);
+    InitTensor1D(&lnw, d);
+    InitTensor1D(&lnb, d);
+
+    input.SetDataRand(-1.0F, 1.0F);
+    wq.SetDataRand(-1.0F, 1.0F);
+    wk.SetDataRand(-1.0F, 1.0F);
+    wv.SetDataRand(-1.0F, 1.0F);
+    wa.SetDataRand(-1.0F, 1.0F);
+    w1.SetDataRand(-1.0F, 1.0F);
+    b1.SetDataRand(-1.0F, 1.0F);
+    w2.SetDataRand(-1.0F, 1.0F);
+    b2.SetDataRand(-1.0F, 1.0F);
+    _SetDataFixedFloat(&lnw, 1.0F);
+    lnb.SetZeroAll();
+
+    long long copyCount = tensorCopyCount;
+
+    XTensor x;
+    XTensor res;
+
+    /* self-attention */
+    {
+        XTensor k2, q2, v2;
+        XTensor kheads, qheads, vheads;
+        XTensor dot, scalar, att;
+
+        k2 = MMul(input, wk);
+        q2 = MMul(input, wq);
+        v2 = MMul(input, wv);
+
+        kheads = Split(k2, k2.order - 1, nhead);
+        qheads = Split(q2, q2.order - 1, nhead);
+        vheads = Split(v2, v2.order - 1, nhead);
+
+        dot = BMMul(qheads, X_NOTRANS, kheads, X_TRANS);
+        dot = Linear(dot, 1.0F/(float)sqrt((float)d/nhead));
+        scalar = Softmax(dot, -1);
+        att = BMMul(scalar, vheads);
+        att = MMul(Merge(att, att.order - 1), wa);
+
+        res = Sum(att, input);
+    }
+
+    /* layer normalization */
+    {
+        XTensor mean, variance, standard;
+
+        mean = ReduceMean(res, res.order - 1);
+        variance = ReduceVariance(res, res.order - 1, mean);
+        standard = Power(variance, 0.5F);
+
+        x = (res - Unsqueeze(mean, res.order - 1, d)) / Unsqueeze(standard, res.order - 1, d);
+        x = x * lnw + lnb;
+    }
+
+    /* feed-forward network */
+    {
+        XTensor t1;
+        XTensor fnn;
+
+        t1 = Rectify(MulAndShift(x, w1, b1));
+        fnn = MulAndShift(t1, w2, b2);
+
+        res = Sum(fnn, x);
+    }
+
+    bool cpuTest = tensorCopyCount == copyCount;
+
+    cpuTest = cpuTest && res.order == 3 && res.GetDim(0) == batch && 
+              res.GetDim(1) == len && res.GetDim(2) == d;
+
+    if(!cpuTest)
+        XPRINT1(0, stderr, "%lld tensors are copied in the layer\n", tensorCopyCount - copyCount);
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for XTensor (copy and move) */
+bool TestXTensor()
+{
+    XPRINT(0, stdout, "[TEST XTensor] copy and move tensors \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestXTensor1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestXTensor2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -42,11 +42,13 @@ bool Test()
     wrong = !TestDivDim() || wrong;
     wrong = !TestExp() || wrong;
     wrong = !TestGather() || wrong;
+    wrong = !TestGatherByIndex() || wrong;
     wrong = !TestLog() || wrong;
     wrong = !TestMatrixMul() || wrong;
     wrong = !TestMatrixMul2D() || wrong;
     wrong = !TestMatrixMul2DParallel() || wrong;
     wrong = !TestMatrixMulBatched() || wrong;
+    wrong = !TestMatrixMulBlockSparse() || wrong;
     wrong = !TestMerge() || wrong;
     wrong = !TestMultiply() || wrong;
     wrong = !TestMultiplyDim() || wrong;
@@ -73,11 +75,21 @@ bool Test()
     wrong = !TestSumByColumnTV() || wrong;
     wrong = !TestSumByColumnVT() || wrong;
     wrong = !TestSumDim() || wrong;
+    wrong = !TestSumRows() || wrong;
     wrong = !TestTan() || wrong;
     wrong = !TestTranspose() || wrong;
-    //wrong = !TestTopK() || wrong;
+    wrong = !TestTopK() || wrong;
     wrong = !TestUnsqueeze() || wrong;
+    wrong = !TestXTensor() || wrong;
+    wrong = !TestXLink() || wrong;
+    wrong = !TestXOperator() || wrong;
     wrong = !TestXMem() || wrong;
+    wrong = !TestNuma() || wrong;
+    wrong = !TestAutoTune() || wrong;
+    wrong = !TestQueue() || wrong;
+    wrong = !TestOptimizer() || wrong;
+    wrong = !TestServer() || wrong;
+    wrong = !TestCopyBlocks() || wrong;
     
     wrong = !TestCrossEntropy() || wrong;
 	wrong = !TestDropout() || wrong;
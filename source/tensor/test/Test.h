@@ -35,11 +35,13 @@
 #include "TDivDim.h"
 #include "TExp.h"
 #include "TGather.h"
+#include "TGatherByIndex.h"
 #include "TLog.h"
 #include "TMatrixMul.h"
 #include "TMatrixMul2D.h"
 #include "TMatrixMul2DParallel.h"
 #include "TMatrixMulBatched.h"
+#include "TMatrixMulBlockSparse.h"
 #include "TMerge.h"
 #include "TMultiply.h"
 #include "TMultiplyDim.h"
@@ -66,10 +68,20 @@
 #include "TSumByColumnTV.h"
 #include "TSumByColumnVT.h"
 #include "TSumDim.h"
+#include "TSumRows.h"
 #include "TTan.h"
 #include "TTranspose.h"
 #include "TTopK.h"
+#include "TNuma.h"
+#include "TAutoTune.h"
+#include "TQueue.h"
+#include "TOptimizer.h"
+#include "TServer.h"
+#include "TCopyBlocks.h"
 #include "TUnsqueeze.h"
+#include "TXTensor.h"
+#include "TXLink.h"
+#include "TXOperator.h"
 #include "TXMem.h"
 
 #include "TCrossEntropy.h"